@@ -5,6 +5,7 @@
 #include "TableInputFormat.h"
 
 #include <Hypertable/Lib/Client.h>
+#include <Hypertable/Lib/Key.h>
 #include "TableRangeMap.h"
 #include <Hypertable/Lib/RangeLocationInfo.h>
 
@@ -54,6 +55,9 @@ namespace Mapreduce {
         env->SetObjectArrayElement(mappings, k*3, str);
         env->DeleteLocalRef(str);
 
+        /* END_ROW_MARKER is not valid UTF-8; the reader maps "" back to it */
+        if (end_row == Key::END_ROW_MARKER)
+          end_row = "";
         str = env->NewStringUTF(end_row.c_str());
         env->SetObjectArrayElement(mappings, k*3+1, str);
         env->DeleteLocalRef(str);
@@ -1,4 +1,8 @@
 #include <Common/Compat.h>
+#include <Common/Timer.h>
+#include <Hypertable/Lib/Defaults.h>
+#include <Hypertable/Lib/Key.h>
+#include <Hypertable/Lib/LocationCache.h>
 #include "TableRangeMap.h"
 #include <iostream>
 
@@ -10,69 +14,47 @@ namespace Mapreduce
     m_client = new Client(RootPath);
 
     m_user_table = m_client->open_table(TableName);
-    m_meta_table = m_client->open_table("METADATA");
 
     m_user_table->get_identifier(&m_table_id);
+    m_user_table->get_range_locator(m_range_locator);
   }
 
   std::vector<RangeLocationInfo> *TableRangeMap::getMap()
   {
-    char tmprow[16];
-    std::string endrow, startrow;
-    ScanSpecBuilder meta_scan_builder;
-    TableScannerPtr scanner;
     std::vector<RangeLocationInfo> *range_vector;
-    Cell cell;
-
-    snprintf(tmprow, 16, "%u:", m_table_id.id);
-
-    startrow = tmprow;
-   
-    meta_scan_builder.add_row_interval(startrow, true, startrow + "\xff\xff", true); 
-    
-    /* select columns */
-    meta_scan_builder.add_column("StartRow");
-    meta_scan_builder.add_column("Location");
-
-    scanner = m_meta_table->create_scanner(meta_scan_builder.get());
+    std::string row;
 
     range_vector = new std::vector<RangeLocationInfo>();
-    while (scanner->next(cell))
-    {
-      RangeLocationInfo range;
-      char *v;
-      /* 
-         the first cell is a StartRow and the start of the range
-         is encoded within the cell value, so extract it first.
-         */
-      v = new char[cell.value_len + 1];
-      memcpy(v, cell.value, cell.value_len);
-      v[cell.value_len] = 0;
-      range.start_row = std::string(v);
-      delete v;
-      v = NULL;
 
-      /*
-         the last row of the range (not inclusive) is encoded within the row key
-         so extract it next
+    try {
+      LocationCachePtr cache;
 
-         note below: I rely on the assumption that
-         the row key is 0 terminated. the below code will
-         cause problems otherwise
-         */
-      range.end_row = std::string(cell.row_key+2);
+      /* load every range location with one METADATA scan, then walk the
+         cache, going back to METADATA only on a miss */
+      m_user_table->prefetch_locations();
+      m_range_locator->get_location_cache(cache);
 
-      /* the second cell is Location */
-      scanner->next(cell);
+      for (;;) {
+        RangeLocationInfo range;
 
-      v = new char[cell.value_len+1];
-      memcpy(v, cell.value, cell.value_len);
-      v[cell.value_len] = 0;
-      range.location = std::string(v);
-      delete v;
-      v = NULL;
+        if (!cache->lookup(m_table_id.id, row.c_str(), &range, row.empty())) {
+          Timer timer(HYPERTABLE_CLIENT_TIMEOUT, true);
+          m_range_locator->find_loop(&m_table_id, row.c_str(), &range, timer,
+                                     true);
+        }
+        range_vector->push_back(range);
 
-      range_vector->push_back(range);
+        if (range.end_row == "" || range.end_row == Key::END_ROW_MARKER)
+          break;
+
+        /* smallest row key that sorts after the end of this range */
+        row = range.end_row;
+        row.append(1, 1);
+      }
+    }
+    catch (...) {
+      delete range_vector;
+      throw;
     }
 
     return range_vector;
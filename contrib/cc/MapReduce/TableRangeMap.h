@@ -7,6 +7,7 @@
 #include <Hypertable/Lib/Cell.h>
 #include <Hypertable/Lib/Client.h>
 #include <Hypertable/Lib/RangeLocationInfo.h>
+#include <Hypertable/Lib/RangeLocator.h>
 #include <string>
 #include <vector>
 
@@ -19,14 +20,21 @@ namespace Mapreduce
     TableRangeMap(const std::string TableName, const std::string ConfigPath);
     ~TableRangeMap() {}
   
+    /**
+     * Returns the table's current ranges in row order.  The locations
+     * of all ranges are prefetched from METADATA in one pass before the
+     * ranges are walked, so the boundaries reflect any splits that have
+     * happened since the cache was last filled.
+     * The start row of each range is exclusive and the end row is
+     * inclusive.
+     */
     std::vector<RangeLocationInfo> *getMap();
 
   private:
     TablePtr m_user_table;
-    TablePtr m_meta_table;
     TableIdentifier m_table_id;
+    RangeLocatorPtr m_range_locator;
     ClientPtr m_client;
   };
 }
 #endif
-
@@ -1,8 +1,18 @@
 #include "TableReader.h"
+#include <Hypertable/Lib/Key.h>
 #include <iostream>
 
+extern "C" {
+#include <poll.h>
+}
+
+namespace {
+  const int MAX_SCAN_RETRIES = 10;
+}
+
 namespace Mapreduce {
 TableReader::TableReader(HadoopPipes::MapContext& context)
+  : m_timestamp(0), m_cells_in_row(0), m_skip(0)
 {    
   const HadoopPipes::JobConf *job = context.getJobConf();
   std::string tableName = job->get("hypertable.table.name");
@@ -13,59 +23,100 @@ TableReader::TableReader(HadoopPipes::MapContext& context)
 
   m_table = m_client->open_table(tableName);
 
-  ScanSpecBuilder scan_spec_builder;
-
-  std::string start_row;
-  std::string end_row;
   std::string tablename;
+  std::string location;
 
   HadoopUtils::StringInStream stream(context.getInputSplit());
   HadoopUtils::deserializeString(tablename, stream);
-  HadoopUtils::deserializeString(start_row, stream);
-  HadoopUtils::deserializeString(end_row, stream);
-
-  scan_spec_builder.add_row_interval(start_row, true, end_row, true);
+  HadoopUtils::deserializeString(m_start_row, stream);
+  HadoopUtils::deserializeString(m_end_row, stream);
+  HadoopUtils::deserializeString(location, stream);
+  m_timestamp = HadoopUtils::deserializeLong(stream);
 
   if (allColumns == false) {
-    std::vector<std::string> columns;
     using namespace boost::algorithm;
     
-    split(columns, job->get("hypertable.table.columns"), is_any_of(", "));
-    BOOST_FOREACH(const std::string &c, columns) {
-      scan_spec_builder.add_column(c);
-    }
+    split(m_columns, job->get("hypertable.table.columns"), is_any_of(", "));
   }
-  m_scanner = m_table->create_scanner(scan_spec_builder.get());
+  create_scanner();
 }
 
 TableReader::~TableReader()
 {
 }
 
+/*
+ * The split's start row belongs to the preceding range, so it is excluded.
+ * An empty end row marks the last range of the table.
+ * When resuming, the scan restarts at (and includes) the last row seen.
+ */
+void TableReader::create_scanner()
+{
+  ScanSpecBuilder scan_spec_builder;
+  std::string end_row = m_end_row.empty() ? Key::END_ROW_MARKER : m_end_row;
+
+  if (m_last_row.empty())
+    scan_spec_builder.add_row_interval(m_start_row, false, end_row, true);
+  else
+    scan_spec_builder.add_row_interval(m_last_row, true, end_row, true);
+
+  BOOST_FOREACH(const std::string &c, m_columns) {
+    if (!c.empty())
+      scan_spec_builder.add_column(c);
+  }
+
+  scan_spec_builder.set_time_interval(0, m_timestamp);
+
+  m_scanner = m_table->create_scanner(scan_spec_builder.get());
+}
+
 bool TableReader::next(std::string& key, std::string& value) {
   Cell cell;
+  int retries = 0;
 
-  if (m_scanner->next(cell)) {
-    std::string key_composition;
+  for (;;) {
+    try {
+      if (!m_scanner->next(cell))
+        return false;
+    }
+    catch (Exception &e) {
+      if (++retries > MAX_SCAN_RETRIES)
+        throw;
+      std::cerr << "Scan of " << m_start_row << ".." << m_end_row
+                << " failed (" << e.what() << "), resuming at row '"
+                << m_last_row << "'" << std::endl;
+      m_scanner = 0;
+      poll(0, 0, 1000);
+      create_scanner();
+      m_skip += m_cells_in_row;
+      m_cells_in_row = 0;
+      continue;
+    }
 
-    key_composition = cell.row_key;
-    key_composition.append(":");
-    key_composition.append(cell.column_family);
-    key_composition.append(":");
-    key_composition.append(cell.column_qualifier);
+    if (m_skip > 0) {
+      m_skip--;
+      m_cells_in_row++;
+      continue;
+    }
+    break;
+  }
 
-    key = key_composition;
+  if (m_last_row != cell.row_key) {
+    m_last_row = cell.row_key;
+    m_cells_in_row = 0;
+  }
+  m_cells_in_row++;
 
-    char *s = new char[cell.value_len+1];
-    memcpy(s, cell.value, cell.value_len);
-    s[cell.value_len] = 0;
-    value = s;
-    delete s;
+  /* the cell points into the scanner's ScanBlock; copy it out only once */
+  key = cell.row_key;
+  key.append(":");
+  key.append(cell.column_family);
+  key.append(":");
+  key.append(cell.column_qualifier);
 
-    return true;
-  } else {
-    return false;
-  }
+  value.assign((const char *)cell.value, cell.value_len);
+
+  return true;
 }
 
 }
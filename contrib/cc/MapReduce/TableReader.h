@@ -10,15 +10,32 @@
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string.hpp>
 #include <string>
+#include <vector>
 
 namespace Mapreduce {
   using namespace Hypertable;
 
+  /**
+   * Reads the cells of one TableSplit.  Every task of a job scans as of the
+   * timestamp recorded in its split, so all tasks see the table at the same
+   * point in time.  If the scan fails part way through, for example because
+   * the range split or moved, the scanner is re-created at the last row
+   * returned and the cells of that row already handed out are skipped.
+   */
   class TableReader : public HadoopPipes::RecordReader {
   private:
     ClientPtr m_client;
     TablePtr m_table;
     TableScannerPtr m_scanner;
+    std::string m_start_row;
+    std::string m_end_row;
+    std::vector<std::string> m_columns;
+    int64_t m_timestamp;
+    std::string m_last_row;
+    size_t m_cells_in_row;
+    size_t m_skip;
+
+    void create_scanner();
 
   public:
     TableReader(HadoopPipes::MapContext& context);
@@ -30,4 +47,3 @@ namespace Mapreduce {
 }
 
 #endif
-
@@ -14,10 +14,113 @@
 #include <boost/python/module.hpp>
 #include <boost/python/borrowed.hpp>
 #include <boost/python/def.hpp>
+#include <deque>
 
 using namespace boost::python;
 using Hypertable::ScanSpecBuilder;
 
+/**
+ * Releases the GIL for the lifetime of the object so other Python threads
+ * run while we block on the network.  No Python API may be used while one
+ * of these is in scope.
+ */
+class ScopedGILRelease {
+public:
+  ScopedGILRelease() : m_state(PyEval_SaveThread()) { }
+  ~ScopedGILRelease() { PyEval_RestoreThread(m_state); }
+
+private:
+  PyThreadState *m_state;
+};
+
+/**
+ * A batch of scanned cells packed into one immutable bytes object.  The
+ * row, qualifier and value of each cell are returned as memoryview slices
+ * of that object, so reading a batch costs one copy out of the ScanBlocks
+ * and one Python allocation, however many cells it holds.
+ */
+class CellBatch {
+private:
+  struct Entry {
+    uint32_t row_offset, row_len;
+    uint32_t qualifier_offset, qualifier_len;
+    uint32_t value_offset, value_len;
+    uint64_t timestamp;
+    const char *column_family;
+    uint8_t flag;
+  };
+
+  std::string m_buf;
+  std::vector<Entry> m_entries;
+  object m_data;
+
+  object view(uint32_t offset, uint32_t len) const
+  {
+    object mv(handle<>(PyMemoryView_FromObject(m_data.ptr())));
+    return mv.slice(offset, offset + len);
+  }
+
+  uint32_t append(const void *data, size_t len)
+  {
+    uint32_t offset = m_buf.size();
+    m_buf.append((const char *)data, len);
+    return offset;
+  }
+
+public:
+  CellBatch() {}
+
+  /**
+   * Appends a cell; called without the GIL.  The column family name points
+   * into the table schema, which outlives the batch.
+   */
+  void add(const Hypertable::Cell &cell)
+  {
+    Entry e;
+    e.row_len = cell.row_key_len ? cell.row_key_len : strlen(cell.row_key);
+    e.row_offset = append(cell.row_key, e.row_len);
+    e.qualifier_len = cell.column_qualifier ? strlen(cell.column_qualifier) : 0;
+    e.qualifier_offset = append(cell.column_qualifier, e.qualifier_len);
+    e.value_len = cell.value_len;
+    e.value_offset = append(cell.value, cell.value_len);
+    e.timestamp = cell.timestamp;
+    e.column_family = cell.column_family;
+    e.flag = cell.flag;
+    m_entries.push_back(e);
+  }
+
+  size_t memory_used() const { return m_buf.size(); }
+
+  /** Moves the packed cells into a Python bytes object; needs the GIL */
+  void seal()
+  {
+    m_data = object(handle<>(PyBytes_FromStringAndSize(m_buf.data(), m_buf.size())));
+    std::string().swap(m_buf);
+  }
+
+  size_t size() const { return m_entries.size(); }
+
+  /** Returns (row, column_family, column_qualifier, timestamp, value, flag) */
+  tuple get(long i) const
+  {
+    if (i < 0)
+      i += (long)m_entries.size();
+    if (i < 0 || i >= (long)m_entries.size()) {
+      PyErr_SetString(PyExc_IndexError, "cell index out of range");
+      throw_error_already_set();
+    }
+    const Entry &e = m_entries[i];
+    object cf = e.column_family ? object(std::string(e.column_family)) : object();
+    return make_tuple(view(e.row_offset, e.row_len), cf,
+                      view(e.qualifier_offset, e.qualifier_len),
+                      e.timestamp, view(e.value_offset, e.value_len),
+                      (int)e.flag);
+  }
+
+  /** Returns the whole packed buffer */
+  object data() const { return m_data; }
+};
+
 class TableScanner {
 private:
   Hypertable::TableScannerPtr m_scanner;
@@ -32,6 +135,27 @@ public:
   {
     return m_scanner->next(cell);
   }  
+
+  /**
+   * Fetches up to max_cells cells, stopping early once max_bytes of cell
+   * data have been collected (0 means no byte limit).  The GIL is released
+   * while the scanner runs.  An empty batch means the scan is done.
+   */
+  CellBatch next_batch(unsigned int max_cells, unsigned int max_bytes)
+  {
+    CellBatch batch;
+    {
+      ScopedGILRelease nogil;
+      Hypertable::Cell cell;
+
+      while (batch.size() < max_cells &&
+             (max_bytes == 0 || batch.memory_used() < max_bytes) &&
+             m_scanner->next(cell))
+        batch.add(cell);
+    }
+    batch.seal();
+    return batch;
+  }
 };
 
 class KeySpec {
@@ -78,7 +202,100 @@ public:
     m_mutator->set(k.compile(), val, value_len);
   }
 
-  void flush() { m_mutator->flush(); }
+  /**
+   * Inserts a list of (row, column_family, column_qualifier, value
+   * [, timestamp]) tuples in one call.  Bytes objects are used in place;
+   * other strings and buffers are copied once.  The batch is sorted and
+   * sent with the GIL released.
+   */
+  void set_cells(list cells)
+  {
+    std::vector<Hypertable::Cell> batch;
+    std::deque<std::string> storage;
+    long n = len(cells);
+
+    batch.reserve(n);
+    for (long i = 0; i < n; i++) {
+      object item = cells[i];
+      long fields = len(item);
+      Hypertable::Cell cell;
+      size_t length;
+
+      if (fields != 4 && fields != 5) {
+        PyErr_SetString(PyExc_ValueError, "cell must be (row, column_family, column_qualifier, value[, timestamp])");
+        throw_error_already_set();
+      }
+      cell.row_key = get_bytes(item[0], &length, storage);
+      cell.row_key_len = length;
+      cell.column_family = get_bytes(item[1], &length, storage);
+      cell.column_qualifier = get_bytes(item[2], &length, storage);
+      if (length == 0)
+        cell.column_qualifier = 0;
+      cell.value = (const uint8_t *)get_bytes(item[3], &length, storage);
+      cell.value_len = length;
+      if (fields == 5)
+        cell.timestamp = extract<uint64_t>(item[4]);
+      batch.push_back(cell);
+    }
+
+    ScopedGILRelease nogil;
+    m_mutator->set_cells(batch);
+  }
+
+  /**
+   * Inserts a buffer of pre-serialized key/value pairs, in the format
+   * taken by Hypertable::TableMutator::set_cells(const uint8_t *, size_t),
+   * with the GIL released.
+   */
+  void set_serialized(object buf)
+  {
+    Py_buffer view;
+
+    if (PyObject_GetBuffer(buf.ptr(), &view, PyBUF_SIMPLE) != 0)
+      throw_error_already_set();
+
+    try {
+      ScopedGILRelease nogil;
+      m_mutator->set_cells((const uint8_t *)view.buf, view.len);
+    }
+    catch (...) {
+      PyBuffer_Release(&view);
+      throw;
+    }
+    PyBuffer_Release(&view);
+  }
+
+  void flush()
+  {
+    ScopedGILRelease nogil;
+    m_mutator->flush();
+  }
+
+private:
+
+  /**
+   * Returns a NUL-terminated pointer to the bytes of obj.  Bytes objects
+   * are referenced in place (the caller's list keeps them alive); anything
+   * else is converted and kept in storage.
+   */
+  static const char *get_bytes(object obj, size_t *lenp, std::deque<std::string> &storage)
+  {
+    if (PyBytes_Check(obj.ptr())) {
+      *lenp = PyBytes_GET_SIZE(obj.ptr());
+      return PyBytes_AS_STRING(obj.ptr());
+    }
+    if (PyObject_CheckBuffer(obj.ptr()) && !PyUnicode_Check(obj.ptr())) {
+      Py_buffer view;
+      if (PyObject_GetBuffer(obj.ptr(), &view, PyBUF_SIMPLE) != 0)
+        throw_error_already_set();
+      storage.push_back(std::string((const char *)view.buf, view.len));
+      PyBuffer_Release(&view);
+    }
+    else
+      storage.push_back(extract<std::string>(obj));
+    *lenp = storage.back().size();
+    return storage.back().c_str();
+  }
 };
 
 class Table {
@@ -104,7 +321,7 @@ public:
     extract<ScanSpecBuilder&> ex(pyspec);
 
     ScanSpecBuilder& spec = ex();
-    return TableScanner(m_table_ptr->create_scanner(spec, 10));
+    return TableScanner(m_table_ptr->create_scanner(spec.get(), 10));
   }
 };
 
@@ -156,14 +373,24 @@ BOOST_PYTHON_MODULE(ht)
 
   class_<TableMutator>("TableMutator", "Table Mutator class")
     .def("set", &TableMutator::set)
+    .def("set_cells", &TableMutator::set_cells)
+    .def("set_serialized", &TableMutator::set_serialized)
     .def("flush", &TableMutator::flush)
     ;
 
   class_<TableScanner>("TableScanner")
     .def("next", &TableScanner::next)
+    .def("next_batch", &TableScanner::next_batch,
+         (arg("max_cells") = 1024, arg("max_bytes") = 0))
+    ;
+
+  class_<CellBatch>("CellBatch", "Batch of scanned cells")
+    .def("__len__", &CellBatch::size)
+    .def("__getitem__", &CellBatch::get)
+    .def("data", &CellBatch::data)
     ;
     
-  class_<ScanSpecBuilder>("ScanSpecBuilder", "scan spec docstring")
+  class_<ScanSpecBuilder, boost::noncopyable>("ScanSpecBuilder", "scan spec docstring")
     .def("add_row_interval", &ScanSpecBuilder::add_row_interval)
     .def("add_column", &ScanSpecBuilder::add_column)
     .def("clear", &ScanSpecBuilder::clear)
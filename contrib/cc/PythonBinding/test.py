@@ -24,6 +24,15 @@ table = client.open_table("dummy4")
   # you get single cell.value() function returning the value from the cell
   #print "%s:%s %s" % (cell.row_key, cell.column_family, cell.value())
 
+# or fetch cells in batches; row, qualifier and value are memoryviews into
+# one buffer per batch
+#while True:
+  #batch = scanner.next_batch(4096)
+  #if len(batch) == 0:
+    #break
+  #for (row, family, qualifier, timestamp, value, flag) in batch:
+    #print "%s:%s %d bytes" % (row.tobytes(), family, len(value))
+
 
 # create table mutator
 
@@ -44,3 +53,15 @@ while i < k+1 :
 
 mutator.flush()
 
+# the same, one call per 1000 cells with the GIL released while sending
+batch = []
+for i in range(1, k+1):
+  batch.append(("row-%s" % (i), families[1], "", 'b' * 10 * 1024))
+  if len(batch) == 1000:
+    mutator.set_cells(batch)
+    batch = []
+if batch:
+  mutator.set_cells(batch)
+
+mutator.flush()
+
@@ -58,6 +58,14 @@ public class TableInputFormat implements InputFormat<Text, MapWritable>, JobConf
       throw new IOException("No input split could be created.");
     }
     
+    /*
+      Every split scans as of the same timestamp (nanoseconds since the
+      epoch) so the job sees one consistent snapshot of the table.  Set
+      hypertable.table.timestamp to rerun a job against an earlier snapshot.
+    */
+    long timestamp = job.getLong("hypertable.table.timestamp",
+                                 System.currentTimeMillis() * 1000000L);
+
     InputSplit[] splits = new InputSplit[rangeVector.length/3];
     
     for (int i = 0; i < (rangeVector.length); i+=3) {
@@ -65,9 +73,11 @@ public class TableInputFormat implements InputFormat<Text, MapWritable>, JobConf
       Text end = new Text(rangeVector[i+1]);
       
       int u = rangeVector[i+2].indexOf("_");
-      Text location = new Text(rangeVector[i+2].substring(0,u));
+      Text location = new Text(u < 0 ? rangeVector[i+2]
+                                     : rangeVector[i+2].substring(0,u));
       
-      splits[i] = new TableSplit(m_tableName, start, end, location);
+      splits[i/3] = new TableSplit(m_tableName, start, end, location,
+                                   timestamp);
     }
 
     return splits;
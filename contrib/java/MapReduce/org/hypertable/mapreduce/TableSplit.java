@@ -5,6 +5,7 @@ import java.io.DataOutput;
 import java.io.IOException;
 
 import org.apache.hadoop.io.Text;
+import org.apache.hadoop.io.WritableUtils;
 import org.apache.hadoop.mapred.InputSplit;
 
 public class TableSplit implements InputSplit {
@@ -12,6 +13,7 @@ public class TableSplit implements InputSplit {
   private Text m_startRow;
   private Text m_endRow;
   private Text m_location;
+  private long m_timestamp;
   
   public TableSplit()
   {
@@ -19,14 +21,17 @@ public class TableSplit implements InputSplit {
     m_startRow = new Text();
     m_endRow = new Text();
     m_location = new Text();
+    m_timestamp = 0;
   }
   
-  public TableSplit(Text tableName, Text startRow, Text endRow, Text location) {
+  public TableSplit(Text tableName, Text startRow, Text endRow, Text location,
+                    long timestamp) {
     this();
     m_location.set(location);
     m_tableName.set(tableName);
     m_startRow.set(startRow);
     m_endRow.set(endRow);
+    m_timestamp = timestamp;
   }
   
   public Text getTableName() {
@@ -48,24 +53,37 @@ public class TableSplit implements InputSplit {
   public Text getLocation() {
     return m_location;
   }
+
+  /**
+   * Returns the scan timestamp shared by every split of the job.  Readers
+   * only return cells written at or before this time.
+   */
+  public long getTimestamp() {
+    return m_timestamp;
+  }
   
   public void readFields(DataInput in) throws IOException {
     m_tableName.readFields(in);
     m_startRow.readFields(in);
     m_endRow.readFields(in);
+    m_location.readFields(in);
+    m_timestamp = WritableUtils.readVLong(in);
   }
   
   public String[] getLocations() {
-    return new String[] { };
+    return new String[] { m_location.toString() };
   }
   public void write(DataOutput out) throws IOException {
     m_tableName.write(out);
     m_startRow.write(out);
     m_endRow.write(out);
+    m_location.write(out);
+    WritableUtils.writeVLong(out, m_timestamp);
   }
 
   @Override
   public String toString() {
-    return m_tableName +"," + m_startRow + "," + m_endRow;
+    return m_tableName +"," + m_startRow + "," + m_endRow + "," + m_location
+        + "," + m_timestamp;
   }
 }
@@ -63,6 +63,14 @@ namespace Hypertable {
      */
     uint64_t get_thread_group() { return (m_event_ptr) ? m_event_ptr->thread_group : 0; }
 
+    /** Returns the trace ID of the request, or 0 if it is not traced (see
+     * Event#trace_id).
+     */
+    uint64_t get_trace_id() { return (m_event_ptr) ? m_event_ptr->trace_id : 0; }
+
+    /** Returns the event object that generated the request */
+    EventPtr &get_event() { return m_event_ptr; }
+
   protected:
     EventPtr m_event_ptr;
   };
@@ -33,8 +33,10 @@
 #include "Common/HashMap.h"
 #include "Common/ReferenceCount.h"
 #include "Common/StringExt.h"
+#include "Common/Trace.h"
 
 #include "ApplicationHandler.h"
+#include "Header.h"
 
 namespace Hypertable {
 
@@ -56,10 +58,16 @@ namespace Hypertable {
 
     class WorkRec {
     public:
-      WorkRec(ApplicationHandler *ah) : handler(ah), usage(0) { return; }
+      WorkRec(ApplicationHandler *ah) : handler(ah), usage(0),
+          trace_id(ah->get_trace_id()) {
+        if (trace_id)
+          boost::xtime_get(&enqueue_time, boost::TIME_UTC);
+      }
       ~WorkRec() { delete handler; }
       ApplicationHandler   *handler;
       UsageRec             *usage;
+      uint64_t              trace_id;
+      boost::xtime          enqueue_time;
     };
 
     class ApplicationQueueState {
@@ -120,7 +128,10 @@ namespace Hypertable {
           }
 
           if (rec) {
-            rec->handler->run();
+            if (rec->trace_id)
+              run_traced(rec);
+            else
+              rec->handler->run();
             if (rec->usage) {
               boost::mutex::scoped_lock ulock(m_state.usage_mutex);
               rec->usage->running = false;
@@ -138,6 +149,26 @@ namespace Hypertable {
       }
 
     private:
+
+      /**
+       * Runs the request under its trace ID, recording how long it
+       * waited in the queue and how long the handler took.
+       */
+      void run_traced(WorkRec *rec) {
+        Trace::Scope scope(rec->trace_id);
+        Event *event = rec->handler->get_event().get();
+        String name = (event->header->protocol < Header::PROTOCOL_MAX)
+            ? Header::protocol_strs[event->header->protocol] : "unknown";
+        if (event->message_len >= 2)
+          name += format(" command=%d",
+                         (int)(event->message[0] | (event->message[1] << 8)));
+        Trace::record((name + " queued").c_str(), rec->enqueue_time);
+        {
+          Trace::Span span(name.c_str());
+          rec->handler->run();
+        }
+      }
+
       ApplicationQueueState &m_state;
     };
 
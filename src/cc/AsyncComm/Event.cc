@@ -56,6 +56,8 @@ namespace Hypertable {
       dstr += (String)" gid=" + (int)header->gid;
       dstr += (String)" header_len=" + (int)header->header_len;
       dstr += (String)" total_len=" + (int)header->total_len;
+      if (trace_id)
+        dstr += format(" trace_id=%016llx", (Llu)trace_id);
     }
     else if (type == TIMER)
       dstr += "TIMER";
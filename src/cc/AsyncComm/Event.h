@@ -66,6 +66,7 @@ namespace Hypertable {
       if (h != 0) {
         message = ((uint8_t *)header) + header->header_len;
         message_len = header->total_len - header->header_len;
+        trace_id = Header::trace_id(header);
         if (header->gid != 0)
           thread_group = ((uint64_t)conn_id << 32) | header->gid;
         else
@@ -75,6 +76,7 @@ namespace Hypertable {
         message = 0;
         message_len = 0;
         thread_group = 0;
+        trace_id = 0;
       }
     }
 
@@ -89,6 +91,7 @@ namespace Hypertable {
       message_len = 0;
       thread_group = 0;
       conn_id = 0;
+      trace_id = 0;
     }
 
     /** Destroys event.  Deallocates message data
@@ -135,6 +138,11 @@ namespace Hypertable {
      */
     uint64_t thread_group;
 
+    /** Trace ID carried in the message header, or 0 if the message is not
+     * part of a trace (see Trace).
+     */
+    uint64_t trace_id;
+
     /** Generates a one-line string representation of the event.  For example:
      * <pre>
      *   Event: type=MESSAGE protocol=hyperspace id=2 gid=0 header_len=16 total_len=20 from=127.0.0.1:38040
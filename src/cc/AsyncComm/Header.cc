@@ -20,6 +20,8 @@
  */
 
 #include "Common/Compat.h"
+#include "Common/Serialization.h"
+
 #include "Header.h"
 
 namespace Hypertable {
@@ -30,5 +32,10 @@ namespace Hypertable {
     "hypertable master",
     "hypertable range server"
   };
+
+  uint64_t Header::decode_trace_id(const uint8_t *ptr) {
+    size_t remaining = TRACE_ID_LENGTH;
+    return Serialization::decode_i64(&ptr, &remaining);
+  }
 }
 
@@ -39,9 +39,14 @@ namespace Hypertable {
 
     static const uint8_t FLAGS_BIT_REQUEST          = 0x01;
     static const uint8_t FLAGS_BIT_IGNORE_RESPONSE  = 0x02;
+    static const uint8_t FLAGS_BIT_TRACE            = 0x04;
 
     static const uint8_t FLAGS_MASK_REQUEST         = 0xFE;
     static const uint8_t FLAGS_MASK_IGNORE_RESPONSE = 0xFD;
+    static const uint8_t FLAGS_MASK_TRACE           = 0xFB;
+
+    /** Length of the trace ID that follows Common when FLAGS_BIT_TRACE is set */
+    static const uint8_t TRACE_ID_LENGTH            = 8;
 
     static const char *protocol_strs[PROTOCOL_MAX];
 
@@ -58,6 +63,19 @@ namespace Hypertable {
       uint32_t  total_len;
     } __attribute__((packed));
 
+    /**
+     * Returns the trace ID carried in the given header, or 0 if the
+     * message is not part of a trace.
+     */
+    static uint64_t trace_id(const Common *header) {
+      if ((header->flags & FLAGS_BIT_TRACE) == 0 ||
+          header->header_len < sizeof(Common) + TRACE_ID_LENGTH)
+        return 0;
+      return decode_trace_id((const uint8_t *)header + sizeof(Common));
+    }
+
+  private:
+    static uint64_t decode_trace_id(const uint8_t *ptr);
   };
 
 }
@@ -20,6 +20,8 @@
  */
 
 #include "Common/Compat.h"
+#include "Common/Serialization.h"
+
 #include "HeaderBuilder.h"
 
 namespace Hypertable {
@@ -29,12 +31,16 @@ namespace Hypertable {
     mheader = (Header::Common *)*bufp;
     mheader->version = Header::VERSION;
     mheader->protocol = m_protocol;
-    mheader->flags = m_flags;
-    mheader->header_len = sizeof(Header::Common);
+    mheader->flags = m_flags & Header::FLAGS_MASK_TRACE;
+    mheader->header_len = header_length();
     mheader->id = m_id;
     mheader->gid = m_group_id;
     mheader->total_len = m_total_len;
     (*bufp) += sizeof(Header::Common);
+    if (m_trace_id) {
+      mheader->flags |= Header::FLAGS_BIT_TRACE;
+      Serialization::encode_i64(bufp, m_trace_id);
+    }
   }
 
 }
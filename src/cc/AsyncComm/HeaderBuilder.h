@@ -25,6 +25,7 @@
 #include <iostream>
 
 #include "Common/atomic.h"
+#include "Common/Trace.h"
 
 #include "Header.h"
 
@@ -44,14 +45,17 @@ namespace Hypertable {
 
   public:
 
-    /** Constructor.  Initializes all members to 0.
+    /** Constructor.  Initializes all members to 0, except the trace ID
+     * which is taken from the calling thread (see Trace#current_id).
      */
-    HeaderBuilder() : m_id(0), m_group_id(0), m_total_len(0), m_protocol(0), m_flags(0) {
+    HeaderBuilder() : m_id(0), m_group_id(0), m_total_len(0), m_protocol(0), m_flags(0),
+                      m_trace_id(Trace::current_id()) {
       return;
     }
 
     /** Constructor.  Initializes the m_protocol and m_group_id members with the
-     * supplied arguments, all other members are set to 0.
+     * supplied arguments and the trace ID with the calling thread's trace ID,
+     * all other members are set to 0.
      *
      * @param protocol application protocol, can be one of PROTOCOL_NONE, PROTOCOL_DFSBROKER,
      *                 PROTOCOL_HYPERSPACE, PROTOCOL_HYPERTABLE_MASTER,
@@ -59,12 +63,13 @@ namespace Hypertable {
      * @param gid the group ID.  If the server is using an ApplicationQueue, then request
      *            messages with the same group ID will get carried out in series
      */
-    HeaderBuilder(uint8_t protocol, uint32_t gid=0) : m_id(0), m_group_id(gid), m_total_len(0), m_protocol(protocol), m_flags(0) {
+    HeaderBuilder(uint8_t protocol, uint32_t gid=0) : m_id(0), m_group_id(gid), m_total_len(0), m_protocol(protocol), m_flags(0),
+                                                      m_trace_id(Trace::current_id()) {
       return;
     }
 
     /** This method is used to initialize a response header from a give request header.  It
-     * pulls the ID, the group ID, and the flags from the given request header.
+     * pulls the ID, the group ID, the flags and the trace ID from the given request header.
      *
      * @param header pointer to the request message header
      */
@@ -74,10 +79,13 @@ namespace Hypertable {
       m_protocol  = header->protocol;
       m_flags     = header->flags;
       m_total_len = 0;
+      m_trace_id  = Header::trace_id(header);
     }
 
     /** Returns the length of the header that would be generated */
-    size_t header_length() { return sizeof(Header::Common); }
+    size_t header_length() {
+      return sizeof(Header::Common) + (m_trace_id ? Header::TRACE_ID_LENGTH : 0);
+    }
 
     /** Encodes the header to the given buffer.  Advances the buffer pointer by the
      * length of the header written.
@@ -118,12 +126,20 @@ namespace Hypertable {
      */
     void set_total_len(uint32_t total_len) { m_total_len = total_len; }
 
+    /** Sets the trace ID of the message.  A value of 0 means the message is
+     * not traced.
+     *
+     * @param trace_id trace ID
+     */
+    void set_trace_id(uint64_t trace_id) { m_trace_id = trace_id; }
+
   protected:
     uint32_t  m_id;
     uint32_t  m_group_id;
     uint32_t  m_total_len;
     uint8_t   m_protocol;
     uint8_t   m_flags;
+    uint64_t  m_trace_id;
   };
 
 }
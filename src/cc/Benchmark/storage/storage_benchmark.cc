@@ -0,0 +1,560 @@
+/**
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Common/Compat.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AsyncComm/ConnectionManager.h"
+#include "AsyncComm/ReactorFactory.h"
+
+#include "Common/atomic.h"
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/Properties.h"
+#include "Common/Serialization.h"
+#include "Common/Stopwatch.h"
+#include "Common/String.h"
+#include "Common/System.h"
+#include "Common/Usage.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "Hypertable/Lib/BlockCompressionHeader.h"
+#include "Hypertable/Lib/CompressorFactory.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/ScanSpec.h"
+
+#include "Hypertable/RangeServer/CellCache.h"
+#include "Hypertable/RangeServer/CellStoreV0.h"
+#include "Hypertable/RangeServer/FileBlockCache.h"
+#include "Hypertable/RangeServer/Global.h"
+#include "Hypertable/RangeServer/MergeScanner.h"
+
+using namespace Hypertable;
+using namespace std;
+
+
+/**
+ * Allocation counting.  Every operator new in the process goes through
+ * here, so the figures include allocations made by library code (e.g. the
+ * std::map nodes of the CellCache), which is the point.
+ */
+namespace {
+  atomic_t g_allocations = ATOMIC_INIT(0);
+}
+
+void *operator new(size_t size) throw(std::bad_alloc) {
+  atomic_inc(&g_allocations);
+  void *ptr = malloc(size ? size : 1);
+  if (ptr == 0)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void *operator new[](size_t size) throw(std::bad_alloc) {
+  atomic_inc(&g_allocations);
+  void *ptr = malloc(size ? size : 1);
+  if (ptr == 0)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void *ptr) throw() { free(ptr); }
+
+void operator delete[](void *ptr) throw() { free(ptr); }
+
+
+namespace {
+  const char *usage[] = {
+    "usage: storage_benchmark [options]",
+    "",
+    "  options:",
+    "    --cells=<n>             Number of cells in the corpus (default: 500000)",
+    "    --columns=<n>           Cells per row (default: 4)",
+    "    --value-size=<n>        Size of generated values in bytes (default: 100)",
+    "    --value-file=<file>     Use the lines of <file> as values instead",
+    "    --merge-inputs=<n>      Number of inputs to MergeScanner (default: 8)",
+    "    --blocksize=<n>         CellStore / codec block size (default: 65536)",
+    "    --compressor=<spec>     CellStore compressor (default: lzo)",
+    "    --codecs=<list>         Comma separated codecs to benchmark",
+    "                            (default: none,bmz,zlib,lzo,quicklz)",
+    "    --tests=<list>          Comma separated subset of cellcache,cellstore,",
+    "                            merge,codec (default: all)",
+    "    --config=<file>         Config file naming the DFS broker (cellstore)",
+    "    --dir=<path>            DFS directory for the CellStore test",
+    "                            (default: /storage_benchmark)",
+    "    --seed=<n>              Random number generator seed",
+    "",
+    "  Measures the RangeServer storage engine in-process: CellCache inserts",
+    "  and scans, CellStoreV0 write and scan through the DFS broker named by",
+    "  the config file (start one with 'start-dfsbroker.sh local'), a",
+    "  MergeScanner over several CellCaches, and each block compression codec",
+    "  on blocks of the corpus.  For each, it reports cells/s, MB/s and heap",
+    "  allocations per cell.",
+    "",
+    (const char *)0
+  };
+
+  const char *DATA_BLOCK_MAGIC = "Benchmark-";
+
+  const char *words[] = {
+    "the", "of", "and", "to", "in", "is", "for", "on", "that", "by", "this",
+    "with", "you", "it", "not", "or", "be", "are", "from", "at", "as",
+    "your", "all", "have", "new", "more", "an", "was", "we", "will", "home",
+    "can", "us", "about", "if", "page", "my", "has", "search", "free",
+    "but", "our", "one", "other", "do", "no", "information", "time", "they",
+    "site", "he", "up", "may", "what", "which", "their", "news", "out",
+    "use", "any", "there", "see", "only", "so", "his", "when", "contact",
+    "here", "business", "who", "web", "also", "now", "help", "get", "pm",
+    "view", "online", "first", "am", "been", "would", "how", "were", "me",
+    "services", "some", "these", "click", "its", "like", "service", "than",
+    "find", "price", "date", "back", "top", "people", "had", "list", "name",
+    0
+  };
+
+  struct Options {
+    Options() : cells(500000), columns(4), value_size(100), merge_inputs(8),
+                blocksize(65536), compressor("lzo"),
+                codecs("none,bmz,zlib,lzo,quicklz"),
+                tests("cellcache,cellstore,merge,codec"),
+                dir("/storage_benchmark"), seed(1234) { }
+    size_t cells;
+    size_t columns;
+    size_t value_size;
+    String value_file;
+    size_t merge_inputs;
+    uint32_t blocksize;
+    String compressor;
+    String codecs;
+    String tests;
+    String config_file;
+    String dir;
+    unsigned long seed;
+  };
+
+  /**
+   * Serialized key/value pairs, in key order (row, then family, then
+   * qualifier).  Row keys look like reversed URLs so that adjacent keys
+   * share long prefixes, as in a web table.
+   */
+  struct Corpus {
+    Corpus() : buf(0), bytes(0) { }
+    DynamicBuffer buf;
+    std::vector<std::pair<ByteString, ByteString> > cells;
+    uint64_t bytes;
+  };
+
+  void split(const String &list, std::set<String> &items) {
+    size_t start = 0, comma;
+    while ((comma = list.find(',', start)) != String::npos) {
+      items.insert(list.substr(start, comma - start));
+      start = comma + 1;
+    }
+    items.insert(list.substr(start));
+  }
+
+  void generate_value(String &value, size_t size,
+                      const std::vector<String> &lines, size_t index) {
+    value.clear();
+    if (!lines.empty()) {
+      value = lines[index % lines.size()];
+      return;
+    }
+    while (value.length() < size) {
+      if (!value.empty())
+        value += ' ';
+      value += words[random() % (sizeof(words)/sizeof(char *) - 1)];
+    }
+    value.resize(size);
+  }
+
+  void build_corpus(const Options &opts, Corpus &corpus) {
+    std::vector<String> lines;
+    std::vector<std::pair<size_t, size_t> > offsets;
+    char row[64], qualifier[16];
+    String value;
+    uint8_t vbuf[8], *vptr;
+
+    if (opts.value_file != "") {
+      ifstream in(opts.value_file.c_str());
+      String line;
+      while (getline(in, line))
+        if (!line.empty())
+          lines.push_back(line);
+      if (lines.empty())
+        HT_THROWF(Error::FILE_NOT_FOUND, "No values in '%s'",
+                  opts.value_file.c_str());
+    }
+
+    srandom(opts.seed);
+
+    size_t rows = (opts.cells + opts.columns - 1) / opts.columns;
+    size_t n = 0;
+
+    // site numbers repeat, so sort the row keys as the table would
+    std::vector<String> row_keys;
+    row_keys.reserve(rows);
+    for (size_t r=0; r<rows; r++) {
+      sprintf(row, "com.site%05u.www/page/%08u",
+              (unsigned)(r % 997), (unsigned)r);
+      row_keys.push_back(row);
+    }
+    sort(row_keys.begin(), row_keys.end());
+
+    // columns are spread over three families; emit each family's run of
+    // qualifiers in turn so that keys within a row stay sorted
+    for (size_t r=0; r<rows && n<opts.cells; r++) {
+      for (uint8_t family=1; family<=3; family++) {
+        for (size_t c=family-1; c<opts.columns && n<opts.cells; c+=3, n++) {
+          sprintf(qualifier, "q%05u", (unsigned)c);
+          generate_value(value, opts.value_size, lines, n);
+
+          size_t key_offset = corpus.buf.fill();
+          create_key_and_append(corpus.buf, FLAG_INSERT, row_keys[r].c_str(),
+                                family, qualifier, (int64_t)(n + 1));
+          size_t value_offset = corpus.buf.fill();
+          vptr = vbuf;
+          Serialization::encode_vi32(&vptr, value.length());
+          corpus.buf.add(vbuf, vptr - vbuf);
+          corpus.buf.add(value.data(), value.length());
+          offsets.push_back(std::make_pair(key_offset, value_offset));
+        }
+      }
+    }
+
+    // the buffer may have moved while growing, so take pointers last
+    for (size_t i=0; i<offsets.size(); i++) {
+      ByteString key(corpus.buf.base + offsets[i].first);
+      ByteString value(corpus.buf.base + offsets[i].second);
+      corpus.cells.push_back(std::make_pair(key, value));
+    }
+    corpus.bytes = corpus.buf.fill();
+  }
+
+  /**
+   * Measures one benchmark phase: elapsed time and allocations between
+   * construction and #report.
+   */
+  class Measurement {
+  public:
+    Measurement() : m_allocations(atomic_read(&g_allocations)) { }
+
+    void report(const char *name, uint64_t cells, uint64_t bytes) {
+      m_stopwatch.stop();
+      uint32_t allocs = (uint32_t)(atomic_read(&g_allocations)
+                                   - m_allocations);
+      double elapsed = m_stopwatch.elapsed();
+      if (elapsed <= 0.0)
+        elapsed = 1e-9;
+      printf("%-24s %12.0f cells/s %10.2f MB/s %8.2f allocs/cell\n", name,
+             (double)cells / elapsed, (double)bytes / elapsed / 1000000.0,
+             cells ? (double)allocs / (double)cells : 0.0);
+      fflush(stdout);
+    }
+
+  private:
+    int m_allocations;
+    Stopwatch m_stopwatch;
+  };
+
+  uint64_t scan_all(CellListScanner *scanner) {
+    ByteString key, value;
+    uint64_t count = 0;
+    while (scanner->get(key, value)) {
+      count++;
+      scanner->forward();
+    }
+    return count;
+  }
+
+  void check_count(const char *name, uint64_t count, uint64_t expected) {
+    if (count != expected)
+      HT_ERRORF("%s returned %llu cells, expected %llu", name, (Llu)count,
+                (Llu)expected);
+  }
+
+  void benchmark_cellcache(const Options &opts, Corpus &corpus) {
+    std::vector<size_t> order(corpus.cells.size());
+    for (size_t i=0; i<order.size(); i++)
+      order[i] = i;
+    random_shuffle(order.begin(), order.end());
+
+    CellCachePtr cache = new CellCache();
+    {
+      Measurement m;
+      cache->lock();
+      for (size_t i=0; i<order.size(); i++)
+        cache->add(corpus.cells[order[i]].first,
+                   corpus.cells[order[i]].second, 0);
+      cache->unlock();
+      m.report("CellCache::add", order.size(), corpus.bytes);
+    }
+
+    {
+      ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME);
+      Measurement m;
+      CellListScanner *scanner = cache->create_scanner(scan_ctx);
+      uint64_t count = scan_all(scanner);
+      delete scanner;
+      m.report("CellCacheScanner", count, corpus.bytes);
+      check_count("CellCacheScanner", count, corpus.cells.size());
+    }
+  }
+
+  void benchmark_merge(const Options &opts, Corpus &corpus) {
+    std::vector<CellCachePtr> caches;
+
+    for (size_t i=0; i<opts.merge_inputs; i++)
+      caches.push_back(new CellCache());
+
+    for (size_t i=0; i<corpus.cells.size(); i++) {
+      CellCachePtr &cache = caches[random() % opts.merge_inputs];
+      cache->lock();
+      cache->add(corpus.cells[i].first, corpus.cells[i].second, 0);
+      cache->unlock();
+    }
+
+    ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME);
+    char name[64];
+    sprintf(name, "MergeScanner (%u inputs)", (unsigned)opts.merge_inputs);
+
+    Measurement m;
+    MergeScanner *mscanner = new MergeScanner(scan_ctx, false);
+    for (size_t i=0; i<caches.size(); i++)
+      mscanner->add_scanner(caches[i]->create_scanner(scan_ctx));
+    uint64_t count = scan_all(mscanner);
+    delete mscanner;
+    m.report(name, count, corpus.bytes);
+    check_count("MergeScanner", count, corpus.cells.size());
+  }
+
+  void benchmark_cellstore(const Options &opts, Corpus &corpus) {
+    ConnectionManagerPtr conn_mgr = new ConnectionManager();
+    String cfgfile = opts.config_file;
+    int error;
+
+    if (cfgfile == "")
+      cfgfile = System::install_dir + "/conf/hypertable.cfg";
+
+    PropertiesPtr props_ptr = new Properties(cfgfile);
+    DfsBroker::Client *client = new DfsBroker::Client(conn_mgr, props_ptr);
+
+    if (!client->wait_for_connection(15)) {
+      cout << "CellStoreV0: skipped, timed out waiting for DFS broker" << endl;
+      return;
+    }
+
+    Global::block_cache = new FileBlockCache(200000000LL);
+
+    String fname = opts.dir + "/cs0";
+    client->mkdirs(opts.dir);
+
+    {
+      CellStoreV0Ptr cellstore = new CellStoreV0(client);
+      Timestamp timestamp(corpus.cells.size(), 0);
+      Measurement m;
+      if ((error = cellstore->create(fname.c_str(), opts.blocksize,
+                                     opts.compressor)) != Error::OK)
+        HT_THROWF(Error::FAILED_EXPECTATION,
+                  "Problem creating cell store '%s' (error=%d)",
+                  fname.c_str(), error);
+      for (size_t i=0; i<corpus.cells.size(); i++)
+        cellstore->add(corpus.cells[i].first, corpus.cells[i].second, 0);
+      if ((error = cellstore->finalize(timestamp)) != Error::OK)
+        HT_THROWF(Error::FAILED_EXPECTATION,
+                  "Problem finalizing cell store '%s' (error=%d)",
+                  fname.c_str(), error);
+      m.report("CellStoreV0 write", corpus.cells.size(), corpus.bytes);
+    }
+
+    {
+      CellStoreV0Ptr cellstore = new CellStoreV0(client);
+      ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME);
+      Measurement m;
+      if ((error = cellstore->open(fname.c_str(), 0, 0)) != Error::OK ||
+          (error = cellstore->load_index()) != Error::OK)
+        HT_THROWF(Error::FAILED_EXPECTATION,
+                  "Problem opening cell store '%s' (error=%d)",
+                  fname.c_str(), error);
+      CellListScanner *scanner = cellstore->create_scanner(scan_ctx);
+      uint64_t count = scan_all(scanner);
+      delete scanner;
+      m.report("CellStoreV0 scan", count, corpus.bytes);
+      check_count("CellStoreV0 scan", count, corpus.cells.size());
+    }
+
+    client->rmdir(opts.dir);
+  }
+
+  void benchmark_codecs(const Options &opts, Corpus &corpus) {
+    std::set<String> codecs;
+    std::vector<DynamicBuffer *> blocks;
+    std::vector<uint64_t> block_cells;
+
+    split(opts.codecs, codecs);
+
+    // cut the corpus into blocks the way CellStoreV0 does
+    for (size_t i=0; i<corpus.cells.size(); ) {
+      DynamicBuffer *block = new DynamicBuffer(opts.blocksize + 4096);
+      uint64_t cells = 0;
+      while (i < corpus.cells.size() && block->fill() < opts.blocksize) {
+        size_t klen = corpus.cells[i].first.length();
+        size_t vlen = corpus.cells[i].second.length();
+        block->add(corpus.cells[i].first.ptr, klen);
+        block->add(corpus.cells[i].second.ptr, vlen);
+        cells++;
+        i++;
+      }
+      blocks.push_back(block);
+      block_cells.push_back(cells);
+    }
+
+    for (std::set<String>::iterator iter = codecs.begin();
+         iter != codecs.end(); ++iter) {
+      BlockCompressionCodec::Args args;
+      BlockCompressionCodec::Type type =
+          CompressorFactory::parse_block_codec_spec(*iter, args);
+      BlockCompressionCodecPtr codec =
+          CompressorFactory::create_block_codec(type, args);
+      std::vector<DynamicBuffer *> zblocks;
+      std::vector<BlockCompressionHeader *> headers;
+      uint64_t zbytes = 0;
+      char name[64];
+
+      {
+        Measurement m;
+        for (size_t i=0; i<blocks.size(); i++) {
+          BlockCompressionHeader *header =
+              new BlockCompressionHeader(DATA_BLOCK_MAGIC);
+          DynamicBuffer *zblock = new DynamicBuffer(0);
+          codec->deflate(*blocks[i], *zblock, *header);
+          zbytes += zblock->fill();
+          zblocks.push_back(zblock);
+          headers.push_back(header);
+        }
+        sprintf(name, "%s deflate", iter->c_str());
+        m.report(name, corpus.cells.size(), corpus.bytes);
+      }
+
+      {
+        DynamicBuffer output(opts.blocksize + 4096);
+        Measurement m;
+        for (size_t i=0; i<zblocks.size(); i++) {
+          codec->inflate(*zblocks[i], output, *headers[i]);
+          if (output.fill() != blocks[i]->fill())
+            HT_ERRORF("%s inflated block %u to %u bytes, expected %u",
+                      iter->c_str(), (unsigned)i, (unsigned)output.fill(),
+                      (unsigned)blocks[i]->fill());
+        }
+        sprintf(name, "%s inflate", iter->c_str());
+        m.report(name, corpus.cells.size(), corpus.bytes);
+      }
+
+      printf("%-24s %12.3f\n", (*iter + " ratio").c_str(),
+             (double)zbytes / (double)corpus.bytes);
+
+      for (size_t i=0; i<zblocks.size(); i++) {
+        delete zblocks[i];
+        delete headers[i];
+      }
+    }
+
+    for (size_t i=0; i<blocks.size(); i++)
+      delete blocks[i];
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  Options opts;
+  std::set<String> tests;
+  Corpus corpus;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--cells=", 8))
+      opts.cells = strtoll(&argv[i][8], 0, 0);
+    else if (!strncmp(argv[i], "--columns=", 10))
+      opts.columns = atoi(&argv[i][10]);
+    else if (!strncmp(argv[i], "--value-size=", 13))
+      opts.value_size = atoi(&argv[i][13]);
+    else if (!strncmp(argv[i], "--value-file=", 13))
+      opts.value_file = &argv[i][13];
+    else if (!strncmp(argv[i], "--merge-inputs=", 15))
+      opts.merge_inputs = atoi(&argv[i][15]);
+    else if (!strncmp(argv[i], "--blocksize=", 12))
+      opts.blocksize = atoi(&argv[i][12]);
+    else if (!strncmp(argv[i], "--compressor=", 13))
+      opts.compressor = &argv[i][13];
+    else if (!strncmp(argv[i], "--codecs=", 9))
+      opts.codecs = &argv[i][9];
+    else if (!strncmp(argv[i], "--tests=", 8))
+      opts.tests = &argv[i][8];
+    else if (!strncmp(argv[i], "--config=", 9))
+      opts.config_file = &argv[i][9];
+    else if (!strncmp(argv[i], "--dir=", 6))
+      opts.dir = &argv[i][6];
+    else if (!strncmp(argv[i], "--seed=", 7))
+      opts.seed = atoi(&argv[i][7]);
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  if (opts.cells == 0 || opts.columns == 0 || opts.merge_inputs == 0 ||
+      opts.blocksize == 0)
+    Usage::dump_and_exit(usage);
+
+  split(opts.tests, tests);
+
+  ReactorFactory::initialize(1);
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  try {
+    build_corpus(opts, corpus);
+
+    printf("Corpus: %llu cells, %llu bytes\n\n",
+           (Llu)corpus.cells.size(), (Llu)corpus.bytes);
+
+    if (tests.count("cellcache"))
+      benchmark_cellcache(opts, corpus);
+    if (tests.count("merge"))
+      benchmark_merge(opts, corpus);
+    if (tests.count("cellstore"))
+      benchmark_cellstore(opts, corpus);
+    if (tests.count("codec"))
+      benchmark_codecs(opts, corpus);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
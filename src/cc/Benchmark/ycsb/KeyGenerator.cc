@@ -0,0 +1,127 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Common/Compat.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include "Common/String.h"
+
+#include "KeyGenerator.h"
+
+using namespace Hypertable;
+
+const double KeyGenerator::ZIPFIAN_CONSTANT = 0.99;
+
+namespace {
+
+  /** 64-bit FNV-1a hash of the record number, used to scatter hot keys */
+  uint64_t fnv_hash64(uint64_t val) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int i=0; i<8; i++) {
+      hash ^= val & 0xff;
+      hash *= 1099511628211LL;
+      val >>= 8;
+    }
+    return hash;
+  }
+
+}
+
+
+KeyGenerator::KeyGenerator(Distribution dist, uint64_t item_count, double zeta)
+  : m_dist(dist), m_items(item_count ? item_count : 1), m_zetan(zeta) {
+  double theta = ZIPFIAN_CONSTANT;
+  double zeta2 = 1.0 + pow(0.5, theta);
+
+  m_alpha = 1.0 / (1.0 - theta);
+  m_eta = (1.0 - pow(2.0 / (double)m_items, 1.0 - theta))
+      / (1.0 - zeta2 / m_zetan);
+  m_half_pow_theta = zeta2;
+}
+
+
+double KeyGenerator::zeta(uint64_t n, double theta) {
+  double sum = 0.0;
+  for (uint64_t i=0; i<n; i++)
+    sum += 1.0 / pow((double)(i+1), theta);
+  return sum;
+}
+
+
+/**
+ * Zipfian generator of Gray et al., "Quickly Generating Billion-Record
+ * Synthetic Databases", SIGMOD 1994.  Returns 0 most often.
+ */
+uint64_t KeyGenerator::next_zipfian(Random64 &rng) {
+  double u = rng.next_double();
+  double uz = u * m_zetan;
+
+  if (uz < 1.0)
+    return 0;
+
+  if (uz < m_half_pow_theta)
+    return 1;
+
+  uint64_t ret = (uint64_t)((double)m_items
+      * pow(m_eta * u - m_eta + 1.0, m_alpha));
+  return ret < m_items ? ret : m_items - 1;
+}
+
+
+uint64_t KeyGenerator::next(Random64 &rng, uint64_t insert_frontier) {
+  if (insert_frontier == 0)
+    return 0;
+
+  switch (m_dist) {
+  case ZIPFIAN:
+    return fnv_hash64(next_zipfian(rng)) % insert_frontier;
+  case LATEST: {
+      uint64_t offset = next_zipfian(rng);
+      return offset < insert_frontier ? insert_frontier - 1 - offset : 0;
+    }
+  default:
+    return rng.next_range(insert_frontier);
+  }
+}
+
+
+bool KeyGenerator::parse_distribution(const std::string &name,
+                                      Distribution *distp) {
+  if (name == "uniform")
+    *distp = UNIFORM;
+  else if (name == "zipfian")
+    *distp = ZIPFIAN;
+  else if (name == "latest")
+    *distp = LATEST;
+  else
+    return false;
+  return true;
+}
+
+
+/**
+ * Row keys are "user" followed by a hash of the record number, so that
+ * records inserted in sequence are spread across all ranges, as in YCSB.
+ */
+void KeyGenerator::format_row(uint64_t record, char *buf, size_t len) {
+  snprintf(buf, len, "user%020llu", (Llu)fnv_hash64(record));
+}
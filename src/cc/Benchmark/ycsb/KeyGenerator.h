@@ -0,0 +1,110 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_KEYGENERATOR_H
+#define HYPERTABLE_KEYGENERATOR_H
+
+#include <string>
+
+namespace Hypertable {
+
+  /**
+   * Small, fast pseudo random number generator (xorshift64*).  Each
+   * workload thread owns one, so no locking or shared state is involved.
+   */
+  class Random64 {
+  public:
+    Random64(uint64_t seed) : m_state(seed ? seed : 0x9e3779b97f4a7c15ULL) { }
+
+    uint64_t next() {
+      m_state ^= m_state >> 12;
+      m_state ^= m_state << 25;
+      m_state ^= m_state >> 27;
+      return m_state * 2685821657736338717LL;
+    }
+
+    /** Returns a double in the range [0.0, 1.0) */
+    double next_double() {
+      return (double)(next() >> 11) / (double)(1LL << 53);
+    }
+
+    uint64_t next_range(uint64_t n) { return n ? next() % n : 0; }
+
+  private:
+    uint64_t m_state;
+  };
+
+
+  /**
+   * Chooses the record number for the next read, update or scan, following
+   * one of the request distributions of the YCSB workloads.
+   * <p>
+   * UNIFORM picks any inserted record with equal probability.  ZIPFIAN
+   * favors a small set of hot records, scattered over the key space by
+   * hashing so that they don't all live in one range.  LATEST favors the
+   * most recently inserted records.
+   */
+  class KeyGenerator {
+  public:
+    enum Distribution { UNIFORM, ZIPFIAN, LATEST };
+
+    static const double ZIPFIAN_CONSTANT;
+
+    /**
+     * @param dist request distribution
+     * @param item_count number of records loaded before the run phase
+     * @param zeta precomputed zeta(item_count, ZIPFIAN_CONSTANT), see #zeta
+     */
+    KeyGenerator(Distribution dist, uint64_t item_count, double zeta);
+
+    /**
+     * Returns the next record number to access, in [0, insert_frontier).
+     *
+     * @param rng random number generator of the calling thread
+     * @param insert_frontier number of records inserted so far
+     */
+    uint64_t next(Random64 &rng, uint64_t insert_frontier);
+
+    /**
+     * Computes the zeta constant used by the zipfian generator.  This is
+     * O(n), so it is computed once and shared by all threads.
+     */
+    static double zeta(uint64_t n, double theta);
+
+    static bool parse_distribution(const std::string &name, Distribution *distp);
+
+    /** Formats the row key of the given record number */
+    static void format_row(uint64_t record, char *buf, size_t len);
+
+  private:
+    uint64_t next_zipfian(Random64 &rng);
+
+    Distribution m_dist;
+    uint64_t m_items;
+    double m_zetan;
+    double m_alpha;
+    double m_eta;
+    double m_half_pow_theta;
+  };
+
+}
+
+#endif // HYPERTABLE_KEYGENERATOR_H
@@ -0,0 +1,579 @@
+/**
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Common/Compat.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <boost/shared_array.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/xtime.hpp>
+
+#include "Common/Error.h"
+#include "Common/LatencyHistogram.h"
+#include "Common/Stopwatch.h"
+#include "Common/String.h"
+#include "Common/System.h"
+#include "Common/Usage.h"
+
+#include "Hypertable/Lib/Client.h"
+#include "Hypertable/Lib/KeySpec.h"
+
+#include "KeyGenerator.h"
+
+using namespace Hypertable;
+using namespace std;
+
+
+namespace {
+  const char *usage[] = {
+    "usage: ycsb_test [options] (load|run)",
+    "",
+    "  options:",
+    "    --config=<file>         Read Hypertable config properties from <file>",
+    "    --table=<name>          Table to use (default: YCSB)",
+    "    --create-table          Create the table before loading",
+    "    --threads=<n>           Number of client threads (default: 1)",
+    "    --records=<n>           Number of records in the data set (default: 100000)",
+    "    --operations=<n>        Number of operations in the run phase (default: 100000)",
+    "    --read=<p>              Proportion of reads (default: 0.95)",
+    "    --update=<p>            Proportion of updates (default: 0.05)",
+    "    --scan=<p>              Proportion of scans (default: 0)",
+    "    --insert=<p>            Proportion of inserts (default: 0)",
+    "    --distribution=<d>      uniform, zipfian or latest (default: zipfian)",
+    "    --columns=<n>           Columns (qualifiers of family 'field') per row (default: 10)",
+    "    --value-size=<n>[:<m>]  Value size, or range of sizes, in bytes (default: 100)",
+    "    --max-scan-length=<n>   Maximum rows returned by a scan (default: 100)",
+    "    --batch=<n>             Flush the mutator every <n> updates or inserts (default: 1)",
+    "    --report-interval=<n>   Print throughput every <n> seconds (default: 10)",
+    "    --seed=<n>              Random number generator seed",
+    "    --dry-run               Generate the workload without contacting the cluster",
+    "",
+    "  This program drives a YCSB-style workload against a Hypertable instance.",
+    "  The 'load' phase inserts --records rows; the 'run' phase then issues",
+    "  --operations reads, updates, scans and inserts in the given proportions.",
+    "  Run it against a single-node cluster, e.g. one brought up with",
+    "  'start-all-servers.sh local', or any cluster named by --config.",
+    "  --dry-run measures the overhead of the driver itself.",
+    "",
+    "  Throughput is reported every --report-interval seconds, followed by",
+    "  a latency summary (p50/p90/p99/p999) per operation type at the end.",
+    "",
+    (const char *)0
+  };
+
+  enum { OP_READ, OP_UPDATE, OP_SCAN, OP_INSERT, OP_MAX };
+
+  const char *op_names[OP_MAX] = { "READ", "UPDATE", "SCAN", "INSERT" };
+
+  const char *COLUMN_FAMILY = "field";
+
+  struct Workload {
+    Workload() : distribution(KeyGenerator::ZIPFIAN), threads(1),
+                 record_count(100000), operation_count(100000), columns(10),
+                 value_min(100), value_max(100), max_scan_length(100),
+                 batch(1), report_interval(10), seed(1234), dry_run(false) {
+      proportion[OP_READ] = 0.95;
+      proportion[OP_UPDATE] = 0.05;
+      proportion[OP_SCAN] = 0.0;
+      proportion[OP_INSERT] = 0.0;
+    }
+
+    int choose_operation(double r) const {
+      double total = 0.0, sum = 0.0;
+      for (int i=0; i<OP_MAX; i++)
+        total += proportion[i];
+      r *= total;
+      for (int i=0; i<OP_MAX; i++) {
+        sum += proportion[i];
+        if (r < sum)
+          return i;
+      }
+      return OP_READ;
+    }
+
+    double proportion[OP_MAX];
+    KeyGenerator::Distribution distribution;
+    size_t threads;
+    uint64_t record_count;
+    uint64_t operation_count;
+    size_t columns;
+    size_t value_min;
+    size_t value_max;
+    size_t max_scan_length;
+    size_t batch;
+    uint32_t report_interval;
+    uint64_t seed;
+    bool dry_run;
+  };
+
+  /**
+   * Per-thread statistics.  The mutex is only contended by the reporter
+   * thread, once per report interval.
+   */
+  struct ThreadStats {
+    ThreadStats() : ops(0), errors(0), not_found(0) { }
+    boost::mutex mutex;
+    LatencyHistogram hist[OP_MAX];
+    uint64_t ops;
+    uint64_t errors;
+    uint64_t not_found;
+  };
+
+  /**
+   * State shared by all workload threads
+   */
+  class WorkloadState {
+  public:
+    WorkloadState(const Workload &wl, TablePtr &table, double zeta)
+      : workload(wl), table_ptr(table), zeta(zeta),
+        next_insert(wl.record_count), done(false) { }
+
+    uint64_t insert_frontier() {
+      boost::mutex::scoped_lock lock(mutex);
+      return next_insert;
+    }
+
+    uint64_t allocate_insert() {
+      boost::mutex::scoped_lock lock(mutex);
+      return next_insert++;
+    }
+
+    const Workload &workload;
+    TablePtr table_ptr;
+    double zeta;
+    boost::mutex mutex;
+    uint64_t next_insert;
+    volatile bool done;
+  };
+
+
+  uint64_t elapsed_usecs(const boost::xtime &start, const boost::xtime &end) {
+    return (uint64_t)(end.sec - start.sec) * 1000000LL
+        + (int64_t)(end.nsec - start.nsec) / 1000;
+  }
+
+
+  /**
+   * Runs one thread's share of the load or run phase.
+   */
+  class WorkloadThread {
+  public:
+    WorkloadThread(WorkloadState &state, ThreadStats &stats, size_t index,
+                   bool load)
+      : m_state(state), m_stats(stats), m_index(index), m_load(load) { }
+
+    void operator()() {
+      const Workload &wl = m_state.workload;
+      Random64 rng(wl.seed * 1000003 + m_index + 1);
+      KeyGenerator keygen(wl.distribution, wl.record_count, m_state.zeta);
+      boost::shared_array<char> values(new char [wl.value_max + 4096]);
+      TableMutatorPtr mutator_ptr;
+      size_t unflushed = 0;
+
+      for (size_t i=0; i<wl.value_max + 4096; i++)
+        values[i] = 'A' + (char)rng.next_range(26);
+
+      try {
+        if (!wl.dry_run)
+          mutator_ptr = m_state.table_ptr->create_mutator();
+
+        if (m_load) {
+          for (uint64_t rec=m_index; rec<wl.record_count; rec+=wl.threads)
+            do_insert(rng, rec, values.get(), mutator_ptr, unflushed, true);
+        }
+        else {
+          uint64_t count = wl.operation_count / wl.threads;
+          if (m_index < wl.operation_count % wl.threads)
+            count++;
+
+          for (uint64_t i=0; i<count; i++) {
+            int op = wl.choose_operation(rng.next_double());
+            uint64_t rec;
+
+            switch (op) {
+            case OP_READ:
+              rec = keygen.next(rng, m_state.insert_frontier());
+              do_read(rec);
+              break;
+            case OP_UPDATE:
+              rec = keygen.next(rng, m_state.insert_frontier());
+              do_insert(rng, rec, values.get(), mutator_ptr, unflushed, false);
+              break;
+            case OP_SCAN:
+              rec = keygen.next(rng, m_state.insert_frontier());
+              do_scan(rec, 1 + rng.next_range(wl.max_scan_length));
+              break;
+            case OP_INSERT:
+              rec = m_state.allocate_insert();
+              do_insert(rng, rec, values.get(), mutator_ptr, unflushed, true);
+              break;
+            }
+          }
+        }
+
+        if (mutator_ptr && unflushed)
+          mutator_ptr->flush();
+      }
+      catch (Hypertable::Exception &e) {
+        HT_ERROR_OUT << e << HT_END;
+        boost::mutex::scoped_lock lock(m_stats.mutex);
+        m_stats.errors++;
+      }
+    }
+
+  private:
+
+    void record(int op, const boost::xtime &start) {
+      boost::xtime now;
+      boost::xtime_get(&now, boost::TIME_UTC);
+      boost::mutex::scoped_lock lock(m_stats.mutex);
+      m_stats.hist[op].record(elapsed_usecs(start, now));
+      m_stats.ops++;
+    }
+
+    /**
+     * Writes all columns of the row (insert) or one random column
+     * (update).  The latency includes the flush, when one is due.
+     */
+    void do_insert(Random64 &rng, uint64_t rec, const char *values,
+                   TableMutatorPtr &mutator_ptr, size_t &unflushed,
+                   bool all_columns) {
+      const Workload &wl = m_state.workload;
+      char row[32], qualifier[16];
+      KeySpec key;
+      boost::xtime start;
+
+      KeyGenerator::format_row(rec, row, sizeof(row));
+      key.row = row;
+      key.row_len = strlen(row);
+      key.column_family = COLUMN_FAMILY;
+      key.column_qualifier = qualifier;
+
+      boost::xtime_get(&start, boost::TIME_UTC);
+
+      size_t first = all_columns ? 0 : rng.next_range(wl.columns);
+      size_t last = all_columns ? wl.columns : first + 1;
+
+      for (size_t c=first; c<last; c++) {
+        size_t len = wl.value_min + rng.next_range(wl.value_max - wl.value_min + 1);
+        sprintf(qualifier, "%u", (unsigned)c);
+        key.column_qualifier_len = strlen(qualifier);
+        if (mutator_ptr)
+          mutator_ptr->set(key, values + rng.next_range(4096), len);
+      }
+
+      if (mutator_ptr && ++unflushed >= wl.batch) {
+        mutator_ptr->flush();
+        unflushed = 0;
+      }
+
+      record(all_columns ? OP_INSERT : OP_UPDATE, start);
+    }
+
+    void do_read(uint64_t rec) {
+      char row[32];
+      boost::xtime start;
+      Cell cell;
+      size_t n = 0;
+
+      KeyGenerator::format_row(rec, row, sizeof(row));
+
+      boost::xtime_get(&start, boost::TIME_UTC);
+
+      if (!m_state.workload.dry_run) {
+        ScanSpecBuilder scan_spec;
+        scan_spec.add_column(COLUMN_FAMILY);
+        scan_spec.add_row(row);
+        TableScannerPtr scanner_ptr =
+            m_state.table_ptr->create_scanner(scan_spec.get());
+        while (scanner_ptr->next(cell))
+          n++;
+        if (n == 0) {
+          boost::mutex::scoped_lock lock(m_stats.mutex);
+          m_stats.not_found++;
+        }
+      }
+
+      record(OP_READ, start);
+    }
+
+    void do_scan(uint64_t rec, size_t rows) {
+      char row[32];
+      boost::xtime start;
+      Cell cell;
+
+      KeyGenerator::format_row(rec, row, sizeof(row));
+
+      boost::xtime_get(&start, boost::TIME_UTC);
+
+      if (!m_state.workload.dry_run) {
+        ScanSpecBuilder scan_spec;
+        scan_spec.add_column(COLUMN_FAMILY);
+        scan_spec.set_row_limit(rows);
+        scan_spec.add_row_interval(row, true, "user~", false);
+        TableScannerPtr scanner_ptr =
+            m_state.table_ptr->create_scanner(scan_spec.get());
+        while (scanner_ptr->next(cell))
+          ;
+      }
+
+      record(OP_SCAN, start);
+    }
+
+    WorkloadState &m_state;
+    ThreadStats &m_stats;
+    size_t m_index;
+    bool m_load;
+  };
+
+
+  /**
+   * Prints the operation count and throughput of the last interval, plus
+   * the running p99 of each operation type, until the workload is done.
+   */
+  class Reporter {
+  public:
+    Reporter(WorkloadState &state, std::vector<ThreadStats *> &stats)
+      : m_state(state), m_stats(stats) { }
+
+    void operator()() {
+      Stopwatch stopwatch;
+      uint64_t last_ops = 0;
+      double last_elapsed = 0.0;
+
+      while (!m_state.done) {
+        boost::xtime wakeup;
+        boost::xtime_get(&wakeup, boost::TIME_UTC);
+        wakeup.sec += m_state.workload.report_interval;
+        while (!m_state.done && !past(wakeup))
+          sleep_briefly();
+        if (m_state.done)
+          break;
+
+        LatencyHistogram hist[OP_MAX];
+        uint64_t ops = 0;
+        for (size_t i=0; i<m_stats.size(); i++) {
+          boost::mutex::scoped_lock lock(m_stats[i]->mutex);
+          ops += m_stats[i]->ops;
+          for (int op=0; op<OP_MAX; op++)
+            hist[op].merge(m_stats[i]->hist[op]);
+        }
+
+        double elapsed = stopwatch.elapsed();
+        printf("%6.0f sec: %llu operations; %.1f current ops/sec;",
+               elapsed, (Llu)ops,
+               (double)(ops - last_ops) / (elapsed - last_elapsed));
+        for (int op=0; op<OP_MAX; op++) {
+          if (hist[op].count())
+            printf(" [%s p99=%lluus]", op_names[op],
+                   (Llu)hist[op].percentile(0.99));
+        }
+        printf("\n");
+        fflush(stdout);
+        last_ops = ops;
+        last_elapsed = elapsed;
+      }
+    }
+
+  private:
+
+    static bool past(const boost::xtime &when) {
+      boost::xtime now;
+      boost::xtime_get(&now, boost::TIME_UTC);
+      return boost::xtime_cmp(now, when) >= 0;
+    }
+
+    static void sleep_briefly() {
+      boost::xtime xt;
+      boost::xtime_get(&xt, boost::TIME_UTC);
+      xt.nsec += 100000000;
+      if (xt.nsec >= 1000000000) {
+        xt.sec++;
+        xt.nsec -= 1000000000;
+      }
+      boost::thread::sleep(xt);
+    }
+
+    WorkloadState &m_state;
+    std::vector<ThreadStats *> &m_stats;
+  };
+
+
+  bool parse_value_size(const char *arg, size_t *minp, size_t *maxp) {
+    char *end;
+    *minp = *maxp = strtoul(arg, &end, 0);
+    if (*end == ':')
+      *maxp = strtoul(end+1, &end, 0);
+    return *end == 0 && *minp > 0 && *minp <= *maxp;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  ClientPtr hypertable_client_ptr;
+  TablePtr table_ptr;
+  Workload wl;
+  String config_file;
+  String table_name = "YCSB";
+  String phase;
+  bool create_table = false;
+
+  for (size_t i=1; i<(size_t)argc; i++) {
+    if (argv[i][0] == '-') {
+      if (!strncmp(argv[i], "--config=", 9))
+        config_file = &argv[i][9];
+      else if (!strncmp(argv[i], "--table=", 8))
+        table_name = &argv[i][8];
+      else if (!strcmp(argv[i], "--create-table"))
+        create_table = true;
+      else if (!strncmp(argv[i], "--threads=", 10))
+        wl.threads = atoi(&argv[i][10]);
+      else if (!strncmp(argv[i], "--records=", 10))
+        wl.record_count = strtoll(&argv[i][10], 0, 0);
+      else if (!strncmp(argv[i], "--operations=", 13))
+        wl.operation_count = strtoll(&argv[i][13], 0, 0);
+      else if (!strncmp(argv[i], "--read=", 7))
+        wl.proportion[OP_READ] = atof(&argv[i][7]);
+      else if (!strncmp(argv[i], "--update=", 9))
+        wl.proportion[OP_UPDATE] = atof(&argv[i][9]);
+      else if (!strncmp(argv[i], "--scan=", 7))
+        wl.proportion[OP_SCAN] = atof(&argv[i][7]);
+      else if (!strncmp(argv[i], "--insert=", 9))
+        wl.proportion[OP_INSERT] = atof(&argv[i][9]);
+      else if (!strncmp(argv[i], "--distribution=", 15)) {
+        if (!KeyGenerator::parse_distribution(&argv[i][15], &wl.distribution))
+          Usage::dump_and_exit(usage);
+      }
+      else if (!strncmp(argv[i], "--columns=", 10))
+        wl.columns = atoi(&argv[i][10]);
+      else if (!strncmp(argv[i], "--value-size=", 13)) {
+        if (!parse_value_size(&argv[i][13], &wl.value_min, &wl.value_max))
+          Usage::dump_and_exit(usage);
+      }
+      else if (!strncmp(argv[i], "--max-scan-length=", 18))
+        wl.max_scan_length = atoi(&argv[i][18]);
+      else if (!strncmp(argv[i], "--batch=", 8))
+        wl.batch = atoi(&argv[i][8]);
+      else if (!strncmp(argv[i], "--report-interval=", 18))
+        wl.report_interval = atoi(&argv[i][18]);
+      else if (!strncmp(argv[i], "--seed=", 7))
+        wl.seed = strtoll(&argv[i][7], 0, 0);
+      else if (!strcmp(argv[i], "--dry-run"))
+        wl.dry_run = true;
+      else
+        Usage::dump_and_exit(usage);
+    }
+    else {
+      if (phase != "")
+        Usage::dump_and_exit(usage);
+      phase = argv[i];
+    }
+  }
+
+  if ((phase != "load" && phase != "run") || wl.threads == 0 ||
+      wl.columns == 0 || wl.max_scan_length == 0 || wl.batch == 0 ||
+      wl.report_interval == 0)
+    Usage::dump_and_exit(usage);
+
+  bool load = (phase == "load");
+
+  try {
+    if (!wl.dry_run) {
+      if (config_file != "")
+        hypertable_client_ptr = new Hypertable::Client(System::locate_install_dir(argv[0]), config_file);
+      else
+        hypertable_client_ptr = new Hypertable::Client(System::locate_install_dir(argv[0]));
+
+      if (create_table) {
+        String schema = String("<Schema><AccessGroup name=\"default\">")
+            + "<ColumnFamily><Name>" + COLUMN_FAMILY + "</Name>"
+            + "<MaxVersions>1</MaxVersions></ColumnFamily>"
+            + "</AccessGroup></Schema>";
+        hypertable_client_ptr->create_table(table_name, schema);
+      }
+
+      table_ptr = hypertable_client_ptr->open_table(table_name);
+    }
+  }
+  catch (Hypertable::Exception &e) {
+    cerr << "error: " << Error::get_text(e.code()) << " - " << e.what() << endl;
+    return 1;
+  }
+
+  double zeta = 1.0;
+  if (!load && wl.distribution != KeyGenerator::UNIFORM)
+    zeta = KeyGenerator::zeta(wl.record_count, KeyGenerator::ZIPFIAN_CONSTANT);
+
+  WorkloadState state(wl, table_ptr, zeta);
+  std::vector<ThreadStats *> stats;
+  boost::thread_group threads;
+
+  for (size_t i=0; i<wl.threads; i++)
+    stats.push_back(new ThreadStats());
+
+  Stopwatch stopwatch;
+
+  for (size_t i=0; i<wl.threads; i++)
+    threads.create_thread(WorkloadThread(state, *stats[i], i, load));
+
+  Reporter reporter(state, stats);
+  boost::thread reporter_thread(reporter);
+
+  threads.join_all();
+  stopwatch.stop();
+
+  state.done = true;
+  reporter_thread.join();
+
+  LatencyHistogram hist[OP_MAX];
+  uint64_t ops = 0, errors = 0, not_found = 0;
+  for (size_t i=0; i<stats.size(); i++) {
+    ops += stats[i]->ops;
+    errors += stats[i]->errors;
+    not_found += stats[i]->not_found;
+    for (int op=0; op<OP_MAX; op++)
+      hist[op].merge(stats[i]->hist[op]);
+    delete stats[i];
+  }
+
+  printf("  Elapsed time:  %.2f s\n", stopwatch.elapsed());
+  printf("    Operations:  %llu\n", (Llu)ops);
+  printf("    Throughput:  %.2f ops/s\n", (double)ops / stopwatch.elapsed());
+  if (not_found)
+    printf("     Not found:  %llu\n", (Llu)not_found);
+  if (errors)
+    printf("        Errors:  %llu\n", (Llu)errors);
+  for (int op=0; op<OP_MAX; op++) {
+    if (hist[op].count()) {
+      printf("%14s:  ", op_names[op]);
+      fflush(stdout);
+      hist[op].dump_summary(cout);
+      cout << endl;
+    }
+  }
+
+  return errors ? 1 : 0;
+}
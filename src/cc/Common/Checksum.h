@@ -73,6 +73,40 @@ crc32(const void *data, size_t len);
 extern uint32_t
 crc32_update(uint32_t crc, const void *data, size_t len);
 
+/** Compute crc32c (Castagnoli) checksum.  Uses the SSE4.2 crc32
+ *  instruction when the CPU supports it (detected on first use), and a
+ *  table-driven slicing-by-8 implementation otherwise.
+ *
+ * @param data - input data
+ * @param len - input data length in bytes
+ */
+extern uint32_t
+crc32c(const void *data, size_t len);
+
+/** Update crc32c checksum incrementally
+ *
+ * @param crc - current crc32c checksum
+ * @param data - input data
+ * @param len - input data length in bytes
+ */
+extern uint32_t
+crc32c_update(uint32_t crc, const void *data, size_t len);
+
+/** Update crc32c checksum with the portable implementation, regardless
+ *  of CPU support.  Produces the same result as crc32c_update.
+ *
+ * @param crc - current crc32c checksum
+ * @param data - input data
+ * @param len - input data length in bytes
+ */
+extern uint32_t
+crc32c_update_portable(uint32_t crc, const void *data, size_t len);
+
+/** Returns true if crc32c uses the hardware instruction on this CPU
+ */
+extern bool
+crc32c_hardware();
+
 } // namespace Hypertable
 
 #endif /* HYPERTABLE_CHECKSUM_H */
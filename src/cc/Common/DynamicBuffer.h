@@ -21,6 +21,7 @@
 #ifndef HYPERTABLE_DYNAMICBUFFER_H
 #define HYPERTABLE_DYNAMICBUFFER_H
 
+#include <algorithm>
 #include <cstring>
 
 extern "C" {
@@ -121,6 +122,16 @@ namespace Hypertable {
       size = new_size;
     }
 
+    /**
+     * Exchanges contents (and ownership) with another buffer
+     */
+    void swap(DynamicBuffer &other) {
+      std::swap(base, other.base);
+      std::swap(ptr, other.ptr);
+      std::swap(size, other.size);
+      std::swap(own, other.own);
+    }
+
     uint8_t *base;
     uint8_t *ptr;
     uint32_t size;
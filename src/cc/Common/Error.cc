@@ -59,6 +59,7 @@ namespace {
     { Error::TABLE_DOES_NOT_EXIST,               "HYPERTABLE table does not exist" },
     { Error::TOO_MANY_COLUMNS,            "HYPERTABLE too many columns" },
     { Error::BAD_DOMAIN_NAME,             "HYPERTABLE bad domain name" },
+    { Error::BAD_VALUE,                   "HYPERTABLE bad value" },
     { Error::FAILED_EXPECTATION,          "HYPERTABLE failed expectation" },
     { Error::MALFORMED_REQUEST,           "HYPERTABLE malformed request" },
     { Error::COMM_NOT_CONNECTED,          "COMM not connected" },
@@ -122,6 +123,8 @@ namespace {
     { Error::RANGESERVER_ROW_OVERFLOW,         "RANGE SERVER row overflow" },
     { Error::RANGESERVER_TABLE_NOT_FOUND,      "RANGE SERVER table not found" },
     { Error::RANGESERVER_BAD_SCAN_SPEC,        "RANGE SERVER bad scan specification" },
+    { Error::RANGESERVER_RANGE_BUSY,           "RANGE SERVER range busy" },
+    { Error::RANGESERVER_IMPORT_REJECTED,      "RANGE SERVER cell store import rejected" },
     { Error::HQL_BAD_LOAD_FILE_FORMAT,         "HQL bad load file format" },
     { Error::METALOG_BAD_RS_HEADER, "METALOG bad range server metalog header" },
     { Error::METALOG_BAD_M_HEADER,  "METALOG bad master metalog header" },
@@ -58,6 +58,7 @@ namespace Hypertable {
       MALFORMED_REQUEST                  = 23,
       TOO_MANY_COLUMNS                   = 24,
       BAD_DOMAIN_NAME                    = 25,
+      BAD_VALUE                          = 26,
 
       COMM_NOT_CONNECTED       = 0x00010001,
       COMM_BROKEN_CONNECTION   = 0x00010002,
@@ -124,6 +125,8 @@ namespace Hypertable {
       RANGESERVER_ROW_OVERFLOW           = 0x00050011,
       RANGESERVER_TABLE_NOT_FOUND        = 0x00050012,
       RANGESERVER_BAD_SCAN_SPEC          = 0x00050013,
+      RANGESERVER_RANGE_BUSY             = 0x00050014,
+      RANGESERVER_IMPORT_REJECTED        = 0x00050015,
 
       HQL_BAD_LOAD_FILE_FORMAT  = 0x00060001,
 
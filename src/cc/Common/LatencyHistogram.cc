@@ -0,0 +1,113 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "LatencyHistogram.h"
+
+using namespace Hypertable;
+
+
+void LatencyHistogram::clear() {
+  memset(m_counts, 0, sizeof(m_counts));
+  m_count = 0;
+  m_sum = 0;
+  m_min = (uint64_t)-1;
+  m_max = 0;
+}
+
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (size_t i=0; i<(size_t)BUCKETS; i++)
+    m_counts[i] += other.m_counts[i];
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  if (other.m_min < m_min)
+    m_min = other.m_min;
+  if (other.m_max > m_max)
+    m_max = other.m_max;
+}
+
+
+/**
+ * Index 0 through SUB_BUCKETS-1 hold exact values.  After that, the bucket
+ * for a value whose highest set bit is b (b >= SUB_BUCKET_BITS) is
+ * (b - SUB_BUCKET_BITS + 1) * SUB_BUCKETS plus the SUB_BUCKET_BITS bits
+ * that follow the highest one.
+ */
+size_t LatencyHistogram::bucket_index(uint64_t usecs) {
+  if (usecs < (uint64_t)SUB_BUCKETS)
+    return (size_t)usecs;
+
+  if (usecs >> MAX_BITS)
+    return BUCKETS - 1;
+
+  int msb = 63 - __builtin_clzll(usecs);
+  int shift = msb - SUB_BUCKET_BITS;
+  size_t sub = (size_t)(usecs >> shift) & (SUB_BUCKETS - 1);
+
+  return (size_t)(msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+  if (index < (size_t)SUB_BUCKETS)
+    return (uint64_t)index;
+
+  int msb = (int)(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+  int shift = msb - SUB_BUCKET_BITS;
+  uint64_t sub = index % SUB_BUCKETS;
+  uint64_t base = ((uint64_t)1 << msb) | (sub << shift);
+
+  return base + ((uint64_t)1 << shift) - 1;
+}
+
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+  if (m_count == 0)
+    return 0;
+
+  uint64_t target = (uint64_t)(fraction * (double)m_count + 0.5);
+  uint64_t seen = 0;
+
+  if (target == 0)
+    target = 1;
+
+  for (size_t i=0; i<(size_t)BUCKETS; i++) {
+    seen += m_counts[i];
+    if (seen >= target) {
+      uint64_t bound = bucket_upper_bound(i);
+      return bound > m_max ? m_max : bound;
+    }
+  }
+  return m_max;
+}
+
+
+void LatencyHistogram::dump_summary(std::ostream &out) const {
+  out << "count=" << m_count << " mean=" << (uint64_t)mean()
+      << "us min=" << min() << "us p50=" << percentile(0.50)
+      << "us p90=" << percentile(0.90) << "us p99=" << percentile(0.99)
+      << "us p999=" << percentile(0.999) << "us max=" << m_max << "us";
+}
@@ -0,0 +1,99 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_LATENCYHISTOGRAM_H
+#define HYPERTABLE_LATENCYHISTOGRAM_H
+
+#include <cstddef>
+#include <iosfwd>
+
+extern "C" {
+#include <stdint.h>
+}
+
+namespace Hypertable {
+
+  /**
+   * Fixed-size histogram of latencies in microseconds.  Values below
+   * 2^SUB_BUCKET_BITS are counted exactly; above that, each power of two
+   * is divided into 2^SUB_BUCKET_BITS buckets, so a reported percentile
+   * is within about 3% of the true value.  Recording is a few arithmetic
+   * operations and never allocates.  Instances are not synchronized; keep
+   * one per thread and #merge them for reporting.
+   */
+  class LatencyHistogram {
+  public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    /** Values at or above 2^MAX_BITS microseconds (~19 hours) are clamped */
+    static const int MAX_BITS = 36;
+    static const int BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() { clear(); }
+
+    void clear();
+
+    void record(uint64_t usecs) {
+      m_counts[bucket_index(usecs)]++;
+      m_count++;
+      m_sum += usecs;
+      if (usecs < m_min)
+        m_min = usecs;
+      if (usecs > m_max)
+        m_max = usecs;
+    }
+
+    void merge(const LatencyHistogram &other);
+
+    uint64_t count() const { return m_count; }
+    uint64_t min() const { return m_count ? m_min : 0; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_count ? (double)m_sum / m_count : 0.0; }
+
+    /**
+     * Returns the value below which the given fraction of the recorded
+     * values fall, as the upper bound of the bucket it lands in.
+     *
+     * @param fraction fraction in the range [0.0, 1.0], e.g. 0.99 for p99
+     * @return latency in microseconds, or 0 if nothing was recorded
+     */
+    uint64_t percentile(double fraction) const;
+
+    /**
+     * Writes a one-line summary (count, mean, min, p50, p90, p99, p999 and
+     * max) to the given stream.
+     */
+    void dump_summary(std::ostream &out) const;
+
+    static size_t bucket_index(uint64_t usecs);
+    static uint64_t bucket_upper_bound(size_t index);
+
+  private:
+    uint64_t m_counts[BUCKETS];
+    uint64_t m_count;
+    uint64_t m_sum;
+    uint64_t m_min;
+    uint64_t m_max;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_LATENCYHISTOGRAM_H
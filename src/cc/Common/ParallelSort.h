@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) 2007 Luke Lu (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HYPERTABLE_PARALLELSORT_H
+#define HYPERTABLE_PARALLELSORT_H
+
+#include <algorithm>
+#include <vector>
+
+#include "Common/Thread.h"
+
+namespace Hypertable {
+
+  namespace ParallelSortDetail {
+
+    template <typename IterT, typename CompareT>
+    struct SortWorker {
+      SortWorker(IterT b, IterT e, CompareT c) : begin(b), end(e), comp(c) { }
+      void operator()() { std::stable_sort(begin, end, comp); }
+      IterT begin, end;
+      CompareT comp;
+    };
+
+    template <typename IterT, typename CompareT>
+    struct MergeWorker {
+      MergeWorker(IterT b, IterT m, IterT e, CompareT c)
+        : begin(b), middle(m), end(e), comp(c) { }
+      void operator()() { std::inplace_merge(begin, middle, end, comp); }
+      IterT begin, middle, end;
+      CompareT comp;
+    };
+
+  }
+
+  /**
+   * Stable sort of [begin, end) spread over up to <code>threads</code>
+   * threads.  The range is cut into equal chunks that are sorted
+   * concurrently and then merged pairwise, each round of merges also running
+   * concurrently.  Equal elements keep their relative order.  Inputs shorter
+   * than two chunks of <code>min_chunk</code> elements are sorted on the
+   * calling thread.
+   *
+   * @param begin start of range to sort
+   * @param end end of range to sort
+   * @param comp strict weak ordering
+   * @param threads maximum number of threads to use
+   * @param min_chunk smallest number of elements worth giving a thread
+   */
+  template <typename IterT, typename CompareT>
+  void parallel_stable_sort(IterT begin, IterT end, CompareT comp,
+                            size_t threads, size_t min_chunk = 8192) {
+    using namespace ParallelSortDetail;
+    size_t n = end - begin;
+
+    if (min_chunk == 0)
+      min_chunk = 1;
+
+    if (threads > n / min_chunk)
+      threads = n / min_chunk;
+
+    if (threads <= 1) {
+      std::stable_sort(begin, end, comp);
+      return;
+    }
+
+    std::vector<IterT> bounds;
+    for (size_t i=0; i<threads; i++)
+      bounds.push_back(begin + (n * i) / threads);
+    bounds.push_back(end);
+
+    {
+      ThreadGroup sorters;
+      for (size_t i=1; i<threads; i++)
+        sorters.create_thread(SortWorker<IterT, CompareT>(bounds[i],
+                              bounds[i+1], comp));
+      std::stable_sort(bounds[0], bounds[1], comp);
+      sorters.join_all();
+    }
+
+    for (size_t width=1; width<threads; width*=2) {
+      ThreadGroup mergers;
+      for (size_t i=0; i+width<threads; i+=2*width) {
+        size_t hi = std::min(i + 2*width, threads);
+        mergers.create_thread(MergeWorker<IterT, CompareT>(bounds[i],
+                              bounds[i+width], bounds[hi], comp));
+      }
+      mergers.join_all();
+    }
+  }
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_PARALLELSORT_H
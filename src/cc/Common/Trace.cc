@@ -0,0 +1,113 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Compat.h"
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include "Logger.h"
+#include "Mutex.h"
+#include "System.h"
+#include "Trace.h"
+
+using namespace Hypertable;
+
+__thread uint64_t Trace::ms_current_id = 0;
+__thread uint64_t Trace::ms_random_state = 0;
+FILE    *Trace::ms_file = 0;
+String   Trace::ms_process_name;
+uint32_t Trace::ms_sample_interval = 0;
+
+namespace {
+  Mutex trace_mutex;
+}
+
+
+void Trace::initialize(const String &process_name, PropertiesPtr &props_ptr) {
+  ScopedLock lock(trace_mutex);
+  const char *log_file = props_ptr->get("Hypertable.Trace.Log", "");
+  int interval = props_ptr->get_int("Hypertable.Trace.SampleInterval", 0);
+
+  ms_sample_interval = (interval > 0) ? (uint32_t)interval : 0;
+  ms_process_name = format("%s:%d", process_name.c_str(), (int)getpid());
+
+  if (ms_file != 0 || *log_file == 0)
+    return;
+
+  String path = (*log_file == '/') ? String(log_file)
+      : System::install_dir + "/log/" + log_file;
+
+  if ((ms_file = fopen(path.c_str(), "a")) == 0)
+    HT_ERRORF("Unable to open trace log '%s' - %s", path.c_str(),
+              strerror(errno));
+}
+
+
+uint64_t Trace::sample() {
+  if (ms_current_id)
+    return ms_current_id;
+  if (ms_sample_interval == 0 || next_random() % ms_sample_interval != 0)
+    return 0;
+  uint64_t id;
+  while ((id = next_random()) == 0)
+    ;
+  return id;
+}
+
+
+void Trace::record(uint64_t trace_id, const char *name,
+                   const boost::xtime &start) {
+  if (trace_id == 0 || ms_file == 0)
+    return;
+
+  HiResTime now;
+  int64_t start_usecs = (int64_t)start.sec * 1000000LL + start.nsec / 1000;
+  int64_t end_usecs = (int64_t)now.sec * 1000000LL + now.nsec / 1000;
+  int64_t duration = end_usecs > start_usecs ? end_usecs - start_usecs : 0;
+
+  ScopedLock lock(trace_mutex);
+  fprintf(ms_file, "%016llx %lld %lld %s %s\n", (Llu)trace_id,
+          (long long)start_usecs, (long long)duration,
+          ms_process_name.c_str(), name);
+  fflush(ms_file);
+}
+
+
+/**
+ * xorshift64* generator with per-thread state, seeded from the clock, the
+ * process ID and the address of the state itself so that threads started
+ * at the same time do not share a sequence.
+ */
+uint64_t Trace::next_random() {
+  if (ms_random_state == 0) {
+    HiResTime now;
+    ms_random_state = ((uint64_t)now.sec << 32) ^ (uint64_t)now.nsec
+        ^ ((uint64_t)getpid() << 16) ^ (uint64_t)(size_t)&ms_random_state;
+    if (ms_random_state == 0)
+      ms_random_state = 1;
+  }
+  ms_random_state ^= ms_random_state >> 12;
+  ms_random_state ^= ms_random_state << 25;
+  ms_random_state ^= ms_random_state >> 27;
+  return ms_random_state * 2685821657736338717ULL;
+}
@@ -0,0 +1,134 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_TRACE_H
+#define HYPERTABLE_TRACE_H
+
+#include <cstdio>
+
+#include "Properties.h"
+#include "String.h"
+#include "Time.h"
+
+namespace Hypertable {
+
+  /**
+   * Request-level tracing.  A trace ID is a nonzero 64-bit value attached
+   * to the calling thread.  Messages built while a thread has a trace ID
+   * carry it in their header (see HeaderBuilder), and the ApplicationQueue
+   * worker that runs the resulting request adopts it, so the ID follows a
+   * client operation through the RangeServer and on to the DFS broker.
+   *
+   * Each process that has a trace log configured appends one line per
+   * span to it:
+   * <pre>
+   *   trace_id start_usecs duration_usecs process span_name
+   * </pre>
+   * trace_id is 16 hex digits and start_usecs is microseconds since the
+   * epoch.  The trace_report tool merges the logs of several processes
+   * and assembles the spans of each trace.
+   */
+  class Trace {
+  public:
+
+    /**
+     * Opens the trace log named by the Hypertable.Trace.Log property
+     * (relative paths are under <install_dir>/log) and reads
+     * Hypertable.Trace.SampleInterval, the number of client operations
+     * per sampled trace (0 disables sampling).  Without a log, trace IDs
+     * are still propagated but no spans are written.
+     *
+     * @param process_name name identifying this process in the log
+     * @param props_ptr properties
+     */
+    static void initialize(const String &process_name, PropertiesPtr &props_ptr);
+
+    /** Returns true if spans are being written to a trace log */
+    static bool enabled() { return ms_file != 0; }
+
+    /** Returns the trace ID of the calling thread, or 0 */
+    static uint64_t current_id() { return ms_current_id; }
+
+    static void set_current_id(uint64_t id) { ms_current_id = id; }
+
+    /**
+     * Decides whether a new client operation is traced.  Returns the
+     * calling thread's trace ID if it already has one, a fresh trace ID
+     * for one in every SampleInterval calls, and 0 otherwise.
+     */
+    static uint64_t sample();
+
+    /**
+     * Writes a span that started at start and ends now.  Does nothing if
+     * trace_id is 0 or no trace log is open.
+     */
+    static void record(uint64_t trace_id, const char *name,
+                       const boost::xtime &start);
+
+    static void record(const char *name, const boost::xtime &start) {
+      record(ms_current_id, name, start);
+    }
+
+    /**
+     * Sets the calling thread's trace ID for the lifetime of the object and
+     * restores the previous one on destruction.
+     */
+    class Scope {
+    public:
+      Scope(uint64_t id) : m_saved_id(ms_current_id) { ms_current_id = id; }
+      ~Scope() { ms_current_id = m_saved_id; }
+    private:
+      uint64_t m_saved_id;
+    };
+
+    /**
+     * Records the lifetime of the object as a span of the calling thread's
+     * trace, if it has one.
+     */
+    class Span {
+    public:
+      Span(const char *name) : m_name(name), m_id(ms_current_id) {
+        if (m_id)
+          boost::xtime_get(&m_start, boost::TIME_UTC);
+      }
+      ~Span() {
+        if (m_id)
+          record(m_id, m_name, m_start);
+      }
+    private:
+      const char *m_name;
+      uint64_t     m_id;
+      boost::xtime m_start;
+    };
+
+  private:
+    static uint64_t next_random();
+
+    static __thread uint64_t ms_current_id;
+    static __thread uint64_t ms_random_state;
+    static FILE    *ms_file;
+    static String   ms_process_name;
+    static uint32_t ms_sample_interval;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_TRACE_H
@@ -0,0 +1,61 @@
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <cstring>
+#include "Common/Checksum.h"
+#include "Common/Config.h"
+#include "Common/Logger.h"
+
+using namespace Hypertable;
+
+namespace {
+
+void test_known_values() {
+  const char *check = "123456789";
+  HT_EXPECT(crc32c(check, 9) == 0xE3069283, -1);
+  HT_EXPECT(crc32c_update_portable(0, check, 9) == 0xE3069283, -1);
+  HT_EXPECT(crc32c("", 0) == 0, -1);
+
+  uint8_t zeros[32];
+  memset(zeros, 0, sizeof(zeros));
+  HT_EXPECT(crc32c(zeros, sizeof(zeros)) == 0x8A9136AA, -1);
+}
+
+void test_incremental_and_alignment() {
+  uint8_t buf[4096 + 16];
+
+  srandom(1);
+  for (size_t i = 0; i < sizeof(buf); i++)
+    buf[i] = (uint8_t)random();
+
+  // every offset and a range of lengths must agree with the portable
+  // version, and split updates must agree with a single pass
+  for (size_t off = 0; off < 16; off++) {
+    for (size_t len = 0; len <= 4096; len += (len < 64) ? 1 : 61) {
+      uint32_t crc = crc32c(buf + off, len);
+      HT_EXPECT(crc == crc32c_update_portable(0, buf + off, len), -1);
+      size_t split = len / 3;
+      uint32_t part = crc32c_update(0, buf + off, split);
+      HT_EXPECT(crc32c_update(part, buf + off + split, len - split) == crc,
+                -1);
+    }
+  }
+}
+
+} // local namespace
+
+int main(int ac, char *av[]) {
+  Config::init(ac, av);
+
+  HT_INFOF("crc32c hardware support: %s",
+           crc32c_hardware() ? "yes" : "no");
+
+  try {
+    test_known_values();
+    test_incremental_and_alignment();
+  }
+  catch (Exception &e) {
+    HT_FATAL_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/LatencyHistogram.h"
+#include "Common/Logger.h"
+
+using namespace Hypertable;
+
+namespace {
+
+void test_buckets() {
+  // every value must land in a bucket whose bounds contain it
+  for (uint64_t v = 0; v < 100000; v += 7) {
+    size_t i = LatencyHistogram::bucket_index(v);
+    HT_EXPECT(v <= LatencyHistogram::bucket_upper_bound(i), -1);
+    HT_EXPECT(i == 0 || v > LatencyHistogram::bucket_upper_bound(i-1), -1);
+  }
+  HT_EXPECT(LatencyHistogram::bucket_index((uint64_t)1 << 40)
+            == LatencyHistogram::BUCKETS - 1, -1);
+}
+
+void test_percentiles() {
+  LatencyHistogram hist, other;
+
+  HT_EXPECT(hist.percentile(0.5) == 0, -1);
+
+  for (uint64_t v = 1; v <= 1000; v++)
+    hist.record(v);
+  for (uint64_t v = 1001; v <= 2000; v++)
+    other.record(v);
+  hist.merge(other);
+
+  HT_EXPECT(hist.count() == 2000, -1);
+  HT_EXPECT(hist.min() == 1, -1);
+  HT_EXPECT(hist.max() == 2000, -1);
+  HT_EXPECT(hist.mean() == 1000.5, -1);
+
+  // percentiles are accurate to within ~3%
+  uint64_t p50 = hist.percentile(0.50);
+  uint64_t p99 = hist.percentile(0.99);
+  HT_EXPECT(p50 >= 1000 && p50 <= 1032, -1);
+  HT_EXPECT(p99 >= 1980 && p99 <= 2000, -1);
+  HT_EXPECT(hist.percentile(1.0) == 2000, -1);
+
+  hist.clear();
+  HT_EXPECT(hist.count() == 0 && hist.max() == 0, -1);
+}
+
+} // local namespace
+
+int main(int ac, char *av[]) {
+  Config::init(ac, av);
+
+  try {
+    test_buckets();
+    test_percentiles();
+  }
+  catch (Exception &e) {
+    HT_FATAL_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/Logger.h"
+#include "Common/ParallelSort.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace Hypertable;
+
+namespace {
+
+typedef std::pair<int, int> Element;  // (key, original position)
+typedef std::vector<Element> ElementVec;
+
+struct LtKey {
+  bool operator()(const Element &e1, const Element &e2) const {
+    return e1.first < e2.first;
+  }
+};
+
+// few distinct keys, so most elements have equal neighbours
+void fill(ElementVec &elems, size_t n) {
+  elems.clear();
+  for (size_t i = 0; i < n; i++)
+    elems.push_back(Element((int)((i * 7919) % 97), (int)i));
+}
+
+void check_sort(size_t n, size_t threads, size_t min_chunk) {
+  ElementVec elems, expected;
+
+  fill(elems, n);
+  expected = elems;
+  std::stable_sort(expected.begin(), expected.end(), LtKey());
+
+  parallel_stable_sort(elems.begin(), elems.end(), LtKey(), threads,
+                       min_chunk);
+
+  // equal keys must keep their original order
+  HT_EXPECT(elems == expected, -1);
+}
+
+void test_stability() {
+  check_sort(100000, 4, 1000);
+  check_sort(100000, 3, 1000);
+  check_sort(99991, 7, 100);
+}
+
+void test_empty() {
+  ElementVec elems;
+  parallel_stable_sort(elems.begin(), elems.end(), LtKey(), 8, 1);
+  HT_EXPECT(elems.empty(), -1);
+}
+
+void test_more_threads_than_elements() {
+  check_sort(1, 16, 1);
+  check_sort(5, 16, 1);
+  check_sort(5, 16, 8192);
+}
+
+} // local namespace
+
+int main(int ac, char *av[]) {
+  Config::init(ac, av);
+
+  try {
+    test_stability();
+    test_empty();
+    test_more_threads_than_elements();
+  }
+  catch (Exception &e) {
+    HT_FATAL_OUT << e << HT_END;
+    return 1;
+  }
+  return 0;
+}
@@ -29,16 +29,60 @@
 
 using namespace Hypertable;
 
+boost::mutex ClientBufferedReaderHandler::ms_mutex;
+uint32_t ClientBufferedReaderHandler::ms_max_read_size = 1024 * 1024;
+uint64_t ClientBufferedReaderHandler::ms_memory_limit = 0;
+uint64_t ClientBufferedReaderHandler::ms_memory_used = 0;
+
+
+void
+ClientBufferedReaderHandler::set_readahead_limits(uint32_t max_read_size,
+                                                  uint64_t memory_limit) {
+  boost::mutex::scoped_lock lock(ms_mutex);
+  ms_max_read_size = max_read_size;
+  ms_memory_limit = memory_limit;
+}
+
+
+uint64_t ClientBufferedReaderHandler::readahead_memory_used() {
+  boost::mutex::scoped_lock lock(ms_mutex);
+  return ms_memory_used;
+}
+
+
+/**
+ * Charges amount to the readahead budget.  A handler with nothing in
+ * flight or buffered passes force, with its smallest read size, so that
+ * it can always make progress.
+ */
+bool ClientBufferedReaderHandler::reserve(uint32_t amount, bool force) {
+  boost::mutex::scoped_lock lock(ms_mutex);
+  if (!force && ms_memory_limit && ms_memory_used + amount > ms_memory_limit)
+    return false;
+  ms_memory_used += amount;
+  return true;
+}
+
+
+void ClientBufferedReaderHandler::release(uint64_t amount) {
+  boost::mutex::scoped_lock lock(ms_mutex);
+  assert(ms_memory_used >= amount);
+  ms_memory_used -= amount;
+}
+
+
 /**
  *
  */
 ClientBufferedReaderHandler::ClientBufferedReaderHandler(
     DfsBroker::Client *client, uint32_t fd, uint32_t buf_size,
     uint32_t outstanding, uint64_t start_offset, uint64_t end_offset) :
-    m_client(client), m_fd(fd), m_read_size(buf_size), m_eof(false),
-    m_error(Error::OK) {
+    m_client(client), m_fd(fd), m_min_read_size(buf_size),
+    m_read_size(buf_size), m_outstanding(0), m_cur_amount(0), m_reserved(0),
+    m_eof(false), m_error(Error::OK) {
 
-  m_max_outstanding = outstanding;
+  m_max_outstanding = outstanding ? outstanding : 1;
+  m_target_outstanding = m_max_outstanding < 2 ? m_max_outstanding : 2;
   m_end_offset = end_offset;
   m_outstanding_offset = start_offset;
   m_actual_offset = start_offset;
@@ -56,24 +100,8 @@ ClientBufferedReaderHandler::ClientBufferedReaderHandler(
 
   {
     boost::mutex::scoped_lock lock(m_mutex);
-    uint32_t toread;
-
-    for (m_outstanding=0; m_outstanding<m_max_outstanding; m_outstanding++) {
-      if (m_end_offset && (m_end_offset-m_outstanding_offset) < m_read_size) {
-        if ((toread = (uint32_t)(m_end_offset - m_outstanding_offset)) == 0)
-          break;
-      }
-      else
-        toread = m_read_size;
-
-      try { m_client->read(m_fd, toread, this); }
-      catch (...) {
-        m_eof = true;
-        throw;
-      }
-      m_outstanding_offset -= toread;
-    }
     m_ptr = m_end_ptr = 0;
+    read_ahead();
   }
 }
 
@@ -86,6 +114,9 @@ ClientBufferedReaderHandler::~ClientBufferedReaderHandler() {
 
     while (m_outstanding > 0)
       m_cond.wait(lock);
+
+    release(m_reserved);
+    m_reserved = 0;
   }
   catch (...) {
     HT_ERROR("synchronization error");
@@ -99,15 +130,21 @@ ClientBufferedReaderHandler::~ClientBufferedReaderHandler() {
  */
 void ClientBufferedReaderHandler::handle(EventPtr &event_ptr) {
   boost::mutex::scoped_lock lock(m_mutex);
+  uint32_t requested = m_requested.front();
 
+  // reads on the same descriptor complete in the order they were issued
+  m_requested.pop();
   m_outstanding--;
 
   if (event_ptr->type == Event::MESSAGE) {
     if ((m_error = (int)Protocol::response_code(event_ptr)) != Error::OK) {
       HT_ERRORF("DFS read error (amount=%u, fd=%d) : %s",
-                m_read_size, m_fd,
+                requested, m_fd,
                 Protocol::string_format_message(event_ptr).c_str());
+      release(requested);
+      m_reserved -= requested;
       m_eof = true;
+      m_cond.notify_all();
       return;
     }
     m_queue.push(event_ptr);
@@ -116,18 +153,24 @@ void ClientBufferedReaderHandler::handle(EventPtr &event_ptr) {
     size_t amount = Filesystem::decode_response_read_header(event_ptr, &offset);
     m_actual_offset += amount;
 
-    if (amount < m_read_size) {
+    if (amount < requested) {
+      release(requested - amount);
+      m_reserved -= requested - amount;
       m_eof = true;
     }
-  }
-  else if (event_ptr->type == Event::ERROR) {
-    HT_ERRORF("%s", event_ptr->to_str().c_str());
-    m_error = event_ptr->error;
-    m_eof = true;
+    else if (m_end_offset && m_actual_offset >= m_end_offset)
+      m_eof = true;
   }
   else {
+    release(requested);
+    m_reserved -= requested;
     HT_ERRORF("%s", event_ptr->to_str().c_str());
-    m_error = Error::FAILED_EXPECTATION;
+    if (event_ptr->type == Event::ERROR) {
+      m_error = event_ptr->error;
+      m_eof = true;
+    }
+    else
+      m_error = Error::FAILED_EXPECTATION;
   }
 
   m_cond.notify_all();
@@ -153,15 +196,17 @@ ClientBufferedReaderHandler::read(void *buf, size_t len) {
     if (m_error != Error::OK)
       HT_THROW(m_error, "");
 
-    if (m_queue.empty())
-      HT_THROW(Error::FAILED_EXPECTATION, "empty queue");
+    // reads stop at the end offset, so EOF can follow a full buffer
+    if (m_queue.empty()) {
+      nread = len - nleft;
+      break;
+    }
 
     if (m_ptr == 0) {
       uint64_t offset;
-      uint32_t amount;
       EventPtr &event_ptr = m_queue.front();
-      amount = Filesystem::decode_response_read_header(event_ptr, &offset, &m_ptr);
-      m_end_ptr = m_ptr + amount;
+      m_cur_amount = Filesystem::decode_response_read_header(event_ptr, &offset, &m_ptr);
+      m_end_ptr = m_ptr + m_cur_amount;
     }
 
     available = m_end_ptr - m_ptr;
@@ -171,16 +216,15 @@ ClientBufferedReaderHandler::read(void *buf, size_t len) {
       nread = len;
       m_ptr += nleft;
       if ((m_end_ptr - m_ptr) == 0) {
-        m_queue.pop();
-        m_ptr = 0;
+        consumed();
         read_ahead();
       }
       break;
     }
     else if (available == 0) {
       if (m_eof && m_queue.size() == 1) {
-        m_queue.pop();
-        m_ptr = m_end_ptr = 0;
+        consumed();
+        m_end_ptr = 0;
         nread = len - nleft;
         break;
       }
@@ -189,8 +233,7 @@ ClientBufferedReaderHandler::read(void *buf, size_t len) {
     memcpy(ptr, m_ptr, available);
     ptr += available;
     nleft -= available;
-    m_queue.pop();
-    m_ptr = 0;
+    consumed();
     read_ahead();
   }
 
@@ -199,34 +242,75 @@ ClientBufferedReaderHandler::read(void *buf, size_t len) {
 
 
 
+/**
+ * Pops the buffer at the front of the queue, returns its memory to the
+ * budget and, since the consumer has drained it, grows the readahead
+ * window: first the read size, then the number of outstanding reads.
+ */
+void ClientBufferedReaderHandler::consumed() {
+  m_queue.pop();
+  m_ptr = 0;
+  release(m_cur_amount);
+  m_reserved -= m_cur_amount;
+  m_cur_amount = 0;
+
+  uint32_t max_read_size;
+  {
+    boost::mutex::scoped_lock lock(ms_mutex);
+    max_read_size = ms_max_read_size;
+  }
+
+  if (m_read_size < max_read_size)
+    m_read_size = (m_read_size > max_read_size / 2) ? max_read_size
+                                                    : m_read_size * 2;
+  else if (m_target_outstanding < m_max_outstanding)
+    m_target_outstanding++;
+}
+
+
+
 /**
  *
  */
 void ClientBufferedReaderHandler::read_ahead() {
-  uint32_t n = m_max_outstanding - (m_outstanding + m_queue.size());
   uint32_t toread;
 
-  assert(m_max_outstanding >= (m_outstanding + m_queue.size()));
-
   if (m_eof)
     return;
 
-  for (uint32_t i=0; i<n; i++) {
-    if (m_end_offset && (m_end_offset-m_outstanding_offset) < m_read_size) {
-      if ((toread = (uint32_t)(m_end_offset - m_outstanding_offset)) == 0)
+  while (m_outstanding + m_queue.size() < m_target_outstanding) {
+    toread = m_read_size;
+    if (m_end_offset) {
+      if (m_outstanding_offset >= m_end_offset)
         break;
+      if (m_end_offset - m_outstanding_offset < toread)
+        toread = (uint32_t)(m_end_offset - m_outstanding_offset);
+    }
+
+    if (!reserve(toread, false)) {
+      // over budget, back off until buffers are consumed
+      m_target_outstanding = 1;
+      if (m_outstanding + m_queue.size() > 0) {
+        if (m_read_size / 2 >= m_min_read_size)
+          m_read_size /= 2;
+        break;
+      }
+      // nothing in flight, so make progress with the smallest read
+      m_read_size = m_min_read_size;
+      if (toread > m_read_size)
+        toread = m_read_size;
+      reserve(toread, true);
     }
-    else
-      toread = m_read_size;
 
     try { m_client->read(m_fd, toread, this); }
     catch(...) {
+      release(toread);
       m_eof = true;
       throw;
     }
+    m_requested.push(toread);
+    m_reserved += toread;
     m_outstanding++;
-    m_outstanding_offset -= toread;
+    m_outstanding_offset += toread;
   }
 }
-
-
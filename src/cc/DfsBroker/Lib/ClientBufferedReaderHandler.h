@@ -35,6 +35,16 @@ namespace Hypertable {
     class Client;
   }
 
+  /**
+   * Reads a file sequentially by keeping asynchronous reads outstanding
+   * ahead of the consumer.  Readahead is adaptive: it starts with one or
+   * two reads of the initial buffer size and, each time the consumer
+   * drains a buffer, doubles the read size (up to the maximum read size)
+   * and then adds outstanding reads (up to the given limit).  Buffered and
+   * in-flight data for all handlers in the process is charged against a
+   * shared memory budget; when the budget is exhausted a handler keeps at
+   * most one read outstanding and halves its read size.
+   */
   class ClientBufferedReaderHandler : public DispatchHandler {
 
   public:
@@ -46,18 +56,39 @@ namespace Hypertable {
 
     size_t read(void *buf, size_t len);
 
+    /** Sets the process-wide readahead limits.
+     *
+     * @param max_read_size largest single read a handler grows to
+     * @param memory_limit total bytes all handlers may have in flight or
+     *        buffered (0 for no limit)
+     */
+    static void set_readahead_limits(uint32_t max_read_size,
+                                     uint64_t memory_limit);
+
+    /** Returns the number of bytes currently charged to the budget */
+    static uint64_t readahead_memory_used();
+
   private:
 
     void read_ahead();
+    void consumed();
+
+    static bool reserve(uint32_t amount, bool force);
+    static void release(uint64_t amount);
 
     boost::mutex         m_mutex;
     boost::condition     m_cond;
     std::queue<EventPtr> m_queue;
+    std::queue<uint32_t> m_requested;
     DfsBroker::Client   *m_client;
     uint32_t             m_fd;
     uint32_t             m_max_outstanding;
+    uint32_t             m_target_outstanding;
+    uint32_t             m_min_read_size;
     uint32_t             m_read_size;
     uint32_t             m_outstanding;
+    uint32_t             m_cur_amount;
+    uint64_t             m_reserved;
     bool                 m_eof;
     int                  m_error;
     uint8_t             *m_ptr;
@@ -65,6 +96,11 @@ namespace Hypertable {
     uint64_t             m_end_offset;
     uint64_t             m_outstanding_offset;
     uint64_t             m_actual_offset;
+
+    static boost::mutex  ms_mutex;
+    static uint32_t      ms_max_read_size;
+    static uint64_t      ms_memory_limit;
+    static uint64_t      ms_memory_used;
   };
 
 }
@@ -0,0 +1,661 @@
+/**
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <boost/scoped_array.hpp>
+
+extern "C" {
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+}
+
+#include "Common/Error.h"
+#include "Common/FileUtils.h"
+#include "Common/Logger.h"
+#include "Common/Serialization.h"
+#include "Common/System.h"
+
+#include "AsyncComm/Event.h"
+#include "AsyncComm/Header.h"
+
+#include "LocalClient.h"
+
+using namespace Hypertable;
+using namespace Hypertable::DfsBroker;
+using namespace Serialization;
+
+namespace {
+
+  /**
+   * Throws an exception for the current errno, mapped to a DFS broker
+   * error code the same way LocalBroker::report_error maps it.
+   */
+  void throw_errno(const String &what) {
+    int code;
+    int saved_errno = errno;
+
+    if (saved_errno == ENOTDIR || saved_errno == ENAMETOOLONG ||
+        saved_errno == ENOENT)
+      code = Error::DFSBROKER_BAD_FILENAME;
+    else if (saved_errno == EACCES || saved_errno == EPERM)
+      code = Error::DFSBROKER_PERMISSION_DENIED;
+    else if (saved_errno == EBADF)
+      code = Error::DFSBROKER_BAD_FILE_HANDLE;
+    else if (saved_errno == EINVAL)
+      code = Error::DFSBROKER_INVALID_ARGUMENT;
+    else
+      code = Error::DFSBROKER_IO_ERROR;
+
+    HT_THROWF(code, "%s - %s", what.c_str(), strerror(saved_errno));
+  }
+
+  int remove_entry(const char *path, const struct stat *, int flag,
+                   struct FTW *) {
+    return (flag == FTW_DP) ? ::rmdir(path) : ::unlink(path);
+  }
+
+}
+
+
+LocalClient::OpenFile::~OpenFile() {
+  // release preallocated space beyond what was written
+  if (preallocated) {
+    off_t end = lseek(fd, 0, SEEK_CUR);
+    if (end == (off_t)-1 || ftruncate(fd, end) != 0)
+      HT_ERRORF("Unable to release preallocated space of fd %d - %s", fd,
+                strerror(errno));
+  }
+  ::close(fd);
+}
+
+
+LocalClient::LocalClient(PropertiesPtr &props_ptr) : m_preallocate(0) {
+  const char *root;
+
+  if ((root = props_ptr->get("DfsBroker.Local.Root", 0)) == 0)
+    HT_THROW(Error::DFSBROKER_INVALID_CONFIG,
+             "DfsBroker.Local.Root property not specified.");
+
+  m_rootdir = (root[0] == '/') ? root : System::install_dir + "/" + root;
+
+  // strip off the trailing '/'
+  if (root[strlen(root)-1] == '/')
+    m_rootdir = m_rootdir.substr(0, m_rootdir.length()-1);
+
+  if (!FileUtils::mkdirs(m_rootdir))
+    HT_THROWF(Error::DFSBROKER_IO_ERROR, "Unable to create root directory %s",
+              m_rootdir.c_str());
+
+  m_preallocate = props_ptr->get_int64("DfsBroker.Local.Preallocate", 0);
+
+  memset(&m_addr, 0, sizeof(m_addr));
+}
+
+
+LocalClient::~LocalClient() {
+  ScopedLock lock(m_mutex);
+  m_open_files.clear();
+}
+
+
+String LocalClient::abspath(const String &name) {
+  if (name.length() && name[0] == '/')
+    return m_rootdir + name;
+  return m_rootdir + "/" + name;
+}
+
+
+LocalClient::OpenFilePtr LocalClient::get_open_file(int32_t fd) {
+  ScopedLock lock(m_mutex);
+  OpenFileMap::iterator iter = m_open_files.find(fd);
+
+  if (iter == m_open_files.end())
+    HT_THROWF(Error::DFSBROKER_BAD_FILE_HANDLE, "%d", (int)fd);
+
+  return iter->second;
+}
+
+
+void LocalClient::open(const String &name, DispatchHandler *handler) {
+  try {
+    uint8_t buf[8], *ptr = buf;
+    int fd = open(name);
+    encode_i32(&ptr, Error::OK);
+    encode_i32(&ptr, fd);
+    deliver(handler, buf, ptr-buf);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+int LocalClient::open(const String &name) {
+  String path = abspath(name);
+  int fd;
+
+  if ((fd = ::open(path.c_str(), O_RDONLY)) == -1)
+    throw_errno(format("open failed: file='%s'", path.c_str()));
+
+  ScopedLock lock(m_mutex);
+  m_open_files[fd] = new OpenFile(fd);
+  return fd;
+}
+
+
+/**
+ * There are no outstanding broker reads to keep in flight, so the
+ * read-ahead is handed to the kernel instead: the range is marked
+ * sequential and the first buf_size * outstanding bytes are prefetched.
+ */
+int
+LocalClient::open_buffered(const String &name, uint32_t buf_size,
+                           uint32_t outstanding, uint64_t start_offset,
+                           uint64_t end_offset) {
+  int fd = open(name);
+
+  try {
+    OpenFilePtr ofp = get_open_file(fd);
+    off_t len = end_offset ? (off_t)(end_offset - start_offset) : 0;
+    off_t prefetch = (off_t)buf_size * outstanding;
+
+    ofp->end_offset = end_offset;
+
+    if (start_offset > 0)
+      seek(fd, start_offset);
+
+    if (len && prefetch > len)
+      prefetch = len;
+
+    (void)posix_fadvise(fd, (off_t)start_offset, len, POSIX_FADV_SEQUENTIAL);
+    if (prefetch)
+      (void)posix_fadvise(fd, (off_t)start_offset, prefetch,
+                          POSIX_FADV_WILLNEED);
+  }
+  catch (Exception &e) {
+    close(fd);
+    HT_THROW2F(e.code(), e, "Error opening buffered DFS file=%s buf_size=%u "
+        "outstanding=%u start_offset=%llu end_offset=%llu", name.c_str(),
+        buf_size, outstanding, (Llu)start_offset, (Llu)end_offset);
+  }
+  return fd;
+}
+
+
+void
+LocalClient::create(const String &name, bool overwrite, int32_t bufsz,
+                    int32_t replication, int64_t blksz,
+                    DispatchHandler *handler) {
+  try {
+    uint8_t buf[8], *ptr = buf;
+    int fd = create(name, overwrite, bufsz, replication, blksz);
+    encode_i32(&ptr, Error::OK);
+    encode_i32(&ptr, fd);
+    deliver(handler, buf, ptr-buf);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+int
+LocalClient::create(const String &name, bool overwrite, int32_t bufsz,
+                    int32_t replication, int64_t blksz) {
+  String path = abspath(name);
+  int flags = overwrite ? (O_WRONLY | O_CREAT | O_TRUNC)
+                        : (O_WRONLY | O_CREAT | O_APPEND);
+  int fd;
+
+  if ((fd = ::open(path.c_str(), flags, 0644)) == -1)
+    throw_errno(format("open failed: file='%s'", path.c_str()));
+
+  OpenFilePtr ofp = new OpenFile(fd);
+
+#if defined(FALLOC_FL_KEEP_SIZE)
+  if (m_preallocate) {
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)m_preallocate) == 0)
+      ofp->preallocated = true;
+    else if (errno != EOPNOTSUPP)
+      HT_WARNF("fallocate failed: file='%s' length=%llu - %s",
+               path.c_str(), (Llu)m_preallocate, strerror(errno));
+  }
+#endif
+
+  ScopedLock lock(m_mutex);
+  m_open_files[fd] = ofp;
+  return fd;
+}
+
+
+void LocalClient::close(int32_t fd, DispatchHandler *handler) {
+  try {
+    close(fd);
+    deliver_ok(handler);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+void LocalClient::close(int32_t fd) {
+  ScopedLock lock(m_mutex);
+  // the descriptor is closed when the last in-flight request drops its
+  // reference
+  m_open_files.erase(fd);
+}
+
+
+void LocalClient::read(int32_t fd, size_t amount, DispatchHandler *handler) {
+  try {
+    uint64_t offset;
+    size_t hlen = 16;  // error, offset, amount
+    uint8_t *buf = new uint8_t [hlen + amount];
+    boost::scoped_array<uint8_t> guard(buf);
+    size_t nread = read(fd, buf + hlen, amount, &offset);
+    uint8_t *ptr = buf;
+    encode_i32(&ptr, Error::OK);
+    encode_i64(&ptr, offset);
+    encode_i32(&ptr, nread);
+    deliver(handler, buf, hlen + nread);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+size_t LocalClient::read(int32_t fd, void *dst, size_t amount) {
+  uint64_t offset;
+  return read(fd, dst, amount, &offset);
+}
+
+
+size_t
+LocalClient::read(int32_t fd, void *dst, size_t amount, uint64_t *offsetp) {
+  OpenFilePtr ofp = get_open_file(fd);
+  ssize_t nread;
+  off_t offset;
+
+  if ((offset = lseek(ofp->fd, 0, SEEK_CUR)) == (off_t)-1)
+    throw_errno(format("lseek failed: fd=%d offset=0 SEEK_CUR", ofp->fd));
+
+  // buffered readers stop at their end offset
+  if (ofp->end_offset) {
+    if ((uint64_t)offset >= ofp->end_offset)
+      amount = 0;
+    else if (ofp->end_offset - offset < amount)
+      amount = ofp->end_offset - offset;
+  }
+
+  if ((nread = FileUtils::read(ofp->fd, dst, amount)) == -1)
+    throw_errno(format("read failed: fd=%d amount=%d", ofp->fd, (int)amount));
+
+  *offsetp = (uint64_t)offset;
+  return (size_t)nread;
+}
+
+
+void
+LocalClient::append(int32_t fd, StaticBuffer &buffer, uint32_t flags,
+                    DispatchHandler *handler) {
+  try {
+    uint8_t buf[16], *ptr = buf;
+    uint64_t offset;
+    size_t amount = append(fd, buffer, flags, &offset);
+    encode_i32(&ptr, Error::OK);
+    encode_i64(&ptr, offset);
+    encode_i32(&ptr, amount);
+    deliver(handler, buf, ptr-buf);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+size_t LocalClient::append(int32_t fd, StaticBuffer &buffer, uint32_t flags) {
+  uint64_t offset;
+  return append(fd, buffer, flags, &offset);
+}
+
+
+size_t
+LocalClient::append(int32_t fd, StaticBuffer &buffer, uint32_t flags,
+                    uint64_t *offsetp) {
+  OpenFilePtr ofp = get_open_file(fd);
+  ssize_t nwritten;
+  off_t offset;
+
+  if ((offset = lseek(ofp->fd, 0, SEEK_CUR)) == (off_t)-1)
+    throw_errno(format("lseek failed: fd=%d offset=0 SEEK_CUR", ofp->fd));
+
+  if ((nwritten = FileUtils::write(ofp->fd, buffer.base, buffer.size)) == -1)
+    throw_errno(format("write failed: fd=%d amount=%d", ofp->fd,
+                       (int)buffer.size));
+
+  if ((flags & O_FLUSH) && fdatasync(ofp->fd) != 0)
+    throw_errno(format("flush failed: fd=%d", ofp->fd));
+
+  *offsetp = (uint64_t)offset;
+  return (size_t)nwritten;
+}
+
+
+void
+LocalClient::seek(int32_t fd, uint64_t offset, DispatchHandler *handler) {
+  try {
+    seek(fd, offset);
+    deliver_ok(handler);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+void LocalClient::seek(int32_t fd, uint64_t offset) {
+  OpenFilePtr ofp = get_open_file(fd);
+
+  if (lseek(ofp->fd, (off_t)offset, SEEK_SET) == (off_t)-1)
+    throw_errno(format("lseek failed: fd=%d offset=%llu", ofp->fd,
+                       (Llu)offset));
+}
+
+
+void LocalClient::remove(const String &name, DispatchHandler *handler) {
+  try {
+    remove(name, false);
+    deliver_ok(handler);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+void LocalClient::remove(const String &name, bool force) {
+  String path = abspath(name);
+
+  if (unlink(path.c_str()) == -1 && !(force && errno == ENOENT))
+    throw_errno(format("unlink failed: file='%s'", path.c_str()));
+}
+
+
+void LocalClient::length(const String &name, DispatchHandler *handler) {
+  try {
+    uint8_t buf[12], *ptr = buf;
+    int64_t len = length(name);
+    encode_i32(&ptr, Error::OK);
+    encode_i64(&ptr, len);
+    deliver(handler, buf, ptr-buf);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+int64_t LocalClient::length(const String &name) {
+  String path = abspath(name);
+  off_t len;
+
+  if ((len = FileUtils::length(path)) == (off_t)-1)
+    throw_errno(format("length (stat) failed: file='%s'", path.c_str()));
+
+  return (int64_t)len;
+}
+
+
+void
+LocalClient::pread(int32_t fd, size_t len, uint64_t offset,
+                   DispatchHandler *handler) {
+  try {
+    size_t hlen = 16;  // error, offset, amount
+    uint8_t *buf = new uint8_t [hlen + len];
+    boost::scoped_array<uint8_t> guard(buf);
+    size_t nread = pread(fd, buf + hlen, len, offset);
+    uint8_t *ptr = buf;
+    encode_i32(&ptr, Error::OK);
+    encode_i64(&ptr, offset);
+    encode_i32(&ptr, nread);
+    deliver(handler, buf, hlen + nread);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+size_t
+LocalClient::pread(int32_t fd, void *dst, size_t len, uint64_t offset) {
+  OpenFilePtr ofp = get_open_file(fd);
+  ssize_t nread;
+
+  if ((nread = FileUtils::pread(ofp->fd, dst, len, (off_t)offset)) == -1)
+    throw_errno(format("pread failed: fd=%d amount=%d offset=%llu", ofp->fd,
+                       (int)len, (Llu)offset));
+
+  return (size_t)nread;
+}
+
+
+void LocalClient::mkdirs(const String &name, DispatchHandler *handler) {
+  try {
+    mkdirs(name);
+    deliver_ok(handler);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+void LocalClient::mkdirs(const String &name) {
+  String path = abspath(name);
+
+  if (!FileUtils::mkdirs(path))
+    throw_errno(format("mkdirs failed: dname='%s'", path.c_str()));
+}
+
+
+void LocalClient::flush(int32_t fd, DispatchHandler *handler) {
+  try {
+    flush(fd);
+    deliver_ok(handler);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+void LocalClient::flush(int32_t fd) {
+  OpenFilePtr ofp = get_open_file(fd);
+
+  if (fsync(ofp->fd) != 0)
+    throw_errno(format("flush failed: fd=%d", ofp->fd));
+}
+
+
+void LocalClient::rmdir(const String &name, DispatchHandler *handler) {
+  try {
+    rmdir(name, false);
+    deliver_ok(handler);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+/**
+ * Removes the directory tree bottom-up, like the broker's "rm -rf" but
+ * without forking from the RangeServer.  A missing directory is not an
+ * error, which matches "rm -rf".
+ */
+void LocalClient::rmdir(const String &name, bool force) {
+  String path = abspath(name);
+
+  if (nftw(path.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS) != 0 &&
+      errno != ENOENT)
+    HT_THROWF(Error::DFSBROKER_IO_ERROR, "rmdir failed: dname='%s' - %s",
+              path.c_str(), strerror(errno));
+}
+
+
+void LocalClient::readdir(const String &name, DispatchHandler *handler) {
+  try {
+    std::vector<String> listing;
+    size_t len = 8;  // error, entry count
+
+    readdir(name, listing);
+    for (size_t i=0; i<listing.size(); i++)
+      len += encoded_length_str16(listing[i]);
+
+    boost::scoped_array<uint8_t> buf(new uint8_t [len]);
+    uint8_t *ptr = buf.get();
+    encode_i32(&ptr, Error::OK);
+    encode_i32(&ptr, listing.size());
+    for (size_t i=0; i<listing.size(); i++)
+      encode_str16(&ptr, listing[i]);
+    deliver(handler, buf.get(), len);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+void LocalClient::readdir(const String &name, std::vector<String> &listing) {
+  String path = abspath(name);
+  struct dirent *dp;
+  DIR *dirp;
+
+  if ((dirp = opendir(path.c_str())) == 0)
+    throw_errno(format("opendir('%s') failed", path.c_str()));
+
+  listing.clear();
+
+  // the DIR stream is private to this call, so plain readdir is safe
+  while (true) {
+    errno = 0;
+    if ((dp = ::readdir(dirp)) == 0 && errno != 0) {
+      int saved_errno = errno;
+      (void)closedir(dirp);
+      errno = saved_errno;
+      throw_errno(format("readdir('%s') failed", path.c_str()));
+    }
+    if (dp == 0)
+      break;
+    if (dp->d_name[0] != '.' && dp->d_name[0] != 0)
+      listing.push_back((String)dp->d_name);
+  }
+  (void)closedir(dirp);
+}
+
+
+void LocalClient::exists(const String &name, DispatchHandler *handler) {
+  uint8_t buf[5], *ptr = buf;
+  encode_i32(&ptr, Error::OK);
+  encode_bool(&ptr, exists(name));
+  deliver(handler, buf, ptr-buf);
+}
+
+
+bool LocalClient::exists(const String &name) {
+  return FileUtils::exists(abspath(name));
+}
+
+
+void
+LocalClient::rename(const String &src, const String &dst,
+                    DispatchHandler *handler) {
+  try {
+    rename(src, dst);
+    deliver_ok(handler);
+  }
+  catch (Exception &e) {
+    deliver_error(handler, e);
+  }
+}
+
+
+void LocalClient::rename(const String &src, const String &dst) {
+  String asrc = abspath(src);
+  String adst = abspath(dst);
+
+  if (std::rename(asrc.c_str(), adst.c_str()) != 0)
+    throw_errno(format("rename %s -> %s failed", asrc.c_str(), adst.c_str()));
+}
+
+
+void
+LocalClient::deliver(DispatchHandler *handler, const uint8_t *msg,
+                     size_t len) {
+  // callers such as CellStoreScannerV0 close without waiting for a reply
+  if (handler == 0)
+    return;
+
+  size_t header_len = sizeof(Header::Common);
+  uint8_t *buf = new uint8_t [header_len + len];
+  Header::Common *header = (Header::Common *)buf;
+
+  memset(header, 0, header_len);
+  header->version = Header::VERSION;
+  header->protocol = Header::PROTOCOL_DFSBROKER;
+  header->header_len = header_len;
+  header->total_len = header_len + len;
+  memcpy(buf + header_len, msg, len);
+
+  EventPtr event_ptr = new Event(Event::MESSAGE, 0, m_addr, Error::OK, header);
+  handler->handle(event_ptr);
+}
+
+
+void LocalClient::deliver_ok(DispatchHandler *handler) {
+  uint8_t buf[4], *ptr = buf;
+  encode_i32(&ptr, Error::OK);
+  deliver(handler, buf, ptr-buf);
+}
+
+
+void LocalClient::deliver_error(DispatchHandler *handler, Exception &e) {
+  String msg = e.what();
+  if (msg.length() > 65535)
+    msg = msg.substr(0, 65535);
+  size_t len = 4 + encoded_length_str16(msg);
+  boost::scoped_array<uint8_t> buf(new uint8_t [len]);
+  uint8_t *ptr = buf.get();
+  encode_i32(&ptr, e.code());
+  encode_str16(&ptr, msg);
+  deliver(handler, buf.get(), len);
+}
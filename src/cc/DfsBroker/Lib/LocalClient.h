@@ -0,0 +1,161 @@
+/**
+ * Copyright (C) 2007 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_DFSBROKER_LOCALCLIENT_H
+#define HYPERTABLE_DFSBROKER_LOCALCLIENT_H
+
+extern "C" {
+#include <netinet/in.h>
+}
+
+#include "Common/Error.h"
+#include "Common/HashMap.h"
+#include "Common/Mutex.h"
+#include "Common/Properties.h"
+#include "Common/ReferenceCount.h"
+
+#include "Hypertable/Lib/Filesystem.h"
+
+namespace Hypertable {
+
+  namespace DfsBroker {
+
+    /**
+     * In-process implementation of the Filesystem interface for local and
+     * POSIX-mounted filesystems.  It has the same semantics as the local
+     * DFS broker (paths are resolved against DfsBroker.Local.Root, errno
+     * values map to the same DFSBROKER_* error codes, O_FLUSH appends are
+     * fdatasync'd) but carries out each request with a direct system call
+     * instead of a round trip through AsyncComm.
+     *
+     * The asynchronous variants carry out the request in the calling
+     * thread and deliver a MESSAGE event, encoded exactly as the broker
+     * would have encoded it, to the handler before returning.  Handlers
+     * must therefore not hold a lock that their handle() method acquires
+     * while issuing a request.
+     */
+    class LocalClient : public Filesystem {
+    public:
+
+      /** Constructor.  Reads DfsBroker.Local.Root (relative paths are taken
+       * relative to the install directory) and DfsBroker.Local.Preallocate.
+       *
+       * @param props_ptr reference to properties object
+       */
+      LocalClient(PropertiesPtr &props_ptr);
+
+      virtual ~LocalClient();
+
+      virtual void open(const String &name, DispatchHandler *handler);
+      virtual int open(const String &name);
+      virtual int open_buffered(const String &name, uint32_t buf_size,
+                                uint32_t outstanding, uint64_t start_offset=0,
+                                uint64_t end_offset=0);
+
+      virtual void create(const String &name, bool overwrite,
+                          int32_t bufsz, int32_t replication,
+                          int64_t blksz, DispatchHandler *handler);
+      virtual int create(const String &name, bool overwrite, int32_t bufsz,
+                         int32_t replication, int64_t blksz);
+
+      virtual void close(int32_t fd, DispatchHandler *handler);
+      virtual void close(int32_t fd);
+
+      virtual void read(int32_t fd, size_t amount, DispatchHandler *handler);
+      virtual size_t read(int32_t fd, void *dst, size_t amount);
+
+      virtual void append(int32_t fd, StaticBuffer &buffer, uint32_t flags,
+                          DispatchHandler *handler);
+      virtual size_t append(int32_t fd, StaticBuffer &buffer,
+                            uint32_t flags = 0);
+
+      virtual void seek(int32_t fd, uint64_t offset, DispatchHandler *handler);
+      virtual void seek(int32_t fd, uint64_t offset);
+
+      virtual void remove(const String &name, DispatchHandler *handler);
+      virtual void remove(const String &name, bool force = true);
+
+      virtual void length(const String &name, DispatchHandler *handler);
+      virtual int64_t length(const String &name);
+
+      virtual void pread(int32_t fd, size_t len, uint64_t offset,
+                         DispatchHandler *handler);
+      virtual size_t pread(int32_t fd, void *dst, size_t len, uint64_t offset);
+
+      virtual void mkdirs(const String &name, DispatchHandler *handler);
+      virtual void mkdirs(const String &name);
+
+      virtual void flush(int32_t fd, DispatchHandler *handler);
+      virtual void flush(int32_t fd);
+
+      virtual void rmdir(const String &name, DispatchHandler *handler);
+      virtual void rmdir(const String &name, bool force = true);
+
+      virtual void readdir(const String &name, DispatchHandler *handler);
+      virtual void readdir(const String &name, std::vector<String> &listing);
+
+      virtual void exists(const String &name, DispatchHandler *handler);
+      virtual bool exists(const String &name);
+
+      virtual void rename(const String &src, const String &dst,
+                          DispatchHandler *handler);
+      virtual void rename(const String &src, const String &dst);
+
+    private:
+
+      class OpenFile : public ReferenceCount {
+      public:
+        OpenFile(int _fd) : fd(_fd), end_offset(0), preallocated(false) { }
+        ~OpenFile();
+        int      fd;
+        uint64_t end_offset;
+        bool     preallocated;
+      };
+      typedef boost::intrusive_ptr<OpenFile> OpenFilePtr;
+
+      typedef hash_map<int32_t, OpenFilePtr> OpenFileMap;
+
+      String abspath(const String &name);
+      OpenFilePtr get_open_file(int32_t fd);
+      size_t read(int32_t fd, void *dst, size_t amount, uint64_t *offsetp);
+      size_t append(int32_t fd, StaticBuffer &buffer, uint32_t flags,
+                    uint64_t *offsetp);
+
+      /** Delivers a response message to a dispatch handler as a MESSAGE
+       * event.  The message begins with the 4-byte error code.
+       */
+      void deliver(DispatchHandler *handler, const uint8_t *msg, size_t len);
+      void deliver_ok(DispatchHandler *handler);
+      void deliver_error(DispatchHandler *handler, Exception &e);
+
+      Mutex       m_mutex;
+      OpenFileMap m_open_files;
+      String      m_rootdir;
+      uint64_t    m_preallocate;
+      struct sockaddr_in m_addr;
+    };
+
+  }
+
+} // namespace Hypertable
+
+
+#endif // HYPERTABLE_DFSBROKER_LOCALCLIENT_H
@@ -32,6 +32,7 @@ extern "C" {
 
 #include "Common/FileUtils.h"
 #include "Common/System.h"
+#include "Common/Trace.h"
 #include "Common/Usage.h"
 
 #include "AsyncComm/ApplicationQueue.h"
@@ -109,6 +110,8 @@ int main(int argc, char **argv) {
   worker_count  = props->get_int("DfsBroker.Workers",  DEFAULT_WORKERS);
   reactor_count = props->get_int("Kfs.Reactors", System::get_processor_count());
 
+  Hypertable::Trace::initialize("dfsbroker", props);
+
   ReactorFactory::initialize(reactor_count);
 
   comm = Comm::instance();
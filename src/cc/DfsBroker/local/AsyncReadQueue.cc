@@ -0,0 +1,227 @@
+/**
+ * Copyright (C) 2007 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+}
+
+#include "Common/Error.h"
+#include "Common/FileUtils.h"
+#include "Common/Logger.h"
+
+#include "AsyncReadQueue.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  /**
+   * glibc has no wrappers for the native AIO system calls
+   */
+  inline int io_setup(unsigned nr, aio_context_t *ctxp) {
+    return syscall(SYS_io_setup, nr, ctxp);
+  }
+
+  inline int io_destroy(aio_context_t ctx) {
+    return syscall(SYS_io_destroy, ctx);
+  }
+
+  inline int io_submit(aio_context_t ctx, long nr, struct iocb **iocbpp) {
+    return syscall(SYS_io_submit, ctx, nr, iocbpp);
+  }
+
+  inline int io_getevents(aio_context_t ctx, long min_nr, long max_nr,
+                          struct io_event *events, struct timespec *timeout) {
+    return syscall(SYS_io_getevents, ctx, min_nr, max_nr, events, timeout);
+  }
+
+  const long REAP_TIMEOUT_NSECS = 100000000L;
+}
+
+
+DirectRead::DirectRead(ResponseCallbackRead *cbp, OpenFileDataLocalPtr &fd_data,
+                       uint64_t off, uint32_t len)
+  : cb(*cbp), fdata(fd_data), offset(off), amount(len), buf(0) {
+  uint64_t end = (offset + amount + DIRECT_IO_ALIGNMENT - 1)
+                 & ~(uint64_t)(DIRECT_IO_ALIGNMENT - 1);
+
+  io_offset = offset & ~(uint64_t)(DIRECT_IO_ALIGNMENT - 1);
+  io_amount = (uint32_t)(end - io_offset);
+
+  if (posix_memalign((void **)&buf, DIRECT_IO_ALIGNMENT, io_amount ? io_amount
+                     : DIRECT_IO_ALIGNMENT) != 0)
+    HT_THROW(Error::DFSBROKER_IO_ERROR, "posix_memalign failed");
+
+  memset(&iocb, 0, sizeof(iocb));
+  iocb.aio_data = (uint64_t)(uintptr_t)this;
+  iocb.aio_lio_opcode = IOCB_CMD_PREAD;
+  iocb.aio_fildes = fdata->direct_fd;
+  iocb.aio_buf = (uint64_t)(uintptr_t)buf;
+  iocb.aio_nbytes = io_amount;
+  iocb.aio_offset = io_offset;
+}
+
+
+DirectRead::~DirectRead() {
+  ::free(buf);
+}
+
+
+
+AsyncReadQueue::AsyncReadQueue(LocalBroker *broker, uint32_t queue_depth)
+  : m_broker(broker), m_ctx(0), m_queue_depth(queue_depth),
+    m_initialized(false), m_in_flight(0), m_shutdown(false) {
+
+  if (io_setup(m_queue_depth, &m_ctx) != 0) {
+    HT_ERRORF("io_setup(%u) failed - %s, falling back to synchronous reads",
+              m_queue_depth, strerror(errno));
+    return;
+  }
+  m_initialized = true;
+
+  m_threads.create_thread(Submitter(this));
+  m_threads.create_thread(Reaper(this));
+}
+
+
+AsyncReadQueue::~AsyncReadQueue() {
+  if (!m_initialized)
+    return;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_shutdown = true;
+    m_cond.notify_all();
+    m_slot_cond.notify_all();
+  }
+  m_threads.join_all();
+  io_destroy(m_ctx);
+}
+
+
+void AsyncReadQueue::add(DirectRead *dread) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_queue.push_back(dread);
+  m_cond.notify_one();
+}
+
+
+void AsyncReadQueue::submit_loop() {
+  std::vector<struct iocb *> iocbs;
+  std::vector<DirectRead *> batch;
+
+  while (true) {
+
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+
+      while (m_queue.empty() && !m_shutdown)
+        m_cond.wait(lock);
+
+      if (m_queue.empty())
+        return;
+
+      while (m_in_flight == m_queue_depth)
+        m_slot_cond.wait(lock);
+
+      batch.clear();
+      while (!m_queue.empty() && m_in_flight < m_queue_depth) {
+        batch.push_back(m_queue.front());
+        m_queue.pop_front();
+        m_in_flight++;
+      }
+    }
+
+    iocbs.clear();
+    for (size_t i=0; i<batch.size(); i++)
+      iocbs.push_back(&batch[i]->iocb);
+
+    size_t submitted = 0;
+    while (submitted < iocbs.size()) {
+      int ret = io_submit(m_ctx, iocbs.size() - submitted, &iocbs[submitted]);
+      if (ret <= 0) {
+        if (ret < 0 && errno == EINTR)
+          continue;
+        break;
+      }
+      submitted += ret;
+    }
+
+    /**
+     * Whatever the kernel refused (e.g. EAGAIN under memory pressure) is
+     * read synchronously here rather than failed
+     */
+    if (submitted < batch.size()) {
+      HT_WARNF("io_submit accepted %lu of %lu reads - %s", (Lu)submitted,
+               (Lu)batch.size(), strerror(errno));
+      for (size_t i=submitted; i<batch.size(); i++) {
+        DirectRead *dread = batch[i];
+        ssize_t nread = FileUtils::pread(dread->fdata->direct_fd, dread->buf,
+                                         dread->io_amount, dread->io_offset);
+        m_broker->complete_pread(dread, nread < 0 ? -errno : nread);
+      }
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_in_flight -= batch.size() - submitted;
+      m_slot_cond.notify_all();
+    }
+  }
+}
+
+
+void AsyncReadQueue::reap_loop() {
+  std::vector<struct io_event> events(m_queue_depth);
+  struct timespec timeout;
+  int n;
+
+  while (true) {
+    timeout.tv_sec = 0;
+    timeout.tv_nsec = REAP_TIMEOUT_NSECS;
+
+    n = io_getevents(m_ctx, 1, m_queue_depth, &events[0], &timeout);
+
+    if (n < 0) {
+      if (errno != EINTR)
+        HT_ERRORF("io_getevents failed - %s", strerror(errno));
+      n = 0;
+    }
+
+    for (int i=0; i<n; i++) {
+      DirectRead *dread = (DirectRead *)(uintptr_t)events[i].data;
+      m_broker->complete_pread(dread, (ssize_t)events[i].res);
+    }
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (n > 0) {
+      m_in_flight -= n;
+      m_slot_cond.notify_all();
+    }
+    if (m_shutdown && m_in_flight == 0 && m_queue.empty())
+      return;
+  }
+}
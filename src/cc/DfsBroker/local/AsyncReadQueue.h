@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2007 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_ASYNCREADQUEUE_H
+#define HYPERTABLE_ASYNCREADQUEUE_H
+
+#include <deque>
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+extern "C" {
+#include <linux/aio_abi.h>
+}
+
+#include "DfsBroker/Lib/ResponseCallbackRead.h"
+
+#include "LocalBroker.h"
+
+namespace Hypertable {
+
+  /**
+   * A pread against an O_DIRECT file descriptor.  The request is widened
+   * to DIRECT_IO_ALIGNMENT boundaries and read into an aligned buffer;
+   * LocalBroker::complete_pread copies the requested range out of it.
+   */
+  class DirectRead {
+  public:
+    static const uint32_t DIRECT_IO_ALIGNMENT = 4096;
+
+    DirectRead(ResponseCallbackRead *cb, OpenFileDataLocalPtr &fdata,
+               uint64_t offset, uint32_t amount);
+    ~DirectRead();
+
+    ResponseCallbackRead cb;
+    OpenFileDataLocalPtr fdata;
+    uint64_t  offset;
+    uint32_t  amount;
+    uint64_t  io_offset;
+    uint32_t  io_amount;
+    uint8_t  *buf;
+    struct iocb iocb;
+  };
+
+
+  /**
+   * Submits DirectReads with Linux native asynchronous I/O.  LocalBroker
+   * worker threads hand reads to #add and return immediately; a submitter
+   * thread passes everything that has queued up to the kernel in a single
+   * io_submit call, so concurrent reads reach the device together, and a
+   * reaper thread collects completions and hands them to
+   * LocalBroker::complete_pread.  At most queue_depth reads are in the
+   * kernel at once.
+   */
+  class AsyncReadQueue {
+  public:
+    AsyncReadQueue(LocalBroker *broker, uint32_t queue_depth);
+    ~AsyncReadQueue();
+
+    /**
+     * Returns false if the kernel AIO context could not be set up, in which
+     * case the caller should fall back to synchronous reads.
+     */
+    bool initialized() { return m_initialized; }
+
+    void add(DirectRead *dread);
+
+  private:
+
+    class Submitter {
+    public:
+      Submitter(AsyncReadQueue *queue) : m_queue(queue) { return; }
+      void operator()() { m_queue->submit_loop(); }
+    private:
+      AsyncReadQueue *m_queue;
+    };
+
+    class Reaper {
+    public:
+      Reaper(AsyncReadQueue *queue) : m_queue(queue) { return; }
+      void operator()() { m_queue->reap_loop(); }
+    private:
+      AsyncReadQueue *m_queue;
+    };
+
+    void submit_loop();
+    void reap_loop();
+
+    LocalBroker             *m_broker;
+    aio_context_t            m_ctx;
+    uint32_t                 m_queue_depth;
+    bool                     m_initialized;
+    boost::mutex             m_mutex;
+    boost::condition         m_cond;
+    boost::condition         m_slot_cond;
+    std::deque<DirectRead *> m_queue;
+    uint32_t                 m_in_flight;
+    bool                     m_shutdown;
+    boost::thread_group      m_threads;
+  };
+
+}
+
+#endif // HYPERTABLE_ASYNCREADQUEUE_H
@@ -41,16 +41,39 @@ extern "C" {
 #include "Common/FileUtils.h"
 #include "Common/System.h"
 
+#include "AsyncReadQueue.h"
 #include "LocalBroker.h"
 
 using namespace Hypertable;
 
 
-LocalBroker::LocalBroker(PropertiesPtr &props) : m_verbose(false) {
+LocalBroker::LocalBroker(PropertiesPtr &props) : m_verbose(false),
+    m_direct_io(false), m_preallocate(0), m_async_reads(0) {
   const char *root;
+  int queue_depth;
 
   m_verbose = props->get_bool("Hypertable.Verbose", false);
 
+  /**
+   * DirectIO opens a second, O_DIRECT descriptor for each file opened for
+   * reading and serves preads from it, so blocks cached in the
+   * RangeServer's FileBlockCache are not cached again by the kernel.
+   * Those reads go through native AIO unless AsyncIO.QueueDepth is 0.
+   * Preallocate reserves that many bytes (fallocate) for each file
+   * created, and the unused part is released on close.
+   */
+  m_direct_io = props->get_bool("DfsBroker.Local.DirectIO", false);
+  m_preallocate = props->get_int64("DfsBroker.Local.Preallocate", 0);
+  queue_depth = props->get_int("DfsBroker.Local.AsyncIO.QueueDepth", 64);
+
+  if (m_direct_io && queue_depth > 0) {
+    m_async_reads = new AsyncReadQueue(this, queue_depth);
+    if (!m_async_reads->initialized()) {
+      delete m_async_reads;
+      m_async_reads = 0;
+    }
+  }
+
   /**
    * Determine root directory
    */
@@ -73,6 +96,7 @@ LocalBroker::LocalBroker(PropertiesPtr &props) : m_verbose(false) {
 
 
 LocalBroker::~LocalBroker() {
+  delete m_async_reads;
 }
 
 
@@ -107,6 +131,11 @@ void LocalBroker::open(ResponseCallbackOpen *cb, const char *fname, uint32_t buf
     struct sockaddr_in addr;
     OpenFileDataLocalPtr fdata(new OpenFileDataLocal(fd, O_RDONLY));
 
+    if (m_direct_io &&
+        (fdata->direct_fd = ::open(abspath.c_str(), O_RDONLY|O_DIRECT)) == -1)
+      HT_WARNF("O_DIRECT open failed: file='%s' - %s, using buffered reads",
+               abspath.c_str(), strerror(errno));
+
     cb->get_address(addr);
 
     m_open_file_map.create(fd, addr, fdata);
@@ -155,6 +184,16 @@ void LocalBroker::create(ResponseCallbackOpen *cb, const char *fname, bool overw
     struct sockaddr_in addr;
     OpenFileDataLocalPtr fdata(new OpenFileDataLocal(fd, O_WRONLY));
 
+#if defined(FALLOC_FL_KEEP_SIZE)
+    if (m_preallocate) {
+      if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)m_preallocate) == 0)
+        fdata->preallocated = true;
+      else if (errno != EOPNOTSUPP)
+        HT_WARNF("fallocate failed: file='%s' length=%llu - %s",
+                 abspath.c_str(), (Llu)m_preallocate, strerror(errno));
+    }
+#endif
+
     cb->get_address(addr);
 
     m_open_file_map.create(fd, addr, fdata);
@@ -246,7 +285,7 @@ void LocalBroker::append(ResponseCallbackAppend *cb, uint32_t fd,
     return;
   }
 
-  if (sync && fsync(fdata->fd) != 0) {
+  if (sync && fdatasync(fdata->fd) != 0) {
     HT_ERRORF("flush failed: fd=%d - %s", fdata->fd, strerror(errno));
     report_error(cb);
     return;
@@ -338,7 +377,6 @@ void LocalBroker::length(ResponseCallbackLength *cb, const char *fname) {
 void LocalBroker::pread(ResponseCallbackRead *cb, uint32_t fd, uint64_t offset, uint32_t amount) {
   OpenFileDataLocalPtr fdata;
   ssize_t nread;
-  StaticBuffer buf(new uint8_t [amount], amount);
 
   if (m_verbose) {
     HT_INFOF("pread fd=%d offset=%lld amount=%d", fd, offset, amount);
@@ -351,6 +389,20 @@ void LocalBroker::pread(ResponseCallbackRead *cb, uint32_t fd, uint64_t offset,
     return;
   }
 
+  if (fdata->direct_fd != -1) {
+    DirectRead *dread = new DirectRead(cb, fdata, offset, amount);
+    if (m_async_reads)
+      m_async_reads->add(dread);
+    else {
+      nread = FileUtils::pread(fdata->direct_fd, dread->buf, dread->io_amount,
+                               (off_t)dread->io_offset);
+      complete_pread(dread, nread < 0 ? -errno : nread);
+    }
+    return;
+  }
+
+  StaticBuffer buf(new uint8_t [amount], amount);
+
   if ((nread = FileUtils::pread(fdata->fd, buf.base, amount, (off_t)offset)) == -1) {
     HT_ERRORF("pread failed: fd=%d amount=%d offset=%lld - %s", fdata->fd, amount, offset, strerror(errno));
     report_error(cb);
@@ -363,6 +415,32 @@ void LocalBroker::pread(ResponseCallbackRead *cb, uint32_t fd, uint64_t offset,
 }
 
 
+void LocalBroker::complete_pread(DirectRead *dread, ssize_t result) {
+
+  if (result < 0) {
+    errno = (int)-result;
+    HT_ERRORF("pread failed: fd=%d amount=%d offset=%llu - %s",
+              dread->fdata->direct_fd, dread->amount, (Llu)dread->offset,
+              strerror(errno));
+    report_error(&dread->cb);
+    delete dread;
+    return;
+  }
+
+  // the aligned read may start before and end after the requested range
+  size_t skip = dread->offset - dread->io_offset;
+  size_t len = ((size_t)result > skip) ? (size_t)result - skip : 0;
+  if (len > dread->amount)
+    len = dread->amount;
+
+  StaticBuffer buf(new uint8_t [len ? len : 1], len);
+  memcpy(buf.base, dread->buf + skip, len);
+
+  dread->cb.response(dread->offset, buf);
+  delete dread;
+}
+
+
 /**
  * Mkdirs
  */
@@ -22,12 +22,15 @@
 #ifndef HYPERTABLE_LOCALBROKER_H
 #define HYPERTABLE_LOCALBROKER_H
 
+#include <cerrno>
+#include <cstring>
 #include <string>
 
 extern "C" {
 #include <unistd.h>
 }
 
+#include "Common/Logger.h"
 #include "Common/String.h"
 #include "Common/atomic.h"
 #include "Common/Properties.h"
@@ -38,15 +41,32 @@ extern "C" {
 namespace Hypertable {
   using namespace DfsBroker;
 
+  class AsyncReadQueue;
+  class DirectRead;
+
   /**
    *
    */
   class OpenFileDataLocal : public OpenFileData {
   public:
-    OpenFileDataLocal(int _fd, int _flags) : fd(_fd), flags(_flags) { return; }
-    virtual ~OpenFileDataLocal() { close(fd); }
+    OpenFileDataLocal(int _fd, int _flags) : fd(_fd), flags(_flags),
+        direct_fd(-1), preallocated(false) { return; }
+    virtual ~OpenFileDataLocal() {
+      // release preallocated space beyond what was written
+      if (preallocated) {
+        off_t end = lseek(fd, 0, SEEK_CUR);
+        if (end == (off_t)-1 || ftruncate(fd, end) != 0)
+          HT_ERRORF("Unable to release preallocated space of fd %d - %s",
+                    fd, strerror(errno));
+      }
+      close(fd);
+      if (direct_fd != -1)
+        close(direct_fd);
+    }
     int  fd;
     int  flags;
+    int  direct_fd;
+    bool preallocated;
   };
 
   /**
@@ -90,12 +110,23 @@ namespace Hypertable {
     virtual void exists(ResponseCallbackExists *cb, const char *fname);
     virtual void rename(ResponseCallback *cb, const char *src, const char *dst);
 
+    /**
+     * Sends the response for a DirectRead and deletes it.
+     *
+     * @param dread completed read
+     * @param result number of bytes read, or a negated errno value
+     */
+    void complete_pread(DirectRead *dread, ssize_t result);
+
   private:
 
     virtual void report_error(ResponseCallback *cb);
 
     bool         m_verbose;
     String       m_rootdir;
+    bool         m_direct_io;
+    uint64_t     m_preallocate;
+    AsyncReadQueue *m_async_reads;
   };
 
 }
@@ -35,6 +35,7 @@ extern "C" {
 #include "Common/FileUtils.h"
 #include "Common/InetAddr.h"
 #include "Common/System.h"
+#include "Common/Trace.h"
 #include "Common/Usage.h"
 
 #include "AsyncComm/ApplicationQueue.h"
@@ -118,6 +119,8 @@ int main(int argc, char **argv) {
   reactor_count = props_ptr->get_int("DfsBroker.Local.Reactors", System::get_processor_count());
   worker_count  = props_ptr->get_int("DfsBroker.Local.Workers",  DEFAULT_WORKERS);
 
+  Trace::initialize("dfsbroker", props_ptr);
+
   ReactorFactory::initialize(reactor_count);
 
   comm = Comm::instance();
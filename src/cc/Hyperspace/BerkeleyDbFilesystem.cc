@@ -52,7 +52,8 @@ using namespace Error;
  */
 BerkeleyDbFilesystem::BerkeleyDbFilesystem(const std::string &basedir,
                                            bool force_recover)
-    : m_base_dir(basedir), m_env(0) {
+    : m_base_dir(basedir), m_env(0), m_commit_seq(0), m_flushed_seq(0),
+      m_flushing(false) {
   DbTxn *txn = NULL;
 
   u_int32_t env_flags =
@@ -149,6 +150,46 @@ DbTxn *BerkeleyDbFilesystem::start_transaction() {
 }
 
 
+void BerkeleyDbFilesystem::commit_transaction(DbTxn *txn) {
+
+  // log records are written to the log buffer but not flushed
+  txn->commit(DB_TXN_NOSYNC);
+
+  boost::mutex::scoped_lock lock(m_commit_mutex);
+  m_commit_seq++;
+}
+
+
+void BerkeleyDbFilesystem::flush_commits() {
+  boost::mutex::scoped_lock lock(m_commit_mutex);
+  uint64_t target = m_commit_seq;
+
+  while (m_flushed_seq < target) {
+    if (m_flushing) {
+      m_commit_cond.wait(lock);
+      continue;
+    }
+
+    // become the leader and flush on behalf of everyone committed so far
+    uint64_t flush_seq = m_commit_seq;
+    m_flushing = true;
+    lock.unlock();
+
+    try {
+      m_env.log_flush(NULL);
+    }
+    catch (DbException &e) {
+      HT_FATALF("Problem flushing Berkeley DB log - %s", e.what());
+    }
+
+    lock.lock();
+    m_flushing = false;
+    m_flushed_seq = flush_seq;
+    m_commit_cond.notify_all();
+  }
+}
+
+
 /**
  */
 bool
@@ -26,6 +26,9 @@
 
 #include <db_cxx.h>
 
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "Common/String.h"
 #include "Common/DynamicBuffer.h"
 
@@ -41,6 +44,23 @@ namespace Hyperspace {
 
     DbTxn *start_transaction();
 
+    /**
+     * Commits a transaction that modified the database without waiting
+     * for its log records to reach disk.  The caller must call
+     * #flush_commits before acknowledging the change.
+     *
+     * @param txn transaction to commit
+     */
+    void commit_transaction(DbTxn *txn);
+
+    /**
+     * Waits until every transaction committed with #commit_transaction
+     * before this call is durable.  Concurrent callers share a single log
+     * flush: one of them flushes on behalf of all waiting callers while
+     * the others wait for it to finish.
+     */
+    void flush_commits();
+
     bool get_xattr_i32(DbTxn *txn, const String &fname,
                        const String &aname, uint32_t *valuep);
     void set_xattr_i32(DbTxn *txn, const String &fname,
@@ -69,6 +89,12 @@ namespace Hyperspace {
     String m_base_dir;
     DbEnv  m_env;
     Db    *m_db;
+
+    boost::mutex     m_commit_mutex;
+    boost::condition m_commit_cond;
+    uint64_t         m_commit_seq;
+    uint64_t         m_flushed_seq;
+    bool             m_flushing;
   };
 
 } // namespace Hyperspace
@@ -0,0 +1,288 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include "ClientCache.h"
+
+using namespace Hypertable;
+using namespace Hyperspace;
+
+
+ClientCache::ClientCache(size_t max_idle_handles)
+  : m_max_idle_handles(max_idle_handles), m_next_generation(1) {
+}
+
+
+void ClientCache::watch(const std::string &node) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry &entry = m_node_map[node];
+  if (entry.watchers++ == 0)
+    entry.generation = m_next_generation++;
+}
+
+
+void ClientCache::unwatch(const std::string &node) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeMap::iterator iter = m_node_map.find(node);
+  if (iter != m_node_map.end() && --(*iter).second.watchers == 0)
+    m_node_map.erase(iter);
+}
+
+
+uint64_t ClientCache::get_generation(const std::string &node) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+  return entry ? entry->generation : 0;
+}
+
+
+bool ClientCache::get_attr(const std::string &node, const std::string &attr,
+                           DynamicBuffer &value) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+
+  if (entry == 0)
+    return false;
+
+  std::map<std::string, std::string>::iterator iter = entry->attrs.find(attr);
+  if (iter == entry->attrs.end())
+    return false;
+
+  // nul-terminate, as Session::attr_get does
+  value.clear();
+  value.ensure((*iter).second.length()+1);
+  value.add_unchecked((*iter).second.data(), (*iter).second.length());
+  *value.ptr = 0;
+  return true;
+}
+
+
+void ClientCache::put_attr(const std::string &node, const std::string &attr,
+                           const DynamicBuffer &value, uint64_t generation) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+
+  if (entry && entry->generation == generation)
+    entry->attrs[attr] = std::string((const char *)value.base, value.fill());
+}
+
+
+bool ClientCache::get_listing(const std::string &node,
+                              std::vector<DirEntry> &listing) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+
+  if (entry == 0 || !entry->listing_valid)
+    return false;
+
+  listing = entry->listing;
+  return true;
+}
+
+
+void ClientCache::put_listing(const std::string &node,
+                              const std::vector<DirEntry> &listing,
+                              uint64_t generation) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+
+  if (entry && entry->generation == generation) {
+    entry->listing = listing;
+    entry->listing_valid = true;
+  }
+}
+
+
+bool ClientCache::get_exists(const std::string &name, bool *existsp) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  std::string parent, child;
+
+  split_name(name, parent, child);
+
+  NodeEntry *entry = find_watched(parent);
+
+  if (entry == 0)
+    return false;
+
+  std::map<std::string, bool>::iterator iter = entry->child_exists.find(child);
+  if (iter == entry->child_exists.end())
+    return false;
+
+  *existsp = (*iter).second;
+  return true;
+}
+
+
+void ClientCache::put_exists(const std::string &name, bool exists,
+                             uint64_t generation) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  std::string parent, child;
+
+  split_name(name, parent, child);
+
+  NodeEntry *entry = find_watched(parent);
+
+  if (entry && entry->generation == generation)
+    entry->child_exists[child] = exists;
+}
+
+
+void ClientCache::attr_changed(const std::string &node, const std::string &attr) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+
+  if (entry) {
+    entry->attrs.erase(attr);
+    entry->generation = m_next_generation++;
+  }
+}
+
+
+void ClientCache::child_changed(const std::string &node, const std::string &child) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+
+  if (entry) {
+    entry->listing_valid = false;
+    entry->listing.clear();
+    entry->child_exists.erase(child);
+    entry->generation = m_next_generation++;
+  }
+}
+
+
+void ClientCache::node_removed(const std::string &node) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  NodeEntry *entry = find_watched(node);
+
+  if (entry) {
+    entry->attrs.clear();
+    entry->listing_valid = false;
+    entry->listing.clear();
+    entry->child_exists.clear();
+    entry->generation = m_next_generation++;
+  }
+
+  std::list<IdleHandle>::iterator iter = m_idle_handles.begin();
+  while (iter != m_idle_handles.end()) {
+    if ((*iter).node == node) {
+      m_orphaned_handles.push_back((*iter).handle);
+      iter = m_idle_handles.erase(iter);
+    }
+    else
+      ++iter;
+  }
+}
+
+
+bool ClientCache::checkout_orphaned_handle(uint64_t *handlep) {
+  boost::mutex::scoped_lock lock(m_mutex);
+
+  if (m_orphaned_handles.empty())
+    return false;
+
+  *handlep = m_orphaned_handles.back();
+  m_orphaned_handles.pop_back();
+  return true;
+}
+
+
+/**
+ * Drops all cached data.  Called when the session leaves the SAFE state,
+ * since events may have been missed.  Watches and idle handles are kept.
+ */
+void ClientCache::clear() {
+  boost::mutex::scoped_lock lock(m_mutex);
+
+  for (NodeMap::iterator iter = m_node_map.begin();
+       iter != m_node_map.end(); ++iter) {
+    (*iter).second.attrs.clear();
+    (*iter).second.listing_valid = false;
+    (*iter).second.listing.clear();
+    (*iter).second.child_exists.clear();
+    (*iter).second.generation = m_next_generation++;
+  }
+}
+
+
+bool ClientCache::checkout_idle_handle(const std::string &node,
+                                       uint32_t event_mask, uint64_t *handlep) {
+  boost::mutex::scoped_lock lock(m_mutex);
+
+  for (std::list<IdleHandle>::iterator iter = m_idle_handles.begin();
+       iter != m_idle_handles.end(); ++iter) {
+    if ((*iter).node == node &&
+        ((*iter).event_mask & event_mask) == event_mask) {
+      *handlep = (*iter).handle;
+      m_idle_handles.erase(iter);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+bool ClientCache::retain_idle_handle(const std::string &node,
+                                     uint32_t event_mask, uint64_t handle,
+                                     uint64_t *evictedp) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  IdleHandle idle;
+
+  idle.node = node;
+  idle.event_mask = event_mask;
+  idle.handle = handle;
+  m_idle_handles.push_front(idle);
+
+  if (m_idle_handles.size() > m_max_idle_handles) {
+    *evictedp = m_idle_handles.back().handle;
+    m_idle_handles.pop_back();
+    return true;
+  }
+  return false;
+}
+
+
+ClientCache::NodeEntry *ClientCache::find_watched(const std::string &node) {
+  NodeMap::iterator iter = m_node_map.find(node);
+  if (iter == m_node_map.end() || (*iter).second.watchers == 0)
+    return 0;
+  return &(*iter).second;
+}
+
+
+void ClientCache::split_name(const std::string &name, std::string &parent,
+                             std::string &child) {
+  size_t lastslash = name.find_last_of('/');
+
+  if (lastslash == std::string::npos || name == "/") {
+    parent = "";
+    child = name;
+  }
+  else if (lastslash == 0) {
+    parent = "/";
+    child = name.substr(1);
+  }
+  else {
+    parent = name.substr(0, lastslash);
+    child = name.substr(lastslash+1);
+  }
+}
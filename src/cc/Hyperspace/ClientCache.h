@@ -0,0 +1,164 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERSPACE_CLIENTCACHE_H
+#define HYPERSPACE_CLIENTCACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "Common/DynamicBuffer.h"
+#include "Common/ReferenceCount.h"
+
+#include "DirEntry.h"
+#include "HandleCallback.h"
+
+namespace Hyperspace {
+
+  /**
+   * Client-side cache of node attributes, directory listings and node
+   * existence.  Data for a node is only cached while the session holds at
+   * least one open handle on that node registered for the events in
+   * #EVENT_MASK.  Since the master waits for every such handle to
+   * acknowledge an event before completing the change that caused it,
+   * invalidating on event receipt keeps the cache coherent.  Existence of
+   * a node is cached only while its parent directory is watched.
+   * <p>
+   * Every invalidation bumps a per-node generation number.  Callers fetch
+   * the generation before issuing a request to the master and pass it back
+   * when populating the cache, so that a response that raced with an
+   * invalidation is not cached.
+   * <p>
+   * The cache also holds on to read-only handles after the application
+   * closes them, so that a subsequent open of the same node (for example,
+   * opening a table) can reuse the handle, and its cached attributes,
+   * without a round trip.  Note that an idle handle on an ephemeral node
+   * keeps that node from being removed.
+   */
+  class ClientCache : public Hypertable::ReferenceCount {
+  public:
+
+    /** Events a handle must be registered for to keep its node cached */
+    static const uint32_t EVENT_MASK = EVENT_MASK_ATTR_SET |
+        EVENT_MASK_ATTR_DEL | EVENT_MASK_CHILD_NODE_ADDED |
+        EVENT_MASK_CHILD_NODE_REMOVED | EVENT_MASK_NODE_REMOVED;
+
+    ClientCache(size_t max_idle_handles);
+
+    void watch(const std::string &node);
+    void unwatch(const std::string &node);
+
+    uint64_t get_generation(const std::string &node);
+
+    bool get_attr(const std::string &node, const std::string &attr,
+                  Hypertable::DynamicBuffer &value);
+    void put_attr(const std::string &node, const std::string &attr,
+                  const Hypertable::DynamicBuffer &value, uint64_t generation);
+
+    bool get_listing(const std::string &node, std::vector<DirEntry> &listing);
+    void put_listing(const std::string &node,
+                     const std::vector<DirEntry> &listing, uint64_t generation);
+
+    bool get_exists(const std::string &name, bool *existsp);
+    void put_exists(const std::string &name, bool exists, uint64_t generation);
+
+    void attr_changed(const std::string &node, const std::string &attr);
+    void child_changed(const std::string &node, const std::string &child);
+
+    /**
+     * Drops everything cached for a deleted node.  Idle handles on the node
+     * are moved to the orphan list, to be closed with
+     * #checkout_orphaned_handle.
+     *
+     * @param node normalized node name
+     */
+    void node_removed(const std::string &node);
+
+    bool checkout_orphaned_handle(uint64_t *handlep);
+
+    void clear();
+
+    /**
+     * Looks for an idle handle on the given node that was opened with an
+     * event mask covering <code>event_mask</code>.
+     *
+     * @param node normalized node name
+     * @param event_mask events the new user of the handle wants
+     * @param handlep address of variable to hold the handle
+     * @return true if an idle handle was found and removed from the idle list
+     */
+    bool checkout_idle_handle(const std::string &node, uint32_t event_mask,
+                              uint64_t *handlep);
+
+    /**
+     * Adds a closed read-only handle to the idle list.  If the list grows
+     * beyond its limit, the least recently used handle is evicted and
+     * should be closed by the caller.
+     *
+     * @param node normalized node name
+     * @param event_mask event mask the handle is registered with
+     * @param handle handle to retain
+     * @param evictedp address of variable to hold the evicted handle
+     * @return true if a handle was evicted
+     */
+    bool retain_idle_handle(const std::string &node, uint32_t event_mask,
+                            uint64_t handle, uint64_t *evictedp);
+
+  private:
+
+    struct NodeEntry {
+      NodeEntry() : watchers(0), generation(0), listing_valid(false) { return; }
+      uint32_t watchers;
+      uint64_t generation;
+      std::map<std::string, std::string> attrs;
+      bool listing_valid;
+      std::vector<DirEntry> listing;
+      std::map<std::string, bool> child_exists;
+    };
+
+    struct IdleHandle {
+      std::string node;
+      uint32_t event_mask;
+      uint64_t handle;
+    };
+
+    typedef std::map<std::string, NodeEntry> NodeMap;
+
+    NodeEntry *find_watched(const std::string &node);
+    static void split_name(const std::string &name, std::string &parent,
+                           std::string &child);
+
+    boost::mutex          m_mutex;
+    NodeMap               m_node_map;
+    std::list<IdleHandle> m_idle_handles;
+    std::vector<uint64_t> m_orphaned_handles;
+    size_t                m_max_idle_handles;
+    uint64_t              m_next_generation;
+  };
+  typedef boost::intrusive_ptr<ClientCache> ClientCachePtr;
+
+}
+
+#endif // HYPERSPACE_CLIENTCACHE_H
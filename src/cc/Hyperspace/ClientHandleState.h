@@ -39,6 +39,7 @@ namespace Hyperspace {
     uint64_t     handle;
     uint32_t     open_flags;
     uint32_t     event_mask;
+    bool         cached;
     std::string  normal_name;
     HandleCallbackPtr callback;
     LockSequencer *sequencer;
@@ -173,7 +173,19 @@ void ClientKeepaliveHandler::handle(Hypertable::EventPtr &event) {
               if (event_id <= m_last_known_event)
                 continue;
 
-              if (handle_state->callback) {
+              if (handle_state->cached) {
+                ClientCache *cache = m_session->get_cache();
+                if (event_mask == EVENT_MASK_ATTR_SET ||
+                    event_mask == EVENT_MASK_ATTR_DEL)
+                  cache->attr_changed(handle_state->normal_name, name);
+                else
+                  cache->child_changed(handle_state->normal_name, name);
+              }
+
+              // cached handles may be registered for more events than the
+              // application asked for
+              if (handle_state->callback &&
+                  (handle_state->event_mask & event_mask)) {
                 if (event_mask == EVENT_MASK_ATTR_SET)
                   handle_state->callback->attr_set(name);
                 else if (event_mask == EVENT_MASK_ATTR_DEL)
@@ -184,6 +196,15 @@ void ClientKeepaliveHandler::handle(Hypertable::EventPtr &event) {
                   handle_state->callback->child_node_removed(name);
               }
             }
+            else if (event_mask == EVENT_MASK_NODE_REMOVED) {
+              name = decode_vstr(&msg, &remaining);
+
+              if (event_id <= m_last_known_event)
+                continue;
+
+              if (handle_state->cached)
+                m_session->get_cache()->node_removed(handle_state->normal_name);
+            }
             else if (event_mask == EVENT_MASK_LOCK_ACQUIRED) {
               uint32_t mode = decode_i32(&msg, &remaining);
 
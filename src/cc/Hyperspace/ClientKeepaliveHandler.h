@@ -62,6 +62,19 @@ namespace Hyperspace {
       m_handle_map.erase(handle);
     }
 
+    /**
+     * Replaces the application callback of a registered handle.  Used when
+     * an idle cached handle is retained or handed out again.
+     */
+    void rebind_handle(uint64_t handle, HandleCallbackPtr &callback) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      HandleMap::iterator iter = m_handle_map.find(handle);
+      if (iter != m_handle_map.end()) {
+        (*iter).second->callback = callback;
+        (*iter).second->event_mask = (callback) ? callback->get_event_mask() : 0;
+      }
+    }
+
     bool get_handle_state(uint64_t handle, ClientHandleStatePtr &handle_state) {
       boost::mutex::scoped_lock lock(m_mutex);
       HandleMap::iterator iter = m_handle_map.find(handle);
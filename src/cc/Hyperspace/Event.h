@@ -38,13 +38,21 @@ namespace Hyperspace {
 
   class Event : public Hypertable::ReferenceCount {
   public:
-    Event(uint32_t mask) : m_mask(mask), m_notification_count(0) {
-      boost::mutex::scoped_lock lock(ms_next_event_id_mutex);
-      m_id = ms_next_event_id++;
+    Event(uint32_t mask) : m_id(0), m_mask(mask), m_notification_count(0) {
       return;
     }
     virtual ~Event() { return; }
 
+    /**
+     * Gives the event the next id.  Clients drop events whose id is not
+     * above the last one they saw, so ids must be assigned in the order
+     * the events are queued to sessions, not when they are built.
+     */
+    void assign_id() {
+      boost::mutex::scoped_lock lock(ms_next_event_id_mutex);
+      m_id = ms_next_event_id++;
+    }
+
     uint64_t get_id() { return m_id; }
 
     uint32_t get_mask() { return m_mask; }
@@ -0,0 +1,69 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERSPACE_EVENTSEQUENCER_H
+#define HYPERSPACE_EVENTSEQUENCER_H
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace Hyperspace {
+
+  /**
+   * Lets the writers of committed transactions queue their events one at
+   * a time, in commit order.  A writer takes a ticket right after it
+   * commits, while it still holds the node locks that ordered the commit,
+   * and later brackets its flush and event delivery with begin() and
+   * end().  Every ticket taken must be passed to begin() and end(),
+   * otherwise all later holders wait forever.
+   */
+  class EventSequencer {
+  public:
+    EventSequencer() : m_next_ticket(0), m_serving(0) { return; }
+
+    uint64_t take_ticket() {
+      boost::mutex::scoped_lock lock(m_mutex);
+      return m_next_ticket++;
+    }
+
+    /** Waits until every ticket before this one has called end() */
+    void begin(uint64_t ticket) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (m_serving != ticket)
+        m_cond.wait(lock);
+    }
+
+    void end() {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_serving++;
+      m_cond.notify_all();
+    }
+
+  private:
+    boost::mutex     m_mutex;
+    boost::condition m_cond;
+    uint64_t         m_next_ticket;
+    uint64_t         m_serving;
+  };
+
+}
+
+#endif // HYPERSPACE_EVENTSEQUENCER_H
@@ -39,6 +39,8 @@ namespace Hyperspace {
       return "EVENT_MASK_LOCK_RELEASED";
     else if (mask == EVENT_MASK_LOCK_GRANTED)
       return "EVENT_MASK_LOCK_GRANTED";
+    else if (mask == EVENT_MASK_NODE_REMOVED)
+      return "EVENT_MASK_NODE_REMOVED";
     return "UNKNOWN";
   }
 
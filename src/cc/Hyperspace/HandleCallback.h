@@ -41,7 +41,10 @@ namespace Hyperspace {
     EVENT_MASK_CHILD_NODE_REMOVED = 0x0008,
     EVENT_MASK_LOCK_ACQUIRED      = 0x0010,
     EVENT_MASK_LOCK_RELEASED      = 0x0020,
-    EVENT_MASK_LOCK_GRANTED       = 0x0040
+    EVENT_MASK_LOCK_GRANTED       = 0x0040,
+    /** Node itself was deleted; consumed by the client cache, not reported
+     * to the application */
+    EVENT_MASK_NODE_REMOVED       = 0x0080
   };
 
   const char *event_mask_to_string(uint32_t mask);
@@ -65,7 +65,8 @@ const uint32_t Master::DEFAULT_KEEPALIVE_INTERVAL;
  */
 Master::Master(ConnectionManagerPtr &conn_mgr, PropertiesPtr &props,
                ServerKeepaliveHandlerPtr &keepalive_handler)
-    : m_verbose(false), m_next_handle_number(1), m_next_session_id(1) {
+    : m_verbose(false), m_next_handle_number(1), m_next_session_id(1),
+      m_next_expiry_shard(0) {
   const char *dirname;
   std::string str;
   uint16_t port;
@@ -78,6 +79,11 @@ Master::Master(ConnectionManagerPtr &conn_mgr, PropertiesPtr &props,
   m_keep_alive_interval = props->get_int("Hyperspace.KeepAlive.Interval",
                                          DEFAULT_KEEPALIVE_INTERVAL);
 
+  m_expiry_batch = props->get_int("Hyperspace.Session.ExpiryBatch",
+                                  DEFAULT_EXPIRY_BATCH);
+  if (m_expiry_batch == 0)
+    m_expiry_batch = 1;
+
   if ((dirname = props->get("Hyperspace.Master.Dir", 0)) == 0) {
     HT_ERROR("Property 'Hyperspace.Master.Dir' not found.");
     exit(1);
@@ -132,7 +138,7 @@ Master::Master(ConnectionManagerPtr &conn_mgr, PropertiesPtr &props,
 
   NodeDataPtr root_node = new NodeData();
   root_node->name = "/";
-  m_node_map["/"] = root_node;
+  m_node_map.set("/", root_node);
 
   port = props->get_int("Hyperspace.Master.Port", DEFAULT_MASTER_PORT);
   InetAddr::initialize(&m_local_addr, INADDR_ANY, port);
@@ -161,105 +167,115 @@ Master::~Master() {
 
 
 uint64_t Master::create_session(struct sockaddr_in &addr) {
-  boost::mutex::scoped_lock lock(m_session_map_mutex);
   SessionDataPtr session_data;
-  uint64_t session_id = m_next_session_id++;
+  uint64_t session_id;
+  {
+    boost::mutex::scoped_lock lock(m_id_mutex);
+    session_id = m_next_session_id++;
+  }
   session_data = new SessionData(addr, m_lease_interval, session_id);
-  m_session_map[session_id] = session_data;
-  m_session_heap.push_back(session_data);
+  m_session_map.set(session_id, session_data);
   return session_id;
 }
 
 
 bool Master::get_session(uint64_t session_id, SessionDataPtr &session_data) {
-  boost::mutex::scoped_lock lock(m_session_map_mutex);
-  SessionMap::iterator iter = m_session_map.find(session_id);
-  if (iter == m_session_map.end())
-    return false;
-  session_data = (*iter).second;
-  return true;
+  return m_session_map.get(session_id, session_data);
 }
 
+/**
+ * Removes the session from the map and destroys its handles.  The removal
+ * is a single shard operation, so a concurrent sweep or destroy_session
+ * cannot also claim the session.
+ */
 void Master::destroy_session(uint64_t session_id) {
-  boost::mutex::scoped_lock lock(m_session_map_mutex);
   SessionDataPtr session_data;
-  SessionMap::iterator iter = m_session_map.find(session_id);
-  if (iter == m_session_map.end())
+  if (!m_session_map.remove(session_id, session_data))
     return;
-  session_data = (*iter).second;
-  m_session_map.erase(session_id);
-  session_data->expire();
-  // force it to top of expiration heap
-  boost::xtime_get(&session_data->expire_time, boost::TIME_UTC);
+  expire_session(session_data);
 }
 
 
 int Master::renew_session_lease(uint64_t session_id) {
-  boost::mutex::scoped_lock lock(m_session_map_mutex);
+  SessionDataPtr session_data;
 
-  SessionMap::iterator iter = m_session_map.find(session_id);
-  if (iter == m_session_map.end())
+  if (!m_session_map.get(session_id, session_data))
     return Error::HYPERSPACE_EXPIRED_SESSION;
 
-  if (!(*iter).second->renew_lease())
+  if (!session_data->renew_lease())
     return Error::HYPERSPACE_EXPIRED_SESSION;
 
   return Error::OK;
 }
 
-bool Master::next_expired_session(SessionDataPtr &session_data) {
-  boost::mutex::scoped_lock lock(m_session_map_mutex);
-  struct LtSessionData ascending;
+
+namespace {
+  struct SessionExpired {
+    SessionExpired(boost::xtime &now) : m_now(now) { }
+    bool operator()(const SessionDataPtr &session_data) const {
+      return session_data->is_expired(m_now);
+    }
+    boost::xtime &m_now;
+  };
+}
+
+
+/**
+ * Sweeps the session map one shard at a time, resuming where the previous
+ * call left off, and stops once m_expiry_batch sessions have been removed.
+ * Handles are destroyed after the shard lock has been released.
+ */
+bool Master::remove_expired_sessions() {
+  SessionDataVec expired;
   boost::xtime now;
+  size_t shards = m_session_map.shard_count();
+  size_t i;
 
   boost::xtime_get(&now, boost::TIME_UTC);
 
-  if (m_session_heap.size() > 0) {
-    std::make_heap(m_session_heap.begin(), m_session_heap.end(), ascending);
-    if (m_session_heap[0]->is_expired(now)) {
-      session_data = m_session_heap[0];
-      std::pop_heap(m_session_heap.begin(), m_session_heap.end(), ascending);
-      m_session_heap.resize(m_session_heap.size()-1);
-      m_session_map.erase(session_data->id);
-      return true;
-    }
+  for (i=0; i<shards && expired.size() < m_expiry_batch; i++) {
+    m_session_map.remove_if(m_next_expiry_shard, SessionExpired(now), expired,
+                            m_expiry_batch - expired.size());
+    if (expired.size() < m_expiry_batch)
+      m_next_expiry_shard = (m_next_expiry_shard + 1) % shards;
   }
-  return false;
+
+  foreach(SessionDataPtr &session_data, expired)
+    expire_session(session_data);
+
+  return expired.size() == m_expiry_batch;
 }
 
 
 /**
- *
+ * Expires a session that has already been removed from the session map
+ * and destroys the handles it holds.
  */
-void Master::remove_expired_sessions() {
-  SessionDataPtr session_data;
+void Master::expire_session(SessionDataPtr &session_data) {
   int error;
   std::string errmsg;
 
-  while (next_expired_session(session_data)) {
+  if (m_verbose) {
+    HT_INFOF("Expiring session %lld", session_data->id);
+  }
 
-    if (m_verbose) {
-      HT_INFOF("Expiring session %lld", session_data->id);
-    }
+  session_data->expire();
 
-    session_data->expire();
+  std::set<uint64_t> handles;
+  {
+    boost::mutex::scoped_lock slock(session_data->mutex);
+    handles.swap(session_data->handles);
+  }
 
-    {
-      boost::mutex::scoped_lock slock(session_data->mutex);
-      HandleDataPtr handle_data;
-      foreach(uint64_t handle, session_data->handles) {
-        if (m_verbose) {
-          HT_INFOF("Destroying handle %llu", (Llu)handle);
-        }
-        if (!destroy_handle(handle, &error, errmsg, false)) {
-          HT_ERRORF("Problem destroying handle - %s (%s)",
-                    Error::get_text(error), errmsg.c_str());
-        }
-      }
-      session_data->handles.clear();
+  foreach(uint64_t handle, handles) {
+    if (m_verbose) {
+      HT_INFOF("Destroying handle %llu", (Llu)handle);
+    }
+    if (!destroy_handle(handle, &error, errmsg, false)) {
+      HT_ERRORF("Problem destroying handle - %s (%s)",
+                Error::get_text(error), errmsg.c_str());
     }
   }
-
 }
 
 
@@ -267,37 +283,28 @@ void Master::remove_expired_sessions() {
  *
  */
 void Master::create_handle(uint64_t *handlep, HandleDataPtr &handle_data) {
-  boost::mutex::scoped_lock lock(m_handle_map_mutex);
-  *handlep = ++m_next_handle_number;
+  {
+    boost::mutex::scoped_lock lock(m_id_mutex);
+    *handlep = ++m_next_handle_number;
+  }
   handle_data = new HandleData();
   handle_data->id = *handlep;
   handle_data->locked = false;
-  m_handle_map[*handlep] = handle_data;
+  m_handle_map.set(*handlep, handle_data);
 }
 
 /**
  *
  */
 bool Master::get_handle_data(uint64_t handle, HandleDataPtr &handle_data) {
-  boost::mutex::scoped_lock lock(m_handle_map_mutex);
-  HandleMap::iterator iter = m_handle_map.find(handle);
-  if (iter == m_handle_map.end())
-    return false;
-  handle_data = (*iter).second;
-  return true;
+  return m_handle_map.get(handle, handle_data);
 }
 
 /**
  *
  */
 bool Master::remove_handle_data(uint64_t handle, HandleDataPtr &handle_data) {
-  boost::mutex::scoped_lock lock(m_handle_map_mutex);
-  HandleMap::iterator iter = m_handle_map.find(handle);
-  if (iter == m_handle_map.end())
-    return false;
-  handle_data = (*iter).second;
-  m_handle_map.erase(iter);
-  return true;
+  return m_handle_map.remove(handle, handle_data);
 }
 
 
@@ -311,6 +318,8 @@ Master::mkdir(ResponseCallback *cb, uint64_t session_id, const char *name) {
   std::string abs_name;
   NodeDataPtr parent_node;
   std::string child_name;
+  NodeEventVec events;
+  uint64_t ticket;
 
   if (m_verbose) {
     HT_INFOF("mkdir(session_id=%lld, name=%s)", session_id, name);
@@ -330,12 +339,12 @@ Master::mkdir(ResponseCallback *cb, uint64_t session_id, const char *name) {
 
     m_bdb_fs->mkdir(txn, name);
 
-    txn->commit(0);
+    m_bdb_fs->commit_transaction(txn);
+
+    events.push_back(std::make_pair(parent_node, HyperspaceEventPtr(
+        new EventNamed(EVENT_MASK_CHILD_NODE_ADDED, child_name))));
 
-    // deliver event notifications
-    HyperspaceEventPtr event(new EventNamed(EVENT_MASK_CHILD_NODE_ADDED,
-                                            child_name));
-    deliver_event_notifications(parent_node.get(), event);
+    ticket = m_event_sequencer.take_ticket();
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -344,6 +353,8 @@ Master::mkdir(ResponseCallback *cb, uint64_t session_id, const char *name) {
     return;
   }
 
+  deliver_events(events, ticket);
+
   cb->response_ok();
 }
 
@@ -356,6 +367,8 @@ void
 Master::unlink(ResponseCallback *cb, uint64_t session_id, const char *name) {
   std::string child_name;
   NodeDataPtr parent_node;
+  NodeEventVec events;
+  uint64_t ticket;
 
   if (m_verbose) {
     HT_INFOF("unlink(session_id=%lld, name=%s)", session_id, name);
@@ -381,12 +394,18 @@ Master::unlink(ResponseCallback *cb, uint64_t session_id, const char *name) {
 
     m_bdb_fs->unlink(txn, name);
 
-    txn->commit(0);
+    m_bdb_fs->commit_transaction(txn);
+
+    events.push_back(std::make_pair(parent_node, HyperspaceEventPtr(
+        new EventNamed(EVENT_MASK_CHILD_NODE_REMOVED, child_name))));
 
-    // deliver event notifications
-    HyperspaceEventPtr event_ptr(new EventNamed(EVENT_MASK_CHILD_NODE_REMOVED,
-                                                child_name));
-    deliver_event_notifications(parent_node.get(), event_ptr);
+    // let handles still open on the node drop what they have cached
+    NodeDataPtr node_data;
+    if (m_node_map.get(name, node_data))
+      events.push_back(std::make_pair(node_data, HyperspaceEventPtr(
+          new EventNamed(EVENT_MASK_NODE_REMOVED, child_name))));
+
+    ticket = m_event_sequencer.take_ticket();
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -395,6 +414,8 @@ Master::unlink(ResponseCallback *cb, uint64_t session_id, const char *name) {
     return;
   }
 
+  deliver_events(events, ticket);
+
   cb->response_ok();
 }
 
@@ -418,6 +439,8 @@ Master::open(ResponseCallbackOpen *cb, uint64_t session_id, const char *name,
   bool lock_notifiy = false;
   uint32_t lock_mode = 0;
   uint64_t lock_generation = 0;
+  NodeEventVec events;
+  uint64_t ticket;
 
   if (m_verbose) {
     HT_INFOF("open(session_id=%lld, fname=%s, flags=0x%x, event_mask=0x%x)",
@@ -512,9 +535,13 @@ Master::open(ResponseCallbackOpen *cb, uint64_t session_id, const char *name,
       session_data->add_handle(handle);
 
       if (created) {
-        HyperspaceEventPtr event(new EventNamed(EVENT_MASK_CHILD_NODE_ADDED,
-                                                child_name));
-        deliver_event_notifications(parent_node.get(), event);
+        events.push_back(std::make_pair(parent_node, HyperspaceEventPtr(
+            new EventNamed(EVENT_MASK_CHILD_NODE_ADDED, child_name))));
+
+        // handles left open across a delete see the initial attributes
+        for (size_t i=0; i<init_attrs.size(); i++)
+          events.push_back(std::make_pair(node_data, HyperspaceEventPtr(
+              new EventNamed(EVENT_MASK_ATTR_SET, init_attrs[i].name))));
       }
 
       /**
@@ -530,15 +557,16 @@ Master::open(ResponseCallbackOpen *cb, uint64_t session_id, const char *name,
         lock_handle(handle_data, lock_mode);
 
         // deliver notification to handles to this same node
-        if (lock_notifiy) {
-          HyperspaceEventPtr event(new EventLockAcquired(lock_mode));
-          deliver_event_notifications(handle_data->node, event);
-        }
+        if (lock_notifiy)
+          events.push_back(std::make_pair(node_data, HyperspaceEventPtr(
+              new EventLockAcquired(lock_mode))));
       }
 
       handle_data->node->add_handle(handle, handle_data);
 
-      txn->commit(0);
+      m_bdb_fs->commit_transaction(txn);
+
+      ticket = m_event_sequencer.take_ticket();
     }
   }
   catch (Exception &e) {
@@ -548,6 +576,8 @@ Master::open(ResponseCallbackOpen *cb, uint64_t session_id, const char *name,
     return;
   }
 
+  deliver_events(events, ticket);
+
   cb->response(handle, created, lock_generation);
 }
 
@@ -582,6 +612,8 @@ void Master::close(ResponseCallback *cb, uint64_t session_id, uint64_t handle) {
     }
   }
 
+  m_bdb_fs->flush_commits();
+
   if ((error = cb->response_ok()) != Error::OK) {
     HT_ERRORF("Problem sending back response - %s", Error::get_text(error));
   }
@@ -597,6 +629,8 @@ Master::attr_set(ResponseCallback *cb, uint64_t session_id, uint64_t handle,
                  const char *name, const void *value, size_t value_len) {
   SessionDataPtr session_data;
   HandleDataPtr handle_data;
+  NodeEventVec events;
+  uint64_t ticket;
   int error;
 
   if (m_verbose) {
@@ -618,11 +652,13 @@ Master::attr_set(ResponseCallback *cb, uint64_t session_id, uint64_t handle,
 
       m_bdb_fs->set_xattr(txn, handle_data->node->name, name, value, value_len);
 
-      HyperspaceEventPtr event(new EventNamed(EVENT_MASK_ATTR_SET, name));
-      deliver_event_notifications(handle_data->node, event);
-    }
+      events.push_back(std::make_pair(NodeDataPtr(handle_data->node),
+          HyperspaceEventPtr(new EventNamed(EVENT_MASK_ATTR_SET, name))));
 
-    txn->commit(0);
+      m_bdb_fs->commit_transaction(txn);
+
+      ticket = m_event_sequencer.take_ticket();
+    }
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -631,6 +667,8 @@ Master::attr_set(ResponseCallback *cb, uint64_t session_id, uint64_t handle,
     return;
   }
 
+  deliver_events(events, ticket);
+
   if ((error = cb->response_ok()) != Error::OK)
     HT_ERRORF("Problem sending back response - %s", Error::get_text(error));
 }
@@ -686,6 +724,8 @@ Master::attr_get(ResponseCallbackAttrGet *cb, uint64_t session_id,
 void Master::attr_del(ResponseCallback *cb, uint64_t session_id, uint64_t handle, const char *name) {
   SessionDataPtr session_data;
   HandleDataPtr handle_data;
+  NodeEventVec events;
+  uint64_t ticket;
   int error;
 
   if (m_verbose)
@@ -706,11 +746,13 @@ void Master::attr_del(ResponseCallback *cb, uint64_t session_id, uint64_t handle
 
       m_bdb_fs->del_xattr(txn, handle_data->node->name, name);
 
-      HyperspaceEventPtr event(new EventNamed(EVENT_MASK_ATTR_DEL, name));
-      deliver_event_notifications(handle_data->node, event);
-    }
+      events.push_back(std::make_pair(NodeDataPtr(handle_data->node),
+          HyperspaceEventPtr(new EventNamed(EVENT_MASK_ATTR_DEL, name))));
 
-    txn->commit(0);
+      m_bdb_fs->commit_transaction(txn);
+
+      ticket = m_event_sequencer.take_ticket();
+    }
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -719,6 +761,8 @@ void Master::attr_del(ResponseCallback *cb, uint64_t session_id, uint64_t handle
     return;
   }
 
+  deliver_events(events, ticket);
+
   if ((error = cb->response_ok()) != Error::OK)
     HT_ERRORF("Problem sending back response - %s", Error::get_text(error));
 }
@@ -753,6 +797,63 @@ Master::exists(ResponseCallbackExists *cb, uint64_t session_id,
 }
 
 
+/**
+ * Executes a list of operations in a single transaction.  If any operation
+ * fails, the transaction is aborted and the error of the failing operation
+ * is returned.  Event notifications are delivered once the transaction has
+ * committed and been flushed.
+ */
+void
+Master::batch(ResponseCallbackBatch *cb, uint64_t session_id,
+              std::vector<BatchOp> &ops) {
+  SessionDataPtr session_data;
+  NodeEventVec events;
+  std::vector<NodeDataPtr> created;
+  uint64_t ticket;
+  size_t i = 0;
+  int error;
+
+  if (m_verbose)
+    HT_INFOF("batch(session_id=%lld, ops=%d)", session_id, (int)ops.size());
+
+  DbTxn *txn = m_bdb_fs->start_transaction();
+
+  try {
+    BatchNodeLocks locks;
+
+    if (!get_session(session_id, session_data))
+      HT_THROWF(Error::HYPERSPACE_EXPIRED_SESSION, "%llu", (Llu)session_id);
+
+    lock_batch_nodes(ops, locks);
+
+    for (i=0; i<ops.size(); i++)
+      execute_batch_op(txn, ops[i], locks, events, created);
+
+    m_bdb_fs->commit_transaction(txn);
+
+    for (size_t j=0; j<created.size(); j++)
+      created[j]->lock_generation = 1;
+
+    ticket = m_event_sequencer.take_ticket();
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    txn->abort();
+    if (i < ops.size())
+      cb->error(e.code(), format("operation %d on '%s' - %s", (int)i,
+                ops[i].name.c_str(), e.what()));
+    else
+      cb->error(e.code(), e.what());
+    return;
+  }
+
+  deliver_events(events, ticket);
+
+  if ((error = cb->response(ops)) != Error::OK)
+    HT_ERRORF("Problem sending back response - %s", Error::get_text(error));
+}
+
+
 void
 Master::readdir(ResponseCallbackReaddir *cb, uint64_t session_id,
                 uint64_t handle) {
@@ -877,7 +978,9 @@ Master::lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t handle,
     try {
       m_bdb_fs->set_xattr_i64(txn, handle_data->node->name, "lock.generation",
                               handle_data->node->lock_generation);
-      txn->commit(0);
+      m_bdb_fs->commit_transaction(txn);
+      // the grant is an acknowledgement, so make it durable first
+      m_bdb_fs->flush_commits();
     }
     catch (Exception &e) {
       HT_ERROR_OUT << e << HT_END;
@@ -1017,7 +1120,8 @@ void Master::release_lock(HandleDataPtr &handle_data, bool wait_for_notify) {
       try {
         m_bdb_fs->set_xattr_i64(txn, handle_data->node->name, "lock.generation",
                                 handle_data->node->lock_generation);
-        txn->commit(0);
+        m_bdb_fs->commit_transaction(txn);
+        m_bdb_fs->flush_commits();
       }
       catch (Exception &e) {
         txn->abort();
@@ -1049,16 +1153,22 @@ Master::deliver_event_notifications(NodeData *node,
     HyperspaceEventPtr &event_ptr, bool wait_for_notify) {
   int notifications = 0;
 
-  // log event
-  for (HandleMap::iterator iter = node->handle_map.begin();
-       iter != node->handle_map.end(); iter++) {
-    //HT_INFOF("Delivering notification (%d == %d)", (*iter).second->event_mask, event_ptr->get_mask());
-    if ((*iter).second->event_mask & event_ptr->get_mask()) {
-      (*iter).second->session_data->add_notification(
-          new Notification((*iter).first, event_ptr));
-      m_keepalive_handler_ptr->deliver_event_notifications(
-          (*iter).second->session_data->id);
-      notifications++;
+  {
+    // the id and the queueing must be atomic; see Event::assign_id
+    boost::mutex::scoped_lock lock(m_event_mutex);
+
+    event_ptr->assign_id();
+
+    for (NodeData::HandleMap::iterator iter = node->handle_map.begin();
+         iter != node->handle_map.end(); iter++) {
+      //HT_INFOF("Delivering notification (%d == %d)", (*iter).second->event_mask, event_ptr->get_mask());
+      if ((*iter).second->event_mask & event_ptr->get_mask()) {
+        (*iter).second->session_data->add_notification(
+            new Notification((*iter).first, event_ptr));
+        m_keepalive_handler_ptr->deliver_event_notifications(
+            (*iter).second->session_data);
+        notifications++;
+      }
     }
   }
 
@@ -1067,6 +1177,39 @@ Master::deliver_event_notifications(NodeData *node,
 }
 
 
+/**
+ * Delivers events collected during a transaction.  ticket is the one
+ * taken from m_event_sequencer right after the commit, under the node
+ * locks; waiting for its turn makes events reach sessions in commit order
+ * with increasing ids.  The commit is flushed first so that clients never
+ * see a change that could still be lost.  Locks each node in turn; events
+ * with a null node are skipped.  Acknowledgements are waited for only
+ * after the turn has been passed on.
+ */
+void Master::deliver_events(NodeEventVec &events, uint64_t ticket,
+                            bool wait_for_notify) {
+  m_event_sequencer.begin(ticket);
+
+  m_bdb_fs->flush_commits();
+
+  for (size_t i=0; i<events.size(); i++) {
+    if (!events[i].first)
+      continue;
+    boost::mutex::scoped_lock node_lock(events[i].first->mutex);
+    deliver_event_notifications(events[i].first.get(), events[i].second,
+                                false);
+  }
+
+  m_event_sequencer.end();
+
+  if (wait_for_notify) {
+    for (size_t i=0; i<events.size(); i++)
+      if (events[i].first)
+        events[i].second->wait_for_notifications();
+  }
+}
+
+
 /**
  * Assumes node is locked.
  */
@@ -1074,11 +1217,14 @@ void
 Master::deliver_event_notification(HandleDataPtr &handle_data,
     HyperspaceEventPtr &event_ptr, bool wait_for_notify) {
 
-  // log event
-  handle_data->session_data->add_notification(
-      new Notification(handle_data->id, event_ptr));
-  m_keepalive_handler_ptr->deliver_event_notifications(
-      handle_data->session_data->id);
+  {
+    boost::mutex::scoped_lock lock(m_event_mutex);
+    event_ptr->assign_id();
+    handle_data->session_data->add_notification(
+        new Notification(handle_data->id, event_ptr));
+    m_keepalive_handler_ptr->deliver_event_notifications(
+        handle_data->session_data);
+  }
 
   if (wait_for_notify)
     event_ptr->wait_for_notifications();
@@ -1092,35 +1238,27 @@ Master::deliver_event_notification(HandleDataPtr &handle_data,
  */
 bool
 Master::find_parent_node(const std::string &normal_name,
-                         NodeDataPtr &parent_node, std::string &child_name) {
-  NodeMap::iterator node_it;
+                         NodeDataPtr &parent_node, std::string &child_name,
+                         bool create) {
   size_t last_slash = normal_name.rfind("/", normal_name.length());
 
   child_name.clear();
 
   if (last_slash > 0) {
-    boost::mutex::scoped_lock lock(m_node_map_mutex);
     std::string parent_name(normal_name, 0, last_slash);
     child_name.append(normal_name, last_slash + 1,
                       normal_name.length() - last_slash - 1);
-    node_it = m_node_map.find(parent_name);
-
-    if (node_it != m_node_map.end())
-      parent_node = (*node_it).second;
-    else {
-      parent_node = new NodeData();
-      parent_node->name = parent_name;
-      m_node_map[parent_name] = parent_node;
-    }
+    if (create)
+      get_node(parent_name, parent_node);
+    else if (!m_node_map.get(parent_name, parent_node))
+      parent_node = 0;
     return true;
   }
   else if (last_slash == 0) {
-    boost::mutex::scoped_lock lock(m_node_map_mutex);
-    std::string parent_name = "/";
-    node_it = m_node_map.find(parent_name);
-    assert (node_it != m_node_map.end());
+    bool found = m_node_map.get("/", parent_node);
+    assert(found);
+    (void)found;
     child_name.append(normal_name, 1, normal_name.length() - 1);
-    parent_node = (*node_it).second;
     return true;
   }
 
@@ -1128,6 +1266,163 @@ Master::find_parent_node(const std::string &normal_name,
 }
 
 
+/**
+ * Locks the nodes the operations of a batch touch, taking the same locks
+ * the single operations do: the parent for MKDIR and DELETE (as mkdir and
+ * unlink), the parent and the node for CREATE (as open), and the node for
+ * the attribute operations.  Nodes without a map entry are skipped; see
+ * execute_batch_op.
+ */
+void
+Master::lock_batch_nodes(std::vector<BatchOp> &ops, BatchNodeLocks &locks) {
+  NodeDataPtr node_data;
+  std::string child_name;
+
+  for (size_t i=0; i<ops.size(); i++) {
+    const std::string &name = ops[i].name;
+
+    switch (ops[i].type) {
+    case BATCH_OP_MKDIR:
+    case BATCH_OP_DELETE:
+    case BATCH_OP_CREATE:
+      if (find_parent_node(name, node_data, child_name, false) && node_data)
+        locks.add(node_data->name, node_data);
+      if (ops[i].type != BATCH_OP_CREATE)
+        break;
+      // fall through
+    case BATCH_OP_ATTR_SET:
+    case BATCH_OP_ATTR_GET:
+    case BATCH_OP_ATTR_DEL:
+      if (m_node_map.get(name, node_data))
+        locks.add(name, node_data);
+      break;
+    default:
+      break;
+    }
+  }
+
+  locks.lock();
+}
+
+
+/**
+ * Executes one operation of a batch within the given transaction,
+ * appending the events it generates to <code>events</code>.  Nodes are
+ * only looked up, never created: a path without a node in the map has no
+ * open handles to notify, and creating one would leak it, since only
+ * destroy_handle removes entries.  Events for such nodes carry a null
+ * node and are skipped on delivery.  The nodes locked by lock_batch_nodes
+ * are taken from <code>locks</code> rather than the map, so an operation
+ * never acts on a node it does not hold the lock of.
+ */
+void
+Master::execute_batch_op(DbTxn *txn, BatchOp &op, BatchNodeLocks &locks,
+                         NodeEventVec &events,
+                         std::vector<NodeDataPtr> &created) {
+  const char *name = op.name.c_str();
+  NodeDataPtr parent_node;
+  NodeDataPtr node_data;
+  std::string child_name;
+  DynamicBuffer dbuf;
+  bool is_dir;
+
+  if (name[0] != '/' || (op.name.length() > 1 && name[op.name.length()-1] == '/'))
+    HT_THROW(Error::HYPERSPACE_BAD_PATHNAME, name);
+
+  switch (op.type) {
+
+  case BATCH_OP_MKDIR:
+    if (!(op.flags & OPEN_FLAG_EXCL) && m_bdb_fs->exists(txn, name, &is_dir)) {
+      if (!is_dir)
+        HT_THROW(Error::HYPERSPACE_FILE_EXISTS, name);
+      break;
+    }
+    if (!find_parent_node(name, parent_node, child_name, false))
+      HT_THROW(Error::HYPERSPACE_FILE_EXISTS, "directory '/' exists");
+    m_bdb_fs->mkdir(txn, name);
+    events.push_back(std::make_pair(parent_node, HyperspaceEventPtr(
+        new EventNamed(EVENT_MASK_CHILD_NODE_ADDED, child_name))));
+    break;
+
+  case BATCH_OP_CREATE:
+    if (op.flags & OPEN_FLAG_TEMP)
+      HT_THROW(Error::HYPERSPACE_CREATE_FAILED,
+               "TEMP files cannot be created in a batch");
+    if (!find_parent_node(name, parent_node, child_name, false))
+      HT_THROW(Error::HYPERSPACE_IS_DIRECTORY, name);
+    locks.get(name, node_data);
+    if (m_bdb_fs->exists(txn, name)) {
+      if (op.flags & OPEN_FLAG_EXCL)
+        HT_THROW(Error::HYPERSPACE_FILE_EXISTS, "mode=CREATE|EXCL");
+    }
+    else {
+      m_bdb_fs->create(txn, name, false);
+      m_bdb_fs->set_xattr_i64(txn, name, "lock.generation", 1);
+      if (node_data)
+        created.push_back(node_data);
+      events.push_back(std::make_pair(parent_node, HyperspaceEventPtr(
+          new EventNamed(EVENT_MASK_CHILD_NODE_ADDED, child_name))));
+    }
+    for (size_t i=0; i<op.attrs.size(); i++) {
+      m_bdb_fs->set_xattr(txn, name, op.attrs[i].name, op.attrs[i].value,
+                          op.attrs[i].value_len);
+      events.push_back(std::make_pair(node_data, HyperspaceEventPtr(
+          new EventNamed(EVENT_MASK_ATTR_SET, op.attrs[i].name))));
+    }
+    break;
+
+  case BATCH_OP_DELETE:
+    if (!find_parent_node(name, parent_node, child_name, false))
+      HT_THROW(Error::HYPERSPACE_PERMISSION_DENIED,
+               "Cannot remove '/' directory");
+    m_node_map.get(name, node_data);
+    m_bdb_fs->unlink(txn, name);
+    events.push_back(std::make_pair(parent_node, HyperspaceEventPtr(
+        new EventNamed(EVENT_MASK_CHILD_NODE_REMOVED, child_name))));
+    events.push_back(std::make_pair(node_data, HyperspaceEventPtr(
+        new EventNamed(EVENT_MASK_NODE_REMOVED, child_name))));
+    break;
+
+  case BATCH_OP_ATTR_SET:
+    locks.get(name, node_data);
+    for (size_t i=0; i<op.attrs.size(); i++) {
+      m_bdb_fs->set_xattr(txn, name, op.attrs[i].name, op.attrs[i].value,
+                          op.attrs[i].value_len);
+      events.push_back(std::make_pair(node_data, HyperspaceEventPtr(
+          new EventNamed(EVENT_MASK_ATTR_SET, op.attrs[i].name))));
+    }
+    break;
+
+  case BATCH_OP_ATTR_GET:
+    op.values.clear();
+    for (size_t i=0; i<op.attrs.size(); i++) {
+      dbuf.clear();
+      if (!m_bdb_fs->get_xattr(txn, name, op.attrs[i].name, dbuf))
+        HT_THROW(Error::HYPERSPACE_ATTR_NOT_FOUND, op.attrs[i].name);
+      op.values.push_back(std::string((const char *)dbuf.base, dbuf.fill()));
+    }
+    break;
+
+  case BATCH_OP_ATTR_DEL:
+    locks.get(name, node_data);
+    for (size_t i=0; i<op.attrs.size(); i++) {
+      m_bdb_fs->del_xattr(txn, name, op.attrs[i].name);
+      events.push_back(std::make_pair(node_data, HyperspaceEventPtr(
+          new EventNamed(EVENT_MASK_ATTR_DEL, op.attrs[i].name))));
+    }
+    break;
+
+  case BATCH_OP_EXISTS:
+    op.exists = m_bdb_fs->exists(txn, name);
+    break;
+
+  default:
+    HT_THROWF(Error::PROTOCOL_ERROR, "Invalid batch operation type (%d)",
+              (int)op.type);
+  }
+}
+
+
 /**
  *
  */
@@ -1157,19 +1452,16 @@ Master::destroy_handle(uint64_t handle, int *errorp, std::string &errmsg,
     if (handle_data->node->ephemeral) {
       std::string child_name;
       NodeDataPtr parent_node;
-
-      if (find_parent_node(handle_data->node->name, parent_node, child_name)) {
-        HyperspaceEventPtr event(new EventNamed(EVENT_MASK_CHILD_NODE_REMOVED,
-                                                child_name));
-        deliver_event_notifications(parent_node.get(), event, wait_for_notify);
-      }
+      NodeEventVec events;
+      uint64_t ticket = 0;
 
       // remove file from database
       DbTxn *txn = m_bdb_fs->start_transaction();
 
       try {
         m_bdb_fs->unlink(txn, handle_data->node->name);
-        txn->commit(0);
+        m_bdb_fs->commit_transaction(txn);
+        ticket = m_event_sequencer.take_ticket();
       }
       catch (DbException &e) {
         txn->abort();
@@ -1178,10 +1470,14 @@ Master::destroy_handle(uint64_t handle, int *errorp, std::string &errmsg,
       }
 
       // remove node
-      NodeMap::iterator node_it = m_node_map.find(handle_data->node->name);
+      m_node_map.remove(handle_data->node->name);
+
+      if (find_parent_node(handle_data->node->name, parent_node, child_name))
+        events.push_back(std::make_pair(parent_node, HyperspaceEventPtr(
+            new EventNamed(EVENT_MASK_CHILD_NODE_REMOVED, child_name))));
 
-      if (node_it != m_node_map.end())
-        m_node_map.erase(node_it);
+      // passes the ticket on even if there is nothing to deliver
+      deliver_events(events, ticket, wait_for_notify);
     }
   }
 
@@ -22,6 +22,7 @@
 #ifndef HYPERSPACE_MASTER_H
 #define HYPERSPACE_MASTER_H
 
+#include <map>
 #include <queue>
 #include <vector>
 
@@ -39,16 +40,19 @@
 #include "AsyncComm/ResponseCallback.h"
 
 #include "BerkeleyDbFilesystem.h"
+#include "EventSequencer.h"
 #include "NodeData.h"
 #include "HandleData.h"
 #include "Protocol.h"
 #include "ResponseCallbackOpen.h"
 #include "ResponseCallbackExists.h"
 #include "ResponseCallbackAttrGet.h"
+#include "ResponseCallbackBatch.h"
 #include "ResponseCallbackLock.h"
 #include "ResponseCallbackReaddir.h"
 #include "ServerKeepaliveHandler.h"
 #include "SessionData.h"
+#include "ShardedMap.h"
 
 
 namespace Hyperspace {
@@ -60,6 +64,7 @@ namespace Hyperspace {
     static const uint32_t DEFAULT_LEASE_INTERVAL     = 20;
     static const uint32_t DEFAULT_KEEPALIVE_INTERVAL = 10;
     static const uint32_t DEFAULT_GRACEPERIOD        = 60;
+    static const uint32_t DEFAULT_EXPIRY_BATCH       = 64;
 
     Master(ConnectionManagerPtr &, PropertiesPtr &,
            ServerKeepaliveHandlerPtr &);
@@ -80,6 +85,8 @@ namespace Hyperspace {
                   const char *name);
     void exists(ResponseCallbackExists *cb, uint64_t session_id,
                 const char *name);
+    void batch(ResponseCallbackBatch *cb, uint64_t session_id,
+               std::vector<BatchOp> &ops);
     void readdir(ResponseCallbackReaddir *cb, uint64_t session_id,
                  uint64_t handle);
     void lock(ResponseCallbackLock *cb, uint64_t session_id, uint64_t handle,
@@ -117,8 +124,15 @@ namespace Hyperspace {
      */
     int renew_session_lease(uint64_t session_id);
 
-    bool next_expired_session(SessionDataPtr &session_data);
-    void remove_expired_sessions();
+    /**
+     * Removes and destroys the handles of sessions whose lease has run out.
+     * At most Hyperspace.Session.ExpiryBatch sessions are processed per
+     * call, so that a mass timeout is worked off over several timer ticks
+     * instead of holding up other requests.
+     *
+     * @return true if expired sessions may remain, false otherwise
+     */
+    bool remove_expired_sessions();
 
     void create_handle(uint64_t *handlep, HandleDataPtr &handle_data);
     bool get_handle_data(uint64_t session_id, HandleDataPtr &handle_data);
@@ -146,20 +160,69 @@ namespace Hyperspace {
      * sets the pointer reference 'parent_node' to it. As a side effect, it
      * also saves the child name (e.g. characters after the last '/' character
      * to the string reference child_name.  NOTE: This method locks the
-     * m_node_map_mutex.
+     * m_node_map shard holding the parent name.
      *
      * @param normal_name Normalized (e.g. no trailing '/') name of path to
      *        find parent of
      * @param parent_node pointer reference to hold return pointer
      * @param child_name reference to string to hold the child directory entry
      *        name
+     * @param create if false, parent_node is set to null instead of creating
+     *        a map entry when the parent has none
      * @return true if parent node found, false otherwise
      */
     bool find_parent_node(const std::string &normal_name,
-                          NodeDataPtr &parent_node, std::string &child_name);
+                          NodeDataPtr &parent_node, std::string &child_name,
+                          bool create=true);
     bool destroy_handle(uint64_t handle, int *errorp, std::string &errmsg,
                         bool wait_for_notify=true);
+    void expire_session(SessionDataPtr &session_data);
     void release_lock(HandleDataPtr &handle_data, bool wait_for_notify=true);
+
+    /**
+     * The node mutexes a batch holds while it executes and commits.  Nodes
+     * are locked in name order, which puts a parent before its children
+     * just as open does, and are unlocked when this object is destroyed.
+     */
+    class BatchNodeLocks {
+    public:
+      BatchNodeLocks() : m_locked(false) { return; }
+      ~BatchNodeLocks() { unlock(); }
+      void add(const std::string &name, NodeDataPtr &node) {
+        if (node)
+          m_nodes[name] = node;
+      }
+      void get(const std::string &name, NodeDataPtr &node) {
+        std::map<std::string, NodeDataPtr>::iterator iter = m_nodes.find(name);
+        node = (iter == m_nodes.end()) ? 0 : (*iter).second;
+      }
+      void lock() {
+        for (std::map<std::string, NodeDataPtr>::iterator iter =
+             m_nodes.begin(); iter != m_nodes.end(); ++iter)
+          (*iter).second->mutex.lock();
+        m_locked = true;
+      }
+      void unlock() {
+        if (!m_locked)
+          return;
+        for (std::map<std::string, NodeDataPtr>::reverse_iterator iter =
+             m_nodes.rbegin(); iter != m_nodes.rend(); ++iter)
+          (*iter).second->mutex.unlock();
+        m_locked = false;
+      }
+    private:
+      std::map<std::string, NodeDataPtr> m_nodes;
+      bool m_locked;
+    };
+
+    typedef std::vector<std::pair<NodeDataPtr, HyperspaceEventPtr> >
+        NodeEventVec;
+    void deliver_events(NodeEventVec &events, uint64_t ticket,
+                        bool wait_for_notify=true);
+    void lock_batch_nodes(std::vector<BatchOp> &ops, BatchNodeLocks &locks);
+    void execute_batch_op(DbTxn *txn, BatchOp &op, BatchNodeLocks &locks,
+                          NodeEventVec &events,
+                          std::vector<NodeDataPtr> &created);
     void lock_handle(HandleDataPtr &handle_data, uint32_t mode);
     void lock_handle_with_notification(HandleDataPtr &handle_data,
                                        uint32_t mode,
@@ -172,40 +235,37 @@ namespace Hyperspace {
      * @param name pathname of node
      * @param node_data Reference of node smart pointer to hold return node
      */
-    void get_node(std::string name, NodeDataPtr &node_data) {
-      boost::mutex::scoped_lock lock(m_node_map_mutex);
-      NodeMap::iterator iter = m_node_map.find(name);
-      if (iter != m_node_map.end()) {
-        node_data = (*iter).second;
+    void get_node(const std::string &name, NodeDataPtr &node_data) {
+      if (m_node_map.get(name, node_data))
         return;
-      }
       node_data = new NodeData();
       node_data->name = name;
-      m_node_map[name] = node_data;
+      m_node_map.get_or_insert(name, node_data);
     }
 
-    typedef hash_map<std::string, NodeDataPtr> NodeMap;
-    typedef hash_map<uint64_t, HandleDataPtr>  HandleMap;
-    typedef hash_map<uint64_t, SessionDataPtr> SessionMap;
+    typedef ShardedMap<std::string, NodeDataPtr> NodeMap;
+    typedef ShardedMap<uint64_t, HandleDataPtr>  HandleMap;
+    typedef ShardedMap<uint64_t, SessionDataPtr> SessionMap;
     typedef std::vector<SessionDataPtr> SessionDataVec;
 
     bool          m_verbose;
     uint32_t      m_lease_interval;
     uint32_t      m_keep_alive_interval;
+    uint32_t      m_expiry_batch;
     NodeMap       m_node_map;
     HandleMap     m_handle_map;
     SessionMap    m_session_map;
-    boost::mutex  m_node_map_mutex;
-    boost::mutex  m_handle_map_mutex;
-    boost::mutex  m_session_map_mutex;
+    boost::mutex  m_id_mutex;
+    boost::mutex  m_event_mutex;
+    EventSequencer m_event_sequencer;
     std::string   m_base_dir;
     int           m_base_fd;
     uint32_t      m_generation;
     uint64_t      m_next_handle_number;
     uint64_t      m_next_session_id;
+    size_t        m_next_expiry_shard;
     ServerKeepaliveHandlerPtr m_keepalive_handler_ptr;
     struct sockaddr_in m_local_addr;
-    SessionDataVec m_session_heap;
 
     // BerkeleyDB state
     BerkeleyDbFilesystem *m_bdb_fs;
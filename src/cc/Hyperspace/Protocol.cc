@@ -53,7 +53,8 @@ const char *Hyperspace::Protocol::command_strs[COMMAND_MAX] = {
   "lock",
   "release",
   "checksequencer",
-  "status"
+  "status",
+  "batch"
 };
 
 
@@ -142,7 +143,7 @@ CommBuf *Hyperspace::Protocol::create_handshake_request(uint64_t session_id) {
 /**
  *
  */
-CommBuf *Hyperspace::Protocol::create_open_request(const std::string &name, uint32_t flags, HandleCallbackPtr &callback, std::vector<Attribute> &init_attrs) {
+CommBuf *Hyperspace::Protocol::create_open_request(const std::string &name, uint32_t flags, uint32_t event_mask, std::vector<Attribute> &init_attrs) {
   size_t len = 14 + encoded_length_vstr(name.size());
   HeaderBuilder hbuilder(Header::PROTOCOL_HYPERSPACE, filename_to_group(name));
   for (size_t i=0; i<init_attrs.size(); i++)
@@ -152,10 +153,7 @@ CommBuf *Hyperspace::Protocol::create_open_request(const std::string &name, uint
 
   cbuf->append_i16(COMMAND_OPEN);
   cbuf->append_i32(flags);
-  if (callback)
-    cbuf->append_i32(callback->get_event_mask());
-  else
-    cbuf->append_i32(0);
+  cbuf->append_i32(event_mask);
   cbuf->append_vstr(name);
 
   // append initial attributes
@@ -244,6 +242,41 @@ CommBuf *Hyperspace::Protocol::create_exists_request(const std::string &name) {
 }
 
 
+/**
+ * Encodes a list of operations to be executed by the master in a single
+ * transaction.
+ */
+CommBuf *Hyperspace::Protocol::create_batch_request(std::vector<BatchOp> &ops) {
+  size_t len = 6;
+  uint32_t gid = ops.empty() ? 0 : filename_to_group(ops[0].name);
+  HeaderBuilder hbuilder(Header::PROTOCOL_HYPERSPACE, gid);
+
+  for (size_t i=0; i<ops.size(); i++) {
+    len += 10 + encoded_length_vstr(ops[i].name.size());
+    for (size_t j=0; j<ops[i].attrs.size(); j++)
+      len += encoded_length_vstr(strlen(ops[i].attrs[j].name)) +
+             encoded_length_vstr(ops[i].attrs[j].value_len);
+  }
+
+  CommBuf *cbuf = new CommBuf(hbuilder, len);
+
+  cbuf->append_i16(COMMAND_BATCH);
+  cbuf->append_i32(ops.size());
+  for (size_t i=0; i<ops.size(); i++) {
+    cbuf->append_i16(ops[i].type);
+    cbuf->append_i32(ops[i].flags);
+    cbuf->append_vstr(ops[i].name);
+    cbuf->append_i32(ops[i].attrs.size());
+    for (size_t j=0; j<ops[i].attrs.size(); j++) {
+      cbuf->append_vstr(ops[i].attrs[j].name);
+      cbuf->append_vstr(ops[i].attrs[j].value, ops[i].attrs[j].value_len);
+    }
+  }
+
+  return cbuf;
+}
+
+
 CommBuf *Hyperspace::Protocol::create_lock_request(uint64_t handle, uint32_t mode, bool try_lock) {
   HeaderBuilder hbuilder(Header::PROTOCOL_HYPERSPACE, (uint32_t)((handle ^ (handle >> 32)) & 0x0FFFFFFFFLL));
   CommBuf *cbuf = new CommBuf(hbuilder, 15);
@@ -21,6 +21,7 @@
 #ifndef HYPERSPACE_PROTOCOL_H
 #define HYPERSPACE_PROTOCOL_H
 
+#include <string>
 #include <vector>
 
 #include "AsyncComm/CommBuf.h"
@@ -45,6 +46,49 @@ namespace Hyperspace {
     uint32_t value_len;
   };
 
+  /**
+   * Operation types of a batch request (see Session#batch)
+   * \anchor BatchOpType
+   */
+  enum {
+    /** Create directory; succeeds if it exists unless OPEN_FLAG_EXCL */
+    BATCH_OP_MKDIR    = 1,
+    /** Create file with attrs; fails if it exists only with OPEN_FLAG_EXCL */
+    BATCH_OP_CREATE   = 2,
+    /** Delete file or empty directory */
+    BATCH_OP_DELETE   = 3,
+    /** Set each of attrs */
+    BATCH_OP_ATTR_SET = 4,
+    /** Get the attributes named in attrs into values */
+    BATCH_OP_ATTR_GET = 5,
+    /** Delete the attributes named in attrs */
+    BATCH_OP_ATTR_DEL = 6,
+    /** Check for existence of the node into exists */
+    BATCH_OP_EXISTS   = 7
+  };
+
+  /**
+   * One operation of a batch request.  Unlike the single operation
+   * requests, nodes are addressed by pathname rather than by handle.
+   */
+  struct BatchOp {
+    BatchOp() : type(0), flags(0), exists(false) { return; }
+    BatchOp(uint16_t t, const std::string &n, uint32_t f=0)
+      : type(t), flags(f), name(n), exists(false) { return; }
+    /** operation type (see \ref BatchOpType) */
+    uint16_t type;
+    /** open flags (only OPEN_FLAG_EXCL is meaningful) */
+    uint32_t flags;
+    /** pathname of node */
+    std::string name;
+    /** attributes to set, or names of attributes to get or delete */
+    std::vector<Attribute> attrs;
+    /** result of BATCH_OP_EXISTS */
+    bool exists;
+    /** result of BATCH_OP_ATTR_GET, one per element of attrs */
+    std::vector<std::string> values;
+  };
+
   class Protocol : public Hypertable::Protocol {
 
   public:
@@ -56,7 +100,7 @@ namespace Hyperspace {
     static CommBuf *create_server_keepalive_request(SessionDataPtr &session_data);
     static CommBuf *create_handshake_request(uint64_t session_id);
 
-    static CommBuf *create_open_request(const std::string &name, uint32_t flags, HandleCallbackPtr &callback, std::vector<Attribute> &init_attrs);
+    static CommBuf *create_open_request(const std::string &name, uint32_t flags, uint32_t event_mask, std::vector<Attribute> &init_attrs);
     static CommBuf *create_close_request(uint64_t handle);
     static CommBuf *create_mkdir_request(const std::string &name);
     static CommBuf *create_delete_request(const std::string &name);
@@ -65,6 +109,7 @@ namespace Hyperspace {
     static CommBuf *create_attr_del_request(uint64_t handle, const std::string &name);
     static CommBuf *create_readdir_request(uint64_t handle);
     static CommBuf *create_exists_request(const std::string &name);
+    static CommBuf *create_batch_request(std::vector<BatchOp> &ops);
 
     static CommBuf *create_lock_request(uint64_t handle, uint32_t mode, bool try_lock);
     static CommBuf *create_release_request(uint64_t handle);
@@ -91,7 +136,8 @@ namespace Hyperspace {
     static const uint16_t COMMAND_RELEASE        = 15;
     static const uint16_t COMMAND_CHECKSEQUENCER = 16;
     static const uint16_t COMMAND_STATUS         = 17;
-    static const uint16_t COMMAND_MAX            = 18;
+    static const uint16_t COMMAND_BATCH          = 18;
+    static const uint16_t COMMAND_MAX            = 19;
 
     static const char * command_strs[COMMAND_MAX];
 
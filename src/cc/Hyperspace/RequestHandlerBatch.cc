@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+#include "AsyncComm/ResponseCallback.h"
+#include "Common/Serialization.h"
+
+#include "Master.h"
+#include "RequestHandlerBatch.h"
+#include "ResponseCallbackBatch.h"
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace Serialization;
+
+/**
+ * Decodes the operation list.  Names and attribute values point into the
+ * request message, which outlives the call to Master::batch.
+ */
+void RequestHandlerBatch::run() {
+  ResponseCallbackBatch cb(m_comm, m_event_ptr);
+  size_t remaining = m_event_ptr->message_len - 2;
+  const uint8_t *msg = m_event_ptr->message + 2;
+  std::vector<BatchOp> ops;
+
+  try {
+    uint32_t op_count = decode_i32(&msg, &remaining);
+
+    ops.resize(op_count);
+    for (uint32_t i=0; i<op_count; i++) {
+      ops[i].type = decode_i16(&msg, &remaining);
+      ops[i].flags = decode_i32(&msg, &remaining);
+      ops[i].name = decode_vstr(&msg, &remaining);
+      uint32_t attr_count = decode_i32(&msg, &remaining);
+      ops[i].attrs.resize(attr_count);
+      for (uint32_t j=0; j<attr_count; j++) {
+        ops[i].attrs[j].name = decode_vstr(&msg, &remaining);
+        ops[i].attrs[j].value = decode_vstr(&msg, &remaining,
+                                            &ops[i].attrs[j].value_len);
+      }
+    }
+
+    m_master->batch(&cb, m_session_id, ops);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    cb.error(e.code(), "Error handling BATCH message");
+  }
+}
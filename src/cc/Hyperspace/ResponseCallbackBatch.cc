@@ -0,0 +1,63 @@
+/**
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+#include "Common/Serialization.h"
+
+#include "AsyncComm/CommBuf.h"
+
+#include "ResponseCallbackBatch.h"
+
+using namespace Hyperspace;
+using namespace Hypertable;
+using namespace Serialization;
+
+/**
+ * Only operations that produce results (EXISTS and ATTR_GET) contribute
+ * to the response; the client walks its own copy of the operation list
+ * to decode it.
+ */
+int ResponseCallbackBatch::response(std::vector<BatchOp> &ops) {
+  size_t len = 4;
+
+  for (size_t i=0; i<ops.size(); i++) {
+    if (ops[i].type == BATCH_OP_EXISTS)
+      len += 1;
+    else if (ops[i].type == BATCH_OP_ATTR_GET) {
+      for (size_t j=0; j<ops[i].values.size(); j++)
+        len += encoded_length_vstr(ops[i].values[j].length());
+    }
+  }
+
+  m_header_builder.initialize_from_request(m_event_ptr->header);
+  CommBufPtr cbp(new CommBuf(m_header_builder, len));
+  cbp->append_i32(Error::OK);
+  for (size_t i=0; i<ops.size(); i++) {
+    if (ops[i].type == BATCH_OP_EXISTS)
+      cbp->append_byte((uint8_t)ops[i].exists);
+    else if (ops[i].type == BATCH_OP_ATTR_GET) {
+      for (size_t j=0; j<ops[i].values.size(); j++)
+        cbp->append_vstr(ops[i].values[j].data(), ops[i].values[j].length());
+    }
+  }
+  return m_comm->send_response(m_event_ptr->addr, cbp);
+}
@@ -29,6 +29,7 @@
 #include "RequestHandlerAttrSet.h"
 #include "RequestHandlerAttrGet.h"
 #include "RequestHandlerAttrDel.h"
+#include "RequestHandlerBatch.h"
 #include "RequestHandlerMkdir.h"
 #include "RequestHandlerDelete.h"
 #include "RequestHandlerOpen.h"
@@ -118,6 +119,9 @@ void ServerConnectionHandler::handle(EventPtr &event) {
       case Protocol::COMMAND_RELEASE:
         handler = new RequestHandlerRelease(m_comm, m_master_ptr.get(), m_session_id, event);
         break;
+      case Protocol::COMMAND_BATCH:
+        handler = new RequestHandlerBatch(m_comm, m_master_ptr.get(), m_session_id, event);
+        break;
       case Protocol::COMMAND_STATUS:
         handler = new RequestHandlerStatus(m_comm, m_master_ptr.get(), m_session_id, event);
         break;
@@ -43,7 +43,7 @@ ServerKeepaliveHandler::ServerKeepaliveHandler(Comm *comm, Master *master) : m_c
 
   m_master->get_datagram_send_address(&m_send_addr);
 
-  if ((error = m_comm->set_timer(1000, this)) != Error::OK) {
+  if ((error = m_comm->set_timer(TIMER_INTERVAL, this)) != Error::OK) {
     HT_ERRORF("Problem setting timer - %s", Error::get_text(error));
     exit(1);
   }
@@ -131,9 +131,10 @@ void ServerKeepaliveHandler::handle(Hypertable::EventPtr &event) {
   }
   else if (event->type == Hypertable::Event::TIMER) {
 
-    m_master->remove_expired_sessions();
+    int interval = m_master->remove_expired_sessions()
+        ? EXPIRY_BACKLOG_INTERVAL : TIMER_INTERVAL;
 
-    if ((error = m_comm->set_timer(1000, this)) != Error::OK) {
+    if ((error = m_comm->set_timer(interval, this)) != Error::OK) {
       HT_ERRORF("Problem setting timer - %s", Error::get_text(error));
       exit(1);
     }
@@ -148,16 +149,11 @@ void ServerKeepaliveHandler::handle(Hypertable::EventPtr &event) {
 /**
  *
  */
-void ServerKeepaliveHandler::deliver_event_notifications(uint64_t session_id) {
+void ServerKeepaliveHandler::deliver_event_notifications(
+    SessionDataPtr &session_ptr) {
   int error = 0;
-  SessionDataPtr session_ptr;
 
-  //HT_INFOF("Delivering event notifications for session %lld", session_id);
-
-  if (!m_master->get_session(session_id, session_ptr)) {
-    HT_ERRORF("Unable to find data for session %lld", session_id);
-    return;
-  }
+  //HT_INFOF("Delivering event notifications for session %lld", session_ptr->id);
 
   /**
   {
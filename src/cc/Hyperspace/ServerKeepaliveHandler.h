@@ -29,6 +29,7 @@
 
 #include "Event.h"
 #include "HandleData.h"
+#include "SessionData.h"
 
 
 namespace Hyperspace {
@@ -39,9 +40,14 @@ namespace Hyperspace {
    */
   class ServerKeepaliveHandler : public DispatchHandler {
   public:
+    /** Timer interval in milliseconds */
+    static const int TIMER_INTERVAL = 1000;
+    /** Timer interval while a backlog of expired sessions remains */
+    static const int EXPIRY_BACKLOG_INTERVAL = 10;
+
     ServerKeepaliveHandler(Comm *comm, Master *master);
     virtual void handle(Hypertable::EventPtr &event_ptr);
-    void deliver_event_notifications(uint64_t session_id);
+    void deliver_event_notifications(SessionDataPtr &session_data);
 
   private:
     Comm              *m_comm;
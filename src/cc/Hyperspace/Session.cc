@@ -71,6 +71,9 @@ Session::Session(Comm *comm, PropertiesPtr &props_ptr, SessionCallback *callback
   boost::xtime_get(&m_expire_time, boost::TIME_UTC);
   m_expire_time.sec += m_grace_period;
 
+  if (props_ptr->get_bool("Hyperspace.Cache.Enable", true))
+    m_cache_ptr = new ClientCache((size_t)props_ptr->get_int("Hyperspace.Cache.IdleHandles", 64));
+
   if (m_verbose) {
     cout << "Hyperspace.GracePeriod=" << m_grace_period << endl;
   }
@@ -124,6 +127,8 @@ int Session::open(ClientHandleStatePtr &handle_state, CommBufPtr &cbuf_ptr, uint
         /** if (createdp) *createdp = cbyte ? true : false; **/
         handle_state->handle = *handlep;
         m_keepalive_handler_ptr->register_handle(handle_state);
+        if (handle_state->cached)
+          m_cache_ptr->watch(handle_state->normal_name);
       }
       catch (Exception &e) {
         HT_ERROR_OUT << e << HT_END;
@@ -147,13 +152,34 @@ int Session::open(ClientHandleStatePtr &handle_state, CommBufPtr &cbuf_ptr, uint
 int Session::open(const std::string &name, uint32_t flags, HandleCallbackPtr &callback, uint64_t *handlep) {
   ClientHandleStatePtr handle_state(new ClientHandleState());
   std::vector<Attribute> empty_attrs;
+  uint32_t event_mask;
+
+  close_orphaned_handles();
 
   handle_state->open_flags = flags;
   handle_state->event_mask = (callback) ? callback->get_event_mask() : 0;
   handle_state->callback = callback;
   normalize_name(name, handle_state->normal_name);
 
-  CommBufPtr cbuf_ptr(Protocol::create_open_request(handle_state->normal_name, flags, callback, empty_attrs));
+  /**
+   * Plain read-only handles are cached.  They are registered with the
+   * master for the cache invalidation events and may be satisfied by an
+   * idle handle left over from an earlier close.
+   */
+  handle_state->cached = m_cache_ptr && flags == OPEN_FLAG_READ &&
+      (handle_state->event_mask & ~ClientCache::EVENT_MASK) == 0;
+
+  event_mask = handle_state->event_mask;
+  if (handle_state->cached) {
+    if (m_cache_ptr->checkout_idle_handle(handle_state->normal_name,
+                                          event_mask, handlep)) {
+      m_keepalive_handler_ptr->rebind_handle(*handlep, callback);
+      return Error::OK;
+    }
+    event_mask = ClientCache::EVENT_MASK;
+  }
+
+  CommBufPtr cbuf_ptr(Protocol::create_open_request(handle_state->normal_name, flags, event_mask, empty_attrs));
 
   return open(handle_state, cbuf_ptr, handlep);
 
@@ -170,9 +196,10 @@ int Session::create(const std::string &name, uint32_t flags, HandleCallbackPtr &
   handle_state->open_flags = flags | OPEN_FLAG_CREATE | OPEN_FLAG_EXCL;
   handle_state->event_mask = (callback) ? callback->get_event_mask() : 0;
   handle_state->callback = callback;
+  handle_state->cached = false;
   normalize_name(name, handle_state->normal_name);
 
-  CommBufPtr cbuf_ptr(Protocol::create_open_request(handle_state->normal_name, handle_state->open_flags, callback, init_attrs));
+  CommBufPtr cbuf_ptr(Protocol::create_open_request(handle_state->normal_name, handle_state->open_flags, handle_state->event_mask, init_attrs));
 
   return open(handle_state, cbuf_ptr, handlep);
 }
@@ -180,12 +207,44 @@ int Session::create(const std::string &name, uint32_t flags, HandleCallbackPtr &
 
 
 /**
- *
+ * Cached handles are not closed right away but kept idle for reuse by a
+ * later open of the same node.  Only the least recently used idle handle
+ * is closed once there are too many.
  */
 int Session::close(uint64_t handle) {
+  ClientHandleStatePtr handle_state;
+  HandleCallbackPtr null_callback;
+  uint64_t evicted;
+
+  close_orphaned_handles();
+
+  if (m_cache_ptr &&
+      m_keepalive_handler_ptr->get_handle_state(handle, handle_state) &&
+      handle_state->cached) {
+    m_keepalive_handler_ptr->rebind_handle(handle, null_callback);
+    if (!m_cache_ptr->retain_idle_handle(handle_state->normal_name,
+        ClientCache::EVENT_MASK, handle, &evicted))
+      return Error::OK;
+    handle = evicted;
+  }
+
+  return close_handle(handle);
+}
+
+
+
+int Session::close_handle(uint64_t handle) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
   CommBufPtr cbuf_ptr(Protocol::create_close_request(handle));
+  ClientHandleStatePtr handle_state;
+
+  if (m_cache_ptr &&
+      m_keepalive_handler_ptr->get_handle_state(handle, handle_state) &&
+      handle_state->cached) {
+    handle_state->cached = false;
+    m_cache_ptr->unwatch(handle_state->normal_name);
+  }
 
  try_again:
   if (!wait_for_safe())
@@ -285,9 +344,16 @@ int Session::exists(const std::string &name, bool *existsp) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
   std::string normal_name;
+  uint64_t generation = 0;
 
   normalize_name(name, normal_name);
 
+  if (m_cache_ptr) {
+    if (m_cache_ptr->get_exists(normal_name, existsp))
+      return Error::OK;
+    generation = m_cache_ptr->get_generation(parent_name(normal_name));
+  }
+
   CommBufPtr cbuf_ptr(Protocol::create_exists_request(normal_name));
 
  try_again:
@@ -310,6 +376,8 @@ int Session::exists(const std::string &name, bool *existsp) {
       try {
         uint8_t bval = decode_byte(&ptr, &remaining);
         *existsp = (bval == 0) ? false : true;
+        if (generation)
+          m_cache_ptr->put_exists(normal_name, *existsp, generation);
       }
       catch (Exception &e) {
         HT_ERROR_OUT << e << HT_END;
@@ -348,6 +416,8 @@ int Session::attr_set(uint64_t handle, const std::string &name, const void *valu
           HT_ERRORF("%s", Protocol::string_format_message(event_ptr.get()).c_str());
       }
     }
+    else
+      invalidate_attr(handle, name);
   }
   else {
     state_transition(Session::STATE_JEOPARDY);
@@ -365,6 +435,16 @@ int Session::attr_get(uint64_t handle, const std::string &name, DynamicBuffer &v
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
   CommBufPtr cbuf_ptr(Protocol::create_attr_get_request(handle, name));
+  ClientHandleStatePtr handle_state;
+  uint64_t generation = 0;
+
+  if (m_cache_ptr &&
+      m_keepalive_handler_ptr->get_handle_state(handle, handle_state) &&
+      handle_state->cached) {
+    if (m_cache_ptr->get_attr(handle_state->normal_name, name, value))
+      return Error::OK;
+    generation = m_cache_ptr->get_generation(handle_state->normal_name);
+  }
 
  try_again:
   if (!wait_for_safe())
@@ -391,6 +471,9 @@ int Session::attr_get(uint64_t handle, const std::string &name, DynamicBuffer &v
         value.add_unchecked(attr_val, attr_val_len);
         // nul-terminate to make caller's lives easier
         *value.ptr = 0;
+        if (generation)
+          m_cache_ptr->put_attr(handle_state->normal_name, name, value,
+                                generation);
       }
       catch (Exception &e) {
         HT_ERROR_OUT << e << HT_END;
@@ -429,6 +512,8 @@ int Session::attr_del(uint64_t handle, const std::string &name) {
           HT_ERRORF("%s", Protocol::string_format_message(event_ptr.get()).c_str());
       }
     }
+    else
+      invalidate_attr(handle, name);
   }
   else {
     state_transition(Session::STATE_JEOPARDY);
@@ -443,6 +528,16 @@ int Session::readdir(uint64_t handle, std::vector<DirEntry> &listing) {
   DispatchHandlerSynchronizer sync_handler;
   Hypertable::EventPtr event_ptr;
   CommBufPtr cbuf_ptr(Protocol::create_readdir_request(handle));
+  ClientHandleStatePtr handle_state;
+  uint64_t generation = 0;
+
+  if (m_cache_ptr &&
+      m_keepalive_handler_ptr->get_handle_state(handle, handle_state) &&
+      handle_state->cached) {
+    if (m_cache_ptr->get_listing(handle_state->normal_name, listing))
+      return Error::OK;
+    generation = m_cache_ptr->get_generation(handle_state->normal_name);
+  }
 
  try_again:
   if (!wait_for_safe())
@@ -484,6 +579,68 @@ int Session::readdir(uint64_t handle, std::vector<DirEntry> &listing) {
         }
         listing.push_back(dentry);
       }
+      if (generation)
+        m_cache_ptr->put_listing(handle_state->normal_name, listing,
+                                 generation);
+    }
+  }
+  else {
+    state_transition(Session::STATE_JEOPARDY);
+    goto try_again;
+  }
+
+  return error;
+}
+
+
+
+int Session::batch(std::vector<BatchOp> &ops) {
+  DispatchHandlerSynchronizer sync_handler;
+  Hypertable::EventPtr event_ptr;
+  std::string normal_name;
+
+  for (size_t i=0; i<ops.size(); i++) {
+    normalize_name(ops[i].name, normal_name);
+    ops[i].name = normal_name;
+  }
+
+  CommBufPtr cbuf_ptr(Protocol::create_batch_request(ops));
+
+ try_again:
+  if (!wait_for_safe())
+    return Error::HYPERSPACE_EXPIRED_SESSION;
+
+  int error = send_message(cbuf_ptr, &sync_handler);
+  if (error == Error::OK) {
+    if (!sync_handler.wait_for_reply(event_ptr)) {
+      error = (int)Protocol::response_code(event_ptr.get());
+      if (!m_silent) {
+        HT_ERRORF("Hyperspace 'batch' error : %s", Error::get_text(error));
+        if (m_verbose)
+          HT_ERRORF("%s", Protocol::string_format_message(event_ptr.get()).c_str());
+      }
+    }
+    else {
+      const uint8_t *ptr = event_ptr->message + 4;
+      size_t remaining = event_ptr->message_len - 4;
+      try {
+        for (size_t i=0; i<ops.size(); i++) {
+          if (ops[i].type == BATCH_OP_EXISTS)
+            ops[i].exists = decode_bool(&ptr, &remaining);
+          else if (ops[i].type == BATCH_OP_ATTR_GET) {
+            ops[i].values.clear();
+            for (size_t j=0; j<ops[i].attrs.size(); j++) {
+              uint32_t len;
+              const char *value = decode_vstr(&ptr, &remaining, &len);
+              ops[i].values.push_back(std::string(value, len));
+            }
+          }
+        }
+      }
+      catch (Exception &e) {
+        HT_ERROR_OUT << e << HT_END;
+        return e.code();
+      }
     }
   }
   else {
@@ -726,6 +883,9 @@ int Session::state_transition(int state) {
       m_session_callback->safe();
   }
   else if (m_state == STATE_JEOPARDY) {
+    // events may be missed while out of contact with the master
+    if (m_cache_ptr && old_state == STATE_SAFE)
+      m_cache_ptr->clear();
     if (m_session_callback && old_state == STATE_SAFE) {
       m_session_callback->jeopardy();
       boost::xtime_get(&m_expire_time, boost::TIME_UTC);
@@ -733,6 +893,8 @@ int Session::state_transition(int state) {
     }
   }
   else if (m_state == STATE_EXPIRED) {
+    if (m_cache_ptr)
+      m_cache_ptr->clear();
     if (m_session_callback && old_state != STATE_EXPIRED)
       m_session_callback->expired();
     m_cond.notify_all();
@@ -824,3 +986,41 @@ void Session::normalize_name(const std::string &name, std::string &normal) {
   else
     normal += name.substr(0, name.length()-1);
 }
+
+
+/**
+ * Closes idle handles whose node has been deleted.
+ */
+void Session::close_orphaned_handles() {
+  uint64_t handle;
+
+  while (m_cache_ptr && m_cache_ptr->checkout_orphaned_handle(&handle))
+    close_handle(handle);
+}
+
+
+/**
+ * Drops a cached attribute after this session changed it, so that our own
+ * writes do not depend on event delivery to become visible.
+ */
+void Session::invalidate_attr(uint64_t handle, const std::string &name) {
+  ClientHandleStatePtr handle_state;
+
+  if (m_cache_ptr &&
+      m_keepalive_handler_ptr->get_handle_state(handle, handle_state))
+    m_cache_ptr->attr_changed(handle_state->normal_name, name);
+}
+
+
+/**
+ *
+ */
+std::string Session::parent_name(const std::string &normal_name) {
+  size_t lastslash = normal_name.find_last_of('/');
+
+  if (lastslash == std::string::npos || normal_name == "/")
+    return "";
+  if (lastslash == 0)
+    return "/";
+  return normal_name.substr(0, lastslash);
+}
@@ -35,6 +35,7 @@
 #include "Common/DynamicBuffer.h"
 #include "Common/ReferenceCount.h"
 
+#include "ClientCache.h"
 #include "ClientKeepaliveHandler.h"
 #include "HandleCallback.h"
 #include "LockSequencer.h"
@@ -120,6 +121,15 @@ namespace Hyperspace {
    * Hyperspace.KeepAlive.Interval=10
    * Hyperspace.GracePeriod=60
    * </pre>
+   * <p>
+   * Handles opened with exactly OPEN_FLAG_READ are cached: attributes,
+   * directory listings and child existence read through them are kept in a
+   * ClientCache and invalidated by master events, and the handle itself is
+   * kept open for reuse after #close.  The cache is configured with:
+   * <pre>
+   * Hyperspace.Cache.Enable=true
+   * Hyperspace.Cache.IdleHandles=64
+   * </pre>
    */
   class Session : public ReferenceCount {
 
@@ -268,6 +278,18 @@ namespace Hyperspace {
      */
     int readdir(uint64_t handle, std::vector<DirEntry> &listing);
 
+    /** Executes a list of operations in a single round trip.  The master
+     * runs them in order inside one transaction, so either all of them take
+     * effect or none do.  Results of BATCH_OP_EXISTS and BATCH_OP_ATTR_GET
+     * operations are returned in the <code>exists</code> and
+     * <code>values</code> members of the corresponding BatchOp.
+     *
+     * @param ops vector of operations (see BatchOp)
+     * @return Error::OK on success or error code of the first failing
+     *         operation
+     */
+    int batch(std::vector<BatchOp> &ops);
+
 
     /** Locks a file.  The mode argument indicates the type of lock to be
      * acquired and takes a value of either LOCK_MODE_SHARED
@@ -380,12 +402,23 @@ namespace Hyperspace {
      */
     bool expired();
 
+    /**
+     * Returns the client cache (internal method)
+     *
+     * @return pointer to client cache, or 0 if caching is disabled
+     */
+    ClientCache *get_cache() { return m_cache_ptr.get(); }
+
   private:
 
     bool wait_for_safe();
     int send_message(CommBufPtr &, DispatchHandler *);
     void normalize_name(const std::string &name, std::string &normal);
     int open(ClientHandleStatePtr &, CommBufPtr &, uint64_t *handlep);
+    int close_handle(uint64_t handle);
+    void close_orphaned_handles();
+    void invalidate_attr(uint64_t handle, const std::string &name);
+    static std::string parent_name(const std::string &normal_name);
 
     boost::mutex m_mutex;
     boost::condition m_cond;
@@ -398,6 +431,7 @@ namespace Hyperspace {
     uint32_t m_timeout;
     boost::xtime m_expire_time;
     struct sockaddr_in m_master_addr;
+    ClientCachePtr m_cache_ptr;
     ClientKeepaliveHandlerPtr m_keepalive_handler_ptr;
     SessionCallback *m_session_callback;
   };
@@ -73,7 +73,7 @@ namespace Hyperspace {
       boost::mutex::scoped_lock lock(mutex);
       boost::xtime now;
       boost::xtime_get(&now, boost::TIME_UTC);
-      if (xtime_cmp(expire_time, now) < 0) {
+      if (expired || xtime_cmp(expire_time, now) < 0) {
         expired = true;
         std::list<Notification *>::iterator iter = notifications.begin();
         while (iter != notifications.end()) {
@@ -90,7 +90,7 @@ namespace Hyperspace {
 
     bool is_expired(boost::xtime &now) {
       boost::mutex::scoped_lock lock(mutex);
-      return (xtime_cmp(expire_time, now) < 0) ? true : false;
+      return (expired || xtime_cmp(expire_time, now) < 0) ? true : false;
     }
 
     void expire() {
@@ -123,12 +123,6 @@ namespace Hyperspace {
 
   typedef boost::intrusive_ptr<SessionData> SessionDataPtr;
 
-  struct LtSessionData {
-    bool operator()(const SessionDataPtr &sd1, const SessionDataPtr &sd2) const {
-      return xtime_cmp(sd1->expire_time, sd2->expire_time) >= 0;
-    }
-  };
-
 }
 
 #endif // HYPERSPACE_SESSIONDATA_H
@@ -0,0 +1,154 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERSPACE_SHARDEDMAP_H
+#define HYPERSPACE_SHARDEDMAP_H
+
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "Common/StringExt.h"
+
+namespace Hyperspace {
+
+  /**
+   * Hash map split into a fixed number of independently locked shards.
+   * Each operation holds only the mutex of the shard its key hashes to,
+   * and only for the duration of the hash table operation, so lookups on
+   * different keys rarely contend and never wait behind a caller that is
+   * blocked on something else.
+   */
+  template <typename KeyT, typename ValueT>
+  class ShardedMap {
+  public:
+
+    static const size_t SHARD_COUNT = 32;
+
+    typedef Hypertable::hash_map<KeyT, ValueT> Map;
+
+    size_t shard_count() const { return SHARD_COUNT; }
+
+    /**
+     * Looks up the value stored under key.
+     *
+     * @param key key to look up
+     * @param value reference to hold the value, if found
+     * @return true if found, false otherwise
+     */
+    bool get(const KeyT &key, ValueT &value) {
+      Shard &shard = shard_for(key);
+      boost::mutex::scoped_lock lock(shard.mutex);
+      typename Map::iterator iter = shard.map.find(key);
+      if (iter == shard.map.end())
+        return false;
+      value = (*iter).second;
+      return true;
+    }
+
+    void set(const KeyT &key, const ValueT &value) {
+      Shard &shard = shard_for(key);
+      boost::mutex::scoped_lock lock(shard.mutex);
+      shard.map[key] = value;
+    }
+
+    /**
+     * Inserts value under key unless the key is already present, in which
+     * case value is replaced with the existing entry.
+     *
+     * @param key key to insert
+     * @param value value to insert, holds the mapped value on return
+     * @return true if value was inserted, false if the key already existed
+     */
+    bool get_or_insert(const KeyT &key, ValueT &value) {
+      Shard &shard = shard_for(key);
+      boost::mutex::scoped_lock lock(shard.mutex);
+      std::pair<typename Map::iterator, bool> ret =
+          shard.map.insert(std::make_pair(key, value));
+      if (!ret.second)
+        value = (*ret.first).second;
+      return ret.second;
+    }
+
+    bool remove(const KeyT &key, ValueT &value) {
+      Shard &shard = shard_for(key);
+      boost::mutex::scoped_lock lock(shard.mutex);
+      typename Map::iterator iter = shard.map.find(key);
+      if (iter == shard.map.end())
+        return false;
+      value = (*iter).second;
+      shard.map.erase(iter);
+      return true;
+    }
+
+    bool remove(const KeyT &key) {
+      ValueT value;
+      return remove(key, value);
+    }
+
+    /**
+     * Removes up to limit entries of one shard for which pred returns
+     * true, appending their values to removed.  Used to sweep the map
+     * incrementally, one shard lock at a time.
+     *
+     * @param shard_index index of shard to sweep (< shard_count())
+     * @param pred predicate called with each value, under the shard lock
+     * @param removed vector to append removed values to
+     * @param limit maximum number of entries to remove
+     * @return number of entries removed
+     */
+    template <typename PredT>
+    size_t remove_if(size_t shard_index, PredT pred,
+                     std::vector<ValueT> &removed, size_t limit) {
+      Shard &shard = m_shards[shard_index];
+      boost::mutex::scoped_lock lock(shard.mutex);
+      size_t count = 0;
+      typename Map::iterator iter = shard.map.begin();
+      while (iter != shard.map.end() && count < limit) {
+        if (pred((*iter).second)) {
+          removed.push_back((*iter).second);
+          shard.map.erase(iter++);
+          count++;
+        }
+        else
+          ++iter;
+      }
+      return count;
+    }
+
+  private:
+
+    struct Shard {
+      boost::mutex mutex;
+      Map map;
+    };
+
+    Shard &shard_for(const KeyT &key) {
+      return m_shards[BOOST_STD_EXTENSION_NAMESPACE::hash<KeyT>()(key)
+                      % SHARD_COUNT];
+    }
+
+    Shard m_shards[SHARD_COUNT];
+  };
+
+}
+
+#endif // HYPERSPACE_SHARDEDMAP_H
@@ -0,0 +1,173 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+extern "C" {
+#include <netinet/in.h>
+#include <sched.h>
+}
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "Common/Logger.h"
+#include "Common/String.h"
+#include "Common/System.h"
+
+#include "Hyperspace/Event.h"
+#include "Hyperspace/EventSequencer.h"
+#include "Hyperspace/HandleCallback.h"
+#include "Hyperspace/Notification.h"
+#include "Hyperspace/SessionData.h"
+
+using namespace Hyperspace;
+using namespace Hypertable;
+
+namespace {
+
+  const int WRITERS = 8;
+  const int LOCKERS = 2;
+  const int ITERATIONS = 2000;
+
+  /**
+   * Stands in for the Hyperspace master: writers commit under a node lock
+   * and deliver afterwards, as mkdir and attr_set do, while lockers queue
+   * events straight away, as lock and release do.  All of them notify one
+   * session.
+   */
+  struct TestMaster {
+    TestMaster() : commit_seq(0) {
+      memset(&addr, 0, sizeof(addr));
+      session = new SessionData(addr, 60, 1);
+    }
+
+    void queue(HyperspaceEventPtr &event_ptr) {
+      boost::mutex::scoped_lock lock(event_mutex);
+      event_ptr->assign_id();
+      session->add_notification(new Notification(1, event_ptr));
+    }
+
+    struct sockaddr_in addr;
+    SessionDataPtr session;
+    boost::mutex node_mutex;
+    boost::mutex event_mutex;
+    EventSequencer sequencer;
+    uint64_t commit_seq;
+    std::map<Event *, uint64_t> commit_of;
+  };
+
+  struct Writer {
+    Writer(TestMaster *m, unsigned seed) : master(m), seed(seed) { }
+    void operator()() {
+      for (int i=0; i<ITERATIONS; i++) {
+        HyperspaceEventPtr event_ptr;
+        uint64_t ticket;
+
+        {
+          boost::mutex::scoped_lock lock(master->node_mutex);
+          event_ptr = new EventNamed(EVENT_MASK_ATTR_SET, "attr");
+          master->commit_of[event_ptr.get()] = master->commit_seq++;
+          ticket = master->sequencer.take_ticket();
+        }
+
+        // widen the window between commit and delivery
+        if (rand_r(&seed) % 4 == 0)
+          sched_yield();
+
+        master->sequencer.begin(ticket);
+        master->queue(event_ptr);
+        master->sequencer.end();
+      }
+    }
+    TestMaster *master;
+    unsigned seed;
+  };
+
+  struct Locker {
+    Locker(TestMaster *m) : master(m) { }
+    void operator()() {
+      for (int i=0; i<ITERATIONS; i++) {
+        HyperspaceEventPtr event_ptr(new EventLockReleased());
+        master->queue(event_ptr);
+      }
+    }
+    TestMaster *master;
+  };
+
+}
+
+
+int main(int argc, char **argv) {
+  TestMaster master;
+  boost::thread_group threads;
+  uint64_t last_id = 0;
+  uint64_t next_commit = 0;
+  int count = 0;
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  for (int i=0; i<WRITERS; i++)
+    threads.create_thread(Writer(&master, (unsigned)i + 1));
+  for (int i=0; i<LOCKERS; i++)
+    threads.create_thread(Locker(&master));
+  threads.join_all();
+
+  /**
+   * The client drops any event whose id is not above the last one it saw
+   * (see ClientKeepaliveHandler), so ids must increase in queue order, and
+   * events of committed transactions must be queued in commit order.
+   */
+  foreach(Notification *notification, master.session->notifications) {
+    HyperspaceEventPtr &event_ptr = notification->event_ptr;
+
+    if (event_ptr->get_id() <= last_id) {
+      HT_ERRORF("Event id %llu queued after id %llu",
+                (Llu)event_ptr->get_id(), (Llu)last_id);
+      return 1;
+    }
+    last_id = event_ptr->get_id();
+
+    if (event_ptr->get_mask() == EVENT_MASK_ATTR_SET) {
+      uint64_t commit = master.commit_of[event_ptr.get()];
+      if (commit != next_commit) {
+        HT_ERRORF("Event of commit %llu queued where commit %llu belongs",
+                  (Llu)commit, (Llu)next_commit);
+        return 1;
+      }
+      next_commit++;
+    }
+    count++;
+  }
+
+  if (count != (WRITERS + LOCKERS) * ITERATIONS) {
+    HT_ERRORF("Expected %d events, found %d",
+              (WRITERS + LOCKERS) * ITERATIONS, count);
+    return 1;
+  }
+
+  master.session->expire();
+
+  return 0;
+}
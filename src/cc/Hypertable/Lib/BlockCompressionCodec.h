@@ -55,6 +55,23 @@ namespace Hypertable {
 
     virtual void set_args(const Args &args) {}
 
+    /**
+     * Returns true if the codec can prime its compressor with a preset
+     * dictionary (see #set_dictionary).
+     */
+    virtual bool supports_dictionary() { return false; }
+
+    /**
+     * Sets the preset dictionary used for both deflate and inflate.  Data
+     * deflated with a dictionary can only be inflated by a codec that has
+     * been given the same dictionary.  The dictionary memory must remain
+     * valid for the lifetime of the codec.
+     *
+     * @param base pointer to dictionary
+     * @param len length of dictionary
+     */
+    virtual void set_dictionary(const uint8_t *base, size_t len) { }
+
     virtual int get_type() = 0;
 
     HT_THREAD_ID_DECL(m_creator_thread);
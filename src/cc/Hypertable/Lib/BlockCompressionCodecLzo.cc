@@ -24,7 +24,6 @@
 #include "Common/DynamicBuffer.h"
 #include "Common/Error.h"
 #include "Common/Logger.h"
-#include "Common/Checksum.h"
 
 #include "lzo/minilzo.h"
 #include "BlockCompressionCodecLzo.h"
@@ -86,7 +85,7 @@ void BlockCompressionCodecLzo::deflate(const DynamicBuffer &input, DynamicBuffer
     header.set_data_length(input.fill());
     header.set_data_zlength(out_len);
   }
-  header.set_data_checksum(fletcher32(output.base + header.length(), header.get_data_zlength()));
+  header.set_data_checksum(header.compute_data_checksum(output.base + header.length(), header.get_data_zlength()));
 
   output.ptr = output.base;
   header.encode(&output.ptr);
@@ -113,7 +112,7 @@ void BlockCompressionCodecLzo::inflate(const DynamicBuffer &input, DynamicBuffer
     HT_THROW(Error::BLOCK_COMPRESSOR_BAD_HEADER, "");
   }
 
-  uint32_t checksum = fletcher32(msg_ptr, remaining);
+  uint32_t checksum = header.compute_data_checksum(msg_ptr, remaining);
   if (checksum != header.get_data_checksum()) {
     HT_ERRORF("Compressed block checksum mismatch header=%d, computed=%d", header.get_data_checksum(), checksum);
     HT_THROW(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "");
@@ -21,7 +21,6 @@
 
 #include "Common/Compat.h"
 
-#include "Common/Checksum.h"
 #include "Common/Thread.h"
 #include "Common/DynamicBuffer.h"
 #include "Common/Error.h"
@@ -77,7 +76,7 @@ void BlockCompressionCodecQuicklz::deflate(const DynamicBuffer &input, DynamicBu
     header.set_data_length(input.fill());
     header.set_data_zlength(len);
   }
-  header.set_data_checksum(fletcher32(output.base + header.length(), header.get_data_zlength()));
+  header.set_data_checksum(header.compute_data_checksum(output.base + header.length(), header.get_data_zlength()));
 
   output.ptr = output.base;
   header.encode(&output.ptr);
@@ -99,7 +98,7 @@ void BlockCompressionCodecQuicklz::inflate(const DynamicBuffer &input, DynamicBu
               "header zlength = %lu, actual = %lu",
               (Lu)header.get_data_zlength(), (Lu)remaining);
 
-  uint32_t checksum = fletcher32(msg_ptr, remaining);
+  uint32_t checksum = header.compute_data_checksum(msg_ptr, remaining);
 
   if (checksum != header.get_data_checksum())
     HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Compressed block "
@@ -23,7 +23,6 @@
 
 #include "Common/DynamicBuffer.h"
 #include "Common/Logger.h"
-#include "Common/Checksum.h"
 
 #include "BlockCompressionCodecZlib.h"
 
@@ -33,7 +32,7 @@ using namespace Hypertable;
 /**
  *
  */
-BlockCompressionCodecZlib::BlockCompressionCodecZlib(const Args &args) : m_inflate_initialized(false), m_deflate_initialized(false), m_level(Z_BEST_SPEED) {
+BlockCompressionCodecZlib::BlockCompressionCodecZlib(const Args &args) : m_inflate_initialized(false), m_deflate_initialized(false), m_level(Z_BEST_SPEED), m_dictionary(0), m_dictionary_len(0) {
   if (!args.empty())
     set_args(args);
 }
@@ -96,6 +95,13 @@ void BlockCompressionCodecZlib::deflate(const DynamicBuffer &input, DynamicBuffe
     m_deflate_initialized = true;
   }
 
+  if (m_dictionary_len) {
+    int ret = deflateSetDictionary(&m_stream_deflate, m_dictionary,
+                                   m_dictionary_len);
+    assert(ret == Z_OK);
+    (void)ret;
+  }
+
   output.clear();
   output.reserve(header.length() + avail_out + reserve);
 
@@ -124,7 +130,7 @@ void BlockCompressionCodecZlib::deflate(const DynamicBuffer &input, DynamicBuffe
     header.set_data_zlength(zlen);
   }
 
-  header.set_data_checksum(fletcher32(output.base + header.length(), header.get_data_zlength()));
+  header.set_data_checksum(header.compute_data_checksum(output.base + header.length(), header.get_data_zlength()));
 
   deflateReset(&m_stream_deflate);
 
@@ -162,7 +168,7 @@ void BlockCompressionCodecZlib::inflate(const DynamicBuffer &input, DynamicBuffe
               "header zlength = %lu, actual = %lu",
               (Lu)header.get_data_zlength(), (Lu)remaining);
 
-  uint32_t checksum = fletcher32(msg_ptr, remaining);
+  uint32_t checksum = header.compute_data_checksum(msg_ptr, remaining);
 
   if (checksum != header.get_data_checksum())
     HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Compressed block "
@@ -184,6 +190,20 @@ void BlockCompressionCodecZlib::inflate(const DynamicBuffer &input, DynamicBuffe
       m_stream_inflate.next_out = output.base;
 
       ret = ::inflate(&m_stream_inflate, Z_NO_FLUSH);
+
+      // block was deflated with a preset dictionary
+      if (ret == Z_NEED_DICT) {
+        if (m_dictionary_len == 0) {
+          ::inflateReset(&m_stream_inflate);
+          HT_THROW(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                   "requires a dictionary but none was supplied");
+        }
+        ret = inflateSetDictionary(&m_stream_inflate, m_dictionary,
+                                   m_dictionary_len);
+        if (ret == Z_OK)
+          ret = ::inflate(&m_stream_inflate, Z_NO_FLUSH);
+      }
+
       if (ret != Z_STREAM_END)
         HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
                   "inflate error (return value = %d)", ret);
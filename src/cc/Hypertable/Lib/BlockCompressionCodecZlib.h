@@ -42,6 +42,11 @@ namespace Hypertable {
     virtual void inflate(const DynamicBuffer &input, DynamicBuffer &output,
                          BlockCompressionHeader &header);
     virtual int get_type() { return ZLIB; }
+    virtual bool supports_dictionary() { return true; }
+    virtual void set_dictionary(const uint8_t *base, size_t len) {
+      m_dictionary = base;
+      m_dictionary_len = len;
+    }
 
   private:
     z_stream  m_stream_inflate;
@@ -49,6 +54,8 @@ namespace Hypertable {
     z_stream  m_stream_deflate;
     bool      m_deflate_initialized;
     int       m_level;
+    const uint8_t *m_dictionary;
+    size_t    m_dictionary_len;
   };
 
 }
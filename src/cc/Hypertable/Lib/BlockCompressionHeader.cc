@@ -34,6 +34,36 @@ using namespace Serialization;
 
 const size_t BlockCompressionHeader::LENGTH;
 
+namespace {
+  const uint8_t CHECKSUM_TYPE_SHIFT = 6;
+  const uint8_t COMPRESSION_TYPE_MASK = 0x3F;
+}
+
+/**
+ * Blocks checksummed with CRC32C can not be read by older releases, so it
+ * is only used when configured (Hypertable.RangeServer.BlockChecksum).
+ */
+uint8_t BlockCompressionHeader::ms_default_checksum_type =
+    BlockCompressionHeader::CHECKSUM_FLETCHER32;
+
+
+uint32_t
+BlockCompressionHeader::compute_data_checksum(const void *data, size_t len) {
+  if (m_checksum_type == CHECKSUM_CRC32C)
+    return crc32c(data, len);
+  return fletcher32(data, len);
+}
+
+
+uint8_t BlockCompressionHeader::parse_checksum_type(const String &name) {
+  if (name == "fletcher32")
+    return CHECKSUM_FLETCHER32;
+  if (name == "crc32c")
+    return CHECKSUM_CRC32C;
+  HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Unknown block checksum "
+            "type '%s'", name.c_str());
+}
+
 
 /**
  */
@@ -42,7 +72,8 @@ void BlockCompressionHeader::encode(uint8_t **bufp) {
   memcpy(*bufp, m_magic, 10);
   (*bufp) += 10;
   *(*bufp)++ = (uint8_t)length();
-  *(*bufp)++ = (uint8_t)m_compression_type;
+  *(*bufp)++ = (uint8_t)(m_compression_type |
+                        (m_checksum_type << CHECKSUM_TYPE_SHIFT));
   encode_i32(bufp, m_data_checksum);
   encode_i32(bufp, m_data_length);
   encode_i32(bufp, m_data_zlength);
@@ -87,11 +118,17 @@ void BlockCompressionHeader::decode(const uint8_t **bufp, size_t *remainp) {
               ": %lu, expecting: %lu", (Lu)header_length, (Lu)length());
 
   m_compression_type = decode_byte(bufp, remainp);
+  m_checksum_type = m_compression_type >> CHECKSUM_TYPE_SHIFT;
+  m_compression_type &= COMPRESSION_TYPE_MASK;
 
   if (m_compression_type >= BlockCompressionCodec::COMPRESSION_TYPE_LIMIT)
     HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Bad compression type: %d",
               (int)m_compression_type);
 
+  if (m_checksum_type >= CHECKSUM_TYPE_LIMIT)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Bad checksum type: %d",
+              (int)m_checksum_type);
+
   m_data_checksum = decode_i32(bufp, remainp);
   m_data_length = decode_i32(bufp, remainp);
   m_data_zlength = decode_i32(bufp, remainp);
@@ -22,6 +22,8 @@
 #ifndef HYPERTABLE_BLOCKCOMPRESSIONHEADER_H
 #define HYPERTABLE_BLOCKCOMPRESSIONHEADER_H
 
+#include "Common/String.h"
+
 namespace Hypertable {
 
   /**
@@ -32,10 +34,19 @@ namespace Hypertable {
 
     static const size_t LENGTH = 26;
 
-    BlockCompressionHeader() : m_data_length(0), m_data_zlength(0), m_data_checksum(0), m_compression_type(-1)
+    /**
+     * Algorithm used for the data checksum.  It is stored in the top two
+     * bits of the compression type byte, so headers written with
+     * CHECKSUM_FLETCHER32 are identical to those written before the
+     * checksum type existed.
+     */
+    enum ChecksumType { CHECKSUM_FLETCHER32=0, CHECKSUM_CRC32C=1,
+                        CHECKSUM_TYPE_LIMIT=2 };
+
+    BlockCompressionHeader() : m_data_length(0), m_data_zlength(0), m_data_checksum(0), m_compression_type(-1), m_checksum_type(ms_default_checksum_type)
     { return; }
 
-    BlockCompressionHeader(const char *magic) : m_data_length(0), m_data_zlength(0), m_data_checksum(0), m_compression_type(-1)
+    BlockCompressionHeader(const char *magic) : m_data_length(0), m_data_zlength(0), m_data_checksum(0), m_compression_type(-1), m_checksum_type(ms_default_checksum_type)
       { memcpy(m_magic, magic, 10); }
 
     virtual ~BlockCompressionHeader() { return; }
@@ -56,6 +67,28 @@ namespace Hypertable {
     void     set_compression_type(uint16_t type) { m_compression_type = type; }
     uint16_t get_compression_type() { return m_compression_type; }
 
+    void     set_checksum_type(uint8_t type) { m_checksum_type = type; }
+    uint8_t  get_checksum_type() { return m_checksum_type; }
+
+    /**
+     * Computes the data checksum with this header's checksum type.  Codecs
+     * call this on the compressed data, both to fill in the header when
+     * deflating and to verify it after decoding the header when inflating.
+     */
+    uint32_t compute_data_checksum(const void *data, size_t len);
+
+    /**
+     * Sets the checksum type for headers constructed from now on.  The
+     * initial default is CHECKSUM_FLETCHER32, which every release can read.
+     */
+    static void set_default_checksum_type(uint8_t type) {
+      ms_default_checksum_type = type;
+    }
+    static uint8_t get_default_checksum_type() {
+      return ms_default_checksum_type;
+    }
+    static uint8_t parse_checksum_type(const String &name);
+
     virtual size_t length() { return LENGTH; }
     virtual void   encode(uint8_t **bufp);
     virtual void   write_header_checksum(uint8_t *base, uint8_t **bufp);
@@ -67,6 +100,9 @@ namespace Hypertable {
     uint32_t m_data_zlength;
     uint32_t m_data_checksum;
     uint16_t m_compression_type;
+    uint8_t  m_checksum_type;
+
+    static uint8_t ms_default_checksum_type;
   };
 
 }
@@ -22,11 +22,16 @@
 #ifndef HYPERTABLE_CELL_H
 #define HYPERTABLE_CELL_H
 
+#include "Key.h"
+
 namespace Hypertable {
 
   /** Encapsulates decomposed key and value */
   class Cell {
   public:
+    Cell() : row_key(0), column_family(0), column_qualifier(0), timestamp(0),
+             value(0), value_len(0), flag(FLAG_INSERT), row_key_len(0) { }
+
     const char *row_key;
     const char *column_family;
     const char *column_qualifier;
@@ -34,6 +39,11 @@ namespace Hypertable {
     const uint8_t *value;
     uint32_t value_len;
     uint8_t flag;
+    /**
+     * Length of row_key.  Zero means row_key is NUL-terminated; set it to
+     * pass a row containing NUL bytes to a table with binary rows.
+     */
+    uint32_t row_key_len;
   };
 
 }
@@ -33,6 +33,7 @@ extern "C" {
 #include "Common/InetAddr.h"
 #include "Common/Logger.h"
 #include "Common/System.h"
+#include "Common/Trace.h"
 
 #include "Hyperspace/DirEntry.h"
 
@@ -190,6 +191,8 @@ void Client::initialize(const String &config_file) {
 
   m_props_ptr = new Properties(config_file);
 
+  Trace::initialize("client", m_props_ptr);
+
   m_comm = Comm::instance();
   m_conn_manager_ptr = new ConnectionManager(m_comm);
 
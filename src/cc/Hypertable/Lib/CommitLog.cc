@@ -22,7 +22,6 @@
 #include "Common/Compat.h"
 #include <cassert>
 
-#include "Common/Checksum.h"
 #include "Common/DynamicBuffer.h"
 #include "Common/Error.h"
 #include "Common/FileUtils.h"
@@ -169,7 +168,7 @@ int CommitLog::link_log(CommitLogBase *log_base, uint64_t timestamp) {
   header.set_compression_type(BlockCompressionCodec::NONE);
   header.set_data_length(log_dir.length() + 1);
   header.set_data_zlength(log_dir.length() + 1);
-  header.set_data_checksum(fletcher32(log_dir.c_str(), log_dir.length()+1));
+  header.set_data_checksum(header.compute_data_checksum(log_dir.c_str(), log_dir.length()+1));
 
   header.encode(&input.ptr);
   input.add(log_dir.c_str(), log_dir.length() + 1);
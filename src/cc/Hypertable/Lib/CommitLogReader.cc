@@ -60,7 +60,7 @@ namespace {
 
 /**
  */
-CommitLogReader::CommitLogReader(Filesystem *fs, String log_dir) : CommitLogBase(log_dir), m_fs(fs), m_block_buffer(256), m_compressor(0) {
+CommitLogReader::CommitLogReader(Filesystem *fs, String log_dir) : CommitLogBase(log_dir), m_fs(fs), m_block_buffer(256), m_fragment_readahead(0), m_compressor(0) {
   load_fragments(log_dir);
 }
 
@@ -77,15 +77,18 @@ bool CommitLogReader::next_raw_block(CommitLogBlockInfo *infop, BlockCompression
   if (m_fragment_stack.empty())
     return false;
 
-  if (m_fragment_stack.top().block_stream == 0)
-    m_fragment_stack.top().block_stream = new CommitLogBlockStream(m_fs, m_fragment_stack.top().log_dir, format("%u", m_fragment_stack.top().num));
+  if (m_fragment_stack.back().block_stream == 0)
+    m_fragment_stack.back().block_stream = new CommitLogBlockStream(m_fs, m_fragment_stack.back().log_dir, format("%u", m_fragment_stack.back().num));
 
-  if (!m_fragment_stack.top().block_stream->next(infop, header)) {
-    delete m_fragment_stack.top().block_stream;
-    m_fragment_stack.top().block_stream = 0;
-    m_fragment_stack.top().timestamp = m_last_timestamp;
-    m_fragment_queue.push_back(m_fragment_stack.top());
-    m_fragment_stack.pop();
+  if (m_fragment_readahead)
+    readahead_fragments();
+
+  if (!m_fragment_stack.back().block_stream->next(infop, header)) {
+    delete m_fragment_stack.back().block_stream;
+    m_fragment_stack.back().block_stream = 0;
+    m_fragment_stack.back().timestamp = m_last_timestamp;
+    m_fragment_queue.push_back(m_fragment_stack.back());
+    m_fragment_stack.pop_back();
     goto try_again;
   }
 
@@ -120,7 +123,7 @@ bool CommitLogReader::next(const uint8_t **blockp, size_t *lenp, BlockCompressio
       catch (Exception &e) {
         HT_ERRORF("Inflate error in CommitLog fragment %s starting at "
                   "postion %lld (block len = %lld) - %s",
-                  m_fragment_stack.top().block_stream->get_fname().c_str(),
+                  m_fragment_stack.back().block_stream->get_fname().c_str(),
                   binfo.start_offset, binfo.end_offset - binfo.start_offset,
                   Error::get_text(e.code()));
         continue;
@@ -136,10 +139,36 @@ bool CommitLogReader::next(const uint8_t **blockp, size_t *lenp, BlockCompressio
 
     HT_WARNF("Corruption detected in CommitLog fragment %s starting at "
 	     "postion %lld for %lld bytes - %s",
-	     m_fragment_stack.top().block_stream->get_fname().c_str(),
+	     m_fragment_stack.back().block_stream->get_fname().c_str(),
 	     binfo.start_offset, binfo.end_offset - binfo.start_offset,
 	     Error::get_text(binfo.error));
-    m_fragment_stack.pop();
+    m_fragment_stack.pop_back();
+
+  }
+
+  return false;
+}
+
+
+
+bool CommitLogReader::next_compressed(DynamicBuffer &zblock, BlockCompressionHeaderCommitLog *header, String &fname) {
+  CommitLogBlockInfo binfo;
+
+  while (next_raw_block(&binfo, header)) {
+
+    if (binfo.error == Error::OK) {
+      zblock.set(binfo.block_ptr, binfo.block_len);
+      fname = m_fragment_stack.back().block_stream->get_fname();
+      m_last_timestamp = header->get_timestamp();
+      return true;
+    }
+
+    HT_WARNF("Corruption detected in CommitLog fragment %s starting at "
+	     "postion %lld for %lld bytes - %s",
+	     m_fragment_stack.back().block_stream->get_fname().c_str(),
+	     binfo.start_offset, binfo.end_offset - binfo.start_offset,
+	     Error::get_text(binfo.error));
+    m_fragment_stack.pop_back();
 
   }
 
@@ -188,11 +217,26 @@ void CommitLogReader::load_fragments(String &log_dir) {
   fragment_vector[0].purge_log_dir = true;
 
   for (size_t i=0; i<fragment_vector.size(); i++)
-    m_fragment_stack.push(fragment_vector[i]);
+    m_fragment_stack.push_back(fragment_vector[i]);
 
 }
 
 
+/**
+ * Opens the block streams of the next m_fragment_readahead fragments so
+ * that their buffered reads are issued before they are needed.
+ */
+void CommitLogReader::readahead_fragments() {
+  size_t count = 0;
+
+  for (LogFragmentStack::reverse_iterator iter = m_fragment_stack.rbegin() + 1;
+       iter != m_fragment_stack.rend() && count < m_fragment_readahead; ++iter, ++count) {
+    if ((*iter).block_stream == 0)
+      (*iter).block_stream = new CommitLogBlockStream(m_fs, (*iter).log_dir, format("%u", (*iter).num));
+  }
+}
+
+
 void CommitLogReader::load_compressor(uint16_t ztype) {
   BlockCompressionCodecPtr compressor_ptr;
 
@@ -22,7 +22,7 @@
 #ifndef HYPERTABLE_COMMITLOGREADER_H
 #define HYPERTABLE_COMMITLOGREADER_H
 
-#include <stack>
+#include <deque>
 #include <vector>
 
 #include <boost/thread/mutex.hpp>
@@ -41,7 +41,7 @@
 
 namespace Hypertable {
 
-  typedef std::stack<CommitLogFileInfo> LogFragmentStack;
+  typedef std::deque<CommitLogFileInfo> LogFragmentStack;
 
   class CommitLogReader : public CommitLogBase {
 
@@ -52,17 +52,40 @@ namespace Hypertable {
     bool next_raw_block(CommitLogBlockInfo *infop, BlockCompressionHeaderCommitLog *header);
     bool next(const uint8_t **blockp, size_t *lenp, BlockCompressionHeaderCommitLog *header);
 
+    /**
+     * Fetches the next block of the log without inflating it.  The raw
+     * block (header included) is copied into <code>zblock</code> so that
+     * it can be decompressed on another thread.  Corrupt blocks are skipped.
+     *
+     * @param zblock buffer to receive the compressed block
+     * @param header receives the decoded block header
+     * @param fname receives the name of the fragment the block came from
+     * @return true if a block was returned, false on end of log
+     */
+    bool next_compressed(DynamicBuffer &zblock, BlockCompressionHeaderCommitLog *header, String &fname);
+
+    /**
+     * Sets the number of fragments, beyond the one currently being read,
+     * that are opened ahead of time so that their readahead is in flight
+     * while the current fragment is consumed.
+     *
+     * @param count number of fragments to open ahead
+     */
+    void set_fragment_readahead(uint32_t count) { m_fragment_readahead = count; }
+
     LogFragmentQueue &get_fragment_queue() { return m_fragment_queue; }
 
   private:
 
     void load_fragments(String &log_dir);
     void load_compressor(uint16_t ztype);
+    void readahead_fragments();
 
     Filesystem       *m_fs;
     LogFragmentStack  m_fragment_stack;
     size_t            m_cur_log_offset;
     DynamicBuffer     m_block_buffer;
+    uint32_t          m_fragment_readahead;
 
     typedef hash_map<uint16_t, BlockCompressionCodecPtr> CompressorMap;
 
@@ -0,0 +1,130 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Luke Lu (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <queue>
+#include <vector>
+
+#include "CompressionDictionary.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  const size_t DMER_SIZE = 8;
+  const size_t SEGMENT_SIZE = 64;
+  const uint32_t TABLE_BITS = 16;
+  const uint32_t TABLE_SIZE = 1 << TABLE_BITS;
+
+  inline uint32_t dmer_hash(const uint8_t *ptr) {
+    uint64_t val = 0;
+    for (size_t i=0; i<DMER_SIZE; i++)
+      val = (val << 8) | ptr[i];
+    return (uint32_t)((val * 0x9E3779B97F4A7C15ULL) >> (64 - TABLE_BITS));
+  }
+
+  struct Segment {
+    Segment(size_t o, uint64_t s) : offset(o), score(s) { }
+    size_t   offset;
+    uint64_t score;
+  };
+
+  struct LtSegment {
+    bool operator()(const Segment &s1, const Segment &s2) const {
+      if (s1.score != s2.score)
+        return s1.score < s2.score;
+      return s1.offset > s2.offset;
+    }
+  };
+
+  /**
+   * Sums the counts of the d-mers starting in the segment.  Only d-mers
+   * seen more than once contribute, since a string that occurs once in
+   * the sample is unlikely to recur in the data.
+   */
+  uint64_t score_segment(const uint8_t *sample, size_t len, size_t offset,
+                         const std::vector<uint32_t> &counts) {
+    uint64_t score = 0;
+    size_t end = std::min(offset + SEGMENT_SIZE, len - DMER_SIZE + 1);
+    for (size_t i=offset; i<end; i++) {
+      uint32_t count = counts[dmer_hash(sample + i)];
+      if (count > 1)
+        score += count;
+    }
+    return score;
+  }
+
+}
+
+
+void CompressionDictionary::train(const uint8_t *sample, size_t len,
+                                  size_t max_size, DynamicBuffer &dict) {
+  std::vector<uint32_t> counts(TABLE_SIZE, 0);
+  std::priority_queue<Segment, std::vector<Segment>, LtSegment> heap;
+  std::vector<size_t> chosen;
+  size_t dict_len = 0;
+
+  dict.clear();
+
+  if (max_size > MAX_SIZE)
+    max_size = MAX_SIZE;
+
+  if (len < SEGMENT_SIZE * 4 || max_size < SEGMENT_SIZE)
+    return;
+
+  for (size_t i=0; i+DMER_SIZE<=len; i++)
+    counts[dmer_hash(sample + i)]++;
+
+  for (size_t offset=0; offset+SEGMENT_SIZE<=len; offset+=SEGMENT_SIZE) {
+    uint64_t score = score_segment(sample, len, offset, counts);
+    if (score)
+      heap.push(Segment(offset, score));
+  }
+
+  /**
+   * Lazy greedy selection: a popped segment's score may be stale because
+   * segments chosen since it was pushed covered some of its d-mers, so
+   * rescore it and only take it if it still beats the next best.
+   */
+  while (!heap.empty() && dict_len + SEGMENT_SIZE <= max_size) {
+    Segment top = heap.top();
+    heap.pop();
+
+    uint64_t score = score_segment(sample, len, top.offset, counts);
+    if (score == 0)
+      continue;
+    if (score < top.score && !heap.empty() && score < heap.top().score) {
+      heap.push(Segment(top.offset, score));
+      continue;
+    }
+
+    chosen.push_back(top.offset);
+    dict_len += SEGMENT_SIZE;
+
+    size_t end = std::min(top.offset + SEGMENT_SIZE, len - DMER_SIZE + 1);
+    for (size_t i=top.offset; i<end; i++)
+      counts[dmer_hash(sample + i)] = 0;
+  }
+
+  dict.reserve(dict_len);
+  for (size_t i=chosen.size(); i>0; i--)
+    dict.add_unchecked(sample + chosen[i-1], SEGMENT_SIZE);
+}
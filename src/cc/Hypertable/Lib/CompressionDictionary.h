@@ -0,0 +1,59 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Luke Lu (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_COMPRESSIONDICTIONARY_H
+#define HYPERTABLE_COMPRESSIONDICTIONARY_H
+
+#include "Common/DynamicBuffer.h"
+
+namespace Hypertable {
+
+  /**
+   * Builds a preset dictionary for dictionary-capable block codecs (see
+   * BlockCompressionCodec#supports_dictionary) from a sample of the data
+   * to be compressed.  The sample is cut into fixed-size segments, each
+   * scored by how often the 8-byte substrings it contains occur elsewhere
+   * in the sample.  Segments are chosen greedily, highest score first,
+   * and once a substring is covered by a chosen segment it no longer
+   * counts towards the score of the others.  The best segments go at the
+   * end of the dictionary, where LZ77-style codecs find them at the
+   * shortest distance.
+   */
+  class CompressionDictionary {
+  public:
+    static const size_t DEFAULT_SIZE = 16384;
+    static const size_t MAX_SIZE = 32768;
+
+    /**
+     * Trains a dictionary.
+     *
+     * @param sample sample data
+     * @param len length of sample data
+     * @param max_size upper bound on dictionary size
+     * @param dict buffer to receive the dictionary (cleared first)
+     */
+    static void train(const uint8_t *sample, size_t len, size_t max_size,
+                      DynamicBuffer &dict);
+  };
+
+}
+
+#endif // HYPERTABLE_COMPRESSIONDICTIONARY_H
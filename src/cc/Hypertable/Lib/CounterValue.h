@@ -0,0 +1,92 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_COUNTERVALUE_H
+#define HYPERTABLE_COUNTERVALUE_H
+
+#include <cstdio>
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+
+namespace Hypertable {
+
+  /**
+   * Counter column families store signed 64-bit values as ASCII decimal so
+   * they stay readable from HQL.  Each insert is a delta; the RangeServer
+   * sums the deltas of a cell and returns the total.  Sums wrap on
+   * overflow.
+   */
+
+  /**
+   * Parses a counter value: an optional sign followed by up to 19 decimal
+   * digits, with no surrounding whitespace.
+   *
+   * @param ptr pointer to the value bytes
+   * @param len length of the value
+   * @param valp address of variable to hold the parsed value
+   * @return true if the value is a valid counter value
+   */
+  inline bool decode_counter(const uint8_t *ptr, size_t len, int64_t *valp) {
+    const uint8_t *end = ptr + len;
+    bool negative = false;
+    uint64_t val = 0;
+
+    if (ptr < end && (*ptr == '-' || *ptr == '+'))
+      negative = (*ptr++ == '-');
+
+    if (ptr == end || end - ptr > 19)
+      return false;
+
+    for (; ptr < end; ptr++) {
+      if (*ptr < '0' || *ptr > '9')
+        return false;
+      val = (val * 10) + (*ptr - '0');
+    }
+
+    *valp = negative ? (int64_t)(0 - val) : (int64_t)val;
+    return true;
+  }
+
+  /**
+   * Parses the counter value held in a serialized value byte string.
+   * Malformed values count as zero.
+   */
+  inline int64_t decode_counter(ByteString value) {
+    const uint8_t *ptr;
+    size_t len = value.decode_length(&ptr);
+    int64_t val;
+    return decode_counter(ptr, len, &val) ? val : 0;
+  }
+
+  /**
+   * Appends a counter value to a buffer as a serialized value byte string
+   * (vint32 length followed by the decimal digits).
+   */
+  inline void append_counter(DynamicBuffer &dst_buf, int64_t val) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%lld", (long long)val);
+    append_as_byte_string(dst_buf, buf, len);
+  }
+
+}
+
+#endif // HYPERTABLE_COUNTERVALUE_H
@@ -25,6 +25,7 @@
 const int Hypertable::HYPERTABLE_CLIENT_TIMEOUT = 120;
 
 const int Hypertable::HYPERTABLE_LOCATIONCACHE_MAXENTRIES = 1000000;
+const int Hypertable::HYPERTABLE_LOCATIONCACHE_SHARDS = 16;
 
 const int Hypertable::HYPERTABLE_MASTER_CLIENT_TIMEOUT = 120;
 const int Hypertable::HYPERTABLE_RANGESERVER_CLIENT_TIMEOUT = 120;
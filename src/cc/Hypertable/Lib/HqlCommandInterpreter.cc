@@ -133,6 +133,7 @@ void HqlCommandInterpreter::execute_line(const String &line) {
       } else {
         schema = new Schema();
         schema->set_compressor(state.table_compressor);
+        schema->set_binary_rows(state.table_binary_rows);
 
         foreach(const Schema::AccessGroupMap::value_type &v, state.ag_map)
           schema->add_access_group(v.second);
@@ -58,6 +58,7 @@ namespace {
     "REPLAY START ...... Start replay",
     "REPLAY LOG ........ Replay a commit log",
     "REPLAY COMMIT ..... Commit replay",
+    "SHOW STATISTICS ... Display latency histograms and counters",
     "SHUTDOWN   ........ Shutdown the RangeServer",
     "UPDATE ............ Selects (and display) cells from a table",
     "",
@@ -196,6 +197,21 @@ namespace {
     0
   };
 
+  const char *help_text_show_statistics[] = {
+    "",
+    "SHOW STATISTICS",
+    "",
+    "This command fetches and displays the RangeServer's performance",
+    "statistics.  For update, create scanner, fetch scanblock, commit log",
+    "append, DFS read and compaction it shows the operation count and the",
+    "mean, min, p50, p90, p99, p999 and max latency in microseconds, plus",
+    "the number of bytes processed.  It also shows the block cache hit",
+    "rate, the maintenance queue depth and the cell cache memory usage.",
+    "All values are cumulative since the RangeServer started.",
+    "",
+    0
+  };
+
   const char *help_text_drop_range[] = {
     "",
     "DROP RANGE range_spec",
@@ -249,9 +265,10 @@ namespace {
     "",
     "table_option:",
     "    COMPRESSOR '=' string_literal",
+    "    | BINARY_ROWS",
     "",
     "create_definition:",
-    "    column_family_name [MAX_VERSIONS '=' value] [TTL '=' duration]",
+    "    column_family_name [MAX_VERSIONS '=' value] [TTL '=' duration] [COUNTER]",
     "    | ACCESS GROUP name [access_group_option ...] ['(' [column_family_name, ...] ')']",
     "",
     "duration:",
@@ -267,6 +284,24 @@ namespace {
     "    | BLOCKSIZE '=' value",
     "    | COMPRESSOR '=' string_literal",
     "",
+    "The COMPRESSOR string is a codec name (none, bmz, zlib, lzo, quicklz)",
+    "followed by codec arguments, e.g. \"zlib --best\".  Adding --dictionary",
+    "(or --dictionary=<bytes>, up to 32768) to a codec that supports it",
+    "(zlib) trains a dictionary from the first block of each CellStore and",
+    "stores it in the file.  \"auto [--dictionary] [codec ...]\" tries each",
+    "listed codec (default quicklz lzo zlib) on the first block and picks the",
+    "smallest output, preferring earlier codecs unless a later one is at least",
+    "10% smaller.",
+    "",
+    "Values written to a COUNTER column family are signed 64-bit decimal",
+    "deltas (e.g. \"1\", \"-5\").  The RangeServer sums the deltas of each cell",
+    "as they arrive, on scan and during compaction, and a scan returns the",
+    "total.",
+    "",
+    "BINARY_ROWS lets row keys contain arbitrary bytes, including NUL, through",
+    "the C++ client API.  Rows are stored with a compact order-preserving",
+    "escape of the bytes 0x00, 0x01, 0xfe and 0xff rather than hex encoded.",
+    "",
     0
   };
 
@@ -634,4 +669,5 @@ void HqlHelpText::install_range_server_client_text() {
   text_map["replay log"] = help_text_replay_log;
   text_map["replay commit"] = help_text_replay_commit;
   text_map["shutdown"] = help_text_shutdown_rangeserver;
+  text_map["show statistics"] = help_text_show_statistics;
 }
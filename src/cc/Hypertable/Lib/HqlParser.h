@@ -80,6 +80,7 @@ namespace Hypertable {
       COMMAND_REPLAY_LOG,
       COMMAND_REPLAY_COMMIT,
       COMMAND_DROP_RANGE,
+      COMMAND_SHOW_STATISTICS,
       COMMAND_MAX
     };
 
@@ -222,7 +223,7 @@ namespace Hypertable {
       hql_interpreter_state() : command(0), dupkeycols(false), cf(0), ag(0),
           nanoseconds(0), delete_all_columns(false), delete_time(0),
           if_exists(false), replay(false), scanner_id(-1),
-          row_uniquify_chars(0) {
+          row_uniquify_chars(0), table_binary_rows(false) {
         memset(&tmval, 0, sizeof(tmval));
       }
       int command;
@@ -257,6 +258,7 @@ namespace Hypertable {
       String range_end_row;
       int32_t scanner_id;
       int32_t row_uniquify_chars;
+      bool table_binary_rows;
     };
 
     struct set_command {
@@ -385,6 +387,16 @@ namespace Hypertable {
       hql_interpreter_state &state;
     };
 
+    struct set_column_family_counter {
+      set_column_family_counter(hql_interpreter_state &state_)
+          : state(state_) { }
+      void operator()(char const *str, char const *end) const {
+        display_string("set_column_family_counter");
+        state.cf->counter = true;
+      }
+      hql_interpreter_state &state;
+    };
+
     struct set_ttl {
       set_ttl(hql_interpreter_state &state_) : state(state_) { }
       void operator()(char const *str, char const *end) const {
@@ -491,6 +503,15 @@ namespace Hypertable {
     };
 
 
+    struct set_table_binary_rows {
+      set_table_binary_rows(hql_interpreter_state &state_) : state(state_) { }
+      void operator()(char const *str, char const *end) const {
+        display_string("set_table_binary_rows");
+        state.table_binary_rows = true;
+      }
+      hql_interpreter_state &state;
+    };
+
     struct set_help {
       set_help(hql_interpreter_state &state_) : state(state_) { }
       void operator()(char const *str, char const *end) const {
@@ -1238,6 +1259,7 @@ namespace Hypertable {
           Token INCLUSIVE    = as_lower_d["inclusive"];
           Token EXCLUSIVE    = as_lower_d["exclusive"];
           Token MAX_VERSIONS = as_lower_d["max_versions"];
+          Token COUNTER      = as_lower_d["counter"];
           Token REVS         = as_lower_d["revs"];
           Token LIMIT        = as_lower_d["limit"];
           Token INTO         = as_lower_d["into"];
@@ -1250,6 +1272,7 @@ namespace Hypertable {
           Token DELETE       = as_lower_d["delete"];
           Token VALUES       = as_lower_d["values"];
           Token COMPRESSOR   = as_lower_d["compressor"];
+          Token BINARY_ROWS  = as_lower_d["binary_rows"];
           Token STARTS       = as_lower_d["starts"];
           Token WITH         = as_lower_d["with"];
           Token IF           = as_lower_d["if"];
@@ -1265,6 +1288,7 @@ namespace Hypertable {
           Token FETCH        = as_lower_d["fetch"];
           Token SCANBLOCK    = as_lower_d["scanblock"];
           Token SHUTDOWN     = as_lower_d["shutdown"];
+          Token STATISTICS   = as_lower_d["statistics"];
           Token REPLAY       = as_lower_d["replay"];
           Token START        = as_lower_d["start"];
           Token COMMIT       = as_lower_d["commit"];
@@ -1324,6 +1348,8 @@ namespace Hypertable {
             | delete_statement[set_command(self.state, COMMAND_DELETE)]
             | show_tables_statement[set_command(self.state,
                 COMMAND_SHOW_TABLES)]
+            | show_statistics_statement[set_command(self.state,
+                COMMAND_SHOW_STATISTICS)]
             | drop_table_statement[set_command(self.state, COMMAND_DROP_TABLE)]
             | load_range_statement[set_command(self.state, COMMAND_LOAD_RANGE)]
             | update_statement[set_command(self.state, COMMAND_UPDATE)]
@@ -1362,6 +1388,10 @@ namespace Hypertable {
             = SHUTDOWN
             ;
 
+          show_statistics_statement
+            = SHOW >> STATISTICS
+            ;
+
           fetch_scanblock_statement
             = FETCH >> SCANBLOCK >> !(lexeme_d[(+digit_p)[
                 set_scanner_id(self.state)]])
@@ -1475,6 +1505,7 @@ namespace Hypertable {
           table_option
             = COMPRESSOR >> EQUAL >> string_literal[
                 set_table_compressor(self.state)]
+            | BINARY_ROWS[set_table_binary_rows(self.state)]
             ;
 
           create_definitions
@@ -1499,6 +1530,7 @@ namespace Hypertable {
           column_option
             = max_versions_option
             | ttl_option
+            | COUNTER[set_column_family_counter(self.state)]
             ;
 
           max_versions_option
@@ -1746,6 +1778,7 @@ namespace Hypertable {
           BOOST_SPIRIT_DEBUG_RULE(destroy_scanner_statement);
           BOOST_SPIRIT_DEBUG_RULE(fetch_scanblock_statement);
           BOOST_SPIRIT_DEBUG_RULE(shutdown_statement);
+          BOOST_SPIRIT_DEBUG_RULE(show_statistics_statement);
           BOOST_SPIRIT_DEBUG_RULE(drop_range_statement);
           BOOST_SPIRIT_DEBUG_RULE(replay_start_statement);
           BOOST_SPIRIT_DEBUG_RULE(replay_log_statement);
@@ -1777,6 +1810,7 @@ namespace Hypertable {
           drop_table_statement, load_range_statement, range_spec,
           update_statement, create_scanner_statement, destroy_scanner_statement,
           fetch_scanblock_statement, shutdown_statement, drop_range_statement,
+          show_statistics_statement,
           replay_start_statement, replay_log_statement, replay_commit_statement,
           rename_table_statement, rename_value_list, rename_value,
           cell_interval, cell_predicate, cell_spec, row_list, row_value, 
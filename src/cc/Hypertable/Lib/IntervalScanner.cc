@@ -52,7 +52,8 @@ IntervalScanner::IntervalScanner(PropertiesPtr &props_ptr, Comm *comm,
       m_range_server(comm, HYPERTABLE_CLIENT_TIMEOUT),
       m_table_identifier(*table_identifier), m_started(false),
       m_eos(false), m_readahead(true), m_fetch_outstanding(false),
-      m_end_inclusive(false), m_rows_seen(0), m_timeout(timeout) {
+      m_end_inclusive(false), m_rows_seen(0), m_timeout(timeout),
+      m_binary_rows(schema_ptr->get_binary_rows()) {
 
   if (!scan_spec.row_intervals.empty() && !scan_spec.cell_intervals.empty())
     HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC,
@@ -76,22 +77,32 @@ IntervalScanner::IntervalScanner(PropertiesPtr &props_ptr, Comm *comm,
   HT_EXPECT(scan_spec.row_intervals.size() <= 1, Error::FAILED_EXPECTATION);
 
   if (!scan_spec.row_intervals.empty()) {
-    if (scan_spec.row_intervals[0].start == 0)
+    const RowInterval &ri = scan_spec.row_intervals[0];
+    if (ri.start == 0)
       HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC, "Bad row interval (start == NULL)");
-    if (scan_spec.row_intervals[0].end == 0)
+    if (ri.end == 0)
       HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC, "Bad row interval (end == NULL)");
-    int cmpval = strcmp(scan_spec.row_intervals[0].start, scan_spec.row_intervals[0].end);
+    if (m_binary_rows) {
+      encode_binary_row(m_start_row, ri.start,
+                        ri.start_len ? ri.start_len : strlen(ri.start));
+      if (!strcmp(ri.end, Key::END_ROW_MARKER))
+        m_end_row = Key::END_ROW_MARKER;
+      else
+        encode_binary_row(m_end_row, ri.end,
+                          ri.end_len ? ri.end_len : strlen(ri.end));
+    }
+    else {
+      m_start_row = ri.start;
+      m_end_row = ri.end;
+    }
+    int cmpval = strcmp(m_start_row.c_str(), m_end_row.c_str());
     if (cmpval > 0)
       HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC, "start_row > end_row");
-    if (cmpval == 0 && !scan_spec.row_intervals[0].start_inclusive && !scan_spec.row_intervals[0].end_inclusive)
+    if (cmpval == 0 && !ri.start_inclusive && !ri.end_inclusive)
       HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC, "empty row interval");
-    m_start_row = scan_spec.row_intervals[0].start;
-    m_end_row = scan_spec.row_intervals[0].end;
-    m_end_inclusive = scan_spec.row_intervals[0].end_inclusive;
-    m_scan_spec_builder.add_row_interval(scan_spec.row_intervals[0].start,
-					 scan_spec.row_intervals[0].start_inclusive,
-					 scan_spec.row_intervals[0].end,
-					 scan_spec.row_intervals[0].end_inclusive);
+    m_end_inclusive = ri.end_inclusive;
+    m_scan_spec_builder.add_row_interval(m_start_row, ri.start_inclusive,
+					 m_end_row, ri.end_inclusive);
   }
   else if (!scan_spec.cell_intervals.empty()) {
     if (scan_spec.cell_intervals[0].start_row == 0)
@@ -112,14 +123,22 @@ IntervalScanner::IntervalScanner(PropertiesPtr &props_ptr, Comm *comm,
       if (cmpval == 0 && !scan_spec.cell_intervals[0].start_inclusive && !scan_spec.cell_intervals[0].end_inclusive)
 	HT_THROW(Error::RANGESERVER_BAD_SCAN_SPEC, "empty cell interval");
     }
-    m_scan_spec_builder.add_cell_interval(scan_spec.cell_intervals[0].start_row,
+    if (m_binary_rows) {
+      encode_binary_row(m_start_row, scan_spec.cell_intervals[0].start_row,
+                        strlen(scan_spec.cell_intervals[0].start_row));
+      encode_binary_row(m_end_row, scan_spec.cell_intervals[0].end_row,
+                        strlen(scan_spec.cell_intervals[0].end_row));
+    }
+    else {
+      m_start_row = scan_spec.cell_intervals[0].start_row;
+      m_end_row = scan_spec.cell_intervals[0].end_row;
+    }
+    m_scan_spec_builder.add_cell_interval(m_start_row,
 					  scan_spec.cell_intervals[0].start_column,
 					  scan_spec.cell_intervals[0].start_inclusive,
-					  scan_spec.cell_intervals[0].end_row,
+					  m_end_row,
 					  scan_spec.cell_intervals[0].end_column,
 					  scan_spec.cell_intervals[0].end_inclusive);
-    m_start_row = scan_spec.cell_intervals[0].start_row;
-    m_end_row = scan_spec.cell_intervals[0].end_row;
     m_end_inclusive = true;
   }
   else {
@@ -243,7 +262,17 @@ bool IntervalScanner::next(Cell &cell) {
       }
     }
 
-    cell.row_key = key.row;
+    if (m_binary_rows) {
+      m_row_buf.clear();
+      if (!decode_binary_row(m_row_buf, key.row))
+        HT_THROWF(Error::BAD_KEY, "Invalid binary row key '%s'", key.row);
+      cell.row_key = m_row_buf.c_str();
+      cell.row_key_len = m_row_buf.length();
+    }
+    else {
+      cell.row_key = key.row;
+      cell.row_key_len = 0;
+    }
     cell.column_qualifier = key.column_qualifier;
     if ((cf = m_schema_ptr->get_column_family(key.column_family_code)) == 0) {
       // LOG ERROR ...
@@ -61,6 +61,12 @@ namespace Hypertable {
 
     void find_range_and_start_scan(const char *row_key, Timer &timer);
 
+    /**
+     * Returns the first row of the interval as sent to the RangeServer,
+     * i.e. after binary row encoding.
+     */
+    const char *get_start_row() { return m_start_row.c_str(); }
+
   private:
 
     Comm               *m_comm;
@@ -85,6 +91,8 @@ namespace Hypertable {
     bool                m_end_inclusive;
     int32_t             m_rows_seen;
     int                 m_timeout;
+    bool                m_binary_rows;
+    std::string         m_row_buf;
   };
   typedef boost::intrusive_ptr<IntervalScanner> IntervalScannerPtr;
 }
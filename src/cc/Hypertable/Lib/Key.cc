@@ -141,6 +141,46 @@ namespace Hypertable {
 
 
 
+  void encode_binary_row(String &dst, const void *row, size_t len) {
+    const uint8_t *ptr = (const uint8_t *)row;
+    const uint8_t *end = ptr + len;
+
+    dst.reserve(dst.length() + len + 8);
+    for (; ptr < end; ptr++) {
+      switch (*ptr) {
+      case 0x00: dst.append(1, (char)0x01); dst.append(1, (char)0x01); break;
+      case 0x01: dst.append(1, (char)0x01); dst.append(1, (char)0x02); break;
+      case 0xfe: dst.append(1, (char)0xfe); dst.append(1, (char)0xfe); break;
+      case 0xff: dst.append(1, (char)0xfe); dst.append(1, (char)0xff); break;
+      default:   dst.append(1, (char)*ptr);
+      }
+    }
+  }
+
+  bool decode_binary_row(String &dst, const char *row) {
+    const uint8_t *ptr = (const uint8_t *)row;
+
+    for (; *ptr; ptr++) {
+      if (*ptr == 0x01) {
+        if (ptr[1] != 0x01 && ptr[1] != 0x02)
+          return false;
+        dst.append(1, (char)(*++ptr - 1));
+      }
+      else if (*ptr == 0xfe) {
+        if (ptr[1] != 0xfe && ptr[1] != 0xff)
+          return false;
+        dst.append(1, (char)*++ptr);
+      }
+      else if (*ptr == 0xff)
+        return false;
+      else
+        dst.append(1, (char)*ptr);
+    }
+    return true;
+  }
+
+
+
   std::ostream &operator<<(std::ostream &os, const Key &key) {
     os << "row='" << key.row << "' ";
     if (key.flag == FLAG_DELETE_ROW)
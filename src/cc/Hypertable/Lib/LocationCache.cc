@@ -32,13 +32,27 @@
 using namespace Hypertable;
 using namespace std;
 
+/**
+ *
+ */
+LocationCache::LocationCache(uint32_t max_entries, uint32_t num_shards)
+  : m_shards(0), m_num_shards(num_shards ? num_shards : 1),
+    m_max_entries(max_entries ? max_entries : 1) {
+  m_shard_share = (m_max_entries + m_num_shards - 1) / m_num_shards;
+  atomic_set(&m_num_entries, 0);
+  atomic_set(&m_next_victim, 0);
+  m_shards = new Shard [m_num_shards];
+}
+
+
 /**
  * Insert
  */
 void
 LocationCache::insert(uint32_t table_id, RangeLocationInfo &range_loc_info,
                       bool pegged) {
-  boost::mutex::scoped_lock lock(m_mutex);
+  uint32_t shard_index = get_shard_index(table_id);
+  Shard &shard = m_shards[shard_index];
   Value *newval = new Value;
   LocationMap::iterator iter;
   LocationCacheKey key;
@@ -53,38 +67,35 @@ LocationCache::insert(uint32_t table_id, RangeLocationInfo &range_loc_info,
   key.table_id = table_id;
   key.end_row = (range_loc_info.end_row == "") ? 0 : newval->end_row.c_str();
 
+  boost::mutex::scoped_lock lock(shard.mutex);
+
   // remove old entry
-  if ((iter = m_location_map.find(key)) != m_location_map.end())
-    remove((*iter).second);
-
-  // make room for the new entry
-  while (m_location_map.size() >= m_max_entries) {
-    if (m_tail->pegged)
-      move_to_head(m_tail);
-    else
-      remove(m_tail);
-  }
+  if ((iter = shard.location_map.find(key)) != shard.location_map.end())
+    remove(shard, (*iter).second);
+
+  make_room(shard_index);
 
   // add to head
-  if (m_head == 0) {
-    assert(m_tail == 0);
+  if (shard.head == 0) {
+    assert(shard.tail == 0);
     newval->next = newval->prev = 0;
-    m_head = m_tail = newval;
+    shard.head = shard.tail = newval;
   }
   else {
-    m_head->next = newval;
-    newval->prev = m_head;
+    shard.head->next = newval;
+    newval->prev = shard.head;
     newval->next = 0;
-    m_head = newval;
+    shard.head = newval;
   }
 
   // Insert the new entry into the map, recording an iterator to the entry in the map
   {
     std::pair<LocationMap::iterator, bool> old_entry;
     LocationMap::value_type map_value(key, newval);
-    old_entry = m_location_map.insert(map_value);
+    old_entry = shard.location_map.insert(map_value);
     assert(old_entry.second);
     newval->map_iter = old_entry.first;
+    atomic_inc(&m_num_entries);
   }
 
 }
@@ -96,9 +107,12 @@ LocationCache::~LocationCache() {
   for (LocationStrSet::iterator iter = m_location_strings.begin();
       iter != m_location_strings.end(); iter++)
     delete [] *iter;
-  for (LocationMap::iterator lm_it = m_location_map.begin();
-      lm_it != m_location_map.end(); lm_it++)
-    delete (*lm_it).second;
+  for (uint32_t i=0; i<m_num_shards; i++) {
+    for (LocationMap::iterator lm_it = m_shards[i].location_map.begin();
+        lm_it != m_shards[i].location_map.end(); lm_it++)
+      delete (*lm_it).second;
+  }
+  delete [] m_shards;
 }
 
 
@@ -108,7 +122,8 @@ LocationCache::~LocationCache() {
 bool
 LocationCache::lookup(uint32_t table_id, const char *rowkey,
                       RangeLocationInfo *rane_loc_infop, bool inclusive) {
-  boost::mutex::scoped_lock lock(m_mutex);
+  Shard &shard = get_shard(table_id);
+  boost::mutex::scoped_lock lock(shard.mutex);
   LocationMap::iterator iter;
   LocationCacheKey key;
 
@@ -117,7 +132,7 @@ LocationCache::lookup(uint32_t table_id, const char *rowkey,
   key.table_id = table_id;
   key.end_row = rowkey;
 
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
+  if ((iter = shard.location_map.lower_bound(key)) == shard.location_map.end())
     return false;
 
   if ((*iter).first.table_id != table_id)
@@ -132,7 +147,7 @@ LocationCache::lookup(uint32_t table_id, const char *rowkey,
       return false;
   }
 
-  move_to_head((*iter).second);
+  move_to_head(shard, (*iter).second);
 
   rane_loc_infop->start_row = (*iter).second->start_row;
   rane_loc_infop->end_row   = (*iter).second->end_row;
@@ -142,7 +157,8 @@ LocationCache::lookup(uint32_t table_id, const char *rowkey,
 }
 
 bool LocationCache::invalidate(uint32_t table_id, const char *rowkey) {
-  boost::mutex::scoped_lock lock(m_mutex);
+  Shard &shard = get_shard(table_id);
+  boost::mutex::scoped_lock lock(shard.mutex);
   LocationMap::iterator iter;
   LocationCacheKey key;
 
@@ -151,7 +167,7 @@ bool LocationCache::invalidate(uint32_t table_id, const char *rowkey) {
   key.table_id = table_id;
   key.end_row = rowkey;
 
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
+  if ((iter = shard.location_map.lower_bound(key)) == shard.location_map.end())
     return false;
 
   if ((*iter).first.table_id != table_id)
@@ -160,68 +176,135 @@ bool LocationCache::invalidate(uint32_t table_id, const char *rowkey) {
   if (strcmp(rowkey, (*iter).second->start_row.c_str()) < 0)
     return false;
 
-  remove((*iter).second);
+  remove(shard, (*iter).second);
   return true;
 }
 
 
 void LocationCache::display(std::ostream &out) {
-  for (Value *value = m_head; value; value = value->prev)
-    out << "DUMP: end=" << value->end_row << " start=" << value->start_row
-        << endl;
+  for (uint32_t i=0; i<m_num_shards; i++) {
+    boost::mutex::scoped_lock lock(m_shards[i].mutex);
+    for (Value *value = m_shards[i].head; value; value = value->prev)
+      out << "DUMP: end=" << value->end_row << " start=" << value->start_row
+          << endl;
+  }
+}
+
+
+/**
+ * Evicts entries until there is room in the cache for one more.  Called
+ * with the shard at shard_index locked.  The shard evicts its own LRU
+ * entries once it holds its share of the budget; below that it takes
+ * entries from a shard that holds more than its share.  Other shards'
+ * locks are only tried, so that two inserting threads cannot deadlock.
+ * If no entry can be evicted the cache briefly runs over budget.
+ */
+void LocationCache::make_room(uint32_t shard_index) {
+  Shard &shard = m_shards[shard_index];
+
+  while ((uint32_t)atomic_read(&m_num_entries) >= m_max_entries) {
+    if (shard.location_map.size() < m_shard_share &&
+        evict_from_other_shard(shard_index))
+      continue;
+    if (!evict_lru(shard))
+      break;
+  }
+}
+
+
+/**
+ * Evicts the LRU entry of some other shard that holds more than its share
+ * of the budget and is not locked.  Returns false if there is none.
+ */
+bool LocationCache::evict_from_other_shard(uint32_t shard_index) {
+  uint32_t start = (uint32_t)atomic_add_return(1, &m_next_victim);
+
+  for (uint32_t i=0; i<m_num_shards; i++) {
+    uint32_t victim = (start + i) % m_num_shards;
+    if (victim == shard_index)
+      continue;
+    Shard &other = m_shards[victim];
+    if (other.mutex.try_lock()) {
+      bool evicted = other.location_map.size() > m_shard_share &&
+          evict_lru(other);
+      other.mutex.unlock();
+      if (evicted)
+        return true;
+    }
+  }
+  return false;
+}
+
+
+/**
+ * Removes the least recently used entry of the shard that is not pegged,
+ * moving pegged entries found on the way to the head.  Returns false if
+ * the shard has no such entry.
+ */
+bool LocationCache::evict_lru(Shard &shard) {
+  for (size_t i=shard.location_map.size(); i>0; i--) {
+    if (!shard.tail->pegged) {
+      remove(shard, shard.tail);
+      return true;
+    }
+    move_to_head(shard, shard.tail);
+  }
+  return false;
 }
 
 
 /**
  * MoveToHead
  */
-void LocationCache::move_to_head(Value *cacheval) {
+void LocationCache::move_to_head(Shard &shard, Value *cacheval) {
 
-  if (m_head == cacheval)
+  if (shard.head == cacheval)
     return;
 
   // unstich entry from cache
   cacheval->next->prev = cacheval->prev;
   if (cacheval->prev == 0)
-    m_tail = cacheval->next;
+    shard.tail = cacheval->next;
   else
     cacheval->prev->next = cacheval->next;
 
   cacheval->next = 0;
-  cacheval->prev = m_head;
-  m_head->next = cacheval;
-  m_head = cacheval;
+  cacheval->prev = shard.head;
+  shard.head->next = cacheval;
+  shard.head = cacheval;
 }
 
 
 /**
  * remove
  */
-void LocationCache::remove(Value *cacheval) {
+void LocationCache::remove(Shard &shard, Value *cacheval) {
   assert(cacheval);
-  if (m_tail == cacheval) {
-    m_tail = cacheval->next;
-    if (m_tail)
-      m_tail->prev = 0;
+  if (shard.tail == cacheval) {
+    shard.tail = cacheval->next;
+    if (shard.tail)
+      shard.tail->prev = 0;
     else {
-      assert (m_head == cacheval);
-      m_head = 0;
+      assert (shard.head == cacheval);
+      shard.head = 0;
     }
   }
-  else if (m_head == cacheval) {
-    m_head = m_head->prev;
-    m_head->next = 0;
+  else if (shard.head == cacheval) {
+    shard.head = shard.head->prev;
+    shard.head->next = 0;
   }
   else {
     cacheval->next->prev = cacheval->prev;
     cacheval->prev->next = cacheval->next;
   }
-  m_location_map.erase(cacheval->map_iter);
+  shard.location_map.erase(cacheval->map_iter);
+  atomic_dec(&m_num_entries);
   delete cacheval;
 }
 
 
 const char *LocationCache::get_constant_location_str(const char *location) {
+  boost::mutex::scoped_lock lock(m_strings_mutex);
   LocationStrSet::iterator iter = m_location_strings.find(location);
 
   if (iter != m_location_strings.end())
@@ -35,6 +35,7 @@ extern "C" {
 
 #include "Common/ReferenceCount.h"
 #include "Common/StringExt.h"
+#include "Common/atomic.h"
 
 #include "RangeLocationInfo.h"
 
@@ -83,7 +84,15 @@ namespace Hypertable {
 
 
   /**
-   *  This class acts as a cache of Range location information.  It
+   *  This class acts as a cache of Range location information.  Entries are
+   *  spread over a fixed number of shards by table id, each with its own
+   *  mutex, map and LRU list, so that mutators and scanners working on
+   *  different tables do not serialize on a single lock.  (Lookups find the
+   *  range containing a row with lower_bound, so all of a table's entries
+   *  must live in one shard.)  The capacity is a single budget shared by
+   *  all shards: a shard that holds less than its share evicts from shards
+   *  that hold more, so one hot table can use the whole cache.  With one shard the
+   *  cache behaves as a single global LRU.
    */
   class LocationCache : public ReferenceCount {
   public:
@@ -98,8 +107,7 @@ namespace Hypertable {
       bool pegged;
     };
 
-    LocationCache(uint32_t max_entries) : m_mutex(), m_location_map(),
-        m_head(0), m_tail(0), m_max_entries(max_entries) { return; }
+    LocationCache(uint32_t max_entries, uint32_t num_shards=1);
     ~LocationCache();
 
     void insert(uint32_t table_id, RangeLocationInfo &range_loc_info,
@@ -114,20 +122,41 @@ namespace Hypertable {
                                  struct sockaddr_in &addr);
 
   private:
-    void move_to_head(Value *cacheval);
-    void remove(Value *cacheval);
-
-    const char *get_constant_location_str(const char *location);
-
     typedef std::map<LocationCacheKey, Value *> LocationMap;
     typedef std::set<const char *, LtCstr> LocationStrSet;
 
-    boost::mutex   m_mutex;
-    LocationMap    m_location_map;
+    struct Shard {
+      Shard() : head(0), tail(0) { }
+      boost::mutex mutex;
+      LocationMap  location_map;
+      Value       *head;
+      Value       *tail;
+    };
+
+    uint32_t get_shard_index(uint32_t table_id) {
+      return table_id % m_num_shards;
+    }
+
+    Shard &get_shard(uint32_t table_id) {
+      return m_shards[get_shard_index(table_id)];
+    }
+
+    void make_room(uint32_t shard_index);
+    bool evict_from_other_shard(uint32_t shard_index);
+    bool evict_lru(Shard &shard);
+    void move_to_head(Shard &shard, Value *cacheval);
+    void remove(Shard &shard, Value *cacheval);
+
+    const char *get_constant_location_str(const char *location);
+
+    boost::mutex   m_strings_mutex;
     LocationStrSet m_location_strings;
-    Value         *m_head;
-    Value         *m_tail;
+    Shard         *m_shards;
+    uint32_t       m_num_shards;
     uint32_t       m_max_entries;
+    uint32_t       m_shard_share;
+    atomic_t       m_num_entries;
+    atomic_t       m_next_victim;
   };
 
   typedef boost::intrusive_ptr<LocationCache> LocationCachePtr;
@@ -45,6 +45,7 @@ using namespace Hypertable;
 namespace {
   const uint32_t METADATA_READAHEAD_COUNT = 10;
   const uint32_t MAX_ERROR_QUEUE_LENGTH = 4;
+  const double   MAX_RETRY_WAIT = 10.0;
 
   class MetaKeyBuilder {
   public:
@@ -85,8 +86,9 @@ namespace {
 RangeLocator::RangeLocator(PropertiesPtr &props_ptr,
                            ConnectionManagerPtr &conn_mgr,
                            Hyperspace::SessionPtr &hyperspace)
-    : m_conn_manager_ptr(conn_mgr), m_hyperspace_ptr(hyperspace),
-      m_root_stale(true), m_range_server(conn_mgr->get_comm(),
+    : m_async_threads(0), m_shutdown(false), m_conn_manager_ptr(conn_mgr),
+      m_hyperspace_ptr(hyperspace), m_root_stale(true),
+      m_range_server(conn_mgr->get_comm(),
       HYPERTABLE_RANGESERVER_CLIENT_TIMEOUT) {
   time_t client_timeout;
 
@@ -94,7 +96,12 @@ RangeLocator::RangeLocator(PropertiesPtr &props_ptr,
     m_range_server.set_default_timeout(client_timeout);
 
   int cache_size = props_ptr->get_int("Hypertable.LocationCache.MaxEntries", HYPERTABLE_LOCATIONCACHE_MAXENTRIES);
-  m_cache_ptr = new LocationCache(cache_size);
+  int cache_shards = props_ptr->get_int("Hypertable.LocationCache.Shards", HYPERTABLE_LOCATIONCACHE_SHARDS);
+  m_cache_ptr = new LocationCache(cache_size, cache_shards > 0 ? cache_shards : 1);
+
+  m_async_workers = props_ptr->get_int("Hypertable.RangeLocator.Workers", 4);
+  if (m_async_workers < 1)
+    m_async_workers = 1;
 
   initialize();
 }
@@ -105,7 +112,8 @@ RangeLocator::RangeLocator(PropertiesPtr &props_ptr,
  */
 RangeLocator::RangeLocator(PropertiesPtr &props_ptr, Comm *comm,
                            Hyperspace::SessionPtr &hyperspace)
-    : m_conn_manager_ptr(0), m_hyperspace_ptr(hyperspace), m_root_stale(true),
+    : m_async_threads(0), m_shutdown(false), m_conn_manager_ptr(0),
+      m_hyperspace_ptr(hyperspace), m_root_stale(true),
       m_range_server(comm, HYPERTABLE_RANGESERVER_CLIENT_TIMEOUT) {
   time_t client_timeout;
 
@@ -113,7 +121,12 @@ RangeLocator::RangeLocator(PropertiesPtr &props_ptr, Comm *comm,
     m_range_server.set_default_timeout(client_timeout);
 
   int cache_size = props_ptr->get_int("Hypertable.LocationCache.MaxEntries", HYPERTABLE_LOCATIONCACHE_MAXENTRIES);
-  m_cache_ptr = new LocationCache(cache_size);
+  int cache_shards = props_ptr->get_int("Hypertable.LocationCache.Shards", HYPERTABLE_LOCATIONCACHE_SHARDS);
+  m_cache_ptr = new LocationCache(cache_size, cache_shards > 0 ? cache_shards : 1);
+
+  m_async_workers = props_ptr->get_int("Hypertable.RangeLocator.Workers", 4);
+  if (m_async_workers < 1)
+    m_async_workers = 1;
 
   initialize();
 }
@@ -175,6 +188,15 @@ void RangeLocator::initialize() {
 
 
 RangeLocator::~RangeLocator() {
+  if (m_async_threads) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_shutdown = true;
+      m_async_cond.notify_all();
+    }
+    m_async_threads->join_all();
+    delete m_async_threads;
+  }
   m_hyperspace_ptr->close(m_root_file_handle);
 }
 
@@ -206,10 +228,15 @@ RangeLocator::find_loop(TableIdentifier *table, const char *row_key,
       HT_THROW(Error::REQUEST_TIMEOUT, (String)"Locating range for row = '" + row_key + "'");
     }
 
-    // wait a bit
-    poll(0, 0, (int)(wait_time*1000.0));
+    // wait a bit, jittered so that many clients retrying the same lookup
+    // don't arrive at the METADATA server together
+    int wait_ms = (int)(wait_time*1000.0);
+    wait_ms = wait_ms/2 + (int)(random() % (wait_ms/2 + 1));
+    poll(0, 0, wait_ms);
     total_wait_time += wait_time;
     wait_time *= 1.5;
+    if (wait_time > MAX_RETRY_WAIT)
+      wait_time = MAX_RETRY_WAIT;
 
     // try again
     if ((error = find(table, row_key, rane_loc_infop, timer, true)) == Error::TABLE_DOES_NOT_EXIST) {
@@ -232,10 +259,8 @@ RangeLocator::find(TableIdentifier *table, const char *row_key,
     RangeLocationInfo *rane_loc_infop, Timer &timer, bool hard) {
   RangeSpec range;
   ScanSpec meta_scan_spec;
-  ScanBlock scan_block;
   int error;
   Key key;
-  RangeLocationInfo range_loc_info;
   std::string start_row;
   std::string end_row;
   struct sockaddr_in addr;
@@ -295,30 +320,16 @@ RangeLocator::find(TableIdentifier *table, const char *row_key,
     meta_scan_spec.return_deletes = false;
     // meta_scan_spec.interval = ????;
 
-    try {
-      m_range_server.set_timeout((time_t)(timer.remaining() + 0.5));
-      m_range_server.create_scanner(addr, m_metadata_table, range, meta_scan_spec, scan_block);
-    }
-    catch (Exception &e) {
-      if (e.code() == Error::RANGESERVER_RANGE_NOT_FOUND)
-	m_cache_ptr->invalidate(0, meta_keys.start);
-      return e.code();
-    }
-
-    if ((error = process_metadata_scanblock(scan_block)) != Error::OK) {
-      m_range_server.destroy_scanner(addr, scan_block.get_scanner_id(), 0);
-      return error;
-    }
+    error = lookup_metadata(Key::END_ROOT_ROW, addr, range, meta_scan_spec,
+                            meta_keys.start, 0, meta_key_ptr, inclusive,
+                            rane_loc_infop, timer);
 
-    if (!scan_block.eos()) {
-      m_range_server.destroy_scanner(addr, scan_block.get_scanner_id(), 0);
-    }
-
-    if (!m_cache_ptr->lookup(0, meta_key_ptr, rane_loc_infop, inclusive)) {
+    if (error == Error::METADATA_NOT_FOUND)
       HT_ERRORF("Unable to find metadata for row '%s' row_key=%s",
                 meta_keys.start, row_key);
-      return Error::METADATA_NOT_FOUND;
-    }
+
+    if (error != Error::OK)
+      return error;
   }
 
   if (table->id == 0)
@@ -328,8 +339,10 @@ RangeLocator::find(TableIdentifier *table, const char *row_key,
    * Find actual range from second-level METADATA range
    */
 
-  range.start_row = rane_loc_infop->start_row.c_str();
-  range.end_row   = rane_loc_infop->end_row.c_str();
+  start_row = rane_loc_infop->start_row;
+  end_row = rane_loc_infop->end_row;
+  range.start_row = start_row.c_str();
+  range.end_row   = end_row.c_str();
 
   if (!LocationCache::location_to_addr(
       rane_loc_infop->location.c_str(), addr)) {
@@ -359,60 +372,311 @@ RangeLocator::find(TableIdentifier *table, const char *row_key,
       HT_THROW(Error::REQUEST_TIMEOUT, "");
   }
 
+  if (row_key == 0)
+    row_key = "";
+
+  /**
+   * Lookups that need this METADATA range while a scan of it is in flight
+   * wait for that scan instead of issuing their own
+   */
+  error = lookup_metadata(end_row, addr, range, meta_scan_spec,
+                          meta_keys.start+2, table->id, row_key, inclusive,
+                          rane_loc_infop, timer);
+
+  if (error == Error::METADATA_NOT_FOUND) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_last_errors.push_back((std::string)"RangeLocator failed to find metadata for table '" + table->name + "' row '" + row_key + "'");
+    while (m_last_errors.size() > MAX_ERROR_QUEUE_LENGTH)
+      m_last_errors.pop_front();
+  }
+
+  return error;
+}
+
+
+/**
+ * Looks up row_key in the cache after a METADATA scan.  If a scan with
+ * the same scan_key (the end row of the METADATA range being read) is
+ * already in flight, this waits for it and consults the cache first, and
+ * only scans itself if that scan did not cover row_key.  If the scan it
+ * waited on failed, its error is returned instead.
+ */
+int
+RangeLocator::lookup_metadata(const String &scan_key, struct sockaddr_in &addr,
+    RangeSpec &range, ScanSpec &scan_spec, const char *invalidate_row,
+    uint32_t table_id, const char *row_key, bool inclusive,
+    RangeLocationInfo *range_loc_infop, Timer &timer) {
+  PendingScanPtr pending;
+  int error;
+
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    PendingScanMap::iterator iter = m_pending_scans.find(scan_key);
+
+    if (iter != m_pending_scans.end()) {
+      boost::xtime expire_time;
+      boost::xtime_get(&expire_time, boost::TIME_UTC);
+      expire_time.sec += (int64_t)timer.remaining();
+
+      pending = iter->second;
+      while (!pending->done) {
+        if (!m_pending_cond.timed_wait(lock, expire_time))
+          return Error::REQUEST_TIMEOUT;
+      }
+      if (pending->error != Error::OK)
+        return pending->error;
+      pending = 0;
+    }
+    else {
+      pending = new PendingScan();
+      m_pending_scans[scan_key] = pending;
+    }
+  }
+
+  if (!pending) {
+    if (m_cache_ptr->lookup(table_id, row_key, range_loc_infop, inclusive))
+      return Error::OK;
+    error = scan_metadata(addr, range, scan_spec, invalidate_row, timer, false);
+  }
+  else {
+    // waiters must be released even if the scan throws
+    try {
+      error = scan_metadata(addr, range, scan_spec, invalidate_row, timer,
+                            false);
+    }
+    catch (Exception &e) {
+      finish_pending_scan(scan_key, pending, e.code());
+      throw;
+    }
+    catch (...) {
+      finish_pending_scan(scan_key, pending, Error::EXTERNAL);
+      throw;
+    }
+    finish_pending_scan(scan_key, pending, error);
+  }
+
+  if (error != Error::OK)
+    return error;
+
+  if (!m_cache_ptr->lookup(table_id, row_key, range_loc_infop, inclusive))
+    return Error::METADATA_NOT_FOUND;
+
+  return Error::OK;
+}
+
+
+/**
+ * Records the outcome of a METADATA scan, removes it from the pending
+ * scan map and wakes up the lookups waiting on it.
+ */
+void
+RangeLocator::finish_pending_scan(const String &scan_key,
+                                  PendingScanPtr &pending, int error) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  PendingScanMap::iterator iter = m_pending_scans.find(scan_key);
+  pending->done = true;
+  pending->error = error;
+  if (iter != m_pending_scans.end() && iter->second == pending)
+    m_pending_scans.erase(iter);
+  m_pending_cond.notify_all();
+}
+
+
+/**
+ * Scans METADATA and loads the rows returned into the cache.  Unless
+ * fetch_all is set, only the first scan block is read.  If stop_row is
+ * given, the scan ends once the first complete row at or past it has
+ * been read.
+ */
+int
+RangeLocator::scan_metadata(struct sockaddr_in &addr, RangeSpec &range,
+    ScanSpec &scan_spec, const char *invalidate_row, Timer &timer,
+    bool fetch_all, const char *stop_row) {
+  ScanBlock scan_block;
+  MetadataRecord record;
+  int error;
+
   try {
     m_range_server.set_timeout((time_t)(timer.remaining() + 0.5));
     m_range_server.create_scanner(addr, m_metadata_table, range,
-                                  meta_scan_spec, scan_block);
+                                  scan_spec, scan_block);
   }
   catch (Exception &e) {
     if (e.code() == Error::RANGESERVER_RANGE_NOT_FOUND)
-      m_cache_ptr->invalidate(0, meta_keys.start+2);
+      m_cache_ptr->invalidate(0, invalidate_row);
     return e.code();
   }
 
-  if ((error = process_metadata_scanblock(scan_block)) != Error::OK) {
-    m_range_server.destroy_scanner(addr, scan_block.get_scanner_id(), 0);
-    return error;
+  while (true) {
+    if ((error = process_metadata_scanblock(scan_block, record)) != Error::OK) {
+      m_range_server.destroy_scanner(addr, scan_block.get_scanner_id(), 0);
+      return error;
+    }
+
+    if (scan_block.eos())
+      break;
+
+    if (!fetch_all || (stop_row && record.got_start_row &&
+        record.got_location && strcmp(format("%u:%s", record.table_id,
+        record.info.end_row.c_str()).c_str(), stop_row) >= 0)) {
+      m_range_server.destroy_scanner(addr, scan_block.get_scanner_id(), 0);
+      break;
+    }
+
+    try {
+      m_range_server.set_timeout((time_t)(timer.remaining() + 0.5));
+      m_range_server.fetch_scanblock(addr, scan_block.get_scanner_id(),
+                                     scan_block);
+    }
+    catch (Exception &e) {
+      return e.code();
+    }
   }
 
-  if (!scan_block.eos()) {
-    m_range_server.destroy_scanner(addr, scan_block.get_scanner_id(), 0);
+  return insert_metadata_record(record, true);
+}
+
+
+void
+RangeLocator::find_async(TableIdentifier *table, const char *row_key,
+                         RangeLocatorCallback *cb, double timeout) {
+  boost::mutex::scoped_lock lock(m_mutex);
+
+  if (m_async_threads == 0) {
+    m_async_threads = new boost::thread_group();
+    for (int i=0; i<m_async_workers; i++)
+      m_async_threads->create_thread(AsyncWorker(this));
   }
 
-  if (row_key == 0)
-    row_key = "";
+  m_async_queue.push_back(new AsyncLookup(table, row_key, cb, timeout));
+  m_async_cond.notify_one();
+}
 
-  if (!m_cache_ptr->lookup(table->id, row_key, rane_loc_infop, inclusive)) {
-    boost::mutex::scoped_lock lock(m_mutex);
-    m_last_errors.push_back((std::string)"RangeLocator failed to find metadata for table '" + table->name + "' row '" + row_key + "'");
-    while (m_last_errors.size() > MAX_ERROR_QUEUE_LENGTH)
-      m_last_errors.pop_front();
-    return Error::METADATA_NOT_FOUND;
+
+void RangeLocator::run_async_lookups() {
+  AsyncLookup *lookup;
+  RangeLocationInfo range_loc_info;
+
+  while (true) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (m_async_queue.empty() && !m_shutdown)
+        m_async_cond.wait(lock);
+      if (m_shutdown)
+        break;
+      lookup = m_async_queue.front();
+      m_async_queue.pop_front();
+    }
+
+    try {
+      find_loop(&lookup->table, lookup->row_key.c_str(), &range_loc_info,
+                lookup->timer, false);
+      lookup->cb->located(lookup->row_key, range_loc_info);
+    }
+    catch (Exception &e) {
+      lookup->cb->error(lookup->row_key, e.code(), e.what());
+    }
+    delete lookup;
   }
 
-  return Error::OK;
+  // fail lookups still queued at shutdown
+  while (true) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (m_async_queue.empty())
+        break;
+      lookup = m_async_queue.front();
+      m_async_queue.pop_front();
+    }
+    lookup->cb->error(lookup->row_key, Error::REQUEST_TIMEOUT,
+                      "RangeLocator shutting down");
+    delete lookup;
+  }
+}
+
+
+void
+RangeLocator::prefetch(TableIdentifier *table, const char *start_row,
+                       const char *end_row, Timer &timer) {
+  RangeLocationInfo meta_range;
+  RangeSpec range;
+  ScanSpec meta_scan_spec;
+  RowInterval ri;
+  struct sockaddr_in addr;
+  int error;
+  String start_key = format("%u:%s", table->id, start_row ? start_row : "");
+  String end_key = format("%u:", table->id);
+  String table_end_key = end_key + Key::END_ROW_MARKER;
+
+  if (end_row && *end_row)
+    end_key += end_row;
+  else
+    end_key = table_end_key;
+
+  while (true) {
+
+    // find the METADATA range (or the root range) holding start_key
+    find_loop(&m_metadata_table, start_key.c_str(), &meta_range, timer, false);
+
+    if (!LocationCache::location_to_addr(meta_range.location.c_str(), addr))
+      HT_THROWF(Error::INVALID_METADATA, "Invalid location found in METADATA "
+                "entry for row '%s' - %s", meta_range.end_row.c_str(),
+                meta_range.location.c_str());
+
+    if (m_conn_manager_ptr &&
+        !m_conn_manager_ptr->wait_for_connection(addr,
+            (time_t)(timer.remaining() + 0.5))) {
+      if (timer.expired())
+        HT_THROW(Error::REQUEST_TIMEOUT, "");
+    }
+
+    range.start_row = meta_range.start_row.c_str();
+    range.end_row = meta_range.end_row.c_str();
+
+    meta_scan_spec.clear();
+    meta_scan_spec.max_versions = 1;
+    meta_scan_spec.columns.push_back("StartRow");
+    meta_scan_spec.columns.push_back("Location");
+    meta_scan_spec.return_deletes = false;
+
+    ri.start = start_key.c_str();
+    ri.start_inclusive = true;
+    /**
+     * METADATA rows are keyed by range end row, so the range holding
+     * end_row is the first row at or past end_key, which may be anywhere
+     * up to the end of the table.  Scan that far, but stop at that row.
+     */
+    ri.end = table_end_key.c_str();
+    ri.end_inclusive = true;
+    meta_scan_spec.row_intervals.push_back(ri);
+
+    if ((error = scan_metadata(addr, range, meta_scan_spec, start_key.c_str(),
+                               timer, true, end_key.c_str())) != Error::OK)
+      HT_THROWF(error, "Prefetching locations of table '%s' from METADATA "
+                "range ending at '%s'", table->name,
+                meta_range.end_row.c_str());
+
+    if (strcmp(meta_range.end_row.c_str(), end_key.c_str()) >= 0)
+      break;
+
+    // the next METADATA range starts just after this one's end row
+    start_key = meta_range.end_row + (char)0x01;
+  }
 }
 
 
 /**
- *
+ * Parses a block of METADATA cells.  A row's StartRow and Location cells
+ * may be split across blocks, so the row being assembled is carried in
+ * record from one call to the next.
  */
-int RangeLocator::process_metadata_scanblock(ScanBlock &scan_block) {
-  RangeLocationInfo range_loc_info;
+int RangeLocator::process_metadata_scanblock(ScanBlock &scan_block,
+                                             MetadataRecord &record) {
   ByteString bskey;
   ByteString value;
   Key key;
   const char *stripped_key;
-  uint32_t table_id = 0;
-  struct sockaddr_in addr;
-
-  range_loc_info.start_row = "";
-  range_loc_info.end_row = "";
-  range_loc_info.location = "";
-
-  bool got_start_row = false;
-  bool got_end_row = false;
-  bool got_location = false;
+  int error;
 
   while (scan_block.next(bskey, value)) {
 
@@ -427,61 +691,32 @@ int RangeLocator::process_metadata_scanblock(ScanBlock &scan_block) {
     }
     stripped_key++;
 
-    if (got_end_row) {
-      if (strcmp(stripped_key, range_loc_info.end_row.c_str())) {
-        if (got_start_row && got_location) {
-
-          /**
-           * Add this location (address) to the connection manager
-           */
-          if (!LocationCache::location_to_addr(
-              range_loc_info.location.c_str(), addr)) {
-            HT_ERRORF("Invalid location found in METADATA entry for row '%s' "
-                      "- %s", range_loc_info.end_row.c_str(),
-                      range_loc_info.location.c_str());
-            return Error::INVALID_METADATA;
-          }
-          if (m_conn_manager_ptr)
-            m_conn_manager_ptr->add(addr, 300, "RangeServer");
-
-          m_cache_ptr->insert(table_id, range_loc_info);
-          //cout << "(1) cache insert table=" << table_id << " start=" << range_loc_info.start_row << " end=" << range_loc_info.end_row << " loc=" << range_loc_info.location << endl;
-        }
-        else {
-          boost::mutex::scoped_lock lock(m_mutex);
-          m_last_errors.push_back(format("Incomplete METADATA record found in "
-              "root range under row key '%s'", range_loc_info.end_row.c_str()));
-          while (m_last_errors.size() > MAX_ERROR_QUEUE_LENGTH)
-            m_last_errors.pop_front();
-        }
-        range_loc_info.start_row = "";
-        range_loc_info.end_row = "";
-        range_loc_info.location = "";
-        got_start_row = false;
-        got_end_row = false;
-        got_location = false;
-      }
+    if (record.got_end_row &&
+        strcmp(stripped_key, record.info.end_row.c_str())) {
+      if ((error = insert_metadata_record(record, false)) != Error::OK)
+        return error;
     }
-    else {
-      table_id = (uint32_t)strtol(key.row, 0, 10);
-      range_loc_info.end_row = stripped_key;
-      got_end_row = true;
+
+    if (!record.got_end_row) {
+      record.table_id = (uint32_t)strtol(key.row, 0, 10);
+      record.info.end_row = stripped_key;
+      record.got_end_row = true;
     }
 
     if (key.column_family_code == m_startrow_cid) {
       const uint8_t *str;
       size_t len = value.decode_length(&str);
       //cout << "TS=" << key.timestamp << endl;
-      range_loc_info.start_row = std::string((const char *)str, len);
-      got_start_row = true;
+      record.info.start_row = std::string((const char *)str, len);
+      record.got_start_row = true;
     }
     else if (key.column_family_code == m_location_cid) {
       const uint8_t *str;
       size_t len = value.decode_length(&str);
-      range_loc_info.location = std::string((const char *)str, len);
-      if (range_loc_info.location == "!")
+      record.info.location = std::string((const char *)str, len);
+      if (record.info.location == "!")
         return Error::TABLE_DOES_NOT_EXIST;
-      got_location = true;
+      record.got_location = true;
     }
     else {
       HT_ERRORF("METADATA lookup on row '%s' returned incorrect column (id=%d)",
@@ -489,29 +724,48 @@ int RangeLocator::process_metadata_scanblock(ScanBlock &scan_block) {
     }
   }
 
-  if (got_start_row && got_end_row && got_location) {
+  return Error::OK;
+}
+
+
+/**
+ * Inserts a completed METADATA row into the cache and clears record.
+ * last indicates the final row of a scan, which may legitimately be cut
+ * short by the scan's limits.
+ */
+int RangeLocator::insert_metadata_record(MetadataRecord &record, bool last) {
+  struct sockaddr_in addr;
+
+  if (record.got_start_row && record.got_end_row && record.got_location) {
 
     /**
      * Add this location (address) to the connection manager
      */
     if (!LocationCache::location_to_addr(
-        range_loc_info.location.c_str(), addr)) {
+        record.info.location.c_str(), addr)) {
       HT_ERRORF("Invalid location found in METADATA entry for row '%s' - %s",
-          range_loc_info.end_row.c_str(), range_loc_info.location.c_str());
+          record.info.end_row.c_str(), record.info.location.c_str());
       return Error::INVALID_METADATA;
     }
     if (m_conn_manager_ptr)
       m_conn_manager_ptr->add(addr, 300, "RangeServer");
 
-    m_cache_ptr->insert(table_id, range_loc_info);
-
-    //cout << "(2) cache insert table=" << table_id << " start=" << range_loc_info.start_row << " end=" << range_loc_info.end_row << " loc=" << range_loc_info.location << endl;
+    m_cache_ptr->insert(record.table_id, record.info);
+  }
+  else if (last) {
+    if (record.got_end_row)
+      HT_ERRORF("Incomplete METADATA record found in root tablet under row "
+                "key '%s'", record.info.end_row.c_str());
   }
-  else if (got_end_row) {
-    HT_ERRORF("Incomplete METADATA record found in root tablet under row key "
-              "'%s'", range_loc_info.end_row.c_str());
+  else {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_last_errors.push_back(format("Incomplete METADATA record found in "
+        "root range under row key '%s'", record.info.end_row.c_str()));
+    while (m_last_errors.size() > MAX_ERROR_QUEUE_LENGTH)
+      m_last_errors.pop_front();
   }
 
+  record.clear();
   return Error::OK;
 }
 
@@ -23,6 +23,10 @@
 #define HYPERTABLE_RANGELOCATOR_H
 
 #include <deque>
+#include <map>
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "Common/ReferenceCount.h"
 #include "Common/Timer.h"
@@ -45,6 +49,22 @@ namespace Hypertable {
 
   class RangeServerClient;
 
+  /** Receives the result of RangeLocator::find_async.  One of the two
+   * methods is called exactly once, from a locator worker thread.
+   */
+  class RangeLocatorCallback {
+  public:
+    virtual ~RangeLocatorCallback() { return; }
+
+    /** Called with the location of the range containing row_key */
+    virtual void located(const String &row_key,
+                         RangeLocationInfo &range_loc_info) = 0;
+
+    /** Called if the range could not be located before the timeout */
+    virtual void error(const String &row_key, int error,
+                       const String &msg) = 0;
+  };
+
   /** Locates containing range given a key.  This class does the METADATA range
    * searching to find the location of the range that contains a row key.
    */
@@ -101,6 +121,33 @@ namespace Hypertable {
     int find(TableIdentifier *table, const char *row_key,
              RangeLocationInfo *range_loc_infop, Timer &timer, bool hard);
 
+    /** Locates the range that contains the given row key asynchronously.
+     * The lookup runs on one of the locator's worker threads (started on
+     * first use, Hypertable.RangeLocator.Workers of them) and the result
+     * is delivered to cb.  Concurrent lookups that need the same METADATA
+     * range share a single METADATA scan.
+     *
+     * @param table pointer to table identifier structure
+     * @param row_key row key to locate
+     * @param cb callback to receive the result
+     * @param timeout maximum time in seconds to spend on the lookup
+     */
+    void find_async(TableIdentifier *table, const char *row_key,
+                    RangeLocatorCallback *cb, double timeout);
+
+    /** Loads the locations of all ranges of a table that intersect a row
+     * interval into the location cache.  This reads the covering METADATA
+     * rows with one scan per METADATA range instead of one lookup per
+     * range, which is what a job about to touch every range wants.
+     *
+     * @param table pointer to table identifier structure
+     * @param start_row first row of interval (0 or "" for beginning of table)
+     * @param end_row last row of interval (0 or "" for end of table)
+     * @param timer reference to timer object
+     */
+    void prefetch(TableIdentifier *table, const char *start_row,
+                  const char *end_row, Timer &timer);
+
     /**
      * Invalidates the cached entry for the given row key
      *
@@ -128,11 +175,76 @@ namespace Hypertable {
 
   private:
 
+    /** METADATA row being assembled from StartRow and Location cells */
+    class MetadataRecord {
+    public:
+      MetadataRecord() { clear(); }
+      void clear() {
+        info.start_row = info.end_row = info.location = "";
+        table_id = 0;
+        got_start_row = got_end_row = got_location = false;
+      }
+      RangeLocationInfo info;
+      uint32_t table_id;
+      bool got_start_row;
+      bool got_end_row;
+      bool got_location;
+    };
+
+    /** A METADATA scan in flight that other lookups can wait on */
+    class PendingScan : public ReferenceCount {
+    public:
+      PendingScan() : done(false), error(0) { return; }
+      bool done;
+      int  error;
+    };
+    typedef boost::intrusive_ptr<PendingScan> PendingScanPtr;
+    typedef std::map<String, PendingScanPtr> PendingScanMap;
+
+    class AsyncLookup {
+    public:
+      AsyncLookup(TableIdentifier *t, const char *row, RangeLocatorCallback *c,
+                  double timeout)
+        : table(*t), row_key(row ? row : ""), cb(c), timer(timeout, true) { }
+      TableIdentifierManaged table;
+      String row_key;
+      RangeLocatorCallback *cb;
+      Timer timer;
+    };
+
+    class AsyncWorker {
+    public:
+      AsyncWorker(RangeLocator *locator) : m_locator(locator) { return; }
+      void operator()() { m_locator->run_async_lookups(); }
+    private:
+      RangeLocator *m_locator;
+    };
+
     void initialize();
-    int process_metadata_scanblock(ScanBlock &scan_block);
+    int lookup_metadata(const String &scan_key, struct sockaddr_in &addr,
+                        RangeSpec &range, ScanSpec &scan_spec,
+                        const char *invalidate_row, uint32_t table_id,
+                        const char *row_key, bool inclusive,
+                        RangeLocationInfo *range_loc_infop, Timer &timer);
+    void finish_pending_scan(const String &scan_key, PendingScanPtr &pending,
+                             int error);
+    int scan_metadata(struct sockaddr_in &addr, RangeSpec &range,
+                      ScanSpec &scan_spec, const char *invalidate_row,
+                      Timer &timer, bool fetch_all, const char *stop_row=0);
+    int process_metadata_scanblock(ScanBlock &scan_block,
+                                   MetadataRecord &record);
+    int insert_metadata_record(MetadataRecord &record, bool last);
     int read_root_location(Timer &timer);
+    void run_async_lookups();
 
     boost::mutex           m_mutex;
+    boost::condition       m_pending_cond;
+    PendingScanMap         m_pending_scans;
+    boost::condition       m_async_cond;
+    std::deque<AsyncLookup *> m_async_queue;
+    boost::thread_group   *m_async_threads;
+    int                    m_async_workers;
+    bool                   m_shutdown;
     ConnectionManagerPtr   m_conn_manager_ptr;
     Hyperspace::SessionPtr m_hyperspace_ptr;
     LocationCachePtr       m_cache_ptr;
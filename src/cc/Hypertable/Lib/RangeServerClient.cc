@@ -21,6 +21,7 @@
 
 #include "Common/Compat.h"
 #include "Common/Error.h"
+#include "Common/Serialization.h"
 #include "Common/StringExt.h"
 #include "AsyncComm/DispatchHandlerSynchronizer.h"
 
@@ -172,6 +173,33 @@ void RangeServerClient::dump_stats(struct sockaddr_in &addr) {
 }
 
 
+void RangeServerClient::get_statistics(struct sockaddr_in &addr, String &stats) {
+  DispatchHandlerSynchronizer sync_handler;
+  EventPtr event_ptr;
+  CommBufPtr cbp(RangeServerProtocol::create_request_get_statistics());
+  send_message(addr, cbp, &sync_handler);
+  if (!sync_handler.wait_for_reply(event_ptr))
+    HT_THROW((int)Protocol::response_code(event_ptr),
+             String("RangeServer get_statistics() failure : ") + Protocol::string_format_message(event_ptr));
+  else {
+    const uint8_t *ptr = event_ptr->message + sizeof(int32_t);
+    size_t remaining = event_ptr->message_len - sizeof(int32_t);
+    stats = Serialization::decode_vstr(&ptr, &remaining);
+  }
+}
+
+
+void RangeServerClient::import_cell_stores(struct sockaddr_in &addr, TableIdentifier &table, RangeSpec &range, const std::vector<String> &access_groups, const std::vector<String> &files, int64_t max_timestamp) {
+  DispatchHandlerSynchronizer sync_handler;
+  EventPtr event_ptr;
+  CommBufPtr cbp(RangeServerProtocol::create_request_import_cell_stores(table, range, access_groups, files, max_timestamp));
+  send_message(addr, cbp, &sync_handler);
+  if (!sync_handler.wait_for_reply(event_ptr))
+    HT_THROW((int)Protocol::response_code(event_ptr),
+             String("RangeServer import_cell_stores() failure : ") + Protocol::string_format_message(event_ptr));
+}
+
+
 void RangeServerClient::replay_begin(struct sockaddr_in &addr, uint16_t group, DispatchHandler *handler) {
   CommBufPtr cbp(RangeServerProtocol::create_request_replay_begin(group));
   send_message(addr, cbp, handler);
@@ -183,6 +183,28 @@ namespace Hypertable {
 
     void dump_stats(struct sockaddr_in &addr);
 
+    /** Issues a "get statistics" request.  This call blocks until it
+     * receives a response from the server.
+     *
+     * @param addr remote address of RangeServer connection
+     * @param stats reference to string to hold the statistics report
+     */
+    void get_statistics(struct sockaddr_in &addr, String &stats);
+
+    /** Issues an "import cell stores" request.  This call blocks until it
+     * receives a response from the server.  On success the files have been
+     * moved into the range's access group directories and recorded in the
+     * METADATA 'Files' column.
+     *
+     * @param addr remote address of RangeServer connection
+     * @param table table identifier
+     * @param range range specification
+     * @param access_groups access group name for each file
+     * @param files DFS paths of the CellStore files to attach
+     * @param max_timestamp largest cell timestamp in any of the files
+     */
+    void import_cell_stores(struct sockaddr_in &addr, TableIdentifier &table, RangeSpec &range, const std::vector<String> &access_groups, const std::vector<String> &files, int64_t max_timestamp);
+
     /** Issues a "replay begin" request.
      *
      * @param addr remote address of RangeServer connection
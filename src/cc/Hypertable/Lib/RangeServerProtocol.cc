@@ -45,6 +45,8 @@ namespace Hypertable {
     "replay load range",
     "replay update",
     "replay commit",
+    "get statistics",
+    "import cell stores",
     (const char *)0
   };
 
@@ -128,6 +130,13 @@ namespace Hypertable {
     return cbuf;
   }
 
+  CommBuf *RangeServerProtocol::create_request_get_statistics() {
+    HeaderBuilder hbuilder(Header::PROTOCOL_HYPERTABLE_RANGESERVER);
+    CommBuf *cbuf = new CommBuf(hbuilder, 2);
+    cbuf->append_i16(COMMAND_GET_STATISTICS);
+    return cbuf;
+  }
+
   CommBuf *RangeServerProtocol::create_request_replay_begin(uint16_t group) {
     HeaderBuilder hbuilder(Header::PROTOCOL_HYPERTABLE_RANGESERVER);
     CommBuf *cbuf = new CommBuf(hbuilder, 4);
@@ -160,6 +169,25 @@ namespace Hypertable {
     return cbuf;
   }
 
+  CommBuf *RangeServerProtocol::create_request_import_cell_stores(TableIdentifier &table, RangeSpec &range, const std::vector<String> &access_groups, const std::vector<String> &files, int64_t max_timestamp) {
+    HeaderBuilder hbuilder(Header::PROTOCOL_HYPERTABLE_RANGESERVER);
+    size_t len = 2 + table.encoded_length() + range.encoded_length() + 8 + 4;
+    HT_EXPECT(access_groups.size() == files.size(), Error::FAILED_EXPECTATION);
+    for (size_t i=0; i<files.size(); i++)
+      len += encoded_length_vstr(access_groups[i]) + encoded_length_vstr(files[i]);
+    CommBuf *cbuf = new CommBuf(hbuilder, len);
+    cbuf->append_i16(COMMAND_IMPORT_CELL_STORES);
+    table.encode(cbuf->get_data_ptr_address());
+    range.encode(cbuf->get_data_ptr_address());
+    cbuf->append_i64(max_timestamp);
+    cbuf->append_i32(files.size());
+    for (size_t i=0; i<files.size(); i++) {
+      cbuf->append_vstr(access_groups[i]);
+      cbuf->append_vstr(files[i]);
+    }
+    return cbuf;
+  }
+
   CommBuf *RangeServerProtocol::create_request_drop_range(TableIdentifier &table, RangeSpec &range) {
     HeaderBuilder hbuilder(Header::PROTOCOL_HYPERTABLE_RANGESERVER);
     CommBuf *cbuf = new CommBuf(hbuilder, 2 + table.encoded_length() + range.encoded_length());
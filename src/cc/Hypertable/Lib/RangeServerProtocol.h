@@ -22,6 +22,8 @@
 #ifndef HYPERTABLE_RANGESERVERPROTOCOL_H
 #define HYPERTABLE_RANGESERVERPROTOCOL_H
 
+#include <vector>
+
 #include "AsyncComm/Protocol.h"
 
 #include "RangeState.h"
@@ -49,7 +51,9 @@ namespace Hypertable {
     static const short COMMAND_REPLAY_LOAD_RANGE = 12;
     static const short COMMAND_REPLAY_UPDATE     = 13;
     static const short COMMAND_REPLAY_COMMIT     = 14;
-    static const short COMMAND_MAX               = 15;
+    static const short COMMAND_GET_STATISTICS    = 15;
+    static const short COMMAND_IMPORT_CELL_STORES = 16;
+    static const short COMMAND_MAX               = 17;
 
     static const char *m_command_strings[];
 
@@ -121,6 +125,13 @@ namespace Hypertable {
      */
     static CommBuf *create_request_dump_stats();
 
+    /** Creates a "get statistics" request message.  The response carries
+     * a text report of per-operation latency histograms and counters.
+     *
+     * @return protocol message
+     */
+    static CommBuf *create_request_get_statistics();
+
     /** Creates a "drop table" request message.
      *
      * @param table table identifier
@@ -163,6 +174,20 @@ namespace Hypertable {
      */
     static CommBuf *create_request_drop_range(TableIdentifier &table, RangeSpec &range);
 
+    /** Creates an "import cell stores" request message.  Each file is a
+     * CellStore written outside of the RangeServer, sorted and confined to
+     * the range, and is attached to the access group at the same index of
+     * the access_groups vector.
+     *
+     * @param table table identifier
+     * @param range range specification
+     * @param access_groups access group name for each file
+     * @param files DFS paths of the CellStore files
+     * @param max_timestamp largest cell timestamp in any of the files
+     * @return protocol message
+     */
+    static CommBuf *create_request_import_cell_stores(TableIdentifier &table, RangeSpec &range, const std::vector<String> &access_groups, const std::vector<String> &files, int64_t max_timestamp);
+
     virtual const char *command_text(short command);
   };
 
@@ -35,7 +35,8 @@ const int64_t Hypertable::BEGINNING_OF_TIME = std::numeric_limits<int64_t>::min(
 const int64_t Hypertable::END_OF_TIME = std::numeric_limits<int64_t>::max();
 
 RowInterval::RowInterval() : start(0), start_inclusive(true),
-			     end(0), end_inclusive(true) { }
+			     end(0), end_inclusive(true), start_len(0),
+			     end_len(0) { }
 
 size_t RowInterval::encoded_length() const {
   return 2 + encoded_length_vstr(start) + encoded_length_vstr(end);
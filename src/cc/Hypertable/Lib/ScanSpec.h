@@ -30,12 +30,16 @@ namespace Hypertable {
 
   /**
    * Represents a row interval.  c-string data members are not managed
-   * so caller must handle deallocation.
+   * so caller must handle deallocation.  start_len and end_len are only
+   * used by the client, for tables with binary rows whose bounds may
+   * contain NUL bytes; zero means the bound is NUL-terminated.  They are
+   * not part of the encoding.
    */
   class RowInterval {
   public:
     RowInterval();
-    RowInterval(const uint8_t **bufp, size_t *remainp) { decode(bufp, remainp); }
+    RowInterval(const uint8_t **bufp, size_t *remainp)
+      : start_len(0), end_len(0) { decode(bufp, remainp); }
 
     size_t encoded_length() const;
     void encode(uint8_t **bufp) const;
@@ -45,6 +49,8 @@ namespace Hypertable {
     bool start_inclusive;
     const char *end;
     bool end_inclusive;
+    size_t start_len;
+    size_t end_len;
   };
 
 
@@ -150,6 +156,7 @@ namespace Hypertable {
       RowInterval ri;
       m_strings.push_back(str);
       ri.start = ri.end = m_strings.back().c_str();
+      ri.start_len = ri.end_len = str.length();
       ri.start_inclusive = ri.end_inclusive = true;
       m_scan_spec.row_intervals.push_back(ri);
     }
@@ -167,9 +174,11 @@ namespace Hypertable {
       RowInterval ri;
       m_strings.push_back(start);
       ri.start = m_strings.back().c_str();
+      ri.start_len = start.length();
       ri.start_inclusive = start_inclusive;
       m_strings.push_back(end);
       ri.end = m_strings.back().c_str();
+      ri.end_len = end.length();
       ri.end_inclusive = end_inclusive;
       m_scan_spec.row_intervals.push_back(ri);      
     }
@@ -71,7 +71,7 @@ bool hql_needs_quotes(const char *name) {
 
 /**
  */
-Schema::Schema(bool read_ids) : m_error_string(), m_next_column_id(0), m_access_group_map(), m_column_family_map(), m_generation(1), m_access_groups(), m_open_access_group(0), m_open_column_family(0), m_read_ids(read_ids), m_output_ids(false), m_max_column_family_id(0) {
+Schema::Schema(bool read_ids) : m_error_string(), m_next_column_id(0), m_access_group_map(), m_column_family_map(), m_generation(1), m_access_groups(), m_open_access_group(0), m_open_column_family(0), m_read_ids(read_ids), m_output_ids(false), m_max_column_family_id(0), m_binary_rows(false) {
   if (Logger::logger == 0) {
     cerr << "Logger::initialize must be called before using Schema class" << endl;
     exit(1);
@@ -124,6 +124,14 @@ void Schema::start_element_handler(void *userdata,
         ms_schema->set_generation(atts[i+1]);
       else if (!strcasecmp(atts[i], "compressor"))
         ms_schema->set_compressor((String)atts[i+1]);
+      else if (!strcasecmp(atts[i], "binaryRows")) {
+        if (!strcasecmp(atts[i+1], "true") || !strcmp(atts[i+1], "1"))
+          ms_schema->set_binary_rows(true);
+        else if (!strcasecmp(atts[i+1], "false") || !strcmp(atts[i+1], "0"))
+          ms_schema->set_binary_rows(false);
+        else
+          ms_schema->set_error_string((String)"Invalid value (" + atts[i+1] + ") for Schema attribute 'binaryRows'");
+      }
       else
         ms_schema->set_error_string((string)"Unrecognized 'Schema' attribute : " + atts[i]);
     }
@@ -144,7 +152,7 @@ void Schema::start_element_handler(void *userdata,
       ms_schema->set_column_family_parameter(atts[i], atts[i+1]);
     }
   }
-  else if (!strcasecmp(name, "MaxVersions") || !strcasecmp(name, "ttl") || !strcasecmp(name, "Name"))
+  else if (!strcasecmp(name, "MaxVersions") || !strcasecmp(name, "ttl") || !strcasecmp(name, "Name") || !strcasecmp(name, "Counter"))
     ms_collected_text = "";
   else
     ms_schema->set_error_string((string)"Unrecognized element - '" + name + "'");
@@ -158,7 +166,7 @@ void Schema::end_element_handler(void *userdata, const XML_Char *name) {
     ms_schema->close_access_group();
   else if (!strcasecmp(name, "ColumnFamily"))
     ms_schema->close_column_family();
-  else if (!strcasecmp(name, "MaxVersions") || !strcasecmp(name, "ttl") || !strcasecmp(name, "Name")) {
+  else if (!strcasecmp(name, "MaxVersions") || !strcasecmp(name, "ttl") || !strcasecmp(name, "Name") || !strcasecmp(name, "Counter")) {
     boost::trim(ms_collected_text);
     ms_schema->set_column_family_parameter(name, ms_collected_text.c_str());
   }
@@ -294,6 +302,14 @@ void Schema::set_column_family_parameter(const char *param, const char *value) {
       if (m_open_column_family->max_versions == 0)
         set_error_string((string)"Invalid value (" + value + ") for MaxVersions");
     }
+    else if (!strcasecmp(param, "Counter")) {
+      if (!strcasecmp(value, "true") || !strcmp(value, "1"))
+        m_open_column_family->counter = true;
+      else if (!strcasecmp(value, "false") || !strcmp(value, "0"))
+        m_open_column_family->counter = false;
+      else
+        set_error_string((string)"Invalid value (" + value + ") for Counter");
+    }
     else if (m_read_ids && !strcasecmp(param, "id")) {
       m_open_column_family->id = atoi(value);
       if (m_open_column_family->id == 0)
@@ -332,6 +348,8 @@ void Schema::render(String &output) {
     output += (String)" generation=\"" + (uint32_t)m_generation + "\"";
   if (m_compressor != "")
     output += (String)" compressor=\"" + m_compressor + "\"";
+  if (m_binary_rows)
+    output += " binaryRows=\"true\"";
   output += ">\n";
 
   for (list<AccessGroup *>::iterator iter = m_access_groups.begin(); iter != m_access_groups.end(); iter++) {
@@ -356,6 +374,8 @@ void Schema::render(String &output) {
         output += (string)"      <MaxVersions>" + (*cfiter)->max_versions + "</MaxVersions>\n";
       if ((*cfiter)->ttl != 0)
         output += (string)"      <ttl>" + (uint32_t)(*cfiter)->ttl + "</ttl>\n";
+      if ((*cfiter)->counter)
+        output += (string)"      <Counter>true</Counter>\n";
       output += (string)"    </ColumnFamily>\n";
     }
     output += (string)"  </AccessGroup>\n";
@@ -372,6 +392,9 @@ void Schema::render_hql_create_table(const String &table_name, String &output) {
   if (m_compressor != "")
     output += (String)"COMPRESSOR=\"" + m_compressor + "\" ";
 
+  if (m_binary_rows)
+    output += (String)"BINARY_ROWS ";
+
   output += table_name + " (\n";
 
   foreach(const ColumnFamilyMap::value_type &v, m_column_family_map) {
@@ -387,6 +410,9 @@ void Schema::render_hql_create_table(const String &table_name, String &output) {
     if (v.second->ttl != 0)
       output += (String)" TTL=" + (uint32_t)v.second->ttl;
 
+    if (v.second->counter)
+      output += (String)" COUNTER";
+
     output += (String)",\n";
   }
 
@@ -40,12 +40,15 @@ namespace Hypertable {
 
     class ColumnFamily {
     public:
-      ColumnFamily() : name(), ag(), id(0), max_versions(0), ttl(0) { return; }
+      ColumnFamily() : name(), ag(), id(0), max_versions(0), ttl(0),
+                       counter(false) { return; }
       String   name;
       String   ag;
       uint32_t id;
       uint32_t max_versions;
       time_t   ttl;
+      /** values are signed 64-bit decimal deltas, summed by the RangeServer */
+      bool     counter;
     };
 
     class AccessGroup {
@@ -106,6 +109,14 @@ namespace Hypertable {
     void set_compressor(String compressor) { m_compressor = compressor; }
     String &get_compressor() { return m_compressor; }
 
+    /**
+     * Tables with binary rows accept arbitrary bytes (including NUL) as row
+     * keys.  The client library encodes them with encode_binary_row before
+     * they are sent to a RangeServer and decodes them when they are scanned.
+     */
+    void set_binary_rows(bool binary_rows) { m_binary_rows = binary_rows; }
+    bool get_binary_rows() { return m_binary_rows; }
+
     typedef hash_map<String, ColumnFamily *> ColumnFamilyMap;
     typedef hash_map<String, AccessGroup *> AccessGroupMap;
 
@@ -126,6 +137,7 @@ namespace Hypertable {
     bool           m_output_ids;
     size_t         m_max_column_family_id;
     String         m_compressor;
+    bool           m_binary_rows;
 
     static void start_element_handler(void *userdata, const XML_Char *name, const XML_Char **atts);
     static void end_element_handler(void *userdata, const XML_Char *name);
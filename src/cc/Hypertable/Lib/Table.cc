@@ -32,6 +32,7 @@
 #include "Hyperspace/HandleCallback.h"
 #include "Hyperspace/Session.h"
 
+#include "Defaults.h"
 #include "Table.h"
 
 using namespace Hypertable;
@@ -136,6 +137,20 @@ TableMutator *Table::create_mutator(int timeout) {
 
 
 
+void
+Table::prefetch_locations(const char *start_row, const char *end_row,
+                          int timeout) {
+  if (timeout == 0 &&
+      (timeout = m_props_ptr->get_int("Hypertable.Client.Timeout", 0)) == 0 &&
+      (timeout = m_props_ptr->get_int("Hypertable.Request.Timeout", 0)) == 0)
+    timeout = HYPERTABLE_CLIENT_TIMEOUT;
+
+  Timer timer(timeout, true);
+  m_range_locator_ptr->prefetch(&m_table, start_row, end_row, timer);
+}
+
+
+
 TableScanner *Table::create_scanner(ScanSpec &scan_spec, int timeout) {
   return new TableScanner(m_props_ptr, m_comm, &m_table, m_schema_ptr, m_range_locator_ptr, scan_spec, timeout);
 }
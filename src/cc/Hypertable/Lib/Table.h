@@ -66,10 +66,28 @@ namespace Hypertable {
      */
     TableScanner *create_scanner(ScanSpec &scan_spec, int timeout=0);
 
+    /**
+     * Loads the locations of all ranges intersecting a row interval into
+     * the table's location cache, with one METADATA scan per METADATA range.
+     * Useful before starting many scanners or mutators over the table.
+     *
+     * @param start_row first row of interval (0 for beginning of table)
+     * @param end_row last row of interval (0 for end of table)
+     * @param timeout maximum time in seconds to spend
+     */
+    void prefetch_locations(const char *start_row=0, const char *end_row=0,
+                            int timeout=0);
+
     void get_identifier(TableIdentifier *table_id_p) {
       memcpy(table_id_p, &m_table, sizeof(TableIdentifier));
     }
 
+    void get_schema(SchemaPtr &schema_ptr) { schema_ptr = m_schema_ptr; }
+
+    void get_range_locator(RangeLocatorPtr &range_locator_ptr) {
+      range_locator_ptr = m_range_locator_ptr;
+    }
+
   private:
 
     void initialize(const String &name);
@@ -20,6 +20,7 @@
  */
 
 #include "Common/Compat.h"
+#include <algorithm>
 #include <cstring>
 
 extern "C" {
@@ -28,8 +29,12 @@ extern "C" {
 
 #include <boost/algorithm/string.hpp>
 
+#include "Common/ParallelSort.h"
+#include "Common/Serialization.h"
 #include "Common/StringExt.h"
+#include "Common/Trace.h"
 
+#include "CounterValue.h"
 #include "Defaults.h"
 #include "Key.h"
 #include "TableMutator.h"
@@ -38,6 +43,52 @@ using namespace Hypertable;
 
 namespace {
   const uint64_t DEFAULT_MAX_MEMORY = 20000000LL;
+  const int DEFAULT_SORT_THREADS = 4;
+
+  inline size_t row_length(const Cell *cell) {
+    return cell->row_key_len ? cell->row_key_len : strlen(cell->row_key);
+  }
+
+  struct LtCellRow {
+    bool operator()(const Cell *c1, const Cell *c2) const {
+      if (c1->row_key_len == 0 && c2->row_key_len == 0)
+        return strcmp(c1->row_key, c2->row_key) < 0;
+      size_t len1 = row_length(c1), len2 = row_length(c2);
+      int cmp = memcmp(c1->row_key, c2->row_key, std::min(len1, len2));
+      return cmp < 0 || (cmp == 0 && len1 < len2);
+    }
+  };
+
+  struct SerializedCell {
+    const uint8_t *key;
+    const uint8_t *value;
+    const char *row;
+  };
+
+  struct LtSerializedCellRow {
+    bool operator()(const SerializedCell &c1, const SerializedCell &c2) const {
+      return strcmp(c1.row, c2.row) < 0;
+    }
+  };
+
+  /**
+   * Returns the serialized byte string at *bufp and advances *bufp past
+   * it, throwing if its length or contents run past the end of the buffer.
+   */
+  const uint8_t *next_byte_string(const uint8_t **bufp, size_t *remainp) {
+    const uint8_t *start = *bufp;
+    uint32_t len;
+
+    try { len = Serialization::decode_vi32(bufp, remainp); }
+    catch (Exception &e) {
+      HT_THROW(Error::BAD_KEY, "Truncated serialized cell buffer");
+    }
+    if (len > *remainp)
+      HT_THROW(Error::BAD_KEY, "Truncated serialized cell buffer");
+    *bufp += len;
+    *remainp -= len;
+    return start;
+  }
 }
 
 
@@ -51,13 +102,28 @@ TableMutator::TableMutator(PropertiesPtr &props_ptr, Comm *comm,
       m_range_locator_ptr(range_locator_ptr),
       m_table_identifier(*table_identifier), m_memory_used(0),
       m_max_memory(DEFAULT_MAX_MEMORY), m_resends(0), m_timeout(timeout),
+      m_sort_threads(1), m_binary_rows(schema_ptr->get_binary_rows()),
       m_last_error(Error::OK), m_last_op(0) {
+  int sort_threads;
 
   if (m_timeout == 0 ||
       (m_timeout = props_ptr->get_int("Hypertable.Client.Timeout", 0)) == 0 ||
       (m_timeout = props_ptr->get_int("Hypertable.Request.Timeout", 0)) == 0)
     m_timeout = HYPERTABLE_CLIENT_TIMEOUT;
 
+  sort_threads = props_ptr->get_int("Hypertable.Mutator.SortThreads", DEFAULT_SORT_THREADS);
+  if (sort_threads > 1)
+    m_sort_threads = sort_threads;
+
+  // pre-serialized cells only carry the column family id
+  memset(m_counter_families, 0, sizeof(m_counter_families));
+  foreach(Schema::AccessGroup *ag, *m_schema_ptr->get_access_group_list()) {
+    foreach(Schema::ColumnFamily *cf, ag->columns) {
+      if (cf->counter)
+        m_counter_families[(uint8_t)cf->id] = cf;
+    }
+  }
+
   m_buffer_ptr = new TableMutatorScatterBuffer(props_ptr, m_comm, &m_table_identifier, m_schema_ptr, m_range_locator_ptr);
 }
 
@@ -85,7 +151,9 @@ void TableMutator::set(uint64_t timestamp, KeySpec &key, const void *value, uint
       Schema::ColumnFamily *cf = m_schema_ptr->get_column_family(key.column_family);
       if (cf == 0)
         HT_THROW(Error::BAD_KEY, (std::string)"Invalid key - bad column family '" + key.column_family + "'");
-      full_key.row = (const char *)key.row;
+      if (cf->counter)
+        sanity_check_counter(cf, value, value_len);
+      full_key.row = encode_row(key);
       full_key.column_qualifier = (const char *)key.column_qualifier;
       full_key.column_family_code = (uint8_t)cf->id;
       full_key.timestamp = timestamp;
@@ -97,20 +165,7 @@ void TableMutator::set(uint64_t timestamp, KeySpec &key, const void *value, uint
 
     m_last_op = FLUSH;
 
-    if (m_buffer_ptr->full() || m_memory_used > m_max_memory) {
-
-      timer.start();
-
-      if (m_prev_buffer_ptr)
-        wait_for_previous_buffer(timer);
-
-      m_buffer_ptr->send();
-
-      m_prev_buffer_ptr = m_buffer_ptr;
-
-      m_buffer_ptr = new TableMutatorScatterBuffer(m_props_ptr, m_comm, &m_table_identifier, m_schema_ptr, m_range_locator_ptr);
-      m_memory_used = 0;
-    }
+    flush_if_full(timer);
 
   }
   catch (Exception &e) {
@@ -140,7 +195,7 @@ void TableMutator::set_delete(uint64_t timestamp, KeySpec &key) {
     sanity_check_key(key);
 
     if (key.column_family == 0) {
-      full_key.row = (const char *)key.row;
+      full_key.row = encode_row(key);
       full_key.column_family_code = 0;
       full_key.column_qualifier = 0;
       full_key.timestamp = timestamp;
@@ -149,7 +204,7 @@ void TableMutator::set_delete(uint64_t timestamp, KeySpec &key) {
       Schema::ColumnFamily *cf = m_schema_ptr->get_column_family(key.column_family);
       if (cf == 0)
         HT_THROW(Error::BAD_KEY, (std::string)"Invalid key - bad column family '" + key.column_family + "'");
-      full_key.row = (const char *)key.row;
+      full_key.row = encode_row(key);
       full_key.column_qualifier = (const char *)key.column_qualifier;
       full_key.column_family_code = (uint8_t)cf->id;
       full_key.timestamp = timestamp;
@@ -161,25 +216,138 @@ void TableMutator::set_delete(uint64_t timestamp, KeySpec &key) {
 
     m_last_op = FLUSH;
 
-    if (m_buffer_ptr->full() || m_memory_used > m_max_memory) {
+    flush_if_full(timer);
+  }
+  catch (Exception &e) {
+    m_last_error = e.code();
+    memcpy(&m_last_timestamp, &timestamp, sizeof(timestamp));
+    memcpy(&m_last_key, &key, sizeof(key));
+    throw;
+  }
 
-      timer.start();
+}
 
-      if (m_prev_buffer_ptr)
-        wait_for_previous_buffer(timer);
 
-      m_buffer_ptr->send();
+void TableMutator::set_cells(const std::vector<Cell> &cells) {
+  std::vector<const Cell *> sorted;
+  const char *cf_name = 0;
+  Schema::ColumnFamily *cf = 0;
 
-      m_prev_buffer_ptr = m_buffer_ptr;
+  if (m_last_error != Error::OK)
+    m_last_error = Error::OK;
 
-      m_buffer_ptr = new TableMutatorScatterBuffer(m_props_ptr, m_comm, &m_table_identifier, m_schema_ptr, m_range_locator_ptr);
-      m_memory_used = 0;
+  sorted.reserve(cells.size());
+  for (size_t i=0; i<cells.size(); i++) {
+    if (cells[i].row_key == 0)
+      HT_THROW(Error::BAD_KEY, "Invalid row key - cannot be zero length");
+    sorted.push_back(&cells[i]);
+  }
+
+  parallel_stable_sort(sorted.begin(), sorted.end(), LtCellRow(),
+                       m_sort_threads);
+
+  m_last_op = FLUSH;
+
+  try {
+
+    for (size_t i=0; i<sorted.size(); i++) {
+      const Cell *cell = sorted[i];
+      KeySpec key(cell->row_key, cell->column_family, cell->column_qualifier);
+      Key full_key;
+      Timer timer(m_timeout);
+
+      if (cell->row_key_len)
+        key.row_len = cell->row_key_len;
+
+      sanity_check_key(key);
+
+      if (key.column_family && (cf == 0 || key.column_family != cf_name)) {
+        if ((cf = m_schema_ptr->get_column_family(key.column_family)) == 0)
+          HT_THROW(Error::BAD_KEY, (std::string)"Invalid key - bad column family '" + key.column_family + "'");
+        cf_name = key.column_family;
+      }
+
+      full_key.row = encode_row(key);
+      full_key.column_qualifier = cell->column_qualifier;
+      full_key.column_family_code = key.column_family ? (uint8_t)cf->id : 0;
+      full_key.timestamp = cell->timestamp;
+
+      if (cell->flag == FLAG_INSERT) {
+        if (key.column_family == 0)
+          HT_THROW(Error::BAD_KEY, "Invalid key - column family not specified");
+        if (cf->counter)
+          sanity_check_counter(cf, cell->value, cell->value_len);
+        m_buffer_ptr->set(full_key, cell->value, cell->value_len, timer);
+        m_memory_used += cell->value_len;
+      }
+      else {
+        if (key.column_family == 0)
+          full_key.column_qualifier = 0;
+        m_buffer_ptr->set_delete(full_key, timer);
+      }
+
+      m_memory_used += 20 + key.row_len + key.column_qualifier_len;
+
+      flush_if_full(timer);
     }
+
+  }
+  catch (Exception &e) {
+    m_last_error = e.code();
+    throw;
+  }
+
+}
+
+
+void TableMutator::set_cells(const uint8_t *buf, size_t len) {
+  std::vector<SerializedCell> sorted;
+  SerializedCell cell;
+  Key key;
+
+  if (m_last_error != Error::OK)
+    m_last_error = Error::OK;
+
+  while (len > 0) {
+    cell.key = next_byte_string(&buf, &len);
+    cell.value = next_byte_string(&buf, &len);
+    if (!key.load(ByteString(cell.key)))
+      HT_THROW(Error::BAD_KEY, "Invalid serialized key");
+    if (key.flag == FLAG_INSERT && m_counter_families[key.column_family_code]) {
+      const uint8_t *value_ptr;
+      size_t value_len = ByteString(cell.value).decode_length(&value_ptr);
+      sanity_check_counter(m_counter_families[key.column_family_code],
+                           value_ptr, value_len);
+    }
+    cell.row = key.row;
+    if (*cell.row == 0)
+      HT_THROW(Error::BAD_KEY, "Invalid row key - cannot be zero length");
+    if (cell.row[0] == (char)0xff && cell.row[1] == (char)0xff)
+      HT_THROW(Error::BAD_KEY, "Invalid row key - cannot start with character sequence 0xff 0xff");
+    sorted.push_back(cell);
+  }
+
+  parallel_stable_sort(sorted.begin(), sorted.end(), LtSerializedCellRow(),
+                       m_sort_threads);
+
+  m_last_op = FLUSH;
+
+  try {
+
+    for (size_t i=0; i<sorted.size(); i++) {
+      ByteString key(sorted[i].key), value(sorted[i].value);
+      Timer timer(m_timeout);
+
+      m_buffer_ptr->set(key, value, timer);
+
+      m_memory_used += key.length() + value.length();
+
+      flush_if_full(timer);
+    }
+
   }
   catch (Exception &e) {
     m_last_error = e.code();
-    memcpy(&m_last_timestamp, &timestamp, sizeof(timestamp));
-    memcpy(&m_last_key, &key, sizeof(key));
     throw;
   }
 
@@ -187,6 +355,8 @@ void TableMutator::set_delete(uint64_t timestamp, KeySpec &key) {
 
 
 void TableMutator::flush() {
+  Trace::Scope trace(Trace::sample());
+  Trace::Span span("TableMutator::flush");
   Timer timer(m_timeout, true);
 
   if (m_last_error != Error::OK)
@@ -279,6 +449,30 @@ void TableMutator::wait_for_previous_buffer(Timer &timer) {
 
 
 
+/**
+ * Once the current scatter buffer is full, or the mutator has buffered more
+ * than its memory limit, sends it off and starts a new one.
+ */
+void TableMutator::flush_if_full(Timer &timer) {
+
+  if (m_buffer_ptr->full() || m_memory_used > m_max_memory) {
+
+    timer.start();
+
+    if (m_prev_buffer_ptr)
+      wait_for_previous_buffer(timer);
+
+    m_buffer_ptr->send();
+
+    m_prev_buffer_ptr = m_buffer_ptr;
+
+    m_buffer_ptr = new TableMutatorScatterBuffer(m_props_ptr, m_comm, &m_table_identifier, m_schema_ptr, m_range_locator_ptr);
+    m_memory_used = 0;
+  }
+}
+
+
+
 void TableMutator::sanity_check_key(KeySpec &key) {
   const char *row = (const char *)key.row;
   const char *column_qualifier = (const char *)key.column_qualifier;
@@ -289,14 +483,19 @@ void TableMutator::sanity_check_key(KeySpec &key) {
   if (key.row_len == 0)
     HT_THROW(Error::BAD_KEY, "Invalid row key - cannot be zero length");
 
-  if (row[key.row_len] != 0)
-    HT_THROW(Error::BAD_KEY, "Invalid row key - must be followed by a '\\0' character");
+  /**
+   * Binary rows may hold any byte; encode_row makes them safe to send
+   */
+  if (!m_binary_rows) {
+    if (row[key.row_len] != 0)
+      HT_THROW(Error::BAD_KEY, "Invalid row key - must be followed by a '\\0' character");
 
-  if (strlen(row) != key.row_len)
-    HT_THROW(Error::BAD_KEY, (std::string)"Invalid row key - '\\0' character not allowed (offset=" + (uint32_t)strlen(row) + ")");
+    if (strlen(row) != key.row_len)
+      HT_THROW(Error::BAD_KEY, (std::string)"Invalid row key - '\\0' character not allowed (offset=" + (uint32_t)strlen(row) + ")");
 
-  if (row[0] == (char)0xff && row[1] == (char)0xff)
-    HT_THROW(Error::BAD_KEY, "Invalid row key - cannot start with character sequence 0xff 0xff");
+    if (row[0] == (char)0xff && row[1] == (char)0xff)
+      HT_THROW(Error::BAD_KEY, "Invalid row key - cannot start with character sequence 0xff 0xff");
+  }
 
   /**
    * Sanity check the column qualifier
@@ -308,3 +507,25 @@ void TableMutator::sanity_check_key(KeySpec &key) {
       HT_THROW(Error::BAD_KEY, (std::string)"Invalid column qualifier - '\\0' character not allowed (offset=" + (uint32_t)strlen(column_qualifier) + ")");
   }
 }
+
+
+void TableMutator::sanity_check_counter(Schema::ColumnFamily *cf, const void *value, uint32_t value_len) {
+  int64_t delta;
+
+  if (!decode_counter((const uint8_t *)value, value_len, &delta))
+    HT_THROW(Error::BAD_VALUE, (std::string)"Invalid value for counter column family '" + cf->name + "' - must be a signed 64-bit decimal integer");
+}
+
+
+/**
+ * Returns the row as it is stored on the RangeServer.  For tables with
+ * binary rows this is the encode_binary_row form, which stays valid until
+ * the next call.
+ */
+const char *TableMutator::encode_row(KeySpec &key) {
+  if (!m_binary_rows)
+    return (const char *)key.row;
+  m_row_buf.clear();
+  encode_binary_row(m_row_buf, key.row, key.row_len);
+  return m_row_buf.c_str();
+}
@@ -22,6 +22,8 @@
 #ifndef HYPERTABLE_TABLEMUTATOR_H
 #define HYPERTABLE_TABLEMUTATOR_H
 
+#include <vector>
+
 #include "AsyncComm/ConnectionManager.h"
 
 #include "Common/Properties.h"
@@ -128,6 +130,40 @@ namespace Hypertable {
       set_delete(0, key);
     }
 
+    /**
+     * Inserts and deletes a batch of cells.  Cells whose flag is FLAG_INSERT
+     * are inserted, the rest are deletes of the row, column family or cell
+     * that they name (see set_delete).  The batch is stable sorted by row on
+     * up to Hypertable.Mutator.SortThreads threads and then partitioned over
+     * the range servers in row order, so every range receives its cells as
+     * one contiguous sorted run and each range location is looked up once
+     * per run rather than once per cell.  Cells of the same row keep their
+     * relative order.
+     *
+     * If this method throws, the cells before the failing one have been
+     * buffered; retry() only covers a pending flush, so the remainder of the
+     * batch has to be resubmitted by the caller.
+     *
+     * @param cells cells to insert or delete
+     */
+    void set_cells(const std::vector<Cell> &cells);
+
+    /**
+     * Inserts a batch of pre-serialized cells.  The buffer holds a sequence
+     * of key/value byte strings, keys as built by create_key_and_append, in
+     * the same format as a range server update request.  The batch is sorted
+     * and partitioned the same way as set_cells.  Keys are sent as is, so
+     * for tables with binary rows the rows must already be in the
+     * encode_binary_row form.  Throws Error::BAD_KEY, before anything is
+     * buffered, if the buffer is truncated or holds a malformed key, and
+     * Error::BAD_VALUE if an insert into a counter column family carries
+     * a malformed delta.
+     *
+     * @param buf pointer to serialized key/value pairs
+     * @param len length of buffer
+     */
+    void set_cells(const uint8_t *buf, size_t len);
+
     /**
      * Flushes the accumulated mutations to their respective range servers.
      */
@@ -190,7 +226,12 @@ namespace Hypertable {
 
     void wait_for_previous_buffer(Timer &timer);
 
+    void flush_if_full(Timer &timer);
+
     void sanity_check_key(KeySpec &key);
+    void sanity_check_counter(Schema::ColumnFamily *cf, const void *value, uint32_t value_len);
+
+    const char *encode_row(KeySpec &key);
 
     PropertiesPtr        m_props_ptr;
     Comm                *m_comm;
@@ -203,6 +244,10 @@ namespace Hypertable {
     TableMutatorScatterBufferPtr  m_prev_buffer_ptr;
     uint64_t             m_resends;
     int                  m_timeout;
+    size_t               m_sort_threads;
+    bool                 m_binary_rows;
+    Schema::ColumnFamily *m_counter_families[256];
+    String               m_row_buf;
 
     int32_t     m_last_error;
     int         m_last_op;
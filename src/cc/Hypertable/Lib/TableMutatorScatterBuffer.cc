@@ -20,6 +20,9 @@
  */
 
 #include "Common/Compat.h"
+
+#include <cstring>
+
 #include "Common/Timer.h"
 
 #include "Defaults.h"
@@ -44,23 +47,31 @@ TableMutatorScatterBuffer::TableMutatorScatterBuffer(PropertiesPtr &props_ptr,
     : m_props_ptr(props_ptr), m_comm(comm), m_schema_ptr(schema_ptr),
       m_range_locator_ptr(range_locator_ptr),
       m_range_server(comm, HYPERTABLE_CLIENT_TIMEOUT),
-      m_table_identifier(*table_identifier), m_full(false), m_resends(0) {
+      m_table_identifier(*table_identifier), m_full(false), m_resends(0),
+      m_last_send_buffer(0) {
 
   m_range_locator_ptr->get_location_cache(m_cache_ptr);
 }
 
 
-
 /**
- *
+ * Returns the send buffer for the range server that holds <code>row</code>.
+ * The range resolved for the previous cell is remembered, so consecutive
+ * cells that fall into the same range skip both the location cache and the
+ * buffer map.
  */
-void TableMutatorScatterBuffer::set(Key &key, const void *value, uint32_t value_len, Timer &timer) {
+TableMutatorSendBuffer *
+TableMutatorScatterBuffer::get_send_buffer(const char *row, Timer &timer) {
   RangeLocationInfo range_info;
   TableMutatorSendBufferMap::const_iterator iter;
 
-  if (!m_cache_ptr->lookup(m_table_identifier.id, key.row, &range_info)) {
+  if (m_last_send_buffer && strcmp(row, m_last_start_row.c_str()) > 0 &&
+      (m_last_end_row.empty() || strcmp(row, m_last_end_row.c_str()) <= 0))
+    return m_last_send_buffer;
+
+  if (!m_cache_ptr->lookup(m_table_identifier.id, row, &range_info)) {
     timer.start();
-    m_range_locator_ptr->find_loop(&m_table_identifier, key.row, &range_info, timer, false);
+    m_range_locator_ptr->find_loop(&m_table_identifier, row, &range_info, timer, false);
   }
 
   iter = m_buffer_map.find(range_info.location);
@@ -73,38 +84,37 @@ void TableMutatorScatterBuffer::set(Key &key, const void *value, uint32_t value_
       HT_THROW(Error::INVALID_METADATA, range_info.location);
   }
 
-  (*iter).second->key_offsets.push_back((*iter).second->accum.fill());
-  create_key_and_append((*iter).second->accum, FLAG_INSERT, key.row, key.column_family_code, key.column_qualifier, key.timestamp);
-  append_as_byte_string((*iter).second->accum, value, value_len);
+  m_last_start_row = range_info.start_row;
+  m_last_end_row = range_info.end_row;
+  m_last_send_buffer = (*iter).second.get();
 
-  if ((*iter).second->accum.fill() > MAX_SEND_BUFFER_SIZE)
-    m_full = true;
+  return m_last_send_buffer;
 }
 
 
+
 /**
  *
  */
-void TableMutatorScatterBuffer::set_delete(Key &key, Timer &timer) {
-  RangeLocationInfo range_info;
-  TableMutatorSendBufferMap::const_iterator iter;
+void TableMutatorScatterBuffer::set(Key &key, const void *value, uint32_t value_len, Timer &timer) {
+  TableMutatorSendBuffer *send_buffer = get_send_buffer(key.row, timer);
 
-  if (!m_cache_ptr->lookup(m_table_identifier.id, key.row, &range_info)) {
-    timer.start();
-    m_range_locator_ptr->find_loop(&m_table_identifier, key.row, &range_info, timer, false);
-  }
+  send_buffer->key_offsets.push_back(send_buffer->accum.fill());
+  create_key_and_append(send_buffer->accum, FLAG_INSERT, key.row, key.column_family_code, key.column_qualifier, key.timestamp);
+  append_as_byte_string(send_buffer->accum, value, value_len);
 
-  iter = m_buffer_map.find(range_info.location);
+  if (send_buffer->accum.fill() > MAX_SEND_BUFFER_SIZE)
+    m_full = true;
+}
 
-  if (iter == m_buffer_map.end()) {
-    m_buffer_map[range_info.location] = new TableMutatorSendBuffer(&m_table_identifier, &m_completion_counter, m_range_locator_ptr.get());
-    iter = m_buffer_map.find(range_info.location);
 
-    if (!LocationCache::location_to_addr(range_info.location.c_str(), (*iter).second->addr))
-      HT_THROW(Error::INVALID_METADATA, range_info.location);
-  }
+/**
+ *
+ */
+void TableMutatorScatterBuffer::set_delete(Key &key, Timer &timer) {
+  TableMutatorSendBuffer *send_buffer = get_send_buffer(key.row, timer);
 
-  (*iter).second->key_offsets.push_back((*iter).second->accum.fill());
+  send_buffer->key_offsets.push_back(send_buffer->accum.fill());
   uint8_t key_flag;
   if (key.column_family_code == 0)
     key_flag = FLAG_DELETE_ROW;
@@ -113,10 +123,10 @@ void TableMutatorScatterBuffer::set_delete(Key &key, Timer &timer) {
   else
     key_flag = FLAG_DELETE_COLUMN_FAMILY;
 
-  create_key_and_append((*iter).second->accum, key_flag, key.row, key.column_family_code, key.column_qualifier, key.timestamp);
-  append_as_byte_string((*iter).second->accum, 0, 0);
+  create_key_and_append(send_buffer->accum, key_flag, key.row, key.column_family_code, key.column_qualifier, key.timestamp);
+  append_as_byte_string(send_buffer->accum, 0, 0);
 
-  if ((*iter).second->accum.fill() > MAX_SEND_BUFFER_SIZE)
+  if (send_buffer->accum.fill() > MAX_SEND_BUFFER_SIZE)
     m_full = true;
 }
 
@@ -126,31 +136,16 @@ void TableMutatorScatterBuffer::set_delete(Key &key, Timer &timer) {
  *
  */
 void TableMutatorScatterBuffer::set(ByteString key, ByteString value, Timer &timer) {
-  RangeLocationInfo range_info;
-  TableMutatorSendBufferMap::const_iterator iter;
   const uint8_t *ptr = key.ptr;
   size_t len = Serialization::decode_vi32(&ptr);
 
-  if (!m_cache_ptr->lookup(m_table_identifier.id, (const char *)ptr, &range_info)) {
-    timer.start();
-    m_range_locator_ptr->find_loop(&m_table_identifier, (const char *)ptr, &range_info, timer, false);
-  }
-
-  iter = m_buffer_map.find(range_info.location);
-
-  if (iter == m_buffer_map.end()) {
-    m_buffer_map[range_info.location] = new TableMutatorSendBuffer(&m_table_identifier, &m_completion_counter, m_range_locator_ptr.get());
-    iter = m_buffer_map.find(range_info.location);
+  TableMutatorSendBuffer *send_buffer = get_send_buffer((const char *)ptr, timer);
 
-    if (!LocationCache::location_to_addr(range_info.location.c_str(), (*iter).second->addr))
-      HT_THROW(Error::INVALID_METADATA, range_info.location);
-  }
-
-  (*iter).second->key_offsets.push_back((*iter).second->accum.fill());
-  (*iter).second->accum.add(key.ptr, (ptr-key.ptr)+len);
-  (*iter).second->accum.add(value.ptr, value.length());
+  send_buffer->key_offsets.push_back(send_buffer->accum.fill());
+  send_buffer->accum.add(key.ptr, (ptr-key.ptr)+len);
+  send_buffer->accum.add(value.ptr, value.length());
 
-  if ((*iter).second->accum.fill() > MAX_SEND_BUFFER_SIZE)
+  if (send_buffer->accum.fill() > MAX_SEND_BUFFER_SIZE)
     m_full = true;
 }
 
@@ -204,7 +199,14 @@ void TableMutatorScatterBuffer::send() {
       kvec.reserve(send_buffer_ptr->key_offsets.size());
       for (size_t i=0; i<send_buffer_ptr->key_offsets.size(); i++)
         kvec.push_back((ByteString)(send_buffer_ptr->accum.base + send_buffer_ptr->key_offsets[i]));
-      sort(kvec.begin(), kvec.end(), swo_bs);
+
+      // bulk loads arrive pre-sorted, so only sort if something is out of order
+      for (size_t i=1; i<kvec.size(); i++) {
+        if (swo_bs(kvec[i], kvec[i-1])) {
+          sort(kvec.begin(), kvec.end(), swo_bs);
+          break;
+        }
+      }
 
       ptr = send_buffer_ptr->pending_updates.base;
 
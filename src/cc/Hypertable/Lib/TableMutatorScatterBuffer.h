@@ -72,6 +72,8 @@ namespace Hypertable {
 
     typedef hash_map<String, TableMutatorSendBufferPtr> TableMutatorSendBufferMap;
 
+    TableMutatorSendBuffer *get_send_buffer(const char *row, Timer &timer);
+
     PropertiesPtr        m_props_ptr;
     Comm                *m_comm;
     SchemaPtr            m_schema_ptr;
@@ -86,6 +88,11 @@ namespace Hypertable {
     std::vector<std::pair<Cell, int> > m_failed_mutations;
     FlyweightString      m_constant_strings;
 
+    // last resolved range, so runs of cells in one range skip the lookup
+    String               m_last_start_row;
+    String               m_last_end_row;
+    TableMutatorSendBuffer *m_last_send_buffer;
+
   };
   typedef boost::intrusive_ptr<TableMutatorScatterBuffer> TableMutatorScatterBufferPtr;
 
@@ -24,6 +24,7 @@
 
 #include "Common/Error.h"
 #include "Common/String.h"
+#include "Common/Trace.h"
 
 #include "Defaults.h"
 #include "TableScanner.h"
@@ -68,7 +69,7 @@ TableScanner::TableScanner(PropertiesPtr &props_ptr, Comm *comm,
 	interval_scan_spec.cell_intervals.push_back(scan_spec.cell_intervals[i]);
 	ri_scanner_ptr = new IntervalScanner(props_ptr, comm, table_identifier, schema_ptr, range_locator_ptr, interval_scan_spec, timeout);
 	m_interval_scanners.push_back(ri_scanner_ptr);
-	ri_scanner_ptr->find_range_and_start_scan(scan_spec.cell_intervals[i].start_row, timer);
+	ri_scanner_ptr->find_range_and_start_scan(ri_scanner_ptr->get_start_row(), timer);
       }
     }
   }
@@ -78,7 +79,7 @@ TableScanner::TableScanner(PropertiesPtr &props_ptr, Comm *comm,
       interval_scan_spec.row_intervals.push_back(scan_spec.row_intervals[i]);
       ri_scanner_ptr = new IntervalScanner(props_ptr, comm, table_identifier, schema_ptr, range_locator_ptr, interval_scan_spec, timeout);
       m_interval_scanners.push_back(ri_scanner_ptr);
-      ri_scanner_ptr->find_range_and_start_scan(scan_spec.row_intervals[i].start, timer);
+      ri_scanner_ptr->find_range_and_start_scan(ri_scanner_ptr->get_start_row(), timer);
     }
   }
 
@@ -91,6 +92,9 @@ bool TableScanner::next(Cell &cell) {
   if (m_eos)
     return false;
 
+  Trace::Scope trace(Trace::sample());
+  Trace::Span span("TableScanner::next");
+
  try_again:
 
   if (m_interval_scanners[m_scanneri]->next(cell))
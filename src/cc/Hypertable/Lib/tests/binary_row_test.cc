@@ -0,0 +1,119 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Common/Logger.h"
+#include "Common/System.h"
+#include "Common/Usage.h"
+
+#include "Hypertable/Lib/Key.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+  const char *usage[] = {
+    "usage: binary_row_test",
+    "",
+    "Validates the binary row key encoding.  Encodes random rows drawn mostly",
+    "from the escaped bytes (0x00, 0x01, 0xfe, 0xff) and checks that they",
+    "decode to the original, contain no NUL, never start with the end row",
+    "marker, and sort with strcmp the way the originals sort with memcmp.",
+    0
+  };
+
+  const int NUM_ROWS = 5000;
+  const uint8_t byte_pool[] = { 0x00, 0x01, 0x02, 0x7f, 0xfd, 0xfe, 0xff };
+
+  int compare_raw(const String &s1, const String &s2) {
+    int cmp = memcmp(s1.data(), s2.data(), std::min(s1.length(), s2.length()));
+    if (cmp == 0)
+      return (s1.length() < s2.length()) ? -1 : (s1.length() > s2.length());
+    return cmp;
+  }
+
+  inline int sign(int x) { return (x > 0) - (x < 0); }
+}
+
+
+int main(int argc, char **argv) {
+  vector<String> raw, encoded;
+
+  if (argc > 1)
+    Usage::dump_and_exit(usage);
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  srandom(1);
+
+  for (int i=0; i<NUM_ROWS; i++) {
+    String row, enc, dec;
+    size_t len = 1 + (random() % 12);
+
+    for (size_t j=0; j<len; j++) {
+      if (random() % 4)
+        row.append(1, (char)byte_pool[random() % sizeof(byte_pool)]);
+      else
+        row.append(1, (char)(random() % 256));
+    }
+
+    encode_binary_row(enc, row.data(), row.length());
+
+    if (strlen(enc.c_str()) != enc.length()) {
+      HT_ERRORF("Encoded row %d contains a NUL byte", i);
+      return 1;
+    }
+    if (enc.length() >= 2 && (uint8_t)enc[0] == 0xff && (uint8_t)enc[1] == 0xff) {
+      HT_ERRORF("Encoded row %d starts with the end row marker", i);
+      return 1;
+    }
+    if (!decode_binary_row(dec, enc.c_str()) || dec != row) {
+      HT_ERRORF("Row %d does not survive an encode/decode round trip", i);
+      return 1;
+    }
+
+    raw.push_back(row);
+    encoded.push_back(enc);
+  }
+
+  for (int i=1; i<NUM_ROWS; i++) {
+    if (sign(compare_raw(raw[i-1], raw[i])) !=
+        sign(strcmp(encoded[i-1].c_str(), encoded[i].c_str()))) {
+      HT_ERRORF("Encoding of rows %d and %d does not preserve order", i-1, i);
+      return 1;
+    }
+  }
+
+  {
+    String dec;
+    if (decode_binary_row(dec, "a\x01") || decode_binary_row(dec, "\xfe\x02")) {
+      HT_ERROR("Invalid encoding was accepted");
+      return 1;
+    }
+  }
+
+  return 0;
+}
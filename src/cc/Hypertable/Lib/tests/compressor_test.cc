@@ -26,6 +26,7 @@
 #include "Common/System.h"
 #include "Common/Usage.h"
 
+#include "Hypertable/Lib/CompressionDictionary.h"
 #include "Hypertable/Lib/CompressorFactory.h"
 #include "Hypertable/Lib/BlockCompressionHeaderCommitLog.h"
 #include "Hypertable/Lib/Types.h"
@@ -94,6 +95,42 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // round trip through a trained dictionary and a second codec instance
+
+  if (compressor->supports_dictionary()) {
+    DynamicBuffer dict(0);
+    BlockCompressionCodecPtr decompressor =
+        CompressorFactory::create_block_codec(argv[1]);
+
+    CompressionDictionary::train(input.base, input.fill(),
+        CompressionDictionary::DEFAULT_SIZE, dict);
+
+    if (dict.fill() == 0) {
+      HT_ERROR("Dictionary training produced an empty dictionary");
+      return 1;
+    }
+
+    compressor->set_dictionary(dict.base, dict.fill());
+    decompressor->set_dictionary(dict.base, dict.fill());
+
+    try {
+      compressor->deflate(input, output1, header);
+      decompressor->inflate(output1, output2, header);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      return 1;
+    }
+
+    if (input.fill() != output2.fill() ||
+        memcmp(input.base, output2.base, input.fill())) {
+      HT_ERROR("Input does not match output after dictionary codec");
+      return 1;
+    }
+
+    compressor->set_dictionary(0, 0);
+  }
+
   // this should not compress ...
 
   memcpy(input.base, "foo", 3);
@@ -21,6 +21,7 @@
 
 #include "Common/Compat.h"
 #include <fstream>
+#include <iostream>
 #include <utility>
 
 #include "Common/NumberStream.h"
@@ -201,6 +202,68 @@ namespace {
       outfile << "[NULL]" << endl;
   }
 
+  const int BUDGET = 32;
+
+  /**
+   * Inserts count adjacent ranges ("", row001], (row001, row002], ...
+   * into table_id.
+   */
+  void InsertRanges(LocationCache &cache, uint32_t table_id, int count) {
+    RangeLocationInfo range_loc_info;
+    char row[16];
+    for (int i=1; i<=count; i++) {
+      range_loc_info.start_row = range_loc_info.end_row;
+      sprintf(row, "row%03d", i);
+      range_loc_info.end_row  = row;
+      range_loc_info.location = server_ids[i % MAX_SERVERIDS];
+      cache.insert(table_id, range_loc_info);
+    }
+  }
+
+  int CountRanges(LocationCache &cache, uint32_t table_id, int count) {
+    RangeLocationInfo range_loc_info;
+    char row[16];
+    int found = 0;
+    for (int i=1; i<=count; i++) {
+      sprintf(row, "row%03d", i);
+      if (cache.lookup(table_id, row, &range_loc_info))
+        found++;
+    }
+    return found;
+  }
+
+  /**
+   * The capacity is shared by all shards, so a single table can fill the
+   * whole cache, and inserting into other tables then evicts its entries.
+   */
+  bool TestSharedBudget() {
+    LocationCache cache(BUDGET, 8);
+    int found;
+
+    InsertRanges(cache, 0, BUDGET);
+    if ((found = CountRanges(cache, 0, BUDGET)) != BUDGET) {
+      cerr << "Table 0 kept " << found << " of " << BUDGET
+           << " entries in a sharded cache" << endl;
+      return false;
+    }
+
+    for (uint32_t table_id=1; table_id<5; table_id++)
+      InsertRanges(cache, table_id, 1);
+
+    if ((found = CountRanges(cache, 0, BUDGET)) != BUDGET-4) {
+      cerr << "Table 0 kept " << found << " entries after 4 inserts into "
+           << "other tables, expected " << BUDGET-4 << endl;
+      return false;
+    }
+    for (uint32_t table_id=1; table_id<5; table_id++) {
+      if (CountRanges(cache, table_id, 1) != 1) {
+        cerr << "Table " << table_id << " entry missing" << endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
 }
 
 
@@ -257,5 +320,8 @@ int main(int argc, char **argv) {
   if (system("diff ./locationCacheTest.output ./locationCacheTest.golden"))
     return 1;
 
+  if (!TestSharedBudget())
+    return 1;
+
   return 0;
 }
@@ -0,0 +1,179 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstring>
+#include <iostream>
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "Common/Usage.h"
+
+#include "Hypertable/Lib/Client.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/LocationCache.h"
+#include "Hypertable/Lib/RangeLocator.h"
+
+using namespace std;
+using namespace Hypertable;
+
+namespace {
+
+  const char *schema =
+  "<Schema>"
+  "  <AccessGroup name=\"default\">"
+  "    <ColumnFamily>"
+  "      <Name>data</Name>"
+  "    </ColumnFamily>"
+  "  </AccessGroup>"
+  "</Schema>";
+
+  const char *usage[] = {
+    "usage: prefetch_test",
+    "",
+    "Validates RangeLocator::prefetch and RangeLocator::find_async.  The test",
+    "table has a single range ending at the end row marker, so every row",
+    "interval checked ends at a row that is not a range boundary.",
+    0
+  };
+
+  class WaitCallback : public RangeLocatorCallback {
+  public:
+    WaitCallback() : m_done(false), m_error(Error::OK) { return; }
+
+    virtual void located(const String &row_key,
+                         RangeLocationInfo &range_loc_info) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_range_loc_info = range_loc_info;
+      m_done = true;
+      m_cond.notify_all();
+    }
+
+    virtual void error(const String &row_key, int error, const String &msg) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      HT_ERRORF("find_async('%s') failed - %s", row_key.c_str(), msg.c_str());
+      m_error = error;
+      m_done = true;
+      m_cond.notify_all();
+    }
+
+    int wait(RangeLocationInfo &range_loc_info) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_done)
+        m_cond.wait(lock);
+      range_loc_info = m_range_loc_info;
+      return m_error;
+    }
+
+  private:
+    boost::mutex      m_mutex;
+    boost::condition  m_cond;
+    bool              m_done;
+    int               m_error;
+    RangeLocationInfo m_range_loc_info;
+  };
+
+  /**
+   * Opens the table afresh, so it starts with an empty location cache,
+   * prefetches [start_row, end_row] and checks that the range holding
+   * each of the given rows was cached.
+   */
+  bool check_prefetch(Client *hypertable, const char *start_row,
+                      const char *end_row, const char **rows) {
+    TablePtr table_ptr = hypertable->open_table("PrefetchTest");
+    TableIdentifier table_id;
+    RangeLocatorPtr locator_ptr;
+    LocationCachePtr cache_ptr;
+    RangeLocationInfo range_loc_info;
+
+    table_ptr->get_identifier(&table_id);
+    table_ptr->get_range_locator(locator_ptr);
+    locator_ptr->get_location_cache(cache_ptr);
+
+    table_ptr->prefetch_locations(start_row, end_row);
+
+    for (; *rows; rows++) {
+      if (!cache_ptr->lookup(table_id.id, *rows, &range_loc_info)) {
+        HT_ERRORF("prefetch('%s', '%s') did not cache the range holding '%s'",
+                  start_row ? start_row : "", end_row ? end_row : "", *rows);
+        return false;
+      }
+      if (range_loc_info.end_row != Key::END_ROW_MARKER) {
+        HT_ERRORF("prefetch('%s', '%s') cached the wrong range for '%s'",
+                  start_row ? start_row : "", end_row ? end_row : "", *rows);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool check_find_async(Client *hypertable, const char *row) {
+    TablePtr table_ptr = hypertable->open_table("PrefetchTest");
+    TableIdentifier table_id;
+    RangeLocatorPtr locator_ptr;
+    RangeLocationInfo range_loc_info;
+    WaitCallback cb;
+
+    table_ptr->get_identifier(&table_id);
+    table_ptr->get_range_locator(locator_ptr);
+
+    locator_ptr->find_async(&table_id, row, &cb, 30.0);
+    if (cb.wait(range_loc_info) != Error::OK)
+      return false;
+    if (range_loc_info.end_row != Key::END_ROW_MARKER) {
+      HT_ERRORF("find_async('%s') returned the wrong range", row);
+      return false;
+    }
+    return true;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  Client *hypertable;
+  const char *middle_rows[] = { "b", "k", "m", 0 };
+  const char *all_rows[] = { "a", "m", "zzz", 0 };
+
+  if (argc > 1)
+    Usage::dump_and_exit(usage);
+
+  hypertable = new Client(argv[0], "./hypertable.cfg");
+
+  try {
+    hypertable->drop_table("PrefetchTest", true);
+    hypertable->create_table("PrefetchTest", schema);
+
+    if (!check_prefetch(hypertable, "b", "m", middle_rows) ||
+        !check_prefetch(hypertable, 0, 0, all_rows) ||
+        !check_find_async(hypertable, "m"))
+      return 1;
+
+    hypertable->drop_table("PrefetchTest", true);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    return 1;
+  }
+
+  return 0;
+}
@@ -739,26 +739,12 @@ Master::create_table(const char *tablename, const char *schemastr,
   string agdir;
   Schema *schema = 0;
   list<Schema::AccessGroup *> *aglist;
-  bool exists;
-  HandleCallbackPtr null_handle_callback;
-  uint64_t handle;
   uint32_t table_id;
+  std::vector<BatchOp> ops;
+  Attribute attr;
 
   m_hyperspace_ptr->set_silent_flag(true);
 
-  /**
-   * Check for table existence
-   */
-  if ((error = m_hyperspace_ptr->exists(tablefile, &exists)) != Error::OK) {
-    errmsg = (String)"Problem checking for existence of table file '" + tablefile + "'";
-    goto abort;
-  }
-  if (exists) {
-    errmsg = tablename;
-    error = Error::MASTER_TABLE_EXISTS;
-    goto abort;
-  }
-
   /**
    *  Parse Schema and assign Generation number and Column ids
    */
@@ -772,44 +758,50 @@ Master::create_table(const char *tablename, const char *schemastr,
   schema->render(finalschema);
 
   /**
-   * Create table file
-   */
-  if ((error = m_hyperspace_ptr->open(tablefile, OPEN_FLAG_READ|OPEN_FLAG_WRITE|OPEN_FLAG_CREATE, null_handle_callback, &handle)) != Error::OK) {
-    errmsg = "Unable to create Hyperspace table file '" + tablefile + "'";
-    goto abort;
-  }
-
-  /**
-   * Write 'table_id' attribute of table file and 'last_table_id' attribute of /hypertable/master
+   * Update 'last_table_id' attribute of /hypertable/master and create the
+   * table file with its 'table_id' and 'schema' attributes, all in one
+   * Hyperspace transaction.  The exclusive create doubles as the table
+   * existence check.  The id is only taken once the transaction succeeds,
+   * and creates are serialized so 'last_table_id' never moves backwards.
    */
   {
+    boost::mutex::scoped_lock lock(m_table_id_mutex);
+
     if (!strcmp(tablename, "METADATA"))
       table_id = 0;
     else {
-      table_id = (uint32_t)atomic_inc_return(&m_last_table_id);
-      if ((error = m_hyperspace_ptr->attr_set(m_master_file_handle, "last_table_id", &table_id, sizeof(int32_t))) != Error::OK) {
-        errmsg = (String)"Problem setting attribute 'last_table_id' of file /hypertable/master - " + Error::get_text(error);
-        goto abort;
-      }
+      table_id = (uint32_t)atomic_read(&m_last_table_id) + 1;
+      ops.push_back(BatchOp(BATCH_OP_ATTR_SET, "/hypertable/master"));
+      attr.name = "last_table_id";
+      attr.value = &table_id;
+      attr.value_len = sizeof(int32_t);
+      ops.back().attrs.push_back(attr);
     }
 
-    if ((error = m_hyperspace_ptr->attr_set(handle, "table_id", &table_id, sizeof(int32_t))) != Error::OK) {
-      errmsg = (String)"Problem setting attribute 'table_id' of file " + tablefile + " - " + Error::get_text(error);
+    ops.push_back(BatchOp(BATCH_OP_CREATE, tablefile, OPEN_FLAG_EXCL));
+    attr.name = "table_id";
+    attr.value = &table_id;
+    attr.value_len = sizeof(int32_t);
+    ops.back().attrs.push_back(attr);
+    attr.name = "schema";
+    attr.value = finalschema.c_str();
+    attr.value_len = finalschema.length();
+    ops.back().attrs.push_back(attr);
+
+    if ((error = m_hyperspace_ptr->batch(ops)) != Error::OK) {
+      if (error == Error::HYPERSPACE_FILE_EXISTS) {
+        errmsg = tablename;
+        error = Error::MASTER_TABLE_EXISTS;
+      }
+      else
+        errmsg = (String)"Unable to create Hyperspace table file '" + tablefile + "' - " + Error::get_text(error);
       goto abort;
     }
-  }
-
 
-  /**
-   * Write schema attribute
-   */
-  if ((error = m_hyperspace_ptr->attr_set(handle, "schema", finalschema.c_str(), strlen(finalschema.c_str()))) != Error::OK) {
-    errmsg = (String)"Problem creating attribute 'schema' for table file '" + tablefile + "'";
-    goto abort;
+    if (table_id != 0)
+      atomic_set(&m_last_table_id, table_id);
   }
 
-  m_hyperspace_ptr->close(handle);
-
   /**
    * Create /hypertable/tables/&lt;table&gt;/&lt;accessGroup&gt; directories for this table in HDFS
    */
@@ -921,52 +913,37 @@ abort:
 
 bool Master::initialize() {
   int error;
-  bool exists;
-  uint64_t handle;
-  HandleCallbackPtr null_handle_callback;
-
-  if ((error = m_hyperspace_ptr->exists("/hypertable/master", &exists)) == Error::OK && exists &&
-      (error = m_hyperspace_ptr->exists("/hypertable/servers", &exists)) == Error::OK && exists)
-    return true;
-
-  if (!create_hyperspace_dir("/hypertable"))
-    return false;
-
-  if (!create_hyperspace_dir("/hypertable/servers"))
-    return false;
-
-  if (!create_hyperspace_dir("/hypertable/tables"))
-    return false;
-
-  /**
-   * Create /hypertable/master
-   */
-  if ((error = m_hyperspace_ptr->open("/hypertable/master", OPEN_FLAG_READ|OPEN_FLAG_WRITE|OPEN_FLAG_CREATE, null_handle_callback, &handle)) != Error::OK) {
-    HT_ERRORF("Unable to open Hyperspace file '/hypertable/master' (%s)", Error::get_text(error));
-    return false;
-  }
-  m_master_file_handle = handle;
-
-  /**
-   * Initialize last_table_id to 0
-   */
+  std::vector<BatchOp> ops(2);
   uint32_t table_id = 0;
-  if ((error = m_hyperspace_ptr->attr_set(m_master_file_handle, "last_table_id", &table_id, sizeof(int32_t))) != Error::OK) {
-    HT_ERRORF("Problem setting attribute 'last_table_id' of file /hypertable/master - %s", Error::get_text(error));
-    return false;
-  }
+  Attribute attr;
 
-  m_hyperspace_ptr->close(handle);
-  m_master_file_handle = 0;
+  ops[0] = BatchOp(BATCH_OP_EXISTS, "/hypertable/master");
+  ops[1] = BatchOp(BATCH_OP_EXISTS, "/hypertable/servers");
+
+  if ((error = m_hyperspace_ptr->batch(ops)) == Error::OK &&
+      ops[0].exists && ops[1].exists)
+    return true;
 
   /**
-   *  Create /hypertable/root
+   * Create the Hyperspace directories, /hypertable/master with
+   * last_table_id initialized to 0, and /hypertable/root in one
+   * transaction
    */
-  if ((error = m_hyperspace_ptr->open("/hypertable/root", OPEN_FLAG_READ|OPEN_FLAG_WRITE|OPEN_FLAG_CREATE, null_handle_callback, &handle)) != Error::OK) {
-    HT_ERRORF("Unable to open Hyperspace file '/hypertable/root' (%s)", Error::get_text(error));
+  ops.clear();
+  ops.push_back(BatchOp(BATCH_OP_MKDIR, "/hypertable"));
+  ops.push_back(BatchOp(BATCH_OP_MKDIR, "/hypertable/servers"));
+  ops.push_back(BatchOp(BATCH_OP_MKDIR, "/hypertable/tables"));
+  ops.push_back(BatchOp(BATCH_OP_CREATE, "/hypertable/master"));
+  attr.name = "last_table_id";
+  attr.value = &table_id;
+  attr.value_len = sizeof(int32_t);
+  ops.back().attrs.push_back(attr);
+  ops.push_back(BatchOp(BATCH_OP_CREATE, "/hypertable/root"));
+
+  if ((error = m_hyperspace_ptr->batch(ops)) != Error::OK) {
+    HT_ERRORF("Problem initializing Hyperspace state (%s)", Error::get_text(error));
     return false;
   }
-  m_hyperspace_ptr->close(handle);
 
   HT_INFO("Successfully Initialized Hypertable.");
 
@@ -1040,32 +1017,6 @@ void Master::scan_servers_directory() {
 }
 
 
-/**
- *
- */
-bool Master::create_hyperspace_dir(const String &dir) {
-  int error;
-  bool exists;
-
-  /**
-   * Check for existence
-   */
-  if ((error = m_hyperspace_ptr->exists(dir, &exists)) != Error::OK) {
-    HT_ERRORF("Problem checking for existence of directory '%s' - %s", dir.c_str(), Error::get_text(error));
-    return false;
-  }
-
-  if (exists)
-    return true;
-
-  if ((error = m_hyperspace_ptr->mkdir(dir)) != Error::OK) {
-    HT_ERRORF("Problem creating directory '%s' - %s", dir.c_str(), Error::get_text(error));
-    return false;
-  }
-
-  return true;
-}
-
 void Master::join() {
   m_app_queue_ptr->join();
   m_threads.join_all();
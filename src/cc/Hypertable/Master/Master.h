@@ -76,7 +76,6 @@ namespace Hypertable {
   private:
     bool initialize();
     void scan_servers_directory();
-    bool create_hyperspace_dir(const String &dir);
 
     boost::mutex m_mutex;
     PropertiesPtr m_props_ptr;
@@ -85,6 +84,7 @@ namespace Hypertable {
     bool m_verbose;
     Hyperspace::SessionPtr m_hyperspace_ptr;
     Filesystem *m_dfs_client;
+    boost::mutex m_table_id_mutex;
     atomic_t m_last_table_id;
     HyperspaceSessionHandler m_hyperspace_session_handler;
     uint64_t m_master_file_handle;
@@ -50,15 +50,19 @@ AccessGroup::AccessGroup(const TableIdentifier *identifier, SchemaPtr &schema_pt
       m_next_table_id(0), m_disk_usage(0), m_blocksize(DEFAULT_BLOCKSIZE),
       m_compression_ratio(1.0), m_is_root(false), m_oldest_cached_timestamp(0),
       m_collisions(0), m_needs_compaction(false), m_drop(false),
-      m_scanners_blocked(false) {
+      m_scanners_blocked(false), m_has_counters(false) {
   m_table_name = m_identifier.name;
   m_start_row = range->start_row;
   m_end_row = range->end_row;
   m_range_name = m_table_name + "[" + m_start_row + ".." + m_end_row + "]";
   m_cell_cache_ptr = new CellCache();
 
-  foreach(Schema::ColumnFamily *cf, ag->columns)
+  memset(m_counter_families, false, 256*sizeof(bool));
+  foreach(Schema::ColumnFamily *cf, ag->columns) {
     m_column_families.insert(cf->id);
+    if (cf->counter)
+      m_has_counters = m_counter_families[cf->id] = true;
+  }
 
   if (ag->blocksize != 0)
     m_blocksize = ag->blocksize;
@@ -111,6 +115,8 @@ int AccessGroup::add(const ByteString key, const ByteString value, int64_t real_
   // assumes timestamps are coming in order
   if (m_oldest_cached_timestamp == 0)
     m_oldest_cached_timestamp = real_timestamp;
+  if (m_has_counters && is_counter(key))
+    return m_cell_cache_ptr->add_counter(key, value, real_timestamp);
   return m_cell_cache_ptr->add(key, value, real_timestamp);
 }
 
@@ -121,7 +127,10 @@ bool AccessGroup::replay_add(const ByteString key, const ByteString value, int64
   if (real_timestamp > m_compaction_timestamp.real) {
     if (m_oldest_cached_timestamp == 0)
       m_oldest_cached_timestamp = real_timestamp;
-    m_cell_cache_ptr->add(key, value, real_timestamp);
+    if (m_has_counters && is_counter(key))
+      m_cell_cache_ptr->add_counter(key, value, real_timestamp);
+    else
+      m_cell_cache_ptr->add(key, value, real_timestamp);
     return true;
   }
   return false;
@@ -140,6 +149,15 @@ CellListScanner *AccessGroup::create_scanner(ScanContextPtr &scan_context_ptr) {
   if (!m_in_memory) {
     CellStoreReleaseCallback callback(this);
     for (size_t i=0; i<m_stores.size(); i++) {
+      /**
+       * Skip stores that hold nothing at or after the start of the time
+       * interval; the MergeScanner would ignore all of their cells,
+       * deletes included.  Stores newer than the end of the interval are
+       * still scanned since their deletes apply to older cells.
+       */
+      if (scan_context_ptr->interval.first > 0 &&
+          m_stores[i]->older_than(scan_context_ptr->interval.first))
+        continue;
       scanner->add_scanner(m_stores[i]->create_scanner(scan_context_ptr));
       filename = m_stores[i]->get_filename();
       callback.add_file(filename);
@@ -243,6 +261,74 @@ void AccessGroup::add_cell_store(CellStorePtr &cellstore_ptr, uint32_t id) {
 }
 
 
+/**
+ * Moves a CellStore written outside of the RangeServer into this access
+ * group's directory under the next CellStore number and opens it.  If the
+ * store can not be opened, the file is moved back to where it came from.
+ * The store is not visible to scans until install_imported_cell_stores().
+ */
+CellStorePtr AccessGroup::load_imported_cell_store(const String &src_file) {
+  CellStorePtr cellstore;
+  String cs_file;
+  int error;
+
+  if (m_in_memory)
+    HT_THROWF(Error::RANGESERVER_IMPORT_REJECTED,
+              "Access group %s(%s) is IN_MEMORY", m_range_name.c_str(),
+              m_name.c_str());
+
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    cs_file = next_cell_store_file();
+  }
+
+  Global::dfs->mkdirs(cs_file.substr(0, cs_file.rfind('/')));
+  Global::dfs->rename(src_file, cs_file);
+
+  cellstore = new CellStoreV0(Global::dfs);
+
+  if ((error = cellstore->open(cs_file.c_str(), m_start_row.c_str(), m_end_row.c_str())) != Error::OK ||
+      (error = cellstore->load_index()) != Error::OK) {
+    cellstore = 0;
+    Global::dfs->rename(cs_file, src_file);
+    HT_THROWF(error, "Problem loading imported cell store '%s'",
+              src_file.c_str());
+  }
+
+  return cellstore;
+}
+
+
+/**
+ * Adds imported CellStores to the store list and records them in the
+ * 'Files' column.  Unlike add_cell_store(), the compaction timestamp is left
+ * alone: imported cells never went through the commit log, so they must not
+ * cause any of it to be skipped on replay.
+ */
+void AccessGroup::install_imported_cell_stores(std::vector<CellStorePtr> &stores) {
+
+  if (stores.empty())
+    return;
+
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    foreach(CellStorePtr &cellstore, stores) {
+      m_stores.push_back(cellstore);
+      m_live_files.insert(cellstore->get_filename());
+      m_disk_usage += cellstore->disk_usage();
+    }
+
+    m_compression_ratio = 0.0;
+    for (size_t i=0; i<m_stores.size(); i++)
+      m_compression_ratio += m_stores[i]->compression_ratio();
+    m_compression_ratio /= m_stores.size();
+  }
+
+  update_files_column();
+}
+
+
 namespace {
   struct LtCellStore {
     bool operator()(const CellStorePtr &x, const CellStorePtr &y) const {
@@ -301,18 +387,9 @@ void AccessGroup::run_compaction(Timestamp timestamp, bool major) {
     }
   }
 
-  // TODO: Issue 11
-  char hash_str[33];
-
-  if (m_end_row == "")
-    memset(hash_str, '0', 24);
-  else
-    md5_string(m_end_row.c_str(), hash_str);
+  String cs_file = next_cell_store_file();
 
-  hash_str[24] = 0;
-  String cs_file = format("/hypertable/tables/%s/%s/%s/cs%d",
-                          m_table_name.c_str(), m_name.c_str(), hash_str,
-                          m_next_table_id++);
+  HiResTime compaction_start;
 
   cellstore = new CellStoreV0(Global::dfs);
 
@@ -330,15 +407,19 @@ void AccessGroup::run_compaction(Timestamp timestamp, bool major) {
       mscanner->add_scanner(m_cell_cache_ptr->create_scanner(scan_context_ptr));
       scanner_ptr = mscanner;
     }
-    else if (major || tableidx < m_stores.size()) {
+    else {
+      /**
+       * Even a plain minor compaction goes through a MergeScanner so that
+       * expired cells and excess versions in the cache are dropped instead
+       * of being written out.  Deletes are only applied in a major
+       * compaction; otherwise they are written out as-is.
+       */
       MergeScanner *mscanner = new MergeScanner(scan_context_ptr, !major);
       mscanner->add_scanner(m_cell_cache_ptr->create_scanner(scan_context_ptr));
       for (size_t i=tableidx; i<m_stores.size(); i++)
         mscanner->add_scanner(m_stores[i]->create_scanner(scan_context_ptr));
       scanner_ptr = mscanner;
     }
-    else
-      scanner_ptr = m_cell_cache_ptr->create_scanner(scan_context_ptr);
   }
 
   while (scanner_ptr->get(bskey, value)) {
@@ -359,6 +440,9 @@ void AccessGroup::run_compaction(Timestamp timestamp, bool major) {
     return;
   }
 
+  Global::server_stats.record(ServerStats::COMPACTION,
+      ServerStats::elapsed_usecs(compaction_start), cellstore->disk_usage());
+
   /**
    * Install new CellCache and CellStore
    */
@@ -575,6 +659,25 @@ void AccessGroup::update_files_column() {
 }
 
 
+/**
+ * Returns the DFS path of the next CellStore for this access group.  Needs
+ * to be called with m_mutex locked, or from the compaction thread.
+ */
+String AccessGroup::next_cell_store_file() {
+  // TODO: Issue 11
+  char hash_str[33];
+
+  if (m_end_row == "")
+    memset(hash_str, '0', 24);
+  else
+    md5_string(m_end_row.c_str(), hash_str);
+
+  hash_str[24] = 0;
+  return format("/hypertable/tables/%s/%s/%s/cs%d", m_table_name.c_str(),
+                m_name.c_str(), hash_str, m_next_table_id++);
+}
+
+
 /**
  * Needs to be called with m_mutex locked
  */
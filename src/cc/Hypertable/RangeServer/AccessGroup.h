@@ -32,6 +32,7 @@
 #include "Common/StringExt.h"
 #include "Common/HashMap.h"
 
+#include "Hypertable/Lib/Key.h"
 #include "Hypertable/Lib/Schema.h"
 #include "Hypertable/Lib/Timestamp.h"
 #include "Hypertable/Lib/Types.h"
@@ -74,6 +75,8 @@ namespace Hypertable {
     bool include_in_scan(ScanContextPtr &scan_ctx);
     uint64_t disk_usage();
     void add_cell_store(CellStorePtr &cellstore_ptr, uint32_t id);
+    CellStorePtr load_imported_cell_store(const String &src_file);
+    void install_imported_cell_stores(std::vector<CellStorePtr> &stores);
     void run_compaction(Timestamp timestamp, bool major);
 
     void get_compaction_timestamp(Timestamp &timestamp);
@@ -116,6 +119,17 @@ namespace Hypertable {
 
     void update_files_column();
 
+    bool is_counter(const ByteString key) {
+      const uint8_t *ptr;
+      size_t len = key.decode_length(&ptr);
+      if (len <= 9 || ptr[len-9] != FLAG_INSERT)
+        return false;
+      ptr += strlen((const char *)ptr) + 1;
+      return m_counter_families[*ptr];
+    }
+
+    String next_cell_store_file();
+
     Mutex                m_mutex;
     boost::condition     m_scanner_blocked_cond;
     TableIdentifierManaged m_identifier;
@@ -144,6 +158,8 @@ namespace Hypertable {
     std::set<String>     m_live_files;
     FileRefCountMap      m_file_refcounts;
     bool                 m_scanners_blocked;
+    bool                 m_counter_families[256];
+    bool                 m_has_counters;
   };
 
 }
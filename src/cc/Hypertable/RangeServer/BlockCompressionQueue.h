@@ -0,0 +1,209 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_BLOCKCOMPRESSIONQUEUE_H
+#define HYPERTABLE_BLOCKCOMPRESSIONQUEUE_H
+
+#include <cassert>
+#include <queue>
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+#include "Common/ReferenceCount.h"
+
+#include "Hypertable/Lib/BlockCompressionCodec.h"
+#include "Hypertable/Lib/BlockCompressionHeader.h"
+
+namespace Hypertable {
+
+  /**
+   * Pool of threads that compress CellStore blocks so that a CellStore
+   * being written can keep several blocks in flight instead of deflating
+   * each one on the compaction thread.  Jobs carry their own codec, since
+   * codecs are not thread safe, and the submitter waits on each job in
+   * the order it needs the results (see #wait_for).
+   *
+   * CellStore block boundaries depend on the window (through the adaptive
+   * block size) but not on the number of workers, so a queue with no
+   * workers, which compresses each job in #add, produces the same files
+   * as one with any number of workers and the same window.
+   */
+  class BlockCompressionQueue : public ReferenceCount {
+  public:
+
+    class Job {
+    public:
+      Job(const char *magic) : codec(0), header(magic), input(0), output(0),
+                               done(false), error(Error::OK) { return; }
+      virtual ~Job() { delete codec; }
+
+      BlockCompressionCodec *codec;
+      BlockCompressionHeader header;
+      DynamicBuffer input;
+      DynamicBuffer output;
+      bool          done;
+      int           error;
+      String        error_msg;
+    };
+
+  private:
+
+    class BlockCompressionQueueState {
+    public:
+      BlockCompressionQueueState() : shutdown(false) { return; }
+      std::queue<Job *>  queue;
+      boost::mutex       mutex;
+      boost::condition   cond;
+      boost::condition   done_cond;
+      bool               shutdown;
+    };
+
+    class Worker {
+
+    public:
+
+      Worker(BlockCompressionQueueState &state) : m_state(state) { return; }
+
+      void operator()() {
+        Job *job = 0;
+
+        while (true) {
+
+          {
+            boost::mutex::scoped_lock lock(m_state.mutex);
+
+            while (m_state.queue.empty()) {
+              if (m_state.shutdown)
+                return;
+              m_state.cond.wait(lock);
+            }
+
+            job = m_state.queue.front();
+            m_state.queue.pop();
+          }
+
+          run(job);
+
+          {
+            boost::mutex::scoped_lock lock(m_state.mutex);
+            job->done = true;
+            m_state.done_cond.notify_all();
+          }
+        }
+      }
+
+    private:
+      BlockCompressionQueueState &m_state;
+    };
+
+    BlockCompressionQueueState  m_state;
+    boost::thread_group         m_threads;
+    int                         m_worker_count;
+    size_t                      m_window;
+    bool                        joined;
+
+  public:
+
+    /**
+     * Constructor.
+     *
+     * @param worker_count number of compression threads, or zero to
+     *        compress in the submitting thread
+     * @param window maximum number of blocks a single CellStore may have
+     *        submitted but not yet written
+     */
+    BlockCompressionQueue(int worker_count, size_t window)
+      : m_worker_count(worker_count), m_window(window), joined(false) {
+      Worker worker(m_state);
+      assert(worker_count >= 0 && window > 0);
+      for (int i=0; i<worker_count; ++i)
+        m_threads.create_thread(worker);
+    }
+
+    /**
+     * Shuts down the queue.  Jobs already queued are compressed and then
+     * the threads exit.
+     */
+    void shutdown() {
+      boost::mutex::scoped_lock lock(m_state.mutex);
+      m_state.shutdown = true;
+      m_state.cond.notify_all();
+    }
+
+    void join() {
+      if (!joined) {
+        m_threads.join_all();
+        joined = true;
+      }
+    }
+
+    size_t window() { return m_window; }
+
+    /**
+     * Queues a job for compression.  The job must not be touched by the
+     * caller until #wait_for returns.
+     */
+    void add(Job *job) {
+      if (m_worker_count == 0) {
+        run(job);
+        job->done = true;
+        return;
+      }
+      boost::mutex::scoped_lock lock(m_state.mutex);
+      job->done = false;
+      m_state.queue.push(job);
+      m_state.cond.notify_one();
+    }
+
+    /**
+     * Blocks until the given job has been compressed.
+     */
+    void wait_for(Job *job) {
+      boost::mutex::scoped_lock lock(m_state.mutex);
+      while (!job->done)
+        m_state.done_cond.wait(lock);
+    }
+
+    /**
+     * Compresses a job in the calling thread, recording any error in the
+     * job rather than throwing.
+     */
+    static void run(Job *job) {
+      try {
+        job->codec->deflate(job->input, job->output, job->header);
+        job->error = Error::OK;
+      }
+      catch (Exception &e) {
+        job->error = e.code();
+        job->error_msg = e.what();
+      }
+    }
+  };
+  typedef boost::intrusive_ptr<BlockCompressionQueue> BlockCompressionQueuePtr;
+
+}
+
+#endif // HYPERTABLE_BLOCKCOMPRESSIONQUEUE_H
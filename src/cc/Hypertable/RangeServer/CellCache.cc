@@ -25,6 +25,7 @@
 
 #include "Common/Logger.h"
 
+#include "Hypertable/Lib/CounterValue.h"
 #include "Hypertable/Lib/Key.h"
 
 #include "CellCache.h"
@@ -36,7 +37,8 @@ using namespace std;
 
 
 const uint32_t CellCache::ALLOC_BIT_MASK  = 0x80000000;
-const uint32_t CellCache::OFFSET_BIT_MASK = 0x7FFFFFFF;
+const uint32_t CellCache::SHARED_BIT_MASK = 0x40000000;
+const uint32_t CellCache::OFFSET_BIT_MASK = 0x3FFFFFFF;
 
 
 //#define STAT
@@ -110,6 +112,63 @@ int CellCache::add(const ByteString key, const ByteString value, int64_t real_ti
 
 
 
+/**
+ */
+int CellCache::add_counter(const ByteString key, const ByteString value, int64_t real_timestamp) {
+  const uint8_t *key_ptr, *old_ptr;
+  size_t key_len = key.decode_length(&key_ptr);
+
+  if (m_scanners > 0 || m_deletes > 0 || key_len <= 9)
+    return add(key, value, real_timestamp);
+
+  CellMap::iterator iter = m_cell_map.lower_bound(key);
+
+  if (iter == m_cell_map.end() || ((*iter).second & SHARED_BIT_MASK))
+    return add(key, value, real_timestamp);
+
+  size_t old_len = (*iter).first.decode_length(&old_ptr);
+
+  if (old_len != key_len || old_ptr[old_len-9] != FLAG_INSERT ||
+      memcmp(old_ptr, key_ptr, key_len-9))
+    return add(key, value, real_timestamp);
+
+  uint8_t *old_base = (uint8_t *)(*iter).first.ptr;
+  uint32_t old_offset = (*iter).second & OFFSET_BIT_MASK;
+  size_t old_total = old_offset + ByteString(old_base + old_offset).length();
+  int64_t sum = (int64_t)((uint64_t)decode_counter(ByteString(old_base + old_offset))
+                          + (uint64_t)decode_counter(value));
+
+  DynamicBuffer sum_buf(32);
+  append_counter(sum_buf, sum);
+
+  ByteString new_key;
+  uint8_t *ptr;
+  size_t new_key_len = key.length();
+  size_t new_total = new_key_len + sum_buf.fill();
+
+  new_key.ptr = ptr = new uint8_t [new_total];
+  memcpy(ptr, key.ptr, new_key_len);
+  memcpy(ptr + new_key_len, sum_buf.base, sum_buf.fill());
+
+  m_cell_map.erase(iter);
+  delete [] old_base;
+
+  m_cell_map.insert(CellMap::value_type(new_key, new_key_len));
+  m_memory_used = m_memory_used - old_total + new_total;
+
+  /**
+   * The caller accounts for the incoming key/value as a new item; take
+   * back what the combined entry does not occupy.
+   */
+  Global::memory_tracker.remove_memory(old_total + key.length() + value.length()
+                                       - new_total);
+  Global::memory_tracker.remove_items(1);
+
+  return 0;
+}
+
+
+
 const char *CellCache::get_split_row() {
   assert(!"CellCache::get_split_row not implemented!");
   return 0;
@@ -170,7 +229,7 @@ CellCache *CellCache::slice_copy(int64_t timestamp) {
     }
 
     if (key.timestamp > timestamp) {
-      child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second));
+      child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second | SHARED_BIT_MASK));
       (*iter).second |= ALLOC_BIT_MASK;  // mark this entry in the "old" map so it doesn't get deleted
     }
 #ifdef STAT
@@ -228,7 +287,7 @@ CellCache *CellCache::purge_deletes() {
           len = (key_comps.column_qualifier - key_comps.row) + strlen(key_comps.column_qualifier) + 1;
           if (deleted_cell.fill() == len && !memcmp(deleted_cell.base, key_comps.row, len)) {
             if (key_comps.timestamp > deleted_cell_timestamp) {
-              child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second));
+              child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second | SHARED_BIT_MASK));
               (*iter).second |= ALLOC_BIT_MASK;  // mark this entry in the "old" map so it doesn't get deleted
             }
             iter++;
@@ -240,7 +299,7 @@ CellCache *CellCache::purge_deletes() {
           len = key_comps.column_qualifier - key_comps.row;
           if (deleted_column_family.fill() == len && !memcmp(deleted_column_family.base, key_comps.row, len)) {
             if (key_comps.timestamp > deleted_column_family_timestamp) {
-              child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second));
+              child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second | SHARED_BIT_MASK));
               (*iter).second |= ALLOC_BIT_MASK;  // mark this entry in the "old" map so it doesn't get deleted
             }
             iter++;
@@ -252,7 +311,7 @@ CellCache *CellCache::purge_deletes() {
           len = strlen(key_comps.row) + 1;
           if (deleted_row.fill() == len && !memcmp(deleted_row.base, key_comps.row, len)) {
             if (key_comps.timestamp > deleted_row_timestamp) {
-              child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second));
+              child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second | SHARED_BIT_MASK));
               (*iter).second |= ALLOC_BIT_MASK;  // mark this entry in the "old" map so it doesn't get deleted
             }
             iter++;
@@ -262,7 +321,7 @@ CellCache *CellCache::purge_deletes() {
         }
         delete_present = false;
       }
-      child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second));
+      child_ptr->m_cell_map.insert(CellMap::value_type((*iter).first, (*iter).second | SHARED_BIT_MASK));
       (*iter).second |= ALLOC_BIT_MASK;  // mark this entry in the "old" map so it doesn't get deleted
       iter++;
     }
@@ -39,7 +39,7 @@ namespace Hypertable {
   class CellCache : public CellList {
 
   public:
-    CellCache() : CellList(), m_memory_used(0), m_deletes(0), m_collisions(0) { return; }
+    CellCache() : CellList(), m_memory_used(0), m_deletes(0), m_collisions(0), m_scanners(0) { return; }
     virtual ~CellCache();
 
     /**
@@ -54,6 +54,21 @@ namespace Hypertable {
      */
     virtual int add(const ByteString key, const ByteString value, int64_t real_timestamp);
 
+    /**
+     * Adds a counter delta to the CellCache.  If the cache already holds
+     * a delta for the same cell, the two are replaced by a single entry
+     * carrying the new key and the summed value.  Combining is skipped
+     * (and the delta added as-is) while scanners are open on the cache,
+     * while it holds delete records, or when the existing entry is shared
+     * with another cache.  Same locking requirements as #add.
+     *
+     * @param key key to be inserted
+     * @param value counter delta to be added
+     * @param real_timestamp real commit log timestamp
+     * @return zero
+     */
+    int add_counter(const ByteString key, const ByteString value, int64_t real_timestamp);
+
     virtual const char *get_split_row();
 
     virtual void get_split_rows(std::vector<std::string> &split_rows);
@@ -108,6 +123,7 @@ namespace Hypertable {
     typedef std::map<const ByteString, uint32_t, LtByteString> CellMap;
 
     static const uint32_t ALLOC_BIT_MASK;
+    static const uint32_t SHARED_BIT_MASK;
     static const uint32_t OFFSET_BIT_MASK;
 
     Mutex              m_mutex;
@@ -116,6 +132,7 @@ namespace Hypertable {
     uint64_t           m_memory_used;
     uint32_t           m_deletes;
     uint32_t           m_collisions;
+    uint32_t           m_scanners;
   };
 
   typedef boost::intrusive_ptr<CellCache> CellCachePtr;
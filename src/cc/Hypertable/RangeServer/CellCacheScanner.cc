@@ -46,6 +46,8 @@ CellCacheScanner::CellCacheScanner(CellCachePtr &cellcache, ScanContextPtr &scan
 
     assert(scan_ctx->start_row <= scan_ctx->end_row);
 
+    m_cell_cache_ptr->m_scanners++;
+
     /** set start iterator **/
     dbuf.clear();
     append_as_byte_string(dbuf, scan_ctx->start_row.c_str(), start_row_len);
@@ -78,6 +80,13 @@ CellCacheScanner::CellCacheScanner(CellCachePtr &cellcache, ScanContextPtr &scan
 }
 
 
+CellCacheScanner::~CellCacheScanner() {
+  boost::mutex::scoped_lock lock(m_cell_cache_mutex);
+  m_cell_cache_ptr->m_scanners--;
+}
+
+
+
 bool CellCacheScanner::get(ByteString &key, ByteString &value) {
   if (!m_eos) {
     key = m_cur_key;
@@ -35,7 +35,7 @@ namespace Hypertable {
   class CellCacheScanner : public CellListScanner {
   public:
     CellCacheScanner(CellCachePtr &cellcache, ScanContextPtr &scan_ctx);
-    virtual ~CellCacheScanner() { return; }
+    virtual ~CellCacheScanner();
     virtual void forward();
     virtual bool get(ByteString &key, ByteString &value);
 
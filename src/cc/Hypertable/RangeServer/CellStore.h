@@ -101,6 +101,30 @@ namespace Hypertable {
      */
     virtual void get_timestamp(Timestamp &timestamp) = 0;
 
+    /**
+     * Returns the smallest and largest key timestamps in this cell store.
+     * Cell stores written before these were recorded return false.
+     *
+     * @param min_timestamp address of variable to hold the minimum timestamp
+     * @param max_timestamp address of variable to hold the maximum timestamp
+     * @return true if the timestamp range is known
+     */
+    virtual bool get_timestamp_range(int64_t *min_timestamp, int64_t *max_timestamp) = 0;
+
+    /**
+     * Returns true if every key in this cell store is known to be older than
+     * the given timestamp.  Cell stores that don't record their timestamp
+     * range are never considered older.
+     *
+     * @param timestamp timestamp to compare against
+     * @return true if all keys are older than timestamp
+     */
+    bool older_than(int64_t timestamp) {
+      int64_t min_timestamp, max_timestamp;
+      return get_timestamp_range(&min_timestamp, &max_timestamp) &&
+          max_timestamp < timestamp;
+    }
+
     /**
      * Returns the disk used by this cell store.  If the cell store is opened with
      * a restricted range, then it returns an estimate of the disk used by that range.
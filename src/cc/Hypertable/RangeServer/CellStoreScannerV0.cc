@@ -24,6 +24,7 @@
 
 #include "Common/Error.h"
 #include "Common/System.h"
+#include "Common/Trace.h"
 
 #include "Hypertable/Lib/BlockCompressionHeader.h"
 #include "Global.h"
@@ -32,7 +33,8 @@
 using namespace Hypertable;
 
 namespace {
-  const uint32_t MINIMUM_READAHEAD_AMOUNT = 65536;
+  const uint32_t MINIMUM_READAHEAD_AMOUNT = 16384;
+  const uint32_t MAXIMUM_READAHEAD_OUTSTANDING = 4;
 }
 
 //#define STAT 1
@@ -96,6 +98,11 @@ CellStoreScannerV0::CellStoreScannerV0(CellStorePtr &cellstore,
     }
   }
   else {
+    /**
+     * Readahead starts at about one block and grows as the scan consumes
+     * data (see ClientBufferedReaderHandler), so scans that stop early
+     * don't pay for a large initial window.
+     */
     uint32_t buf_size = m_cell_store_ptr->get_blocksize();
 
     if (buf_size < MINIMUM_READAHEAD_AMOUNT)
@@ -108,20 +115,20 @@ CellStoreScannerV0::CellStoreScannerV0(CellStorePtr &cellstore,
     bskey.ptr = dbuf.base;
 
     if ((m_end_iter = m_index.upper_bound(bskey)) == m_index.end())
-      m_end_offset = m_cell_store_v0->m_trailer.fix_index_offset;
+      m_end_offset = m_cell_store_v0->data_end_offset();
     else {
       CellStoreV0::IndexMap::iterator iter_next = m_end_iter;
       iter_next++;
       if (iter_next == m_index.end())
-        m_end_offset = m_cell_store_v0->m_trailer.fix_index_offset;
+        m_end_offset = m_cell_store_v0->data_end_offset();
       else
         m_end_offset = (*iter_next).second;
     }
 
     try {
       m_fd = m_cell_store_v0->m_filesys->open_buffered(
-          m_cell_store_ptr->get_filename(), buf_size, 2,
-          m_start_offset, m_end_offset);
+          m_cell_store_ptr->get_filename(), buf_size,
+          MAXIMUM_READAHEAD_OUTSTANDING, m_start_offset, m_end_offset);
     }
     catch (Exception &e) {
       m_iter = m_index.end();
@@ -331,7 +338,7 @@ bool CellStoreScannerV0::fetch_next_block() {
     CellStoreV0::IndexMap::iterator it_next = m_iter;
     it_next++;
     if (it_next == m_index.end()) {
-      m_block.zlength = m_cell_store_v0->m_trailer.fix_index_offset - m_block.offset;
+      m_block.zlength = m_cell_store_v0->data_end_offset() - m_block.offset;
       if (m_end_row.c_str()[0] != (char)0xff)
         m_check_for_range_end = true;
     }
@@ -344,14 +351,30 @@ bool CellStoreScannerV0::fetch_next_block() {
     /**
      * Cache lookup / block read
      */
-    if (!Global::block_cache->checkout(m_file_id, (uint32_t)m_block.offset,
-                                      (uint8_t **)&m_block.base, &len)) {
+    if (Global::block_cache->checkout(m_file_id, (uint32_t)m_block.offset,
+                                     (uint8_t **)&m_block.base, &len))
+      Global::server_stats.block_cache_hit();
+    else {
+      Global::server_stats.block_cache_miss();
       try {
         DynamicBuffer buf(m_block.zlength);
         /** Read compressed block **/
-        m_cell_store_v0->m_filesys->pread(m_cell_store_v0->m_fd, buf.ptr,
-                                          m_block.zlength, m_block.offset);
+        HiResTime read_start;
+        size_t nread = m_cell_store_v0->m_filesys->pread(
+            m_cell_store_v0->m_fd, buf.ptr, m_block.zlength, m_block.offset);
+        Global::server_stats.record(ServerStats::DFS_READ,
+            ServerStats::elapsed_usecs(read_start), nread);
+        Trace::record("dfs pread", read_start);
+        if (nread != m_block.zlength)
+          HT_THROWF(Error::BLOCK_COMPRESSOR_TRUNCATED, "Short read of block "
+                    "at offset %lu (%lu of %lu bytes)", (Lu)m_block.offset,
+                    (Lu)nread, (Lu)m_block.zlength);
         buf.ptr += m_block.zlength;
+        /**
+         * The block checksum is verified by inflate, before the block is
+         * inserted into the cache, so corruption on disk or in transit
+         * from the DFS broker never reaches the cache.
+         */
         /** inflate compressed block **/
         BlockCompressionHeader header;
 
@@ -427,7 +450,7 @@ bool CellStoreScannerV0::fetch_next_block_readahead() {
     CellStoreV0::IndexMap::iterator it_next = m_iter;
     it_next++;
     if (it_next == m_index.end()) {
-      m_block.zlength = m_cell_store_v0->m_trailer.fix_index_offset - m_block.offset;
+      m_block.zlength = m_cell_store_v0->data_end_offset() - m_block.offset;
       if (m_end_row.c_str()[0] != (char)0xff)
         m_check_for_range_end = true;
     }
@@ -440,7 +463,15 @@ bool CellStoreScannerV0::fetch_next_block_readahead() {
     try {
       DynamicBuffer buf(m_block.zlength);
       /** Read compressed block **/
+      HiResTime read_start;
       nread = m_cell_store_v0->m_filesys->read(m_fd, buf.ptr, m_block.zlength);
+      Global::server_stats.record(ServerStats::DFS_READ,
+          ServerStats::elapsed_usecs(read_start), nread);
+      Trace::record("dfs read", read_start);
+      if (nread != m_block.zlength)
+        HT_THROWF(Error::BLOCK_COMPRESSOR_TRUNCATED, "Short read of block "
+                  "at offset %lu (%lu of %lu bytes)", (Lu)m_block.offset,
+                  (Lu)nread, (Lu)m_block.zlength);
       buf.ptr += m_block.zlength;
       /** inflate compressed block **/
       BlockCompressionHeader header;
@@ -44,6 +44,9 @@ CellStoreTrailerV0::CellStoreTrailerV0() {
 /**
  */
 void CellStoreTrailerV0::clear() {
+  timestamp_min = 0;
+  timestamp_max = 0;
+  dictionary_offset = 0;
   fix_index_offset = 0;
   var_index_offset = 0;
   filter_offset = 0;
@@ -63,6 +66,12 @@ void CellStoreTrailerV0::clear() {
  */
 void CellStoreTrailerV0::serialize(uint8_t *buf) {
   uint8_t *base = buf;
+  if (version >= 2) {
+    encode_i64(&buf, timestamp_min);
+    encode_i64(&buf, timestamp_max);
+  }
+  if (version >= 1)
+    encode_i32(&buf, dictionary_offset);
   encode_i32(&buf, fix_index_offset);
   encode_i32(&buf, var_index_offset);
   encode_i32(&buf, filter_offset);
@@ -81,10 +90,18 @@ void CellStoreTrailerV0::serialize(uint8_t *buf) {
 
 
 /**
+ * The version must be set (see CellStoreV0::open) before calling this,
+ * since it determines where the trailer starts.
  */
 void CellStoreTrailerV0::deserialize(const uint8_t *buf) {
   HT_TRY("deserializing cellstore trailer",
     size_t remaining = CellStoreTrailerV0::size();
+    if (version >= 2) {
+      timestamp_min = decode_i64(&buf, &remaining);
+      timestamp_max = decode_i64(&buf, &remaining);
+    }
+    if (version >= 1)
+      dictionary_offset = decode_i32(&buf, &remaining);
     fix_index_offset = decode_i32(&buf, &remaining);
     var_index_offset = decode_i32(&buf, &remaining);
     filter_offset = decode_i32(&buf, &remaining);
@@ -103,6 +120,12 @@ void CellStoreTrailerV0::deserialize(const uint8_t *buf) {
 /**
  */
 void CellStoreTrailerV0::display(std::ostream &os) {
+  if (version >= 2) {
+    os << "timestamp_min = " << timestamp_min << endl;
+    os << "timestamp_max = " << timestamp_max << endl;
+  }
+  if (version >= 1)
+    os << "dictionary_offset = " << dictionary_offset << endl;
   os << "fix_index_offset = " << fix_index_offset << endl;
   os << "var_index_offset = " << var_index_offset << endl;
   os << "filter_offset = " << filter_offset << endl;
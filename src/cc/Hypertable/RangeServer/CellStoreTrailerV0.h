@@ -33,11 +33,28 @@ namespace Hypertable {
     CellStoreTrailerV0();
     virtual ~CellStoreTrailerV0() { return; }
     virtual void clear();
-    virtual size_t size() { return 48; }
+    /**
+     * Version 1 trailers are version 0 trailers preceded by the offset of
+     * the compression dictionary block.  Version 2 trailers are version 1
+     * trailers preceded by the minimum and maximum key timestamps; their
+     * dictionary block is empty when dictionary_offset == fix_index_offset.
+     */
+    virtual size_t size() {
+      return (version >= 2) ? 68 : ((version == 1) ? 52 : 48);
+    }
     virtual void serialize(uint8_t *buf);
     virtual void deserialize(const uint8_t *buf);
     virtual void display(std::ostream &os);
 
+    static const size_t MAX_SIZE = 68;
+
+    bool has_dictionary() {
+      return version >= 1 && dictionary_offset < fix_index_offset;
+    }
+
+    int64_t   timestamp_min;
+    int64_t   timestamp_max;
+    uint32_t  dictionary_offset;
     uint32_t  fix_index_offset;
     uint32_t  var_index_offset;
     uint32_t  filter_offset;
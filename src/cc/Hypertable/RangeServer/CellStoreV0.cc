@@ -26,17 +26,21 @@
 
 #include "Common/Error.h"
 #include "Common/Logger.h"
+#include "Common/Serialization.h"
+#include "Common/Sweetener.h"
 #include "Common/System.h"
 
 #include "AsyncComm/Protocol.h"
 
 #include "Hypertable/Lib/BlockCompressionHeader.h"
+#include "Hypertable/Lib/CompressionDictionary.h"
 #include "Hypertable/Lib/CompressorFactory.h"
 #include "Hypertable/Lib/Key.h"
 
 #include "CellStoreScannerV0.h"
 #include "CellStoreV0.h"
 #include "FileBlockCache.h"
+#include "Global.h"
 
 using namespace std;
 using namespace Hypertable;
@@ -44,14 +48,69 @@ using namespace Hypertable;
 const char CellStoreV0::DATA_BLOCK_MAGIC[10]           = { 'D','a','t','a','-','-','-','-','-','-' };
 const char CellStoreV0::INDEX_FIXED_BLOCK_MAGIC[10]    = { 'I','d','x','F','i','x','-','-','-','-' };
 const char CellStoreV0::INDEX_VARIABLE_BLOCK_MAGIC[10] = { 'I','d','x','V','a','r','-','-','-','-' };
+const char CellStoreV0::DICTIONARY_BLOCK_MAGIC[10]     = { 'D','i','c','t','-','-','-','-','-','-' };
 
 namespace {
   const uint32_t MAX_APPENDS_OUTSTANDING = 3;
+
+  /**
+   * Removes a "--dictionary[=<size>]" argument from the codec arguments,
+   * returning the requested dictionary size, or zero if the argument
+   * was not present.
+   */
+  size_t strip_dictionary_arg(BlockCompressionCodec::Args &args) {
+    size_t size = 0;
+    BlockCompressionCodec::Args::iterator it = args.begin();
+    while (it != args.end()) {
+      if (*it == "--dictionary") {
+        size = CompressionDictionary::DEFAULT_SIZE;
+        it = args.erase(it);
+      }
+      else if (boost::starts_with(*it, "--dictionary=")) {
+        size = strtoul((*it).c_str() + 13, 0, 0);
+        if (size == 0 || size > CompressionDictionary::MAX_SIZE)
+          HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Bad dictionary size "
+                    "'%s' (must be between 1 and %lu)", (*it).c_str() + 13,
+                    (Lu)CompressionDictionary::MAX_SIZE);
+        it = args.erase(it);
+      }
+      else
+        ++it;
+    }
+    return size;
+  }
+
+  /**
+   * Groups the tokens of an "auto" compressor spec into one spec per
+   * candidate codec.  A token beginning with '-' is an argument to the
+   * codec named before it, so "zlib -9 lzo" yields "zlib -9" and "lzo".
+   */
+  void split_auto_candidates(const BlockCompressionCodec::Args &tokens,
+                             std::vector<std::string> &candidates) {
+    foreach(const std::string &token, tokens) {
+      if (boost::starts_with(token, "-")) {
+        if (candidates.empty())
+          HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Codec argument '%s' "
+                    "does not follow a codec name", token.c_str());
+        candidates.back() += " " + token;
+      }
+      else
+        candidates.push_back(token);
+    }
+  }
+
+  /**
+   * A slower codec chosen by sampling must beat the faster ones by at
+   * least this much to be worth its cost.
+   */
+  const size_t AUTO_IMPROVEMENT_PERCENT = 10;
 }
 
 CellStoreV0::CellStoreV0(Filesystem *filesys) : m_filesys(filesys), m_filename(), m_fd(-1), m_index(),
   m_compressor(0), m_buffer(0), m_fix_index_buffer(0), m_var_index_buffer(0),
-  m_outstanding_appends(0), m_offset(0), m_last_key(0), m_file_length(0), m_disk_usage(0), m_file_id(0), m_uncompressed_blocksize(0) {
+  m_outstanding_appends(0), m_offset(0), m_last_key(0), m_file_length(0), m_disk_usage(0), m_file_id(0), m_uncompressed_blocksize(0),
+  m_compression_setup(false), m_dictionary_size(0), m_dictionary(0),
+  m_compression_queue(Global::block_compression_queue) {
   m_file_id = FileBlockCache::get_next_file_id();
   assert(sizeof(float) == 4);
 }
@@ -62,6 +121,15 @@ CellStoreV0::~CellStoreV0() {
   try {
     delete m_compressor;
 
+    // workers may still hold blocks abandoned by a failed create
+    foreach(PendingBlock *block, m_pending_blocks) {
+      if (m_compression_queue)
+        m_compression_queue->wait_for(block);
+      delete block;
+    }
+    foreach(PendingBlock *block, m_free_blocks)
+      delete block;
+
     if (m_fd != -1)
       m_filesys->close(m_fd);
   }
@@ -72,8 +140,11 @@ CellStoreV0::~CellStoreV0() {
 
 
 BlockCompressionCodec *CellStoreV0::create_block_compression_codec() {
-  return CompressorFactory::create_block_codec(
+  BlockCompressionCodec *codec = CompressorFactory::create_block_codec(
       (BlockCompressionCodec::Type)m_trailer.compression_type);
+  if (codec && m_dictionary.fill())
+    codec->set_dictionary(m_dictionary.base, m_dictionary.fill());
+  return codec;
 }
 
 
@@ -83,6 +154,15 @@ void CellStoreV0::get_timestamp(Timestamp &timestamp) {
 }
 
 
+bool CellStoreV0::get_timestamp_range(int64_t *min_timestamp, int64_t *max_timestamp) {
+  if (m_trailer.version < 2)
+    return false;
+  *min_timestamp = m_trailer.timestamp_min;
+  *max_timestamp = m_trailer.timestamp_max;
+  return true;
+}
+
+
 const char *CellStoreV0::get_split_row() {
   if (m_split_row != "")
     return m_split_row.c_str();
@@ -117,16 +197,76 @@ int CellStoreV0::create(const char *fname, uint32_t blocksize, const std::string
   m_start_row = "";
   m_end_row = Key::END_ROW_MARKER;
 
-  if (compressor.empty())
-    m_trailer.compression_type = CompressorFactory::parse_block_codec_spec(
-        "lzo", m_compressor_args);
-  else
+  m_compression_setup = false;
+  m_dictionary.clear();
+  m_auto_candidates.clear();
+
+  /**
+   * A compressor spec of
+   * "auto [--dictionary[=<size>]] [<codec> [<codec-args>] ...]" defers the
+   * choice of codec to setup_compression(), which tries each candidate
+   * (quicklz, lzo and zlib by default, fastest first) on the first block.
+   * Every candidate is instantiated here so that a bad spec fails the
+   * create rather than the first flush.
+   */
+  try {
+    std::string spec = compressor.empty() ? "lzo" : compressor;
+    bool dictionary_supported = false;
+    boost::trim(spec);
+
+    if (spec == "auto" || boost::starts_with(spec, "auto ")) {
+      BlockCompressionCodec::Args args;
+      boost::split(args, spec, boost::is_any_of(" \t"),
+                   boost::token_compress_on);
+      args.erase(args.begin());
+      m_dictionary_size = strip_dictionary_arg(args);
+      split_auto_candidates(args, m_auto_candidates);
+      if (m_auto_candidates.empty()) {
+        m_auto_candidates.push_back("quicklz");
+        m_auto_candidates.push_back("lzo");
+        m_auto_candidates.push_back("zlib");
+      }
+
+      foreach(const std::string &candidate, m_auto_candidates) {
+        int type = CompressorFactory::parse_block_codec_spec(candidate, args);
+        if (type == BlockCompressionCodec::UNKNOWN)
+          HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE, "Unknown codec "
+                    "'%s' in compressor spec", candidate.c_str());
+        BlockCompressionCodecPtr codec = CompressorFactory::create_block_codec(
+            (BlockCompressionCodec::Type)type, args);
+        if (codec && codec->supports_dictionary())
+          dictionary_supported = true;
+      }
+      spec = m_auto_candidates.front();
+    }
+
     m_trailer.compression_type = CompressorFactory::parse_block_codec_spec(
-        compressor, m_compressor_args);
+        spec, m_compressor_args);
+    if (m_auto_candidates.empty())
+      m_dictionary_size = strip_dictionary_arg(m_compressor_args);
 
-  m_compressor = CompressorFactory::create_block_codec(
-      (BlockCompressionCodec::Type)m_trailer.compression_type,
-      m_compressor_args);
+    m_compressor = CompressorFactory::create_block_codec(
+        (BlockCompressionCodec::Type)m_trailer.compression_type,
+        m_compressor_args);
+
+    if (m_auto_candidates.empty() && m_compressor)
+      dictionary_supported = m_compressor->supports_dictionary();
+
+    if (m_dictionary_size && !dictionary_supported)
+      HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "--dictionary given "
+                "for codec without dictionary support in '%s'",
+                compressor.c_str());
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << "Error creating cellstore compressor: " << e << HT_END;
+    return e.code();
+  }
+
+  if (m_compressor == 0) {
+    HT_ERRORF("Bad compressor spec '%s' for cellstore '%s'",
+              compressor.c_str(), fname);
+    return Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE;
+  }
 
   try { m_fd = m_filesys->create(m_filename, true, -1, -1, -1); }
   catch (Exception &e) {
@@ -138,43 +278,12 @@ int CellStoreV0::create(const char *fname, uint32_t blocksize, const std::string
 
 
 int CellStoreV0::add(const ByteString key, const ByteString value, int64_t real_timestamp) {
-  EventPtr event_ptr;
-  DynamicBuffer zbuf;
 
   (void)real_timestamp;
 
   if (m_buffer.fill() > m_uncompressed_blocksize) {
-    BlockCompressionHeader header(DATA_BLOCK_MAGIC);
-
-    add_index_entry(m_last_key, m_offset);
-
-    m_uncompressed_data += (float)m_buffer.fill();
-    m_compressor->deflate(m_buffer, zbuf, header);
-    m_compressed_data += (float)zbuf.fill();
-    m_buffer.clear();
-
-    uint64_t llval = ((uint64_t)m_trailer.blocksize * (uint64_t)m_uncompressed_data) / (uint64_t)m_compressed_data;
-    m_uncompressed_blocksize = (uint32_t)llval;
-
-    if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
-      if (!m_sync_handler.wait_for_reply(event_ptr)) {
-        HT_ERRORF("Problem writing to DFS file '%s' : %s", m_filename.c_str(), Hypertable::Protocol::string_format_message(event_ptr).c_str());
-        return -1;
-      }
-      m_outstanding_appends--;
-    }
-
-    size_t zlen = zbuf.fill();
-    StaticBuffer send_buf(zbuf);
-
-    try { m_filesys->append(m_fd, send_buf, 0, &m_sync_handler); }
-    catch (Exception &e) {
-      HT_ERRORF("Problem writing to DFS file '%s' : %s",
-                m_filename.c_str(), e.what());
+    if (flush_block() < 0)
       return -1;
-    }
-    m_outstanding_appends++;
-    m_offset += zlen;
   }
 
   size_t key_len = key.length();
@@ -185,6 +294,19 @@ int CellStoreV0::add(const ByteString key, const ByteString value, int64_t real_
   m_last_key.ptr = m_buffer.add_unchecked(key.ptr, key_len);
   m_buffer.add_unchecked(value.ptr, value_len);
 
+  /** The timestamp is the last eight bytes of the key **/
+  const uint8_t *ptr;
+  size_t len = key.decode_length(&ptr);
+  ptr += len - 8;
+  int64_t timestamp = (int64_t)Key::decode_ts64(&ptr);
+
+  if (m_trailer.total_entries == 0)
+    m_trailer.timestamp_min = m_trailer.timestamp_max = timestamp;
+  else if (timestamp < m_trailer.timestamp_min)
+    m_trailer.timestamp_min = timestamp;
+  else if (timestamp > m_trailer.timestamp_max)
+    m_trailer.timestamp_max = timestamp;
+
   m_trailer.total_entries++;
 
   return 0;
@@ -193,7 +315,6 @@ int CellStoreV0::add(const ByteString key, const ByteString value, int64_t real_
 
 
 int CellStoreV0::finalize(Timestamp &timestamp) {
-  EventPtr event_ptr;
   int error = -1;
   size_t zlen;
   DynamicBuffer zbuf(0);
@@ -202,40 +323,43 @@ int CellStoreV0::finalize(Timestamp &timestamp) {
   ByteString key;
   StaticBuffer send_buf;
 
-  if (m_buffer.fill() > 0) {
-    BlockCompressionHeader header(DATA_BLOCK_MAGIC);
+  if (m_buffer.fill() > 0 && flush_block() < 0)
+    goto abort;
 
-    add_index_entry(m_last_key, m_offset);
+  while (!m_pending_blocks.empty()) {
+    if (write_block() < 0)
+      goto abort;
+  }
 
-    m_uncompressed_data += (float)m_buffer.fill();
-    m_compressor->deflate(m_buffer, zbuf, header);
-    m_compressed_data += (float)zbuf.fill();
+  /**
+   * Write compression dictionary.  It is stored uncompressed so that it
+   * can be read back before the codec that depends on it is set up.
+   */
+  if (m_dictionary.fill()) {
+    BlockCompressionHeader header(DICTIONARY_BLOCK_MAGIC);
+    BlockCompressionCodecPtr none_codec =
+        CompressorFactory::create_block_codec(BlockCompressionCodec::NONE);
+    none_codec->deflate(m_dictionary, zbuf, header);
 
     zlen = zbuf.fill();
     send_buf = zbuf;
 
-    if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
-      if (!m_sync_handler.wait_for_reply(event_ptr)) {
-        HT_ERRORF("Problem writing to DFS file '%s' : %s", m_filename.c_str(), Protocol::string_format_message(event_ptr).c_str());
-        goto abort;
-      }
-      m_outstanding_appends--;
-    }
-
     try { m_filesys->append(m_fd, send_buf, 0, &m_sync_handler); }
     catch (Exception &e) {
-      HT_ERRORF("Problem writing to DFS file '%s' : %s", m_filename.c_str(),
-                e.what());
+      HT_ERROR_OUT << e << HT_END;
       goto abort;
     }
     m_outstanding_appends++;
+    m_trailer.dictionary_offset = m_offset;
     m_offset += zlen;
   }
+  else
+    m_trailer.dictionary_offset = m_offset;
 
   m_trailer.fix_index_offset = m_offset;
   m_trailer.timestamp = timestamp;
   m_trailer.compression_ratio = m_compressed_data / m_uncompressed_data;
-  m_trailer.version = 0;
+  m_trailer.version = 2;
 
   /**
    * Chop the Index buffers down to the exact length
@@ -346,6 +470,179 @@ int CellStoreV0::finalize(Timestamp &timestamp) {
 
 
 
+/**
+ * Hands the block in m_buffer off for compression, first writing out the
+ * oldest pending blocks if the window is full.  Blocks are written in the
+ * order they were handed off, so offsets and index entries are assigned
+ * by write_block().  Without a compression queue (e.g. in tools that
+ * write CellStores outside of a RangeServer) the block is compressed and
+ * written immediately.
+ */
+int CellStoreV0::flush_block() {
+  PendingBlock *block;
+  size_t max_pending = m_compression_queue ? m_compression_queue->window() : 1;
+
+  if (!m_compression_setup)
+    setup_compression();
+
+  if (m_free_blocks.empty()) {
+    block = new PendingBlock();
+    block->codec = CompressorFactory::create_block_codec(
+        (BlockCompressionCodec::Type)m_trailer.compression_type,
+        m_compressor_args);
+    if (m_dictionary.fill())
+      block->codec->set_dictionary(m_dictionary.base, m_dictionary.fill());
+  }
+  else {
+    block = m_free_blocks.back();
+    m_free_blocks.pop_back();
+  }
+
+  block->input.swap(m_buffer);
+  block->last_key = m_last_key;
+  m_buffer.clear();
+  m_buffer.reserve(m_trailer.blocksize*4);
+
+  m_pending_blocks.push_back(block);
+
+  if (m_compression_queue)
+    m_compression_queue->add(block);
+  else {
+    BlockCompressionQueue::run(block);
+    block->done = true;
+  }
+
+  while (m_pending_blocks.size() >= max_pending) {
+    if (write_block() < 0)
+      return -1;
+  }
+
+  return 0;
+}
+
+
+
+/**
+ * Waits for the oldest pending block to be compressed and appends it.
+ */
+int CellStoreV0::write_block() {
+  EventPtr event_ptr;
+  PendingBlock *block = m_pending_blocks.front();
+
+  if (m_compression_queue)
+    m_compression_queue->wait_for(block);
+
+  m_pending_blocks.pop_front();
+  m_free_blocks.push_back(block);
+
+  if (block->error != Error::OK) {
+    HT_ERRORF("Problem compressing block for DFS file '%s' : %s - %s",
+              m_filename.c_str(), Error::get_text(block->error),
+              block->error_msg.c_str());
+    return -1;
+  }
+
+  add_index_entry(block->last_key, m_offset);
+
+  m_uncompressed_data += (float)block->input.fill();
+  m_compressed_data += (float)block->output.fill();
+
+  uint64_t llval = ((uint64_t)m_trailer.blocksize * (uint64_t)m_uncompressed_data) / (uint64_t)m_compressed_data;
+  m_uncompressed_blocksize = (uint32_t)llval;
+
+  if (m_outstanding_appends >= MAX_APPENDS_OUTSTANDING) {
+    if (!m_sync_handler.wait_for_reply(event_ptr)) {
+      HT_ERRORF("Problem writing to DFS file '%s' : %s", m_filename.c_str(), Hypertable::Protocol::string_format_message(event_ptr).c_str());
+      return -1;
+    }
+    m_outstanding_appends--;
+  }
+
+  size_t zlen = block->output.fill();
+  StaticBuffer send_buf(block->output);
+
+  try { m_filesys->append(m_fd, send_buf, 0, &m_sync_handler); }
+  catch (Exception &e) {
+    HT_ERRORF("Problem writing to DFS file '%s' : %s",
+              m_filename.c_str(), e.what());
+    return -1;
+  }
+  m_outstanding_appends++;
+  m_offset += zlen;
+
+  return 0;
+}
+
+
+
+/**
+ * Called with the first block in m_buffer, which serves as the sample
+ * both for choosing among the "auto" candidates and for training the
+ * dictionary.
+ */
+void CellStoreV0::setup_compression() {
+  m_compression_setup = true;
+
+  if (m_dictionary_size)
+    CompressionDictionary::train(m_buffer.base, m_buffer.fill(),
+                                 m_dictionary_size, m_dictionary);
+
+  if (!m_auto_candidates.empty()) {
+    BlockCompressionHeader header(DATA_BLOCK_MAGIC);
+    BlockCompressionCodec::Args args, best_args;
+    DynamicBuffer zbuf(0);
+    int best_type = BlockCompressionCodec::UNKNOWN;
+    size_t best_index = 0;
+    size_t best_len = 0;
+
+    for (size_t i=0; i<m_auto_candidates.size(); i++) {
+      BlockCompressionCodecPtr codec;
+      int type = CompressorFactory::parse_block_codec_spec(
+          m_auto_candidates[i], args);
+
+      if ((codec = CompressorFactory::create_block_codec(
+          (BlockCompressionCodec::Type)type, args)) == 0)
+        continue;
+
+      if (m_dictionary.fill() && codec->supports_dictionary())
+        codec->set_dictionary(m_dictionary.base, m_dictionary.fill());
+
+      codec->deflate(m_buffer, zbuf, header);
+
+      if (best_type == BlockCompressionCodec::UNKNOWN ||
+          zbuf.fill() * 100 < best_len * (100 - AUTO_IMPROVEMENT_PERCENT)) {
+        best_type = type;
+        best_args = args;
+        best_index = i;
+        best_len = zbuf.fill();
+      }
+    }
+
+    // m_compressor was created from the first candidate
+    if (best_type != BlockCompressionCodec::UNKNOWN && best_index != 0) {
+      delete m_compressor;
+      m_compressor_args = best_args;
+      m_trailer.compression_type = best_type;
+      m_compressor = CompressorFactory::create_block_codec(
+          (BlockCompressionCodec::Type)best_type, m_compressor_args);
+    }
+
+    HT_DEBUGF("Selected '%s' compressor for cellstore '%s' (%lu -> %lu bytes)",
+              BlockCompressionCodec::get_compressor_name(
+              m_trailer.compression_type), m_filename.c_str(),
+              (Lu)m_buffer.fill(), (Lu)best_len);
+  }
+
+  if (m_dictionary.fill()) {
+    if (m_compressor->supports_dictionary())
+      m_compressor->set_dictionary(m_dictionary.base, m_dictionary.fill());
+    else
+      m_dictionary.clear();
+  }
+}
+
+
+
 /**
  *
  */
@@ -402,11 +699,13 @@ int CellStoreV0::open(const char *fname, const char *start_row, const char *end_
    */
   {
     uint32_t len;
-    uint8_t *trailer_buf = new uint8_t [m_trailer.size()];
+    uint32_t amount = (m_file_length < CellStoreTrailerV0::MAX_SIZE) ?
+        (uint32_t)m_file_length : CellStoreTrailerV0::MAX_SIZE;
+    uint8_t *trailer_buf = new uint8_t [amount];
 
     try {
-      len = m_filesys->pread(m_fd, trailer_buf, m_trailer.size(),
-                             m_file_length - m_trailer.size());
+      len = m_filesys->pread(m_fd, trailer_buf, amount,
+                             m_file_length - amount);
     }
     catch (Exception &e) {
       HT_ERRORF("Problem reading trailer for CellStore '%s': %s",
@@ -415,21 +714,36 @@ int CellStoreV0::open(const char *fname, const char *start_row, const char *end_
       goto abort;
     }
 
-    if (len != m_trailer.size()) {
+    if (len != amount) {
       HT_ERRORF("Problem reading trailer for CellStore file '%s' - only read "
-                "%d of %d bytes", m_filename.c_str(), len, m_trailer.size());
+                "%d of %d bytes", m_filename.c_str(), len, amount);
       delete [] trailer_buf;
       goto abort;
     }
 
-    m_trailer.deserialize(trailer_buf);
+    /** The version is the last field and determines the trailer size **/
+    const uint8_t *version_ptr = trailer_buf + len - 2;
+    size_t remaining = 2;
+    m_trailer.version = Serialization::decode_i16(&version_ptr, &remaining);
+
+    if (m_trailer.version > 2 || m_trailer.size() > len) {
+      HT_ERRORF("Unsupported CellStore version (%d) for file '%s'",
+                m_trailer.version, fname);
+      delete [] trailer_buf;
+      goto abort;
+    }
+
+    m_trailer.deserialize(trailer_buf + len - m_trailer.size());
     delete [] trailer_buf;
   }
 
   /** Sanity check trailer **/
-  if (m_trailer.version != 0) {
-    HT_ERRORF("Unsupported CellStore version (%d) for file '%s'",
-              m_trailer.version, fname);
+  if ((m_trailer.version == 1 &&
+       m_trailer.dictionary_offset >= m_trailer.fix_index_offset) ||
+      m_trailer.dictionary_offset > m_trailer.fix_index_offset) {
+    HT_ERRORF("Bad dictionary offset in CellStore trailer dict=%lu, fix=%lu, "
+              "file='%s'", (Lu)m_trailer.dictionary_offset,
+              (Lu)m_trailer.fix_index_offset, fname);
     goto abort;
   }
   if (!(m_trailer.fix_index_offset < m_trailer.var_index_offset &&
@@ -456,22 +770,42 @@ int CellStoreV0::load_index() {
   BlockCompressionHeader header;
   ByteString key;
 
-  m_compressor = create_block_compression_codec();
-
-  amount = (m_file_length-m_trailer.size()) - m_trailer.fix_index_offset;
+  amount = (m_file_length-m_trailer.size()) - data_end_offset();
 
   try {
     DynamicBuffer buf(amount);
-    /** Read index data **/
-    len = m_filesys->pread(m_fd, buf.ptr, amount, m_trailer.fix_index_offset);
+    DynamicBuffer fbuf(0, false);
+    /** Read dictionary and index data **/
+    len = m_filesys->pread(m_fd, buf.ptr, amount, data_end_offset());
 
     if (len != amount)
       HT_THROWF(Error::DFSBROKER_IO_ERROR, "Error loading index for "
                 "CellStore '%s' : tried to read %d but only got %d",
                 m_filename.c_str(), amount, len);
+    fbuf.base = buf.base;
+
+    /** load dictionary **/
+    if (m_trailer.has_dictionary()) {
+      BlockCompressionCodecPtr none_codec =
+          CompressorFactory::create_block_codec(BlockCompressionCodec::NONE);
+      DynamicBuffer dbuf(0, false);
+      dbuf.base = buf.base;
+      dbuf.ptr = buf.base + (m_trailer.fix_index_offset
+                             - m_trailer.dictionary_offset);
+      none_codec->inflate(dbuf, m_dictionary, header);
+
+      if (!header.check_magic(DICTIONARY_BLOCK_MAGIC))
+        HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, "");
+
+      fbuf.base = dbuf.ptr;
+    }
+
+    m_compressor = create_block_compression_codec();
+
     /** inflate fixed index **/
-    buf.ptr += (m_trailer.var_index_offset - m_trailer.fix_index_offset);
-    m_compressor->inflate(buf, m_fix_index_buffer, header);
+    fbuf.ptr = fbuf.base + (m_trailer.var_index_offset
+                            - m_trailer.fix_index_offset);
+    m_compressor->inflate(fbuf, m_fix_index_buffer, header);
 
     if (!header.check_magic(INDEX_FIXED_BLOCK_MAGIC))
       HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC, "");
@@ -479,8 +813,8 @@ int CellStoreV0::load_index() {
     /** inflate variable index **/
     DynamicBuffer vbuf(0, false);
     amount = (m_file_length-m_trailer.size()) - m_trailer.var_index_offset;
-    vbuf.base = buf.ptr;
-    vbuf.ptr = buf.ptr + amount;
+    vbuf.base = fbuf.ptr;
+    vbuf.ptr = fbuf.ptr + amount;
 
     m_compressor->inflate(vbuf, m_var_index_buffer, header);
 
@@ -583,7 +917,7 @@ void CellStoreV0::display_block_info() {
     last_key = (*iter).first;
   }
   if (last_key) {
-    block_size = m_trailer.filter_offset - last_offset;
+    block_size = data_end_offset() - last_offset;
     cout << i << ": offset=" << last_offset << " size=" << block_size << " row=" << last_key.str() << endl;
   }
 }
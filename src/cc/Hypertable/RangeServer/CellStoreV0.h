@@ -22,6 +22,7 @@
 #ifndef HYPERTABLE_CELLSTOREV0_H
 #define HYPERTABLE_CELLSTOREV0_H
 
+#include <deque>
 #include <map>
 #include <string>
 #include <vector>
@@ -32,6 +33,7 @@
 #include "Hypertable/Lib/BlockCompressionCodec.h"
 #include "Hypertable/Lib/Filesystem.h"
 
+#include "BlockCompressionQueue.h"
 #include "CellStore.h"
 #include "CellStoreTrailerV0.h"
 
@@ -61,6 +63,7 @@ namespace Hypertable {
     virtual int load_index();
     virtual uint32_t get_blocksize() { return m_trailer.blocksize; }
     virtual void get_timestamp(Timestamp &timestamp);
+    virtual bool get_timestamp_range(int64_t *min_timestamp, int64_t *max_timestamp);
     virtual uint64_t disk_usage() { return m_disk_usage; }
     virtual float compression_ratio() { return m_trailer.compression_ratio; }
     virtual const char *get_split_row();
@@ -69,6 +72,15 @@ namespace Hypertable {
 
     BlockCompressionCodec *create_block_compression_codec();
 
+    /**
+     * Returns the offset of the end of the data blocks, which is where the
+     * compression dictionary block (if any) or the fixed index begins.
+     */
+    uint32_t data_end_offset() {
+      return (m_trailer.version >= 1) ? m_trailer.dictionary_offset
+                                      : m_trailer.fix_index_offset;
+    }
+
     /**
      * Displays block map information to stdout
      */
@@ -82,10 +94,25 @@ namespace Hypertable {
 
     void add_index_entry(const ByteString key, uint32_t offset);
     void record_split_row(const ByteString key);
+    void setup_compression();
+    int flush_block();
+    int write_block();
 
     static const char DATA_BLOCK_MAGIC[10];
     static const char INDEX_FIXED_BLOCK_MAGIC[10];
     static const char INDEX_VARIABLE_BLOCK_MAGIC[10];
+    static const char DICTIONARY_BLOCK_MAGIC[10];
+
+    /**
+     * A data block handed off for compression, along with the last key it
+     * contains (which points into its input buffer) for the index entry
+     * that is added once the block is written.
+     */
+    class PendingBlock : public BlockCompressionQueue::Job {
+    public:
+      PendingBlock() : BlockCompressionQueue::Job(DATA_BLOCK_MAGIC) { }
+      ByteString last_key;
+    };
 
     typedef std::map<ByteString, uint32_t, LtByteString> IndexMap;
 
@@ -110,6 +137,13 @@ namespace Hypertable {
     float                  m_compressed_data;
     uint32_t               m_uncompressed_blocksize;
     BlockCompressionCodec::Args m_compressor_args;
+    std::vector<std::string> m_auto_candidates;
+    bool                   m_compression_setup;
+    size_t                 m_dictionary_size;
+    DynamicBuffer          m_dictionary;
+    BlockCompressionQueue *m_compression_queue;
+    std::deque<PendingBlock *>  m_pending_blocks;
+    std::vector<PendingBlock *> m_free_blocks;
   };
   typedef boost::intrusive_ptr<CellStoreV0> CellStoreV0Ptr;
 
@@ -35,6 +35,7 @@ namespace Hypertable {
   Filesystem            *Global::dfs = 0;
   Filesystem            *Global::log_dfs = 0;
   MaintenanceQueue      *Global::maintenance_queue = 0;
+  BlockCompressionQueue *Global::block_compression_queue = 0;
   RangeServerProtocol   *Global::protocol = 0;
   bool                   Global::verbose = false;
   CommitLog             *Global::user_log = 0;
@@ -51,6 +52,7 @@ namespace Hypertable {
   TablePtr               Global::metadata_table_ptr = 0;
   uint64_t               Global::range_metadata_max_bytes = 0;
   MemoryTracker          Global::memory_tracker;
+  ServerStats            Global::server_stats;
   uint64_t               Global::log_prune_threshold_min = 0;
   uint64_t               Global::log_prune_threshold_max = 0;
   CrashTest             *Global::crash_test = 0;
@@ -40,10 +40,12 @@
 #include "Hypertable/Lib/Table.h"
 #include "Hypertable/Lib/Types.h"
 
+#include "BlockCompressionQueue.h"
 #include "FileBlockCache.h"
 #include "MaintenanceQueue.h"
 #include "MemoryTracker.h"
 #include "ScannerMap.h"
+#include "ServerStats.h"
 #include "TableInfo.h"
 
 namespace Hypertable {
@@ -56,6 +58,7 @@ namespace Hypertable {
     static Hypertable::Filesystem *dfs;
     static Hypertable::Filesystem *log_dfs;
     static Hypertable::MaintenanceQueue *maintenance_queue;
+    static Hypertable::BlockCompressionQueue *block_compression_queue;
     static Hypertable::RangeServerProtocol *protocol;
     static bool           verbose;
     static CommitLog     *user_log;
@@ -72,6 +75,7 @@ namespace Hypertable {
     static TablePtr       metadata_table_ptr;
     static uint64_t       range_metadata_max_bytes;
     static Hypertable::MemoryTracker memory_tracker;
+    static Hypertable::ServerStats server_stats;
     static uint64_t       log_prune_threshold_min;
     static uint64_t       log_prune_threshold_max;
     static Hypertable::CrashTest *crash_test;
@@ -0,0 +1,401 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cassert>
+
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+#include "Hypertable/Lib/CompressorFactory.h"
+#include "Hypertable/Lib/Types.h"
+
+#include "Global.h"
+#include "LogReplayer.h"
+
+using namespace Hypertable;
+
+
+LogReplayer::Block::~Block() {
+  for (size_t i=0; i<batches.size(); i++)
+    delete batches[i];
+}
+
+
+LogReplayer::LogReplayer(TableInfoMapPtr &replay_map, int worker_count,
+                         size_t max_pending, RangeReplayedCallback *cb)
+  : m_replay_map(replay_map), m_callback(cb), m_ranges_remaining(0), m_next_route(0),
+    m_pending_blocks(0), m_max_pending(max_pending), m_all_routed(false),
+    m_shutdown(false), m_error(Error::OK) {
+  std::vector<TableInfoPtr> table_vec;
+  std::vector<RangePtr> range_vec;
+
+  assert(worker_count > 0);
+
+  if (m_max_pending == 0)
+    m_max_pending = 1;
+
+  replay_map->get_all(table_vec);
+
+  for (size_t i=0; i<table_vec.size(); i++) {
+    range_vec.clear();
+    table_vec[i]->get_range_vector(range_vec);
+    for (size_t j=0; j<range_vec.size(); j++) {
+      RangeReplayState *state = new RangeReplayState();
+      state->table_info = table_vec[i];
+      state->range = range_vec[j];
+      state->start_row = range_vec[j]->start_row();
+      state->end_row = range_vec[j]->end_row();
+      m_range_states[range_vec[j].get()] = state;
+    }
+  }
+  m_ranges_remaining = m_range_states.size();
+
+  Worker worker(this);
+  for (int i=0; i<worker_count; ++i)
+    m_threads.create_thread(worker);
+}
+
+
+LogReplayer::~LogReplayer() {
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_shutdown = true;
+    m_work_cond.notify_all();
+  }
+  m_threads.join_all();
+
+  m_unrouted.clear();
+  m_inflate_queue.clear();
+  for (RangeStateMap::iterator iter = m_range_states.begin();
+       iter != m_range_states.end(); ++iter)
+    delete (*iter).second;
+}
+
+
+void LogReplayer::replay(CommitLogReader *log_reader) {
+  std::vector<RangeReplayState *> completed;
+  uint64_t seq = 0;
+
+  while (true) {
+    BlockPtr block = new Block();
+
+    if (!log_reader->next_compressed(block->zblock, &block->header, block->fname))
+      break;
+
+    block->seq = seq++;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_pending_blocks >= m_max_pending)
+      m_reader_cond.wait(lock);
+    m_pending_blocks++;
+    m_inflate_queue.push_back(block);
+    m_work_cond.notify_one();
+  }
+
+  /**
+   * Wait for every block to be routed, then retire the ranges that
+   * have nothing left to insert.  Ranges still being inserted into
+   * are retired by the worker that drains them.
+   */
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_next_route < seq)
+      m_reader_cond.wait(lock);
+    m_all_routed = true;
+    for (RangeStateMap::iterator iter = m_range_states.begin();
+         iter != m_range_states.end(); ++iter) {
+      RangeReplayState *state = (*iter).second;
+      if (!state->busy && state->pending.empty() && !state->done) {
+        state->done = true;
+        completed.push_back(state);
+      }
+    }
+  }
+
+  notify_replayed(completed);
+
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_ranges_remaining > 0)
+      m_reader_cond.wait(lock);
+    if (m_error != Error::OK)
+      HT_THROW(m_error, m_error_msg);
+  }
+
+}
+
+
+/**
+ * Worker thread body.  Insert work is preferred over inflate work so
+ * that blocks are released as quickly as possible.
+ */
+void LogReplayer::run() {
+  CompressorMap compressors;
+  std::vector<RangeReplayState *> completed;
+  boost::mutex::scoped_lock lock(m_mutex);
+
+  while (true) {
+
+    if (!m_ready.empty()) {
+      RangeReplayState *state = m_ready.front();
+      std::deque<Batch *> batches;
+      m_ready.pop_front();
+      batches.swap(state->pending);
+      state->busy = true;
+
+      lock.unlock();
+      insert(batches);
+      lock.lock();
+
+      finish_batches(batches);
+      state->busy = false;
+      if (!state->pending.empty())
+        m_ready.push_back(state);
+      else if (m_all_routed && !state->done) {
+        state->done = true;
+        completed.push_back(state);
+      }
+    }
+    else if (!m_inflate_queue.empty()) {
+      BlockPtr block = m_inflate_queue.front();
+      m_inflate_queue.pop_front();
+
+      lock.unlock();
+      inflate_and_partition(block.get(), compressors);
+      lock.lock();
+
+      route(block);
+    }
+    else if (m_shutdown)
+      return;
+    else
+      m_work_cond.wait(lock);
+
+    if (!completed.empty()) {
+      lock.unlock();
+      notify_replayed(completed);
+      lock.lock();
+    }
+  }
+}
+
+
+/**
+ * Inflates a block and partitions its cells by containing range.  Cells
+ * that do not belong to any range being replayed are dropped.
+ */
+void LogReplayer::inflate_and_partition(Block *block, CompressorMap &compressors) {
+  BlockCompressionCodecPtr &compressor = compressors[block->header.get_compression_type()];
+  TableIdentifier table_id;
+  TableInfoPtr table_info;
+  RangePtr range_ptr;
+  RangeReplayState *state = 0;
+  Batch *batch = 0;
+  std::map<RangeReplayState *, Batch *> batch_map;
+  std::map<RangeReplayState *, Batch *>::iterator batch_iter;
+  ByteString key, value;
+  const uint8_t *ptr, *end;
+  size_t remaining;
+  const char *row;
+
+  try {
+    uint16_t ztype = block->header.get_compression_type();
+    if (ztype >= BlockCompressionCodec::COMPRESSION_TYPE_LIMIT)
+      HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE,
+                "Invalid compression type - %d", (int)ztype);
+    if (!compressor)
+      compressor = CompressorFactory::create_block_codec((BlockCompressionCodec::Type)ztype);
+    compressor->inflate(block->zblock, block->block, block->header);
+  }
+  catch (Exception &e) {
+    HT_ERRORF("Inflate error in CommitLog fragment %s - %s",
+              block->fname.c_str(), Error::get_text(e.code()));
+    return;
+  }
+  block->zblock.free();
+
+  ptr = block->block.base;
+  end = block->block.ptr;
+  remaining = end - ptr;
+
+  try {
+    table_id.decode(&ptr, &remaining);
+
+    if (!m_replay_map->get(table_id.id, table_info))
+      return;
+
+    while (ptr < end) {
+
+      key.ptr = ptr;
+      ptr += key.length();
+      if (ptr > end)
+        HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
+
+      value.ptr = ptr;
+      ptr += value.length();
+      if (ptr > end)
+        HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
+
+      row = key.str();
+
+      if (state == 0 || strcmp(row, state->start_row.c_str()) <= 0 ||
+          strcmp(row, state->end_row.c_str()) > 0) {
+        RangeStateMap::iterator state_iter;
+        if (!table_info->find_containing_range(row, range_ptr) ||
+            (state_iter = m_range_states.find(range_ptr.get())) == m_range_states.end()) {
+          state = 0;
+          continue;
+        }
+        state = (*state_iter).second;
+        batch_iter = batch_map.find(state);
+        if (batch_iter == batch_map.end()) {
+          batch = new Batch();
+          batch->state = state;
+          batch_map[state] = batch;
+          block->batches.push_back(batch);
+        }
+        else
+          batch = (*batch_iter).second;
+      }
+
+      batch->keys.push_back(key.ptr);
+    }
+  }
+  catch (Exception &e) {
+    HT_ERRORF("Problem decoding block from CommitLog fragment %s - %s",
+              block->fname.c_str(), e.what());
+    record_error(e.code(), e.what());
+  }
+
+}
+
+
+/**
+ * Hands inflated blocks to their ranges in log order.  Called with
+ * m_mutex held.
+ */
+void LogReplayer::route(BlockPtr &block) {
+  std::map<uint64_t, BlockPtr>::iterator iter;
+
+  m_unrouted[block->seq] = block;
+
+  while ((iter = m_unrouted.begin()) != m_unrouted.end() &&
+         (*iter).first == m_next_route) {
+    Block *routed = (*iter).second.get();
+
+    for (size_t i=0; i<routed->batches.size(); i++) {
+      Batch *batch = routed->batches[i];
+      batch->block = routed;
+      batch->state->pending.push_back(batch);
+      if (!batch->state->busy && batch->state->pending.size() == 1)
+        m_ready.push_back(batch->state);
+    }
+    routed->outstanding = routed->batches.size();
+    routed->batches.clear();
+
+    if (routed->outstanding == 0) {
+      m_pending_blocks--;
+      m_reader_cond.notify_all();
+    }
+
+    m_unrouted.erase(iter);
+    m_next_route++;
+  }
+
+  if (!m_ready.empty())
+    m_work_cond.notify_all();
+  m_reader_cond.notify_all();
+}
+
+
+void LogReplayer::insert(std::deque<Batch *> &batches) {
+  ByteString key, value;
+  uint32_t count;
+  uint64_t memory_added = 0;
+  uint64_t items_added = 0;
+  int error;
+
+  for (size_t i=0; i<batches.size(); i++) {
+    Batch *batch = batches[i];
+    int64_t timestamp = batch->block->header.get_timestamp();
+    Range *range = batch->state->range.get();
+
+    for (size_t j=0; j<batch->keys.size(); j++) {
+      key.ptr = batch->keys[j];
+      value.ptr = key.ptr + key.length();
+
+      if ((error = range->replay_add(key, value, timestamp, &count)) != Error::OK) {
+        record_error(error, format("Problem replaying cell into range %s",
+                                   range->get_name().c_str()));
+        continue;
+      }
+
+      if (count) {
+        items_added += count;
+        memory_added += count * ((value.ptr + value.length()) - key.ptr);
+      }
+    }
+  }
+
+  Global::memory_tracker.add_memory(memory_added);
+  Global::memory_tracker.add_items(items_added);
+}
+
+
+/**
+ * Releases inserted batches, returning fully consumed blocks to the
+ * reader's budget.  Called with m_mutex held.
+ */
+void LogReplayer::finish_batches(std::deque<Batch *> &batches) {
+  for (size_t i=0; i<batches.size(); i++) {
+    BlockPtr block = batches[i]->block;
+    delete batches[i];
+    if (--block->outstanding == 0) {
+      m_pending_blocks--;
+      m_reader_cond.notify_all();
+    }
+  }
+  batches.clear();
+}
+
+
+void LogReplayer::notify_replayed(std::vector<RangeReplayState *> &completed) {
+  for (size_t i=0; i<completed.size(); i++) {
+    if (m_callback)
+      m_callback->range_replayed(completed[i]->table_info, completed[i]->range);
+  }
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_ranges_remaining -= completed.size();
+    m_reader_cond.notify_all();
+  }
+  completed.clear();
+}
+
+
+void LogReplayer::record_error(int error, const String &msg) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (m_error == Error::OK) {
+    m_error = error;
+    m_error_msg = msg;
+  }
+}
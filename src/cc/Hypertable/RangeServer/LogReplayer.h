@@ -0,0 +1,164 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_LOGREPLAYER_H
+#define HYPERTABLE_LOGREPLAYER_H
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+#include "Common/DynamicBuffer.h"
+#include "Common/HashMap.h"
+#include "Common/ReferenceCount.h"
+#include "Common/String.h"
+
+#include "Hypertable/Lib/BlockCompressionCodec.h"
+#include "Hypertable/Lib/BlockCompressionHeaderCommitLog.h"
+#include "Hypertable/Lib/CommitLogReader.h"
+
+#include "TableInfoMap.h"
+
+namespace Hypertable {
+
+  /**
+   * Replays a commit log into the ranges of a replay TableInfoMap.  Blocks
+   * are read from the log on the calling thread and handed to a pool of
+   * worker threads that inflate them and route each cell to its containing
+   * range.  The cells of a given range are inserted by one worker at a time,
+   * in log order, so distinct ranges are filled concurrently.  Once the whole
+   * log has been read, each range is reported through the
+   * RangeReplayedCallback as soon as its own backlog has been inserted.
+   */
+  class LogReplayer {
+  public:
+
+    class RangeReplayedCallback {
+    public:
+      virtual ~RangeReplayedCallback() { return; }
+      virtual void range_replayed(TableInfoPtr &table_info, RangePtr &range) = 0;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param replay_map map of the tables and ranges being replayed
+     * @param worker_count number of inflate/insert threads
+     * @param max_pending maximum number of blocks held in memory at once
+     * @param cb object notified as each range finishes replay (may be 0)
+     */
+    LogReplayer(TableInfoMapPtr &replay_map, int worker_count,
+                size_t max_pending, RangeReplayedCallback *cb=0);
+    ~LogReplayer();
+
+    /**
+     * Replays the given log, returning when every range in the replay
+     * map has been completely replayed.
+     *
+     * @param log_reader commit log to replay
+     */
+    void replay(CommitLogReader *log_reader);
+
+  private:
+
+    class Block;
+    typedef boost::intrusive_ptr<Block> BlockPtr;
+
+    class RangeReplayState;
+
+    /** Cells of one block that fall within one range */
+    struct Batch {
+      BlockPtr block;
+      RangeReplayState *state;
+      std::vector<const uint8_t *> keys;
+    };
+
+    class Block : public ReferenceCount {
+    public:
+      Block() : seq(0), outstanding(0) { return; }
+      ~Block();
+      uint64_t seq;
+      BlockCompressionHeaderCommitLog header;
+      String fname;
+      DynamicBuffer zblock;
+      DynamicBuffer block;
+      std::vector<Batch *> batches;
+      size_t outstanding;
+    };
+
+    class RangeReplayState {
+    public:
+      RangeReplayState() : busy(false), done(false) { return; }
+      TableInfoPtr table_info;
+      RangePtr range;
+      String start_row;
+      String end_row;
+      std::deque<Batch *> pending;
+      bool busy;
+      bool done;
+    };
+
+    typedef hash_map<uint16_t, BlockCompressionCodecPtr> CompressorMap;
+    typedef std::map<Range *, RangeReplayState *> RangeStateMap;
+
+    class Worker {
+    public:
+      Worker(LogReplayer *replayer) : m_replayer(replayer) { return; }
+      void operator()() { m_replayer->run(); }
+    private:
+      LogReplayer *m_replayer;
+    };
+
+    void run();
+    void inflate_and_partition(Block *block, CompressorMap &compressors);
+    void route(BlockPtr &block);
+    void insert(std::deque<Batch *> &batches);
+    void finish_batches(std::deque<Batch *> &batches);
+    void notify_replayed(std::vector<RangeReplayState *> &completed);
+    void record_error(int error, const String &msg);
+
+    boost::mutex          m_mutex;
+    boost::condition      m_work_cond;
+    boost::condition      m_reader_cond;
+    boost::thread_group   m_threads;
+    TableInfoMapPtr       m_replay_map;
+    RangeReplayedCallback *m_callback;
+    RangeStateMap         m_range_states;
+    size_t                m_ranges_remaining;
+    std::deque<BlockPtr>  m_inflate_queue;
+    std::map<uint64_t, BlockPtr> m_unrouted;
+    std::deque<RangeReplayState *> m_ready;
+    uint64_t              m_next_route;
+    size_t                m_pending_blocks;
+    size_t                m_max_pending;
+    bool                  m_all_routed;
+    bool                  m_shutdown;
+    int                   m_error;
+    String                m_error_msg;
+  };
+
+}
+
+#endif // HYPERTABLE_LOGREPLAYER_H
@@ -186,6 +186,14 @@ namespace Hypertable {
       m_state.queue.push(task);
       m_state.cond.notify_one();
     }
+
+    /**
+     * Returns the number of tasks waiting in the queue
+     */
+    size_t size() {
+      boost::mutex::scoped_lock lock(m_state.mutex);
+      return m_state.queue.size();
+    }
   };
   typedef boost::intrusive_ptr<MaintenanceQueue> MaintenanceQueuePtr;
 
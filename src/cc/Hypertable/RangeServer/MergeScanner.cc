@@ -24,6 +24,7 @@
 
 #include "Common/Logger.h"
 
+#include "Hypertable/Lib/CounterValue.h"
 #include "Hypertable/Lib/Key.h"
 
 #include "MergeScanner.h"
@@ -33,7 +34,7 @@ using namespace Hypertable;
 /**
  *
  */
-MergeScanner::MergeScanner(ScanContextPtr &scan_ctx, bool return_dels) : CellListScanner(scan_ctx), m_done(false), m_initialized(false), m_scanners(), m_queue(), m_delete_present(false), m_deleted_row(0), m_deleted_column_family(0), m_deleted_cell(0), m_return_deletes(return_dels), m_row_count(0), m_row_limit(0), m_cell_count(0), m_cell_limit(0), m_cell_cutoff(0), m_prev_key(0) {
+MergeScanner::MergeScanner(ScanContextPtr &scan_ctx, bool return_dels) : CellListScanner(scan_ctx), m_done(false), m_initialized(false), m_scanners(), m_queue(), m_delete_present(false), m_deleted_row(0), m_deleted_column_family(0), m_deleted_cell(0), m_return_deletes(return_dels), m_row_count(0), m_row_limit(0), m_cell_count(0), m_cell_limit(0), m_prev_key(0), m_fold_active(false), m_fold_key(0), m_fold_value(0) {
   if (scan_ctx->spec != 0)
     m_row_limit = scan_ctx->spec->row_limit;
   m_start_timestamp = scan_ctx->interval.first;
@@ -58,6 +59,17 @@ MergeScanner::~MergeScanner() {
 
 
 void MergeScanner::forward() {
+  // the deltas of a folded counter have already been consumed
+  if (m_fold_active)
+    m_fold_active = false;
+  else
+    advance();
+  fold_counter();
+}
+
+
+
+void MergeScanner::advance() {
   ScannerState sstate;
   Key key;
   size_t len;
@@ -143,7 +155,7 @@ void MergeScanner::forward() {
           break;
       }
       else {
-        if (key.timestamp >= m_end_timestamp)
+        if (key.timestamp >= m_end_timestamp || expired(key))
           continue;
         if (!m_return_deletes && m_delete_present) {
           if (m_deleted_cell.fill() > 0) {
@@ -179,6 +191,14 @@ void MergeScanner::forward() {
       }
     }
 
+    /**
+     * Delete records only reach here when deletes are being returned; they
+     * are not versions of the cell, so they must not use up its version
+     * limit and cause a newer insert to be dropped.
+     */
+    if (key.flag != FLAG_INSERT)
+      break;
+
     const uint8_t *prev_key;
     size_t prev_key_len = sstate.key.decode_length(&prev_key);
 
@@ -193,7 +213,6 @@ void MergeScanner::forward() {
           }
           m_prev_key.set(prev_key, prev_key_len);
           m_cell_limit = m_scan_context_ptr->family_info[key.column_family_code].max_versions;
-          m_cell_cutoff = m_scan_context_ptr->family_info[key.column_family_code].cutoff_time;
           m_cell_count = 0;
           return;
         }
@@ -210,7 +229,6 @@ void MergeScanner::forward() {
       else {
         m_prev_key.set(prev_key, prev_key_len);
         m_cell_limit = m_scan_context_ptr->family_info[key.column_family_code].max_versions;
-        m_cell_cutoff = m_scan_context_ptr->family_info[key.column_family_code].cutoff_time;
         m_cell_count = 0;
       }
 
@@ -218,7 +236,6 @@ void MergeScanner::forward() {
     else {
       m_prev_key.set(prev_key, prev_key_len);
       m_cell_limit = m_scan_context_ptr->family_info[key.column_family_code].max_versions;
-      m_cell_cutoff = m_scan_context_ptr->family_info[key.column_family_code].cutoff_time;
       m_cell_count = 0;
     }
 
@@ -235,6 +252,12 @@ bool MergeScanner::get(ByteString &key, ByteString &value) {
   if (!m_initialized)
     initialize();
 
+  if (m_fold_active) {
+    key.ptr = m_fold_key.base;
+    value.ptr = m_fold_value.base;
+    return true;
+  }
+
   if (!m_queue.empty() && !m_done) {
     const ScannerState &sstate = m_queue.top();
     // check for row or cell limit
@@ -281,7 +304,7 @@ void MergeScanner::initialize() {
       m_deleted_row_timestamp = key.timestamp;
       m_delete_present = true;
       if (!m_return_deletes)
-        forward();
+        advance();
     }
     else if (key.flag == FLAG_DELETE_COLUMN_FAMILY) {
       size_t len = key.column_qualifier - key.row;
@@ -292,7 +315,7 @@ void MergeScanner::initialize() {
       m_deleted_column_family_timestamp = key.timestamp;
       m_delete_present = true;
       if (!m_return_deletes)
-        forward();
+        advance();
     }
     else if (key.flag == FLAG_DELETE_CELL) {
       size_t len = (key.column_qualifier - key.row) + strlen(key.column_qualifier) + 1;
@@ -303,10 +326,10 @@ void MergeScanner::initialize() {
       m_deleted_cell_timestamp = key.timestamp;
       m_delete_present = true;
       if (!m_return_deletes)
-        forward();
+        advance();
     }
     else {
-      if (key.timestamp >= m_end_timestamp) {
+      if (key.timestamp >= m_end_timestamp || expired(key)) {
         m_queue.pop();
         sstate.scanner->forward();
         if (sstate.scanner->get(sstate.key, sstate.value))
@@ -318,12 +341,96 @@ void MergeScanner::initialize() {
       size_t len = sstate.key.decode_length(&ptr);
       m_prev_key.set(ptr, len);
       m_cell_limit = m_scan_context_ptr->family_info[key.column_family_code].max_versions;
-      m_cell_cutoff = m_scan_context_ptr->family_info[key.column_family_code].cutoff_time;
       m_cell_count = 0;
     }
     break;
   }
 
+  fold_counter();
+
   m_initialized = true;
 }
 
+
+
+/**
+ * If the scanner is positioned on a counter cell, sums the deltas of that
+ * cell (newest first) into m_fold_value under the newest key, leaving the
+ * queue positioned on the cell that follows.  When deletes are being
+ * returned, a counter that a delete applies to is passed through unfolded
+ * so that the delete still masks the right deltas.
+ */
+void MergeScanner::fold_counter() {
+  ScannerState sstate;
+  Key key;
+
+  if (m_done || m_queue.empty())
+    return;
+
+  sstate = m_queue.top();
+
+  if (!key.load(sstate.key) || key.flag != FLAG_INSERT ||
+      !m_scan_context_ptr->family_info[key.column_family_code].counter)
+    return;
+
+  if (m_return_deletes && delete_applies(key))
+    return;
+
+  const uint8_t *fold_ptr, *ptr;
+  size_t fold_len = sstate.key.decode_length(&fold_ptr);
+  size_t len;
+  uint64_t sum = (uint64_t)decode_counter(sstate.value);
+
+  m_fold_key.set(sstate.key.ptr, sstate.key.length());
+  fold_ptr = m_fold_key.base + (fold_ptr - sstate.key.ptr);
+
+  while (true) {
+    advance();
+    if (m_queue.empty())
+      break;
+    sstate = m_queue.top();
+    len = sstate.key.decode_length(&ptr);
+    if (len != fold_len || ptr[len-9] != FLAG_INSERT ||
+        memcmp(ptr, fold_ptr, len-9))
+      break;
+    sum += (uint64_t)decode_counter(sstate.value);
+  }
+
+  m_fold_value.clear();
+  append_counter(m_fold_value, (int64_t)sum);
+  m_fold_active = true;
+}
+
+
+
+/**
+ * Returns true if the cell is older than the TTL of its column family.
+ */
+bool MergeScanner::expired(Key &key) {
+  uint64_t cutoff = m_scan_context_ptr->family_info[key.column_family_code].cutoff_time;
+  return cutoff != 0 && (uint64_t)key.timestamp < cutoff;
+}
+
+
+
+bool MergeScanner::delete_applies(Key &key) {
+  size_t len;
+
+  if (m_deleted_cell.fill() > 0) {
+    len = (key.column_qualifier - key.row) + strlen(key.column_qualifier) + 1;
+    if (m_deleted_cell.fill() == len && !memcmp(m_deleted_cell.base, key.row, len))
+      return true;
+  }
+  if (m_deleted_column_family.fill() > 0) {
+    len = key.column_qualifier - key.row;
+    if (m_deleted_column_family.fill() == len && !memcmp(m_deleted_column_family.base, key.row, len))
+      return true;
+  }
+  if (m_deleted_row.fill() > 0) {
+    len = strlen(key.row) + 1;
+    if (m_deleted_row.fill() == len && !memcmp(m_deleted_row.base, key.row, len))
+      return true;
+  }
+  return false;
+}
+
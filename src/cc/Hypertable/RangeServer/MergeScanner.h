@@ -29,6 +29,8 @@
 #include "Common/ByteString.h"
 #include "Common/DynamicBuffer.h"
 
+#include "Hypertable/Lib/Key.h"
+
 #include "CellListScanner.h"
 #include "CellStoreReleaseCallback.h"
 
@@ -63,6 +65,10 @@ namespace Hypertable {
   private:
 
     void initialize();
+    void advance();
+    void fold_counter();
+    bool expired(Key &key);
+    bool delete_applies(Key &key);
 
     bool          m_done;
     bool          m_initialized;
@@ -80,10 +86,12 @@ namespace Hypertable {
     int32_t       m_row_limit;
     uint32_t      m_cell_count;
     uint32_t      m_cell_limit;
-    uint64_t      m_cell_cutoff;
     int64_t       m_start_timestamp;
     int64_t       m_end_timestamp;
     DynamicBuffer m_prev_key;
+    bool          m_fold_active;
+    DynamicBuffer m_fold_key;
+    DynamicBuffer m_fold_value;
     CellStoreReleaseCallback m_release_callback;
   };
 }
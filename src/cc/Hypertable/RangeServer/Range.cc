@@ -52,7 +52,8 @@ using namespace std;
 
 
 Range::Range(MasterClientPtr &master_client_ptr, const TableIdentifier *identifier,
-             SchemaPtr &schema_ptr, const RangeSpec *range, const RangeState *state)
+             SchemaPtr &schema_ptr, const RangeSpec *range, const RangeState *state,
+             Metadata *metadata)
     : m_master_client_ptr(master_client_ptr), m_identifier(*identifier),
       m_schema(schema_ptr), m_maintenance_in_progress(false),
       m_last_logical_timestamp(0), m_added_inserts(0), m_state(*state),
@@ -83,13 +84,15 @@ Range::Range(MasterClientPtr &master_client_ptr, const TableIdentifier *identifi
       m_column_family_vector[(*cf_it)->id] = ag;
   }
 
-  if (m_is_root) {
-    MetadataRoot metadata(m_schema);
-    load_cell_stores(&metadata);
+  if (metadata)
+    load_cell_stores(metadata);
+  else if (m_is_root) {
+    MetadataRoot root_metadata(m_schema);
+    load_cell_stores(&root_metadata);
   }
   else {
-    MetadataNormal metadata(&m_identifier, m_end_row);
-    load_cell_stores(&metadata);
+    MetadataNormal normal_metadata(&m_identifier, m_end_row);
+    load_cell_stores(&normal_metadata);
   }
 
   /**
@@ -646,6 +649,74 @@ void Range::run_compaction(bool major) {
 }
 
 
+/**
+ * Attaches externally written CellStores, one per entry of files, to the
+ * access groups named alongside them.  All files are moved and opened before
+ * any of them is installed, so a bad file leaves the range untouched.  The
+ * range's logical clock is advanced past the newest imported cell so that
+ * compactions keep the imported cells and later updates sort after them.
+ * Must be called with the maintenance bit set.
+ */
+void Range::import_cell_stores(const std::vector<String> &access_groups,
+                               const std::vector<String> &files,
+                               int64_t max_timestamp) {
+  std::vector<AccessGroup *> ags;
+  std::vector<CellStorePtr> stores;
+  AccessGroup *ag;
+
+  HT_EXPECT(m_maintenance_in_progress, Error::FAILED_EXPECTATION);
+
+  for (size_t i=0; i<access_groups.size(); i++) {
+    if ((ag = get_access_group(access_groups[i])) == 0)
+      HT_THROWF(Error::RANGESERVER_IMPORT_REJECTED,
+                "Unknown access group '%s' for table '%s'",
+                access_groups[i].c_str(), m_identifier.name);
+    ags.push_back(ag);
+  }
+
+  try {
+    for (size_t i=0; i<files.size(); i++)
+      stores.push_back(ags[i]->load_imported_cell_store(files[i]));
+  }
+  catch (Exception &e) {
+    // hand back the files that were already moved
+    for (size_t i=0; i<stores.size(); i++) {
+      try { Global::dfs->rename(stores[i]->get_filename(), files[i]); }
+      catch (Exception &e2) {
+        HT_ERROR_OUT << "Problem returning imported cell store '" << files[i]
+                     << "' - " << e2 << HT_END;
+      }
+    }
+    throw;
+  }
+
+  /**
+   * Advance the logical clock before the stores become visible
+   */
+  {
+    int64_t real_timestamp;
+    lock();
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (max_timestamp > m_last_logical_timestamp)
+        m_last_logical_timestamp = max_timestamp;
+      real_timestamp = m_timestamp.real;
+    }
+    unlock(real_timestamp);
+  }
+
+  for (size_t i=0; i<m_access_group_vector.size(); i++) {
+    std::vector<CellStorePtr> ag_stores;
+    for (size_t j=0; j<ags.size(); j++) {
+      if (ags[j] == m_access_group_vector[i])
+        ag_stores.push_back(stores[j]);
+    }
+    m_access_group_vector[i]->install_imported_cell_stores(ag_stores);
+  }
+}
+
+
+
 /**
  *
  */
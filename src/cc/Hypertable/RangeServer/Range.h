@@ -53,7 +53,12 @@ namespace Hypertable {
     typedef std::vector<AccessGroup *>  ColumnFamilyVector;
 
   public:
-    Range(MasterClientPtr &master_client_ptr, const TableIdentifier *identifier, SchemaPtr &schema_ptr, const RangeSpec *range, const RangeState *state);
+    /**
+     * Constructor.  Loads the range's cell stores as listed in metadata,
+     * or, if metadata is 0, in the range's METADATA entry (the root file
+     * for the root range).
+     */
+    Range(MasterClientPtr &master_client_ptr, const TableIdentifier *identifier, SchemaPtr &schema_ptr, const RangeSpec *range, const RangeState *state, Metadata *metadata=0);
     virtual ~Range();
     virtual int add(const ByteString key, const ByteString value, int64_t real_timestamp);
     virtual const char *get_split_row() { return 0; }
@@ -106,9 +111,18 @@ namespace Hypertable {
       return m_maintenance_in_progress;
     }
 
+    void clear_maintenance() {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_maintenance_in_progress = false;
+    }
+
     void split();
     void compact(bool major=false);
 
+    void import_cell_stores(const std::vector<String> &access_groups,
+                            const std::vector<String> &files,
+                            int64_t max_timestamp);
+
     void increment_update_counter() {
       m_update_barrier.enter();
     }
@@ -21,6 +21,7 @@
 
 #include "Common/Compat.h"
 #include <cassert>
+#include <sstream>
 #include <string>
 
 #include <boost/shared_array.hpp>
@@ -35,7 +36,9 @@ extern "C" {
 #include "Common/md5.h"
 #include "Common/StringExt.h"
 #include "Common/System.h"
+#include "Common/Trace.h"
 
+#include "Hypertable/Lib/BlockCompressionHeader.h"
 #include "Hypertable/Lib/CommitLog.h"
 #include "Hypertable/Lib/Defaults.h"
 #include "Hypertable/Lib/RangeServerMetaLogReader.h"
@@ -43,6 +46,8 @@ extern "C" {
 #include "Hypertable/Lib/RangeServerProtocol.h"
 
 #include "DfsBroker/Lib/Client.h"
+#include "DfsBroker/Lib/ClientBufferedReaderHandler.h"
+#include "DfsBroker/Lib/LocalClient.h"
 
 #include "FillScanBlock.h"
 #include "Global.h"
@@ -70,6 +75,8 @@ namespace {
 RangeServer::RangeServer(PropertiesPtr &props_ptr, ConnectionManagerPtr &conn_manager_ptr, ApplicationQueuePtr &app_queue_ptr, Hyperspace::SessionPtr &hyperspace_ptr) : m_root_replay_finished(false), m_metadata_replay_finished(false), m_replay_finished(false), m_props_ptr(props_ptr), m_verbose(false), m_conn_manager_ptr(conn_manager_ptr), m_app_queue_ptr(app_queue_ptr), m_hyperspace_ptr(hyperspace_ptr), m_last_commit_log_clean(0), m_bytes_loaded(0) {
   uint16_t port;
   uint32_t maintenance_threads = 1;
+  int32_t compression_threads;
+  int32_t compression_window;
   Comm *comm = conn_manager_ptr->get_comm();
 
   Global::range_max_bytes           = props_ptr->get_int64("Hypertable.RangeServer.Range.MaxBytes", 200000000LL);
@@ -81,6 +88,28 @@ RangeServer::RangeServer(PropertiesPtr &props_ptr, ConnectionManagerPtr &conn_ma
   m_scanner_ttl                   = (time_t)props_ptr->get_int("Hypertable.RangeServer.Scanner.Ttl", 120);
   m_timer_interval                = props_ptr->get_int("Hypertable.RangeServer.Timer.Interval", 60);
   m_log_roll_limit                = props_ptr->get_int64("Hypertable.RangeServer.CommitLog.RollLimit", HYPERTABLE_RANGESERVER_COMMITLOG_ROLLLIMIT);
+  m_replay_threads                = props_ptr->get_int("Hypertable.RangeServer.CommitLog.Replay.Threads", 4);
+  m_replay_fragment_readahead     = props_ptr->get_int("Hypertable.RangeServer.CommitLog.Replay.FragmentReadahead", 2);
+  compression_threads             = props_ptr->get_int("Hypertable.RangeServer.CellStore.CompressionThreads", System::get_processor_count());
+  compression_window              = props_ptr->get_int("Hypertable.RangeServer.CellStore.CompressionWindow", compression_threads + 1);
+
+  {
+    String checksum = props_ptr->get("Hypertable.RangeServer.BlockChecksum", "");
+    try {
+      if (checksum != "")
+        BlockCompressionHeader::set_default_checksum_type(
+            BlockCompressionHeader::parse_checksum_type(checksum));
+    }
+    catch (Exception &e) {
+      HT_ERRORF("Bad Hypertable.RangeServer.BlockChecksum: %s", e.what());
+      exit(1);
+    }
+  }
+
+  if (m_replay_threads < 1) {
+    HT_WARNF("Value %d for Hypertable.RangeServer.CommitLog.Replay.Threads is too small, setting to 1", m_replay_threads);
+    m_replay_threads = 1;
+  }
 
   if (m_timer_interval >= 1000) {
     HT_ERROR("Hypertable.RangeServer.Timer.Interval property too large, exiting ...");
@@ -95,6 +124,10 @@ RangeServer::RangeServer(PropertiesPtr &props_ptr, ConnectionManagerPtr &conn_ma
   uint64_t block_cacheMemory = props_ptr->get_int64("Hypertable.RangeServer.BlockCache.MaxMemory", 200000000LL);
   Global::block_cache = new FileBlockCache(block_cacheMemory);
 
+  int32_t readahead_max_read = props_ptr->get_int("Hypertable.RangeServer.Readahead.MaxReadSize", 1024*1024);
+  int64_t readahead_memory = props_ptr->get_int64("Hypertable.RangeServer.Readahead.MaxMemory", 64000000LL);
+  ClientBufferedReaderHandler::set_readahead_limits(readahead_max_read, readahead_memory);
+
   assert(Global::access_group_merge_files <= Global::access_group_max_files);
 
   m_verbose = props_ptr->get_bool("Hypertable.Verbose", false);
@@ -104,8 +137,12 @@ RangeServer::RangeServer(PropertiesPtr &props_ptr, ConnectionManagerPtr &conn_ma
     cout << "Hypertable.RangeServer.AccessGroup.MaxMemory=" << Global::access_group_max_mem << endl;
     cout << "Hypertable.RangeServer.AccessGroup.MergeFiles=" << Global::access_group_merge_files << endl;
     cout << "Hypertable.RangeServer.BlockCache.MaxMemory=" << block_cacheMemory << endl;
+    cout << "Hypertable.RangeServer.Readahead.MaxReadSize=" << readahead_max_read << endl;
+    cout << "Hypertable.RangeServer.Readahead.MaxMemory=" << readahead_memory << endl;
     cout << "Hypertable.RangeServer.Range.MaxBytes=" << Global::range_max_bytes << endl;
     cout << "Hypertable.RangeServer.MaintenanceThreads=" << maintenance_threads << endl;
+    cout << "Hypertable.RangeServer.CellStore.CompressionThreads=" << compression_threads << endl;
+    cout << "Hypertable.RangeServer.CellStore.CompressionWindow=" << compression_window << endl;
     cout << "Hypertable.RangeServer.Port=" << port << endl;
     //cout << "Hypertable.RangeServer.workers=" << worker_count << endl;
   }
@@ -115,20 +152,34 @@ RangeServer::RangeServer(PropertiesPtr &props_ptr, ConnectionManagerPtr &conn_ma
 
   Global::protocol = new Hypertable::RangeServerProtocol();
 
-  DfsBroker::Client *dfs_client = new DfsBroker::Client(m_conn_manager_ptr, props_ptr);
+  DfsBroker::Client *dfs_client;
 
-  if (m_verbose) {
-    cout << "DfsBroker.Host=" << props_ptr->get("DfsBroker.Host", "") << endl;
-    cout << "DfsBroker.Port=" << props_ptr->get("DfsBroker.Port", "") << endl;
-    cout << "DfsBroker.Timeout=" << props_ptr->get("DfsBroker.Timeout", "") << endl;
+  /**
+   * With DfsBroker.InProcess set, CellStore and commit log I/O goes
+   * straight to the local (or POSIX-mounted) filesystem under
+   * DfsBroker.Local.Root instead of through the broker process.
+   */
+  if (props_ptr->get_bool("Hypertable.RangeServer.DfsBroker.InProcess", false)) {
+    if (m_verbose)
+      cout << "DfsBroker.Local.Root=" << props_ptr->get("DfsBroker.Local.Root", "") << " (in-process)" << endl;
+    Global::dfs = new DfsBroker::LocalClient(props_ptr);
   }
+  else {
+    dfs_client = new DfsBroker::Client(m_conn_manager_ptr, props_ptr);
 
-  if (!dfs_client->wait_for_connection(30)) {
-    HT_ERROR("Unable to connect to DFS Broker, exiting...");
-    exit(1);
-  }
+    if (m_verbose) {
+      cout << "DfsBroker.Host=" << props_ptr->get("DfsBroker.Host", "") << endl;
+      cout << "DfsBroker.Port=" << props_ptr->get("DfsBroker.Port", "") << endl;
+      cout << "DfsBroker.Timeout=" << props_ptr->get("DfsBroker.Timeout", "") << endl;
+    }
 
-  Global::dfs = dfs_client;
+    if (!dfs_client->wait_for_connection(30)) {
+      HT_ERROR("Unable to connect to DFS Broker, exiting...");
+      exit(1);
+    }
+
+    Global::dfs = dfs_client;
+  }
 
   /**
    * Check for and connect to commit log DFS broker
@@ -168,6 +219,10 @@ RangeServer::RangeServer(PropertiesPtr &props_ptr, ConnectionManagerPtr &conn_ma
   // Create the maintenance queue
   Global::maintenance_queue = new MaintenanceQueue(maintenance_threads);
 
+  // Create the CellStore block compression pool (zero threads compresses inline)
+  if (compression_threads > 0)
+    Global::block_compression_queue = new BlockCompressionQueue(compression_threads, compression_window < 1 ? 1 : compression_window);
+
   // Create table info maps
   m_live_map_ptr = new TableInfoMap();
   m_replay_map_ptr = new TableInfoMap();
@@ -232,23 +287,18 @@ RangeServer::~RangeServer() {
  */
 int RangeServer::initialize(PropertiesPtr &props_ptr) {
   int error;
-  bool exists;
   String top_dir;
+  std::vector<BatchOp> ops;
 
   /**
-   * Create /hypertable/servers directory
+   * Create /hypertable/servers directory (and its parent) if missing
    */
-  if ((error = m_hyperspace_ptr->exists("/hypertable/servers", &exists)) != Error::OK) {
-    HT_ERRORF("Problem checking existence of '/hypertable/servers' Hyperspace directory - %s", Error::get_text(error));
-    return error;
-  }
+  ops.push_back(BatchOp(BATCH_OP_MKDIR, "/hypertable"));
+  ops.push_back(BatchOp(BATCH_OP_MKDIR, "/hypertable/servers"));
 
-  if (!exists) {
-    m_hyperspace_ptr->mkdir("/hypertable");
-    if ((error = m_hyperspace_ptr->mkdir("/hypertable/servers")) != Error::OK) {
-      HT_ERRORF("Problem creating directory '/hypertable/servers' - %s", Error::get_text(error));
-      return error;
-    }
+  if ((error = m_hyperspace_ptr->batch(ops)) != Error::OK) {
+    HT_ERRORF("Problem creating directory '/hypertable/servers' - %s", Error::get_text(error));
+    return error;
   }
 
   top_dir = (String)"/hypertable/servers/" + m_location;
@@ -415,6 +465,16 @@ void RangeServer::local_recover() {
 	m_replay_finished_cond.notify_all();
       }
 
+      /**
+       * Finish the splits that were interrupted, now that the logs they
+       * write to exist
+       */
+      {
+	std::vector<RangePtr> split_ranges;
+	m_live_map_ptr->get_split_ranges(split_ranges);
+	schedule_splits(split_ranges);
+      }
+
     }
     else {
       boost::mutex::scoped_lock lock(m_mutex);
@@ -451,69 +511,45 @@ void RangeServer::local_recover() {
 
 
 
+/**
+ * Replays the given log into the ranges of the replay map.  Each range
+ * is moved into the live map, and becomes available for scanning, as
+ * soon as its portion of the log has been replayed.
+ */
 void RangeServer::replay_log(CommitLogReaderPtr &log_reader_ptr) {
-  BlockCompressionHeaderCommitLog header;
-  uint8_t *base;
-  size_t len;
-  TableIdentifier table_id;
-  DynamicBuffer dbuf;
-  const uint8_t *ptr, *end;
-  int64_t timestamp;
-  TableInfoPtr table_info_ptr;
-  RangePtr range_ptr;
-  ByteString key, value;
-
-  while (log_reader_ptr->next((const uint8_t **)&base, &len, &header)) {
+  LogReplayer replayer(m_replay_map_ptr, m_replay_threads,
+                       4 * m_replay_threads, this);
 
-    timestamp = header.get_timestamp();
+  log_reader_ptr->set_fragment_readahead(m_replay_fragment_readahead);
 
-    ptr = base;
-    end = base + len;
-
-    table_id.decode(&ptr, &len);
-
-    // Fetch table info
-    if (!m_replay_map_ptr->get(table_id.id, table_info_ptr))
-      continue;
-
-    dbuf.ensure(table_id.encoded_length() + 12 + len);
-    dbuf.clear();
-
-    dbuf.ptr += 4;  // skip size
-    encode_i64(&dbuf.ptr, timestamp);
-    table_id.encode(&dbuf.ptr);
-    base = dbuf.ptr;
+  replayer.replay(log_reader_ptr.get());
+}
 
-    while (ptr < end) {
 
-      // extract the key
-      key.ptr = ptr;
-      ptr += key.length();
-      if (ptr > end)
-	HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
 
-      // extract the value
-      value.ptr = ptr;
-      ptr += value.length();
-      if (ptr > end)
-	HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
+/**
+ * Queues a split task for each of the given ranges that is not already
+ * undergoing maintenance.
+ */
+void RangeServer::schedule_splits(std::vector<RangePtr> &split_ranges) {
+  foreach(RangePtr &range_ptr, split_ranges) {
+    if (!range_ptr->test_and_set_maintenance())
+      Global::maintenance_queue->add(new MaintenanceTaskSplit(range_ptr));
+  }
+}
 
-      // Look for containing range, add to stop mods if not found
-      if (!table_info_ptr->find_containing_range(key.str(), range_ptr))
-	continue;
 
-      // add key/value pair to buffer
-      memcpy(dbuf.ptr, key.ptr, ptr-key.ptr);
-      dbuf.ptr += ptr-key.ptr;
 
-    }
+void RangeServer::range_replayed(TableInfoPtr &table_info, RangePtr &range) {
+  m_live_map_ptr->merge_range(table_info, range);
 
-    uint32_t block_size = dbuf.ptr - base;
-    base = dbuf.base;
-    encode_i32(&base, block_size);
+  if (Global::verbose)
+    HT_INFOF("Replay of range %s complete", range->get_name().c_str());
 
-    replay_update(0, dbuf.base, dbuf.fill());
-  }
+  boost::mutex::scoped_lock lock(m_mutex);
+  m_root_replay_finished_cond.notify_all();
+  m_metadata_replay_finished_cond.notify_all();
+  m_replay_finished_cond.notify_all();
 }
 
 
@@ -584,6 +620,95 @@ void RangeServer::compact(ResponseCallback *cb, TableIdentifier *table, RangeSpe
 
 
 
+/**
+ * Attaches CellStores that were written outside of the RangeServer (by
+ * csimport) to a range.  The range is marked as under maintenance for the
+ * duration, so the import can not interleave with a compaction or split that
+ * would rewrite the access group's store list underneath it.
+ */
+void RangeServer::import_cell_stores(ResponseCallback *cb, TableIdentifier *table, RangeSpec *range,
+                                     const std::vector<String> &access_groups,
+                                     const std::vector<String> &files,
+                                     int64_t max_timestamp) {
+  int error = Error::OK;
+  String errmsg;
+  TableInfoPtr table_info;
+  RangePtr range_ptr;
+
+  if (Global::verbose) {
+    cout << *table;
+    cout << *range;
+    cout << "Importing " << files.size() << " cell stores" << endl;
+  }
+
+  if (!m_replay_finished)
+    wait_for_recovery_finish();
+
+  /**
+   * Fetch table info
+   */
+  if (!m_live_map_ptr->get(table->id, table_info)) {
+    error = Error::RANGESERVER_RANGE_NOT_FOUND;
+    errmsg = "No ranges loaded for table '" + (String)table->name + "'";
+    goto abort;
+  }
+
+  /**
+   * Fetch range info
+   */
+  if (!table_info->get_range(range, range_ptr)) {
+    error = Error::RANGESERVER_RANGE_NOT_FOUND;
+    errmsg = (String)table->name + "[" + range->start_row + ".." + range->end_row + "]";
+    goto abort;
+  }
+
+  /**
+   * Imported cells must sort before anything the server will assign later
+   */
+  if (max_timestamp > (int64_t)Global::user_log->get_timestamp()) {
+    error = Error::RANGESERVER_IMPORT_REJECTED;
+    errmsg = format("Import timestamp %lld is in the future", (long long)max_timestamp);
+    goto abort;
+  }
+
+  if (range_ptr->test_and_set_maintenance()) {
+    error = Error::RANGESERVER_RANGE_BUSY;
+    errmsg = (String)table->name + "[" + range->start_row + ".." + range->end_row + "]";
+    goto abort;
+  }
+
+  try {
+    range_ptr->import_cell_stores(access_groups, files, max_timestamp);
+  }
+  catch (Exception &e) {
+    range_ptr->clear_maintenance();
+    error = e.code();
+    errmsg = e.what();
+    goto abort;
+  }
+
+  range_ptr->clear_maintenance();
+
+  if ((error = cb->response_ok()) != Error::OK) {
+    HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
+  }
+
+  HT_INFOF("Imported %d cell stores into %s[%s..%s]", (int)files.size(),
+           table->name, range->start_row, range->end_row);
+
+  error = Error::OK;
+
+ abort:
+  if (error != Error::OK) {
+    HT_ERRORF("%s '%s'", Error::get_text(error), errmsg.c_str());
+    if ((error = cb->error(error, errmsg)) != Error::OK) {
+      HT_ERRORF("Problem sending error response - %s", Error::get_text(error));
+    }
+  }
+}
+
+
+
 /**
  *  CreateScanner
  */
@@ -598,6 +723,7 @@ void RangeServer::create_scanner(ResponseCallbackCreateScanner *cb, TableIdentif
   Timestamp scan_timestamp;
   SchemaPtr schema_ptr;
   ScanContextPtr scan_ctx;
+  ServerStats::Timer timer(Global::server_stats, ServerStats::CREATE_SCANNER);
 
   if (Global::verbose) {
     cout << "RangeServer::create_scanner" << endl;
@@ -643,6 +769,7 @@ void RangeServer::create_scanner(ResponseCallbackCreateScanner *cb, TableIdentif
                                   (String)"(b) " + table->name + "[" + range->start_row + ".." + range->end_row + "]");
 
     more = FillScanBlock(scanner_ptr, rbuf);
+    timer.add_bytes(rbuf.fill());
 
     id = (more) ? Global::scanner_map.put(scanner_ptr, range_ptr) : 0;
 
@@ -685,6 +812,7 @@ void RangeServer::fetch_scanblock(ResponseCallbackFetchScanblock *cb, uint32_t s
   RangePtr range_ptr;
   bool more = true;
   DynamicBuffer rbuf;
+  ServerStats::Timer timer(Global::server_stats, ServerStats::FETCH_SCANBLOCK);
 
   if (Global::verbose) {
     cout << "RangeServer::fetch_scanblock" << endl;
@@ -700,6 +828,7 @@ void RangeServer::fetch_scanblock(ResponseCallbackFetchScanblock *cb, uint32_t s
   }
 
   more = FillScanBlock(scanner_ptr, rbuf);
+  timer.add_bytes(rbuf.fill());
 
   if (!more)
     Global::scanner_map.remove(scanner_id);
@@ -971,6 +1100,9 @@ void RangeServer::update(ResponseCallbackUpdate *cb, TableIdentifier *table, Sta
   vector<SendBackRec> send_back_vector;
   const uint8_t *send_back_ptr = 0;
   uint32_t misses = 0;
+  ServerStats::Timer timer(Global::server_stats, ServerStats::UPDATE);
+
+  timer.add_bytes(buffer.size);
 
   min_ts_vector.reserve(50);
 
@@ -1149,11 +1281,16 @@ void RangeServer::update(ResponseCallbackUpdate *cb, TableIdentifier *table, Sta
 
         HT_EXPECT(dbuf.fill() <= (splitsz + table->encoded_length()), Error::FAILED_EXPECTATION);
 
+        HiResTime log_start;
+
 	if ((error = splitlog->write(dbuf, update_timestamp)) != Error::OK) {
 	  errmsg = (string)"Problem writing " + (int)dbuf.fill() + " bytes to split log";
 	  m_update_mutex_a.unlock();
 	  goto abort;
 	}
+        Global::server_stats.record(ServerStats::COMMIT_LOG_APPEND,
+            ServerStats::elapsed_usecs(log_start), dbuf.fill());
+        Trace::record("commit log append", log_start);
       }
 
       /**
@@ -1246,11 +1383,16 @@ void RangeServer::update(ResponseCallbackUpdate *cb, TableIdentifier *table, Sta
 
       HT_EXPECT(dbuf.fill() <= (rootsz + table->encoded_length()), Error::FAILED_EXPECTATION);
 
+      HiResTime log_start;
+
       if ((error = Global::root_log->write(dbuf, initial_timestamp)) != Error::OK) {
 	errmsg = (string)"Problem writing " + (int)dbuf.fill() + " bytes to ROOT commit log";
 	m_update_mutex_b.unlock();
 	goto abort;
       }
+      Global::server_stats.record(ServerStats::COMMIT_LOG_APPEND,
+          ServerStats::elapsed_usecs(log_start), dbuf.fill());
+      Trace::record("commit log append", log_start);
     }
 
     /**
@@ -1272,11 +1414,16 @@ void RangeServer::update(ResponseCallbackUpdate *cb, TableIdentifier *table, Sta
 
       HT_EXPECT(dbuf.fill() <= (gosz + table->encoded_length()), Error::FAILED_EXPECTATION);
 
+      HiResTime log_start;
+
       if ((error = log->write(dbuf, initial_timestamp)) != Error::OK) {
 	errmsg = (string)"Problem writing " + (int)dbuf.fill() + " bytes to commit log (" + log->get_log_dir() + ")";
 	m_update_mutex_b.unlock();
 	goto abort;
       }
+      Global::server_stats.record(ServerStats::COMMIT_LOG_APPEND,
+          ServerStats::elapsed_usecs(log_start), dbuf.fill());
+      Trace::record("commit log append", log_start);
     }
 
     m_update_mutex_b.unlock();
@@ -1432,6 +1579,23 @@ void RangeServer::dump_stats(ResponseCallback *cb) {
 }
 
 
+void RangeServer::get_statistics(ResponseCallbackGetStatistics *cb) {
+  std::ostringstream out;
+  int error;
+
+  Global::server_stats.dump(out);
+
+  out << "maintenance queue depth=" << Global::maintenance_queue->size()
+      << "\n";
+  out << "cell cache        memory=" << Global::memory_tracker.get_memory()
+      << " items=" << Global::memory_tracker.get_items() << "\n";
+
+  if ((error = cb->response(out.str())) != Error::OK)
+    HT_ERRORF("Problem sending get statistics response - %s",
+              Error::get_text(error));
+}
+
+
 /**
  *
  */
@@ -1696,8 +1860,13 @@ void RangeServer::replay_commit(ResponseCallback *cb) {
     if ((error = log->link_log(m_replay_log_ptr.get(), Global::user_log->get_timestamp())) != Error::OK)
       HT_THROW(error, std::string("Problem linking replay log (") + m_replay_log_ptr->get_log_dir() + ") into commit log (" + log->get_log_dir() + ")");
 
+    std::vector<RangePtr> split_ranges;
+    m_replay_map_ptr->get_split_ranges(split_ranges);
+
     m_live_map_ptr->merge(m_replay_map_ptr);
 
+    schedule_splits(split_ranges);
+
   }
   catch (Hypertable::Exception &e) {
     HT_ERRORF("%s - %s", e.what(), Error::get_text(e.code()));
@@ -1978,22 +2147,40 @@ void RangeServer::wait_for_recovery_finish(TableIdentifier *table, RangeSpec *ra
   boost::mutex::scoped_lock lock(m_mutex);
   if (table->id == 0) {
     if (!strcmp(range->end_row, Key::END_ROOT_ROW)) {
-      while (!m_root_replay_finished) {
+      while (!m_root_replay_finished && !range_online(table, range)) {
 	HT_INFO_OUT << "Waiting for ROOT recovery to complete..." << HT_END;
 	m_root_replay_finished_cond.wait(lock);
       }
     }
     else {
-      while (!m_metadata_replay_finished) {
+      while (!m_metadata_replay_finished && !range_online(table, range)) {
 	HT_INFO_OUT << "Waiting for METADATA recovery to complete..." << HT_END;
 	m_metadata_replay_finished_cond.wait(lock);
       }
     }
   }
   else {
-    while (!m_replay_finished) {
+    while (!m_replay_finished && !range_online(table, range)) {
       HT_INFO_OUT << "Waiting for recovery to complete..." << HT_END;
       m_replay_finished_cond.wait(lock);
     }
   }
 }
+
+
+/**
+ * Returns true if the given range has been replayed and moved into
+ * the live map.
+ */
+bool RangeServer::range_online(TableIdentifier *table, RangeSpec *range) {
+  TableInfoPtr table_info;
+  RangePtr range_ptr;
+
+  if (!m_live_map_ptr->get(table->id, table_info))
+    return false;
+
+  if (!table_info->find_containing_range(range->end_row, range_ptr))
+    return false;
+
+  return range_ptr->end_row() == range->end_row;
+}
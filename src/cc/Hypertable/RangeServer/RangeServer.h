@@ -41,8 +41,10 @@
 #include "Hypertable/Lib/Types.h"
 
 #include "Global.h"
+#include "LogReplayer.h"
 #include "ResponseCallbackCreateScanner.h"
 #include "ResponseCallbackFetchScanblock.h"
+#include "ResponseCallbackGetStatistics.h"
 #include "ResponseCallbackUpdate.h"
 #include "TableInfo.h"
 #include "TableInfoMap.h"
@@ -53,7 +55,7 @@ namespace Hypertable {
 
   class ConnectionHandler;
 
-  class RangeServer : public ReferenceCount {
+  class RangeServer : public ReferenceCount, public LogReplayer::RangeReplayedCallback {
   public:
     RangeServer(PropertiesPtr &, ConnectionManagerPtr &, ApplicationQueuePtr &,
                 Hyperspace::SessionPtr &);
@@ -71,6 +73,11 @@ namespace Hypertable {
     void update(ResponseCallbackUpdate *, TableIdentifier *, StaticBuffer &);
     void drop_table(ResponseCallback *, TableIdentifier *);
     void dump_stats(ResponseCallback *);
+    void get_statistics(ResponseCallbackGetStatistics *);
+    void import_cell_stores(ResponseCallback *, TableIdentifier *, RangeSpec *,
+                            const std::vector<String> &access_groups,
+                            const std::vector<String> &files,
+                            int64_t max_timestamp);
 
     void replay_begin(ResponseCallback *, uint16_t group);
     void replay_load_range(ResponseCallback *, const TableIdentifier *, const RangeSpec *, const RangeState *);
@@ -96,12 +103,16 @@ namespace Hypertable {
     void wait_for_recovery_finish();
     void wait_for_recovery_finish(TableIdentifier *table, RangeSpec *range);
 
+    virtual void range_replayed(TableInfoPtr &table_info, RangePtr &range);
+
   private:
     int initialize(PropertiesPtr &);
     void local_recover();
     void replay_log(CommitLogReaderPtr &log_reader_ptr);
+    bool range_online(TableIdentifier *table, RangeSpec *range);
     int verify_schema(TableInfoPtr &, int generation, std::string &errmsg);
     void schedule_log_cleanup_compactions(std::vector<RangePtr> &range_vec, CommitLog *log, uint64_t prune_threshold);
+    void schedule_splits(std::vector<RangePtr> &split_ranges);
 
     Mutex                  m_mutex;
     boost::condition       m_root_replay_finished_cond;
@@ -132,6 +143,8 @@ namespace Hypertable {
     uint64_t               m_bytes_loaded;
     uint64_t               m_log_roll_limit;
     int                    m_replay_group;
+    int                    m_replay_threads;
+    uint32_t               m_replay_fragment_readahead;
   };
 
   typedef intrusive_ptr<RangeServer> RangeServerPtr;
@@ -0,0 +1,67 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+#include "AsyncComm/ResponseCallback.h"
+#include "Common/Serialization.h"
+
+#include "Hypertable/Lib/Types.h"
+
+#include "RangeServer.h"
+#include "RequestHandlerImportCellStores.h"
+
+using namespace Hypertable;
+using namespace Serialization;
+
+/**
+ *
+ */
+void RequestHandlerImportCellStores::run() {
+  ResponseCallback cb(m_comm, m_event_ptr);
+  TableIdentifier table;
+  RangeSpec range;
+  int64_t max_timestamp;
+  uint32_t count;
+  std::vector<String> access_groups;
+  std::vector<String> files;
+  size_t remaining = m_event_ptr->message_len - 2;
+  const uint8_t *msg = m_event_ptr->message + 2;
+
+  try {
+    table.decode(&msg, &remaining);
+    range.decode(&msg, &remaining);
+    max_timestamp = (int64_t)decode_i64(&msg, &remaining);
+    count = decode_i32(&msg, &remaining);
+    for (uint32_t i=0; i<count; i++) {
+      access_groups.push_back(decode_vstr(&msg, &remaining));
+      files.push_back(decode_vstr(&msg, &remaining));
+    }
+    m_range_server->import_cell_stores(&cb, &table, &range, access_groups,
+                                       files, max_timestamp);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    cb.error(Error::PROTOCOL_ERROR, "Error handling import cell stores message");
+  }
+}
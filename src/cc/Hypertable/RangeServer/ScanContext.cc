@@ -24,6 +24,7 @@
 #include <cassert>
 
 #include "Common/Logger.h"
+#include "Common/Time.h"
 
 #include "Hypertable/Lib/Key.h"
 
@@ -32,12 +33,32 @@
 using namespace std;
 using namespace Hypertable;
 
+namespace {
+
+  /**
+   * Returns the timestamp before which cells of a family with the given
+   * TTL (in seconds) have expired, or zero if nothing has.
+   */
+  uint64_t ttl_cutoff(int64_t now, uint32_t ttl) {
+    int64_t ttl_nanos = (int64_t)ttl * 1000000000LL;
+    if (ttl == 0 || now <= ttl_nanos)
+      return 0;
+    return (uint64_t)(now - ttl_nanos);
+  }
+
+}
+
 /**
  *
  */
 void ScanContext::initialize(int64_t ts, ScanSpec *ss, RangeSpec *range_, SchemaPtr &sp) {
   Schema::ColumnFamily *cf;
   uint32_t max_versions = 0;
+  int64_t now = ts;
+
+  // TTLs count back from the scan timestamp, or from the present if unbounded
+  if (now == 0 || now == END_OF_TIME)
+    now = (int64_t)get_ts64();
 
   // set time interval
   if (ss) {
@@ -78,10 +99,7 @@ void ScanContext::initialize(int64_t ts, ScanSpec *ss, RangeSpec *range_, Schema
           throw Hypertable::Exception(Error::RANGESERVER_INVALID_COLUMNFAMILY, *iter);
 
         family_mask[cf->id] = true;
-        if (cf->ttl == 0)
-          family_info[cf->id].cutoff_time = 0;
-        else
-          family_info[cf->id].cutoff_time = ts - ((uint64_t)cf->ttl * 1000000000LL);
+        family_info[cf->id].cutoff_time = ttl_cutoff(now, cf->ttl);
         if (max_versions == 0)
           family_info[cf->id].max_versions = cf->max_versions;
         else {
@@ -90,6 +108,11 @@ void ScanContext::initialize(int64_t ts, ScanSpec *ss, RangeSpec *range_, Schema
           else
             family_info[cf->id].max_versions = (max_versions < cf->max_versions) ? max_versions : cf->max_versions;
         }
+        if (cf->counter) {
+          // every counter delta is a version, so version limits don't apply
+          family_info[cf->id].counter = true;
+          family_info[cf->id].max_versions = 0;
+        }
       }
     }
     else {
@@ -101,10 +124,7 @@ void ScanContext::initialize(int64_t ts, ScanSpec *ss, RangeSpec *range_, Schema
           if ((*cf_it)->id == 0)
             throw Hypertable::Exception(Error::RANGESERVER_SCHEMA_INVALID_CFID, (std::string)"Bad ID for Column Family '" + (*cf_it)->name + "'");
           family_mask[(*cf_it)->id] = true;
-          if ((*cf_it)->ttl == 0)
-            family_info[(*cf_it)->id].cutoff_time = 0;
-          else
-            family_info[(*cf_it)->id].cutoff_time = ts - ((uint64_t)(*cf_it)->ttl * 1000000000LL);
+          family_info[(*cf_it)->id].cutoff_time = ttl_cutoff(now, (*cf_it)->ttl);
 
           if (max_versions == 0)
             family_info[(*cf_it)->id].max_versions = (*cf_it)->max_versions;
@@ -114,6 +134,10 @@ void ScanContext::initialize(int64_t ts, ScanSpec *ss, RangeSpec *range_, Schema
             else
               family_info[(*cf_it)->id].max_versions = (max_versions < (*cf_it)->max_versions) ? max_versions : (*cf_it)->max_versions;
           }
+          if ((*cf_it)->counter) {
+            family_info[(*cf_it)->id].counter = true;
+            family_info[(*cf_it)->id].max_versions = 0;
+          }
         }
       }
     }
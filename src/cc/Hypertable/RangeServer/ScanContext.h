@@ -39,6 +39,7 @@ namespace Hypertable {
   struct CellFilterInfo {
     uint64_t cutoff_time;
     uint32_t max_versions;
+    bool counter;
   };
 
   /**
@@ -0,0 +1,96 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <iomanip>
+#include <iostream>
+
+#include "ServerStats.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+  const char *operation_strings[] = {
+    "update",
+    "create scanner",
+    "fetch scanblock",
+    "commit log append",
+    "dfs read",
+    "compaction",
+    (const char *)0
+  };
+}
+
+
+ServerStats::ServerStats() {
+  atomic_set(&m_block_cache_hits, 0);
+  atomic_set(&m_block_cache_misses, 0);
+}
+
+
+void ServerStats::record(Operation op, uint64_t usecs, uint64_t bytes) {
+  OperationStats &stats = m_ops[op];
+  boost::mutex::scoped_lock lock(stats.mutex);
+  stats.histogram.record(usecs);
+  stats.bytes += bytes;
+}
+
+
+void ServerStats::dump(std::ostream &out) {
+  for (int i=0; i<OPERATION_MAX; i++) {
+    LatencyHistogram histogram;
+    uint64_t bytes;
+    {
+      boost::mutex::scoped_lock lock(m_ops[i].mutex);
+      histogram = m_ops[i].histogram;
+      bytes = m_ops[i].bytes;
+    }
+    out << setw(18) << left << operation_text(i) << right;
+    histogram.dump_summary(out);
+    if (bytes)
+      out << " bytes=" << bytes;
+    out << "\n";
+  }
+
+  uint32_t hits = (uint32_t)atomic_read(&m_block_cache_hits);
+  uint32_t misses = (uint32_t)atomic_read(&m_block_cache_misses);
+  double rate = (hits + misses) ? (100.0 * hits) / (hits + misses) : 0.0;
+
+  out << setw(18) << left << "block cache" << right << "hits=" << hits
+      << " misses=" << misses << " hit_rate=" << fixed << setprecision(1)
+      << rate << "%\n";
+}
+
+
+const char *ServerStats::operation_text(int op) {
+  if (op < 0 || op >= OPERATION_MAX)
+    return "unknown";
+  return operation_strings[op];
+}
+
+
+uint64_t ServerStats::elapsed_usecs(const HiResTime &start) {
+  HiResTime now;
+  int64_t usecs = ((int64_t)now.sec - (int64_t)start.sec) * 1000000LL
+      + ((int64_t)now.nsec - (int64_t)start.nsec) / 1000;
+  return usecs < 0 ? 0 : (uint64_t)usecs;
+}
@@ -0,0 +1,112 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_SERVERSTATS_H
+#define HYPERTABLE_SERVERSTATS_H
+
+#include <iosfwd>
+
+#include <boost/thread/mutex.hpp>
+
+#include "Common/atomic.h"
+#include "Common/LatencyHistogram.h"
+#include "Common/Time.h"
+
+namespace Hypertable {
+
+  /**
+   * Per-operation latency histograms and counters for the RangeServer.
+   * Each operation has its own mutex, held only long enough to bump a
+   * histogram bucket, so concurrent requests of different types never
+   * contend and requests of the same type contend only for a few
+   * instructions.  Block cache lookups are counted with atomics.
+   */
+  class ServerStats {
+  public:
+
+    enum Operation {
+      UPDATE,
+      CREATE_SCANNER,
+      FETCH_SCANBLOCK,
+      COMMIT_LOG_APPEND,
+      DFS_READ,
+      COMPACTION,
+      OPERATION_MAX
+    };
+
+    ServerStats();
+
+    /**
+     * Records one completed operation.
+     *
+     * @param op operation type
+     * @param usecs elapsed time in microseconds
+     * @param bytes number of bytes processed by the operation
+     */
+    void record(Operation op, uint64_t usecs, uint64_t bytes=0);
+
+    void block_cache_hit() { atomic_inc(&m_block_cache_hits); }
+    void block_cache_miss() { atomic_inc(&m_block_cache_misses); }
+
+    /**
+     * Writes one line per operation (count, latency percentiles and
+     * bytes) followed by the block cache hit rate.
+     */
+    void dump(std::ostream &out);
+
+    static const char *operation_text(int op);
+
+    /** Returns the number of microseconds elapsed since start */
+    static uint64_t elapsed_usecs(const HiResTime &start);
+
+    /**
+     * Records the lifetime of the object as one operation.
+     */
+    class Timer {
+    public:
+      Timer(ServerStats &stats, Operation op)
+        : m_stats(stats), m_op(op), m_bytes(0) { }
+      ~Timer() { m_stats.record(m_op, elapsed_usecs(m_start), m_bytes); }
+      void add_bytes(uint64_t bytes) { m_bytes += bytes; }
+    private:
+      ServerStats &m_stats;
+      Operation    m_op;
+      uint64_t     m_bytes;
+      HiResTime    m_start;
+    };
+
+  private:
+
+    struct OperationStats {
+      OperationStats() : bytes(0) { }
+      boost::mutex     mutex;
+      LatencyHistogram histogram;
+      uint64_t         bytes;
+    };
+
+    OperationStats m_ops[OPERATION_MAX];
+    atomic_t       m_block_cache_hits;
+    atomic_t       m_block_cache_misses;
+  };
+
+}
+
+#endif // HYPERTABLE_SERVERSTATS_H
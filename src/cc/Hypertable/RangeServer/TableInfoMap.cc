@@ -20,8 +20,6 @@
  */
 
 #include "Common/Compat.h"
-#include "Global.h"
-#include "MaintenanceTaskSplit.h"
 #include "TableInfoMap.h"
 
 using namespace Hypertable;
@@ -91,27 +89,12 @@ void TableInfoMap::merge(TableInfoMapPtr &table_info_map_ptr) {
     to_iter = m_map.find( (*from_iter).first );
 
     range_vec.clear();
-    if (to_iter == m_map.end()) {
+    if (to_iter == m_map.end())
       m_map[ (*from_iter).first ] = (*from_iter).second;
-      (*from_iter).second->get_range_vector(range_vec);
-      for (size_t i=0; i<range_vec.size(); i++) {
-	if (range_vec[i]->get_state() == RangeState::SPLIT_LOG_INSTALLED ||
-	    range_vec[i]->get_state() == RangeState::SPLIT_SHRUNK) {
-          if (!range_vec[i]->test_and_set_maintenance())
-	    Global::maintenance_queue->add(new MaintenanceTaskSplit(range_vec[i]));
-	}
-      }
-    }
     else {
       (*from_iter).second->get_range_vector(range_vec);
-      for (size_t i=0; i<range_vec.size(); i++) {
+      for (size_t i=0; i<range_vec.size(); i++)
 	(*to_iter).second->add_range(range_vec[i]);
-	if (range_vec[i]->get_state() == RangeState::SPLIT_LOG_INSTALLED ||
-	    range_vec[i]->get_state() == RangeState::SPLIT_SHRUNK) {
-          if (!range_vec[i]->test_and_set_maintenance())
-	    Global::maintenance_queue->add(new MaintenanceTaskSplit(range_vec[i]));
-	}
-      }
     }
 
   }
@@ -120,6 +103,53 @@ void TableInfoMap::merge(TableInfoMapPtr &table_info_map_ptr) {
 }
 
 
+/**
+ * Moves a single range out of the table info of a replay map and into
+ * this map, so that it can be served before the rest of the replay map
+ * has been merged.
+ */
+void TableInfoMap::merge_range(TableInfoPtr &table_info_ptr, RangePtr &range_ptr) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  InfoMap::iterator iter = m_map.find(table_info_ptr->get_id());
+  RangeSpec range_spec;
+  RangePtr removed_range;
+  String start_row = range_ptr->start_row();
+  String end_row = range_ptr->end_row();
+
+  range_spec.start_row = start_row.c_str();
+  range_spec.end_row = end_row.c_str();
+  table_info_ptr->remove_range(&range_spec, removed_range);
+
+  if (iter == m_map.end()) {
+    TableInfoPtr new_info = table_info_ptr->create_shallow_copy();
+    m_map[table_info_ptr->get_id()] = new_info;
+    new_info->add_range(range_ptr);
+  }
+  else
+    (*iter).second->add_range(range_ptr);
+}
+
+
+/**
+ * Collects the ranges whose split was interrupted.  Finishing a split
+ * writes to the range transaction log and the commit logs, so recovery
+ * queues these splits only once it has created those logs.
+ */
+void TableInfoMap::get_split_ranges(std::vector<RangePtr> &split_ranges) {
+  boost::mutex::scoped_lock lock(m_mutex);
+  std::vector<RangePtr> range_vec;
+
+  for (InfoMap::iterator iter = m_map.begin(); iter != m_map.end(); iter++) {
+    range_vec.clear();
+    (*iter).second->get_range_vector(range_vec);
+    for (size_t i=0; i<range_vec.size(); i++) {
+      if (range_vec[i]->get_state() == RangeState::SPLIT_LOG_INSTALLED ||
+          range_vec[i]->get_state() == RangeState::SPLIT_SHRUNK)
+        split_ranges.push_back(range_vec[i]);
+    }
+  }
+}
+
 
 void TableInfoMap::dump() {
   InfoMap::iterator table_iter;
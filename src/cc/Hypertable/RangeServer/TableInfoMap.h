@@ -54,6 +54,8 @@ namespace Hypertable {
     bool empty() { return m_map.empty(); }
 
     void merge(TableInfoMapPtr &table_info_map_ptr);
+    void merge_range(TableInfoPtr &table_info_ptr, RangePtr &range_ptr);
+    void get_split_ranges(std::vector<RangePtr> &split_ranges);
 
     void dump();
 
@@ -0,0 +1,478 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <poll.h>
+#include <unistd.h>
+}
+
+#include "AsyncComm/Comm.h"
+#include "AsyncComm/ConnectionManager.h"
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+#include "Common/ParallelSort.h"
+#include "Common/Properties.h"
+#include "Common/Stopwatch.h"
+#include "Common/Sweetener.h"
+#include "Common/System.h"
+#include "Common/Time.h"
+#include "Common/Timer.h"
+#include "Common/Usage.h"
+
+#include "DfsBroker/Lib/Client.h"
+
+#include "Hypertable/Lib/Client.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/KeySpec.h"
+#include "Hypertable/Lib/LoadDataSource.h"
+#include "Hypertable/Lib/LocationCache.h"
+#include "Hypertable/Lib/RangeServerClient.h"
+
+#include "BlockCompressionQueue.h"
+#include "CellStoreV0.h"
+#include "Global.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const uint32_t DEFAULT_BLOCKSIZE = 65536;
+  const size_t DEFAULT_CHUNK_SIZE = 1000000000;
+  const int DEFAULT_TIMEOUT = 180;
+  const int MAX_ATTEMPTS = 10;
+
+  const char *usage[] = {
+    "usage: csimport [OPTIONS] <table> <input-file>",
+    "",
+    "OPTIONS:",
+    "  --config=<file>          Read configuration from <file>.  The default config",
+    "                           file is \"conf/hypertable.cfg\" relative to the",
+    "                           toplevel install directory",
+    "  --chunk-size=<n>         Sort and import the input <n> bytes at a time",
+    "                           (default 1000000000)",
+    "  --staging-dir=<dir>      DFS directory to write CellStores into before they",
+    "                           are handed to the RangeServers (default",
+    "                           /hypertable/import)",
+    "  --sort-threads=<n>       Number of threads used to sort a chunk",
+    "  --compression-threads=<n> Number of threads used to compress blocks",
+    "  --timeout=<secs>         Timeout for each range lookup and import request",
+    "  --verbose,-v             Report each range as it is imported",
+    "  --help                   Display this help text and exit",
+    "",
+    "Bulk loads <input-file>, in the format accepted by LOAD DATA INFILE, into",
+    "<table> without going through the RangeServer write path.  Each chunk of",
+    "input is sorted, split along the table's current range boundaries and",
+    "written as one CellStore per range and access group.  The CellStores are",
+    "then attached to their ranges with an 'import cell stores' request, which",
+    "moves them into the table directory and records them in METADATA.",
+    "Nothing is written to the commit log.  Cells without a timestamp are",
+    "given one from the local clock.",
+    0
+  };
+
+  struct ImportEntry {
+    uint64_t key_offset;
+    uint64_t value_offset;
+    uint32_t ag;
+  };
+
+  struct LtImportEntry {
+    LtImportEntry(const uint8_t *b) : base(b) { }
+    bool operator()(const ImportEntry &e1, const ImportEntry &e2) const {
+      return ByteString(base + e1.key_offset) < ByteString(base + e2.key_offset);
+    }
+    const uint8_t *base;
+  };
+
+  /**
+   * Accumulates a chunk of cells, then sorts it and imports it range by
+   * range.
+   */
+  class CellStoreImporter {
+  public:
+    CellStoreImporter(TablePtr &table_ptr, Filesystem *dfs,
+                      const String &staging_dir, size_t sort_threads,
+                      int timeout, bool verbose)
+      : m_table_ptr(table_ptr), m_dfs(dfs), m_staging_dir(staging_dir),
+        m_sort_threads(sort_threads), m_timeout(timeout), m_verbose(verbose),
+        m_range_server(Comm::instance(), timeout), m_kvbuf(0),
+        m_last_timestamp(0), m_next_file(0), m_cells(0), m_ranges(0),
+        m_files(0) {
+      Schema::AccessGroup *ag;
+
+      m_table_ptr->get_identifier(&m_table);
+      m_table_ptr->get_schema(m_schema_ptr);
+      m_table_ptr->get_range_locator(m_range_locator_ptr);
+
+      std::list<Schema::AccessGroup *> *ag_list =
+          m_schema_ptr->get_access_group_list();
+      m_cf_to_ag.resize(m_schema_ptr->get_max_column_family_id() + 1, 0);
+      for (std::list<Schema::AccessGroup *>::iterator iter = ag_list->begin();
+           iter != ag_list->end(); ++iter) {
+        ag = *iter;
+        for (std::list<Schema::ColumnFamily *>::iterator cf_iter =
+             ag->columns.begin(); cf_iter != ag->columns.end(); ++cf_iter)
+          m_cf_to_ag[(*cf_iter)->id] = m_access_groups.size();
+        m_access_groups.push_back(ag);
+      }
+
+      m_staging_dir += format("/%s", m_table.name);
+      m_dfs->mkdirs(m_staging_dir);
+    }
+
+    void add(uint64_t timestamp, KeySpec &key, const void *value,
+             uint32_t value_len) {
+      Schema::ColumnFamily *cf;
+      ImportEntry entry;
+
+      if ((cf = m_schema_ptr->get_column_family(key.column_family)) == 0)
+        HT_THROWF(Error::BAD_KEY, "Bad column family '%s'",
+                  key.column_family);
+
+      if (timestamp == 0) {
+        if (m_last_timestamp == 0)
+          m_last_timestamp = get_ts64();
+        timestamp = ++m_last_timestamp;
+      }
+
+      entry.ag = m_cf_to_ag[cf->id];
+      entry.key_offset = m_kvbuf.fill();
+      create_key_and_append(m_kvbuf, FLAG_INSERT, (const char *)key.row,
+                            (uint8_t)cf->id,
+                            (const char *)key.column_qualifier, timestamp);
+      entry.value_offset = m_kvbuf.fill();
+      append_as_byte_string(m_kvbuf, value, value_len);
+      m_entries.push_back(entry);
+    }
+
+    size_t memory_used() { return m_kvbuf.fill(); }
+
+    void import_chunk();
+
+    void report(ostream &out, double elapsed) {
+      out << "Imported " << m_cells << " cells into " << m_ranges
+          << " range(s) as " << m_files << " cell store(s) in " << elapsed
+          << " s" << endl;
+    }
+
+  private:
+    const char *row(size_t i) {
+      return ByteString(m_kvbuf.base + m_entries[i].key_offset).str();
+    }
+
+    size_t write_range(size_t begin, const RangeLocationInfo &range_info,
+                       std::vector<String> &ags, std::vector<String> &files,
+                       int64_t *max_timestamp);
+
+    void remove_files(const std::vector<String> &files) {
+      foreach(const String &fname, files) {
+        try { m_dfs->remove(fname); }
+        catch (Exception &e) {
+          HT_WARNF("Unable to remove '%s' - %s", fname.c_str(), e.what());
+        }
+      }
+    }
+
+    TablePtr          m_table_ptr;
+    TableIdentifier   m_table;
+    SchemaPtr         m_schema_ptr;
+    RangeLocatorPtr   m_range_locator_ptr;
+    Filesystem       *m_dfs;
+    String            m_staging_dir;
+    size_t            m_sort_threads;
+    int               m_timeout;
+    bool              m_verbose;
+    RangeServerClient m_range_server;
+    std::vector<Schema::AccessGroup *> m_access_groups;
+    std::vector<uint32_t> m_cf_to_ag;
+    DynamicBuffer     m_kvbuf;
+    std::vector<ImportEntry> m_entries;
+    uint64_t          m_last_timestamp;
+    uint32_t          m_next_file;
+    uint64_t          m_cells;
+    uint64_t          m_ranges;
+    uint64_t          m_files;
+  };
+
+
+  /**
+   * Writes the cells from begin up to the end of the range into one
+   * CellStore per access group.  Returns the index of the first cell past
+   * the range.
+   */
+  size_t CellStoreImporter::write_range(size_t begin,
+      const RangeLocationInfo &range_info, std::vector<String> &ags,
+      std::vector<String> &files, int64_t *max_timestamp) {
+    std::vector<CellStorePtr> stores(m_access_groups.size());
+    bool last_range = range_info.end_row == "" ||
+                      range_info.end_row == Key::END_ROW_MARKER;
+    Timestamp timestamp;
+    Key key_comps;
+    size_t i;
+    int error;
+
+    *max_timestamp = 0;
+
+    for (i=begin; i<m_entries.size(); i++) {
+      const ImportEntry &entry = m_entries[i];
+      ByteString key(m_kvbuf.base + entry.key_offset);
+      ByteString value(m_kvbuf.base + entry.value_offset);
+
+      if (!last_range && strcmp(key.str(), range_info.end_row.c_str()) > 0)
+        break;
+
+      if (!stores[entry.ag]) {
+        Schema::AccessGroup *ag = m_access_groups[entry.ag];
+        String fname = format("%s/%d-%u", m_staging_dir.c_str(),
+                              (int)getpid(), m_next_file++);
+        String compressor = (ag->compressor != "") ? ag->compressor
+                                                   : m_schema_ptr->get_compressor();
+        stores[entry.ag] = new CellStoreV0(m_dfs);
+        if ((error = stores[entry.ag]->create(fname.c_str(), ag->blocksize
+             ? ag->blocksize : DEFAULT_BLOCKSIZE, compressor)) != Error::OK)
+          HT_THROWF(error, "Problem creating cell store '%s'", fname.c_str());
+        ags.push_back(ag->name);
+        files.push_back(fname);
+      }
+
+      key_comps.load(key);
+      if (key_comps.timestamp > *max_timestamp)
+        *max_timestamp = key_comps.timestamp;
+
+      if (stores[entry.ag]->add(key, value, 0) != 0)
+        HT_THROWF(Error::EXTERNAL, "Problem adding to cell store for "
+                  "access group '%s'", m_access_groups[entry.ag]->name.c_str());
+    }
+
+    /**
+     * A zero timestamp keeps imported stores from moving the access group's
+     * compaction timestamp, which governs commit log replay.
+     */
+    for (size_t j=0; j<stores.size(); j++) {
+      if (stores[j] && stores[j]->finalize(timestamp) != 0)
+        HT_THROWF(Error::EXTERNAL, "Problem finalizing cell store for "
+                  "access group '%s'", m_access_groups[j]->name.c_str());
+    }
+
+    return i;
+  }
+
+
+  void CellStoreImporter::import_chunk() {
+    size_t pos = 0;
+    int attempts = 0;
+
+    parallel_stable_sort(m_entries.begin(), m_entries.end(),
+                         LtImportEntry(m_kvbuf.base), m_sort_threads);
+
+    while (pos < m_entries.size()) {
+      RangeLocationInfo range_info;
+      std::vector<String> ags, files;
+      int64_t max_timestamp;
+      struct sockaddr_in addr;
+      size_t end;
+
+      {
+        Timer timer(m_timeout, true);
+        m_range_locator_ptr->find_loop(&m_table, row(pos), &range_info, timer,
+                                       false);
+      }
+
+      if (!LocationCache::location_to_addr(range_info.location.c_str(), addr))
+        HT_THROW(Error::INVALID_METADATA, range_info.location);
+
+      // don't leave partially written stores behind in the staging directory
+      try {
+        end = write_range(pos, range_info, ags, files, &max_timestamp);
+      }
+      catch (Exception &e) {
+        remove_files(files);
+        throw;
+      }
+
+      try {
+        RangeSpec range(range_info.start_row.c_str(),
+                        range_info.end_row.c_str());
+        int wait_ms = 1000;
+
+        for (;;) {
+          try {
+            m_range_server.import_cell_stores(addr, m_table, range, ags, files,
+                                              max_timestamp);
+            break;
+          }
+          catch (Exception &e) {
+            if (e.code() != Error::RANGESERVER_RANGE_BUSY ||
+                ++attempts >= MAX_ATTEMPTS)
+              throw;
+            poll(0, 0, wait_ms);
+            wait_ms *= 2;
+          }
+        }
+      }
+      catch (Exception &e) {
+        remove_files(files);
+        if ((e.code() != Error::RANGESERVER_RANGE_NOT_FOUND &&
+             e.code() != Error::COMM_NOT_CONNECTED &&
+             e.code() != Error::COMM_BROKEN_CONNECTION) ||
+            ++attempts >= MAX_ATTEMPTS)
+          throw;
+        // the range moved or split since it was looked up, so re-partition
+        HT_WARNF("Import into %s[%s..%s] failed (%s), retrying", m_table.name,
+                 range_info.start_row.c_str(), range_info.end_row.c_str(),
+                 e.what());
+        m_range_locator_ptr->invalidate(&m_table, row(pos));
+        continue;
+      }
+
+      if (m_verbose)
+        cout << "Imported " << (end - pos) << " cells into " << m_table.name
+             << "[" << range_info.start_row << ".." << range_info.end_row
+             << "]" << endl;
+
+      m_cells += end - pos;
+      m_ranges++;
+      m_files += files.size();
+      attempts = 0;
+      pos = end;
+    }
+
+    m_entries.clear();
+    m_kvbuf.clear();
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  String cfgfile;
+  String table_name, input_file;
+  String staging_dir = "/hypertable/import";
+  size_t chunk_size = DEFAULT_CHUNK_SIZE;
+  int sort_threads = 0;
+  int compression_threads = -1;
+  int timeout = DEFAULT_TIMEOUT;
+  bool verbose = false;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--config=", 9))
+      cfgfile = &argv[i][9];
+    else if (!strncmp(argv[i], "--chunk-size=", 13))
+      chunk_size = strtoull(&argv[i][13], 0, 0);
+    else if (!strncmp(argv[i], "--staging-dir=", 14))
+      staging_dir = &argv[i][14];
+    else if (!strncmp(argv[i], "--sort-threads=", 15))
+      sort_threads = atoi(&argv[i][15]);
+    else if (!strncmp(argv[i], "--compression-threads=", 22))
+      compression_threads = atoi(&argv[i][22]);
+    else if (!strncmp(argv[i], "--timeout=", 10))
+      timeout = atoi(&argv[i][10]);
+    else if (!strcmp(argv[i], "--verbose") || !strcmp(argv[i], "-v"))
+      verbose = true;
+    else if (!strcmp(argv[i], "--help"))
+      Usage::dump_and_exit(usage);
+    else if (table_name == "")
+      table_name = argv[i];
+    else if (input_file == "")
+      input_file = argv[i];
+    else
+      Usage::dump_and_exit(usage);
+  }
+
+  if (input_file == "" || chunk_size == 0)
+    Usage::dump_and_exit(usage);
+
+  try {
+    ClientPtr client_ptr;
+    PropertiesPtr props_ptr;
+    ConnectionManagerPtr conn_mgr;
+    DfsBroker::Client *dfs;
+    TablePtr table_ptr;
+    Stopwatch stopwatch;
+    uint64_t timestamp;
+    KeySpec key;
+    uint8_t *value;
+    uint32_t value_len, consumed;
+
+    if (cfgfile == "") {
+      client_ptr = new Client(System::locate_install_dir(argv[0]));
+      cfgfile = System::install_dir + "/conf/hypertable.cfg";
+    }
+    else
+      client_ptr = new Client(System::locate_install_dir(argv[0]), cfgfile);
+    props_ptr = new Properties(cfgfile);
+
+    if (sort_threads <= 0)
+      sort_threads = System::get_processor_count();
+    if (compression_threads < 0)
+      compression_threads = System::get_processor_count();
+    if (compression_threads > 0)
+      Global::block_compression_queue =
+          new BlockCompressionQueue(compression_threads, compression_threads+1);
+
+    conn_mgr = new ConnectionManager();
+    dfs = new DfsBroker::Client(conn_mgr, props_ptr);
+    if (!dfs->wait_for_connection(15)) {
+      cerr << "error: timed out waiting for DFS broker" << endl;
+      return 1;
+    }
+
+    table_ptr = client_ptr->open_table(table_name);
+
+    CellStoreImporter importer(table_ptr, dfs, staging_dir, sort_threads,
+                               timeout, verbose);
+
+    std::vector<String> key_columns;
+    auto_ptr<LoadDataSource> lds(new LoadDataSource(input_file, "",
+                                 key_columns, ""));
+
+    while (lds->next(0, &timestamp, &key, &value, &value_len, &consumed)) {
+      // a missing value is skipped, but an empty one is a legitimate cell
+      if (value == 0)
+        continue;
+      importer.add(timestamp, key, value, value_len);
+      if (importer.memory_used() >= chunk_size)
+        importer.import_chunk();
+    }
+    importer.import_chunk();
+
+    stopwatch.stop();
+    importer.report(cout, stopwatch.elapsed());
+  }
+  catch (Exception &e) {
+    cerr << "error: " << Error::get_text(e.code()) << " - " << e.what()
+         << endl;
+    return 1;
+  }
+
+  return 0;
+}
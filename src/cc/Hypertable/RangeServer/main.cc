@@ -36,6 +36,7 @@ extern "C" {
 #include "Common/Logger.h"
 #include "Common/Properties.h"
 #include "Common/System.h"
+#include "Common/Trace.h"
 #include "Common/Usage.h"
 
 #include "AsyncComm/ApplicationQueue.h"
@@ -128,6 +129,8 @@ int main(int argc, char **argv) {
       props_ptr->set("Hypertable.RangeServer.CommitLog.DfsBroker.Port", portstr);
     }
 
+    Trace::initialize("rangeserver", props_ptr);
+
     reactor_count = props_ptr->get_int("Hypertable.RangeServer.Reactors", System::get_processor_count());
     ReactorFactory::initialize(reactor_count);
     Comm *comm = Comm::instance();
@@ -0,0 +1,224 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/FileUtils.h"
+#include "Common/Logger.h"
+#include "Common/Properties.h"
+#include "Common/System.h"
+
+#include "DfsBroker/Lib/LocalClient.h"
+
+#include "Hypertable/Lib/BlockCompressionCodec.h"
+#include "Hypertable/Lib/CompressorFactory.h"
+#include "Hypertable/Lib/Key.h"
+
+#include "Hypertable/RangeServer/BlockCompressionQueue.h"
+#include "Hypertable/RangeServer/CellStoreV0.h"
+#include "Hypertable/RangeServer/FileBlockCache.h"
+#include "Hypertable/RangeServer/Global.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  typedef vector<pair<ByteString, ByteString> > CellVec;
+
+  const uint32_t BLOCKSIZE = 4096;
+
+  const char TEST_BLOCK_MAGIC[10] = { 'T','e','s','t','-','-','-','-','-','-' };
+
+  /**
+   * Codec whose deflate always fails, standing in for a codec that runs
+   * out of memory or is handed a corrupt buffer on a worker thread.
+   */
+  class FailingCodec : public BlockCompressionCodec {
+  public:
+    virtual void deflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockCompressionHeader &header, size_t reserve=0) {
+      HT_THROW(Error::BLOCK_COMPRESSOR_DEFLATE_ERROR, "injected failure");
+    }
+    virtual void inflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockCompressionHeader &header) { }
+    virtual int get_type() { return NONE; }
+  };
+
+  void build_cells(DynamicBuffer &buf, CellVec &cells) {
+    vector<pair<size_t, size_t> > offsets;
+    char row[64], value[64];
+
+    for (int i=0; i<20000; i++) {
+      sprintf(row, "com.site%04d/page%06d", i / 100, i);
+      sprintf(value, "value %d of site %d", i, i / 100);
+      size_t key_offset = buf.fill();
+      create_key_and_append(buf, FLAG_INSERT, row, 1, "", (int64_t)(i + 1));
+      size_t value_offset = buf.fill();
+      append_as_byte_string(buf, value, strlen(value));
+      offsets.push_back(make_pair(key_offset, value_offset));
+    }
+
+    for (size_t i=0; i<offsets.size(); i++)
+      cells.push_back(make_pair(ByteString(buf.base + offsets[i].first),
+                                ByteString(buf.base + offsets[i].second)));
+  }
+
+  bool write_cellstore(Filesystem *fs, const String &fname, CellVec &cells) {
+    CellStoreV0Ptr cellstore = new CellStoreV0(fs);
+    Timestamp timestamp(cells.size(), 0);
+
+    if (cellstore->create(fname.c_str(), BLOCKSIZE, "zlib") != Error::OK)
+      return false;
+    for (size_t i=0; i<cells.size(); i++)
+      cellstore->add(cells[i].first, cells[i].second, 0);
+    return cellstore->finalize(timestamp) == Error::OK;
+  }
+
+  bool write_with_queue(Filesystem *fs, const String &fname, CellVec &cells,
+                        int worker_count, size_t window) {
+    BlockCompressionQueuePtr queue =
+        new BlockCompressionQueue(worker_count, window);
+    Global::block_compression_queue = queue.get();
+    bool written = write_cellstore(fs, fname, cells);
+    Global::block_compression_queue = 0;
+    queue->shutdown();
+    queue->join();
+    if (!written)
+      HT_ERRORF("Unable to write cellstore with %d compression workers",
+                worker_count);
+    return written;
+  }
+
+  /**
+   * Writes the same cells once with blocks compressed in the calling
+   * thread and once by four workers, using the same window; the files
+   * must match byte for byte.
+   */
+  bool test_identical_output(Filesystem *fs, const String &root,
+                             CellVec &cells) {
+    off_t sync_len, async_len;
+
+    if (!write_with_queue(fs, "/cs/sync", cells, 0, 6) ||
+        !write_with_queue(fs, "/cs/async", cells, 4, 6))
+      return false;
+
+    char *sync_buf = FileUtils::file_to_buffer(root + "/cs/sync", &sync_len);
+    char *async_buf = FileUtils::file_to_buffer(root + "/cs/async",
+                                                &async_len);
+    bool identical = sync_buf && async_buf && sync_len == async_len &&
+        memcmp(sync_buf, async_buf, sync_len) == 0;
+    delete [] sync_buf;
+    delete [] async_buf;
+
+    if (!identical)
+      HT_ERRORF("Cellstore written through compression queue (%llu bytes) "
+                "differs from synchronous one (%llu bytes)",
+                (Llu)async_len, (Llu)sync_len);
+    return identical;
+  }
+
+  /**
+   * A codec exception thrown on a worker must come back in the job, and
+   * must not affect the jobs around it.
+   */
+  bool test_error_propagation() {
+    BlockCompressionQueuePtr queue = new BlockCompressionQueue(2, 4);
+    vector<BlockCompressionQueue::Job *> jobs;
+    bool ok = true;
+
+    for (int i=0; i<8; i++) {
+      BlockCompressionQueue::Job *job =
+          new BlockCompressionQueue::Job(TEST_BLOCK_MAGIC);
+      if (i == 5)
+        job->codec = new FailingCodec();
+      else
+        job->codec = CompressorFactory::create_block_codec(
+            BlockCompressionCodec::ZLIB);
+      job->input.add("some data to compress", 21);
+      jobs.push_back(job);
+      queue->add(job);
+    }
+
+    for (size_t i=0; i<jobs.size(); i++) {
+      queue->wait_for(jobs[i]);
+      if (i == 5) {
+        if (jobs[i]->error != Error::BLOCK_COMPRESSOR_DEFLATE_ERROR ||
+            jobs[i]->error_msg.find("injected failure") == String::npos) {
+          HT_ERRORF("Worker error not propagated (error=%d, msg='%s')",
+                    jobs[i]->error, jobs[i]->error_msg.c_str());
+          ok = false;
+        }
+      }
+      else if (jobs[i]->error != Error::OK || jobs[i]->output.fill() == 0) {
+        HT_ERRORF("Job %u failed alongside the injected failure",
+                  (unsigned)i);
+        ok = false;
+      }
+      delete jobs[i];
+    }
+
+    queue->shutdown();
+    queue->join();
+    return ok;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  DynamicBuffer buf(0);
+  CellVec cells;
+  char root[64];
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  sprintf(root, "/tmp/BlockCompressionQueue_test-%d", (int)getpid());
+
+  PropertiesPtr props_ptr = new Properties();
+  props_ptr->set("DfsBroker.Local.Root", root);
+  DfsBroker::LocalClient *fs = new DfsBroker::LocalClient(props_ptr);
+
+  Global::block_cache = new FileBlockCache(20000000LL);
+
+  build_cells(buf, cells);
+
+  fs->mkdirs("/cs");
+
+  bool ok = test_identical_output(fs, root, cells) &&
+      test_error_propagation();
+
+  fs->rmdir("/cs");
+  ::rmdir(root);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/FileUtils.h"
+#include "Common/Logger.h"
+#include "Common/Properties.h"
+#include "Common/System.h"
+
+#include "DfsBroker/Lib/LocalClient.h"
+
+#include "Hypertable/Lib/BlockCompressionCodec.h"
+#include "Hypertable/Lib/Key.h"
+
+#include "Hypertable/RangeServer/CellStoreV0.h"
+#include "Hypertable/RangeServer/FileBlockCache.h"
+#include "Hypertable/RangeServer/Global.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  typedef vector<pair<ByteString, ByteString> > CellVec;
+
+  const char *words[] = { "the", "quick", "brown", "fox", "jumps", "over",
+                          "lazy", "dog", "page", "index", "www", "http" };
+
+  const uint32_t BLOCKSIZE = 4096;
+
+  /**
+   * Fills buf with sorted key/value pairs whose values are made of a small
+   * vocabulary, so that a dictionary trained on the first block applies to
+   * the rest.
+   */
+  void build_cells(DynamicBuffer &buf, CellVec &cells) {
+    vector<pair<size_t, size_t> > offsets;
+    char row[64];
+    String value;
+
+    for (int i=0; i<20000; i++) {
+      sprintf(row, "com.site%04d/page%06d", i / 100, i);
+      value.clear();
+      for (int j=0; j<12; j++) {
+        value += words[(i * 7 + j * 3) % (sizeof(words)/sizeof(char *))];
+        value += ' ';
+      }
+      size_t key_offset = buf.fill();
+      create_key_and_append(buf, FLAG_INSERT, row, 1, "", (int64_t)(i + 1));
+      size_t value_offset = buf.fill();
+      append_as_byte_string(buf, value.data(), value.length());
+      offsets.push_back(make_pair(key_offset, value_offset));
+    }
+
+    // the buffer may have moved while growing, so take pointers last
+    for (size_t i=0; i<offsets.size(); i++)
+      cells.push_back(make_pair(ByteString(buf.base + offsets[i].first),
+                                ByteString(buf.base + offsets[i].second)));
+  }
+
+  int write_cellstore(Filesystem *fs, const String &fname,
+                      const String &compressor, CellVec &cells) {
+    CellStoreV0Ptr cellstore = new CellStoreV0(fs);
+    Timestamp timestamp(cells.size(), 0);
+    int error;
+
+    if ((error = cellstore->create(fname.c_str(), BLOCKSIZE, compressor))
+        != Error::OK)
+      return error;
+    for (size_t i=0; i<cells.size(); i++)
+      cellstore->add(cells[i].first, cells[i].second, 0);
+    return cellstore->finalize(timestamp);
+  }
+
+  /**
+   * Reads a cellstore back and checks that it holds exactly cells and was
+   * compressed with the expected codec.
+   */
+  bool read_back(Filesystem *fs, const String &fname, const String &label,
+                 CellVec &cells, int expected_type) {
+    ByteString key, value;
+    size_t i = 0;
+
+    CellStoreV0Ptr cellstore = new CellStoreV0(fs);
+    if (cellstore->open(fname.c_str(), 0, 0) != 0 ||
+        cellstore->load_index() != 0) {
+      HT_ERRORF("Unable to open cellstore written with %s", label.c_str());
+      return false;
+    }
+
+    CellStoreTrailerV0 *trailer =
+        dynamic_cast<CellStoreTrailerV0 *>(cellstore->get_trailer());
+    if (trailer->compression_type != expected_type) {
+      HT_ERRORF("Cellstore written with %s uses codec %d, expected %d",
+                label.c_str(), (int)trailer->compression_type,
+                expected_type);
+      return false;
+    }
+
+    ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME);
+    CellListScanner *scanner = cellstore->create_scanner(scan_ctx);
+    for (; scanner->get(key, value); scanner->forward(), i++) {
+      if (i == cells.size() || key != cells[i].first ||
+          value != cells[i].second) {
+        HT_ERRORF("Cell %u read back wrong with %s", (unsigned)i,
+                  label.c_str());
+        delete scanner;
+        return false;
+      }
+    }
+    delete scanner;
+
+    if (i != cells.size()) {
+      HT_ERRORF("Read back %u of %u cells with %s", (unsigned)i,
+                (unsigned)cells.size(), label.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Writes cells with the given compressor spec, reads them back and
+   * checks that every key and value survived the trip.
+   */
+  bool round_trip(Filesystem *fs, const String &fname,
+                  const String &compressor, CellVec &cells,
+                  int expected_type) {
+    if (write_cellstore(fs, fname, compressor, cells) != Error::OK) {
+      HT_ERRORF("Unable to write cellstore with compressor '%s'",
+                compressor.c_str());
+      return false;
+    }
+    return read_back(fs, fname, "compressor '" + compressor + "'", cells,
+                     expected_type);
+  }
+
+  bool rejected(Filesystem *fs, const String &fname,
+                const String &compressor) {
+    CellStoreV0Ptr cellstore = new CellStoreV0(fs);
+    if (cellstore->create(fname.c_str(), BLOCKSIZE, compressor)
+        == Error::OK) {
+      HT_ERRORF("Compressor spec '%s' was accepted", compressor.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Writes cells [begin, end), whose timestamps are their index plus one,
+   * and checks the timestamp range recorded for them: a scan starting
+   * after the newest cell may skip the store, one starting at it may not.
+   */
+  bool check_timestamp_range(Filesystem *fs, const String &fname,
+                             CellVec &cells, size_t begin, size_t end) {
+    CellVec range_cells(cells.begin() + begin, cells.begin() + end);
+    int64_t min_timestamp, max_timestamp;
+
+    if (write_cellstore(fs, fname, "zlib", range_cells) != Error::OK) {
+      HT_ERRORF("Unable to write cellstore '%s'", fname.c_str());
+      return false;
+    }
+
+    CellStoreV0Ptr cellstore = new CellStoreV0(fs);
+    if (cellstore->open(fname.c_str(), 0, 0) != 0 ||
+        !cellstore->get_timestamp_range(&min_timestamp, &max_timestamp)) {
+      HT_ERRORF("No timestamp range recorded in cellstore '%s'",
+                fname.c_str());
+      return false;
+    }
+    if (min_timestamp != (int64_t)begin + 1 || max_timestamp != (int64_t)end) {
+      HT_ERRORF("Cellstore '%s' records timestamps %lld..%lld, expected "
+                "%lld..%lld", fname.c_str(), (long long)min_timestamp,
+                (long long)max_timestamp, (long long)begin + 1,
+                (long long)end);
+      return false;
+    }
+    if (!cellstore->older_than(end + 1) || cellstore->older_than(end) ||
+        cellstore->older_than(begin + 1)) {
+      HT_ERRORF("Wrong pruning decision for cellstore '%s'", fname.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Rewrites the trailer of a cellstore in an older format, as if the file
+   * had been written before that format was replaced.
+   */
+  bool downgrade_trailer(const String &path, CellStoreTrailerV0 trailer,
+                         uint16_t version) {
+    uint8_t buf[CellStoreTrailerV0::MAX_SIZE];
+    off_t len = FileUtils::length(path);
+    bool written;
+    int fd;
+
+    trailer.version = version;
+    trailer.serialize(buf);
+
+    if (::truncate(path.c_str(), len - CellStoreTrailerV0::MAX_SIZE) != 0 ||
+        (fd = ::open(path.c_str(), O_WRONLY|O_APPEND)) < 0)
+      return false;
+    written = FileUtils::write(fd, buf, trailer.size()) ==
+        (ssize_t)trailer.size();
+    ::close(fd);
+    return written;
+  }
+
+  /**
+   * Cellstores written with version 0 and 1 trailers don't record their
+   * timestamp range; they must still read back and never be skipped.
+   */
+  bool check_old_trailer(Filesystem *fs, const String &root,
+                         const String &fname, const String &compressor,
+                         uint16_t version, CellVec &cells) {
+    int64_t min_timestamp, max_timestamp;
+    String label = format("version %d trailer", (int)version);
+
+    if (write_cellstore(fs, fname, compressor, cells) != Error::OK) {
+      HT_ERRORF("Unable to write cellstore with compressor '%s'",
+                compressor.c_str());
+      return false;
+    }
+
+    CellStoreV0Ptr cellstore = new CellStoreV0(fs);
+    if (cellstore->open(fname.c_str(), 0, 0) != 0) {
+      HT_ERRORF("Unable to open cellstore written with compressor '%s'",
+                compressor.c_str());
+      return false;
+    }
+    CellStoreTrailerV0 trailer =
+        *dynamic_cast<CellStoreTrailerV0 *>(cellstore->get_trailer());
+    if (!downgrade_trailer(root + fname, trailer, version)) {
+      HT_ERRORF("Unable to rewrite cellstore with %s", label.c_str());
+      return false;
+    }
+    if (!read_back(fs, fname, label, cells, trailer.compression_type))
+      return false;
+
+    cellstore = new CellStoreV0(fs);
+    if (cellstore->open(fname.c_str(), 0, 0) != 0 ||
+        dynamic_cast<CellStoreTrailerV0 *>(cellstore->get_trailer())->version
+        != version) {
+      HT_ERRORF("Unable to reopen cellstore with %s", label.c_str());
+      return false;
+    }
+    if (cellstore->get_timestamp_range(&min_timestamp, &max_timestamp) ||
+        cellstore->older_than(END_OF_TIME)) {
+      HT_ERRORF("Cellstore with %s may be skipped by scans", label.c_str());
+      return false;
+    }
+    return true;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  DynamicBuffer buf(0);
+  CellVec cells;
+  char root[64];
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  sprintf(root, "/tmp/CellStoreV0_test-%d", (int)getpid());
+
+  PropertiesPtr props_ptr = new Properties();
+  props_ptr->set("DfsBroker.Local.Root", root);
+  DfsBroker::LocalClient *fs = new DfsBroker::LocalClient(props_ptr);
+
+  Global::block_cache = new FileBlockCache(20000000LL);
+
+  build_cells(buf, cells);
+
+  fs->mkdirs("/cs");
+
+  bool ok =
+      // dictionary with a fixed codec
+      round_trip(fs, "/cs/zlib", "zlib --dictionary", cells,
+                 BlockCompressionCodec::ZLIB) &&
+      // zlib beats lzo on this data, so auto must switch to it and keep
+      // its arguments and the dictionary
+      round_trip(fs, "/cs/auto", "auto --dictionary=2048 lzo zlib -9", cells,
+                 BlockCompressionCodec::ZLIB) &&
+      rejected(fs, "/cs/bad", "lzo --dictionary") &&
+      rejected(fs, "/cs/bad", "auto --dictionary lzo quicklz") &&
+      rejected(fs, "/cs/bad", "auto -9 zlib") &&
+      rejected(fs, "/cs/bad", "auto lzo bogus") &&
+      // two stores covering disjoint time ranges
+      check_timestamp_range(fs, "/cs/older", cells, 0, 10000) &&
+      check_timestamp_range(fs, "/cs/newer", cells, 10000, cells.size()) &&
+      check_old_trailer(fs, root, "/cs/v0", "zlib", 0, cells) &&
+      check_old_trailer(fs, root, "/cs/v1", "zlib --dictionary", 1, cells);
+
+  fs->rmdir("/cs");
+  ::rmdir(root);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,402 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+#include "Common/Properties.h"
+#include "Common/System.h"
+
+#include "DfsBroker/Lib/LocalClient.h"
+
+#include "Hypertable/Lib/CounterValue.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/Schema.h"
+
+#include "Hypertable/RangeServer/CellCache.h"
+#include "Hypertable/RangeServer/CellStoreV0.h"
+#include "Hypertable/RangeServer/FileBlockCache.h"
+#include "Hypertable/RangeServer/Global.h"
+#include "Hypertable/RangeServer/MergeScanner.h"
+#include "Hypertable/RangeServer/ScanContext.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+    "<Schema>\n"
+    "  <AccessGroup name=\"default\">\n"
+    "    <ColumnFamily>\n"
+    "      <Name>hits</Name>\n"
+    "      <Counter>true</Counter>\n"
+    "    </ColumnFamily>\n"
+    "    <ColumnFamily>\n"
+    "      <Name>plain</Name>\n"
+    "    </ColumnFamily>\n"
+    "  </AccessGroup>\n"
+    "</Schema>\n";
+
+  const uint8_t HITS = 1;
+
+  // small enough to put every cell in a block of its own
+  const uint32_t BLOCKSIZE = 1;
+
+  struct TestCell {
+    const char *row;
+    uint8_t family;
+    uint8_t flag;
+    int64_t timestamp;
+    const char *value;
+  };
+
+  struct CounterInput {
+    const char *str;
+    bool valid;
+    int64_t value;
+  };
+
+  CounterInput counter_inputs[] = {
+    { "0", true, 0 },
+    { "42", true, 42 },
+    { "+7", true, 7 },
+    { "-12", true, -12 },
+    { "9223372036854775807", true, 9223372036854775807LL },
+    { "-9223372036854775808", true, (-9223372036854775807LL - 1) },
+    { "", false, 0 },
+    { "-", false, 0 },
+    { "abc", false, 0 },
+    { "12abc", false, 0 },
+    { " 12", false, 0 },
+    { "1.5", false, 0 },
+    { "1e3", false, 0 },
+    { "12345678901234567890", false, 0 },
+    { 0, false, 0 }
+  };
+
+  /**
+   * Deltas in the older of the two stores.  The malformed delta can only
+   * get there by bypassing TableMutator, and must count as zero.
+   */
+  TestCell store1_cells[] = {
+    { "a", HITS, FLAG_INSERT, 1, "5" },
+    { "a", HITS, FLAG_INSERT, 2, "3" },
+    { "b", HITS, FLAG_INSERT, 1, "abc" },
+    { "b", HITS, FLAG_INSERT, 2, "2" },
+    { "d", HITS, FLAG_INSERT, 1, "5" },
+    { "d", HITS, FLAG_INSERT, 2, "3" },
+    { "e", HITS, FLAG_INSERT, 1, "4" },
+    { 0, 0, 0, 0, 0 }
+  };
+
+  TestCell store2_cells[] = {
+    { "a", HITS, FLAG_INSERT, 3, "7" },
+    { "c", HITS, FLAG_INSERT, 3, "-1" },
+    { "f", HITS, FLAG_INSERT, 3, "9" },
+    { 0, 0, 0, 0, 0 }
+  };
+
+  /**
+   * Updates still in the cell cache, including deletes that reset the
+   * counters of rows d and e.
+   */
+  TestCell cache_cells[] = {
+    { "a", HITS, FLAG_INSERT, 4, "10" },
+    { "a", HITS, FLAG_INSERT, 5, "-4" },
+    { "a", 2, FLAG_INSERT, 4, "hello" },
+    { "b", HITS, FLAG_INSERT, 4, "1" },
+    { "d", HITS, FLAG_DELETE_CELL, 3, "" },
+    { "d", HITS, FLAG_INSERT, 4, "7" },
+    { "d", HITS, FLAG_INSERT, 5, "1" },
+    { "e", 0, FLAG_DELETE_ROW, 3, "" },
+    { "e", HITS, FLAG_INSERT, 4, "2" },
+    { 0, 0, 0, 0, 0 }
+  };
+
+  /**
+   * Each counter reads back as the sum of its deltas under the newest
+   * key, and a delete discards every delta older than it.
+   */
+  const char *scan_expected[] = {
+    "a:1 21@5",
+    "a:2 hello@4",
+    "b:1 3@4",
+    "c:1 -1@3",
+    "d:1 8@5",
+    "e:1 2@4",
+    "f:1 9@3",
+    0
+  };
+
+  /**
+   * A minor compaction keeps the deletes, so the counters they apply to
+   * are written out unfolded.
+   */
+  const char *minor_expected[] = {
+    "a:1 21@5",
+    "a:2 hello@4",
+    "b:1 3@4",
+    "c:1 -1@3",
+    "d:1 delete@3",
+    "d:1 1@5",
+    "d:1 7@4",
+    "d:1 3@2",
+    "d:1 5@1",
+    "e:0 delete@3",
+    "e:1 2@4",
+    "e:1 4@1",
+    "f:1 9@3",
+    0
+  };
+
+  void load_cache(CellCachePtr &cache, TestCell *cells, bool combine) {
+    DynamicBuffer buf(0);
+
+    cache->lock();
+    for (; cells->row; cells++) {
+      buf.clear();
+      create_key_and_append(buf, cells->flag, cells->row, cells->family, "",
+                            cells->timestamp);
+      size_t value_offset = buf.fill();
+      append_as_byte_string(buf, cells->value, strlen(cells->value));
+      ByteString key(buf.base), value(buf.base + value_offset);
+      if (combine && cells->flag == FLAG_INSERT && cells->family == HITS)
+        cache->add_counter(key, value, 0);
+      else
+        cache->add(key, value, 0);
+    }
+    cache->unlock();
+  }
+
+  /**
+   * Writes cells to a CellStore, sorting them through a CellCache first,
+   * and opens it for reading.
+   */
+  CellStoreV0Ptr write_store(Filesystem *fs, const char *fname,
+                             SchemaPtr &schema_ptr, TestCell *cells) {
+    ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME, schema_ptr);
+    CellStoreV0Ptr cellstore = new CellStoreV0(fs);
+    CellCachePtr cache = new CellCache();
+    Timestamp timestamp(10, 0);
+    ByteString key, value;
+
+    load_cache(cache, cells, false);
+
+    if (cellstore->create(fname, BLOCKSIZE, "none") != Error::OK)
+      return 0;
+    CellListScanner *scanner = cache->create_scanner(scan_ctx);
+    for (; scanner->get(key, value); scanner->forward())
+      cellstore->add(key, value, 0);
+    delete scanner;
+    if (cellstore->finalize(timestamp) != Error::OK)
+      return 0;
+
+    cellstore = new CellStoreV0(fs);
+    if (cellstore->open(fname, 0, 0) != 0 || cellstore->load_index() != 0)
+      return 0;
+    return cellstore;
+  }
+
+  /**
+   * Runs the merge scanner to completion and compares its output, in
+   * order, against expected.  If copy is given, the merged cells are
+   * also added to it.
+   */
+  bool check_merge(const char *what, MergeScanner *mscanner,
+                   const char **expected, CellCache *copy=0) {
+    ByteString bskey, value;
+    Key key;
+    const uint8_t *ptr;
+    char cell[128];
+    bool ok = true;
+
+    for (; mscanner->get(bskey, value); mscanner->forward(), expected++) {
+      key.load(bskey);
+      if (key.flag == FLAG_INSERT) {
+        size_t len = value.decode_length(&ptr);
+        sprintf(cell, "%s:%d %.*s@%lld", key.row, (int)key.column_family_code,
+                (int)len, (const char *)ptr, (long long)key.timestamp);
+      }
+      else
+        sprintf(cell, "%s:%d delete@%lld", key.row,
+                (int)key.column_family_code, (long long)key.timestamp);
+      if (*expected == 0 || strcmp(cell, *expected)) {
+        HT_ERRORF("%s produced '%s', expected '%s'", what, cell,
+                  *expected ? *expected : "nothing");
+        ok = false;
+        break;
+      }
+      if (copy)
+        copy->add(bskey, value, 0);
+    }
+
+    if (ok && *expected) {
+      HT_ERRORF("%s dropped '%s'", what, *expected);
+      ok = false;
+    }
+
+    delete mscanner;
+    return ok;
+  }
+
+  /**
+   * Checks that the parser TableMutator uses to reject counter updates
+   * accepts exactly the signed 64-bit decimal integers.
+   */
+  bool test_decode() {
+    int64_t value;
+    bool ok = true;
+
+    for (CounterInput *input = counter_inputs; input->str; input++) {
+      bool valid = decode_counter((const uint8_t *)input->str,
+                                  strlen(input->str), &value);
+      if (valid != input->valid || (valid && value != input->value)) {
+        HT_ERRORF("Counter value '%s' decoded wrong", input->str);
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
+  /**
+   * Deltas for the same cell are combined in the cache, except while a
+   * scanner is open on it.
+   */
+  bool test_cache_combining(SchemaPtr &schema_ptr) {
+    ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME, schema_ptr);
+    CellCachePtr cache = new CellCache();
+    TestCell first[] = {
+      { "a", HITS, FLAG_INSERT, 1, "10" },
+      { "a", HITS, FLAG_INSERT, 2, "-4" },
+      { 0, 0, 0, 0, 0 }
+    };
+    TestCell second[] = {
+      { "a", HITS, FLAG_INSERT, 3, "1" },
+      { 0, 0, 0, 0, 0 }
+    };
+    ByteString key, value;
+
+    load_cache(cache, first, true);
+    if (cache->size() != 1) {
+      HT_ERRORF("Cache holds %u entries after two deltas, expected 1",
+                (unsigned)cache->size());
+      return false;
+    }
+    CellListScanner *scanner = cache->create_scanner(scan_ctx);
+    scanner->get(key, value);
+    if (decode_counter(value) != 6) {
+      HT_ERRORF("Combined delta is %lld, expected 6",
+                (long long)decode_counter(value));
+      delete scanner;
+      return false;
+    }
+
+    load_cache(cache, second, true);
+    delete scanner;
+    if (cache->size() != 2) {
+      HT_ERRORF("Cache holds %u entries after a delta added while scanning, "
+                "expected 2", (unsigned)cache->size());
+      return false;
+    }
+    return true;
+  }
+
+  bool test_folding(Filesystem *fs, SchemaPtr &schema_ptr) {
+    CellStoreV0Ptr store1 = write_store(fs, "/cs/store1", schema_ptr,
+                                        store1_cells);
+    CellStoreV0Ptr store2 = write_store(fs, "/cs/store2", schema_ptr,
+                                        store2_cells);
+    if (!store1 || !store2) {
+      HT_ERROR("Unable to write counter cellstores");
+      return false;
+    }
+
+    CellCachePtr cache = new CellCache();
+    load_cache(cache, cache_cells, true);
+
+    ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME, schema_ptr);
+    MergeScanner *mscanner = new MergeScanner(scan_ctx, false);
+    mscanner->add_scanner(cache->create_scanner(scan_ctx));
+    mscanner->add_scanner(store2->create_scanner(scan_ctx));
+    mscanner->add_scanner(store1->create_scanner(scan_ctx));
+    if (!check_merge("scan", mscanner, scan_expected))
+      return false;
+
+    // the output of a minor compaction must read back the same
+    CellCachePtr compacted = new CellCache();
+    mscanner = new MergeScanner(scan_ctx, true);
+    mscanner->add_scanner(cache->create_scanner(scan_ctx));
+    mscanner->add_scanner(store2->create_scanner(scan_ctx));
+    mscanner->add_scanner(store1->create_scanner(scan_ctx));
+    if (!check_merge("minor compaction", mscanner, minor_expected,
+                     compacted.get()))
+      return false;
+
+    mscanner = new MergeScanner(scan_ctx, false);
+    mscanner->add_scanner(compacted->create_scanner(scan_ctx));
+    return check_merge("scan after minor compaction", mscanner,
+                       scan_expected);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  char root[64];
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  SchemaPtr schema_ptr = Schema::new_instance(schema_str, strlen(schema_str));
+  if (!schema_ptr->is_valid()) {
+    HT_ERRORF("Schema parse error - %s", schema_ptr->get_error_string());
+    return 1;
+  }
+  schema_ptr->assign_ids();
+
+  sprintf(root, "/tmp/Counter_test-%d", (int)getpid());
+
+  PropertiesPtr props_ptr = new Properties();
+  props_ptr->set("DfsBroker.Local.Root", root);
+  DfsBroker::LocalClient *fs = new DfsBroker::LocalClient(props_ptr);
+
+  Global::block_cache = new FileBlockCache(20000000LL);
+
+  fs->mkdirs("/cs");
+
+  bool ok = test_decode() &&
+      test_cache_combining(schema_ptr) &&
+      test_folding(fs, schema_ptr);
+
+  fs->rmdir("/cs");
+  ::rmdir(root);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 2 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+#include "Common/Properties.h"
+#include "Common/System.h"
+
+#include "DfsBroker/Lib/LocalClient.h"
+
+#include "Hypertable/Lib/CommitLog.h"
+#include "Hypertable/Lib/CommitLogReader.h"
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/RangeState.h"
+#include "Hypertable/Lib/Schema.h"
+#include "Hypertable/Lib/Types.h"
+
+#include "Hypertable/RangeServer/FileBlockCache.h"
+#include "Hypertable/RangeServer/Global.h"
+#include "Hypertable/RangeServer/LogReplayer.h"
+#include "Hypertable/RangeServer/Metadata.h"
+#include "Hypertable/RangeServer/Range.h"
+#include "Hypertable/RangeServer/ScanContext.h"
+#include "Hypertable/RangeServer/TableInfo.h"
+#include "Hypertable/RangeServer/TableInfoMap.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+    "<Schema>\n"
+    "  <AccessGroup name=\"default\">\n"
+    "    <ColumnFamily>\n"
+    "      <Name>data</Name>\n"
+    "    </ColumnFamily>\n"
+    "  </AccessGroup>\n"
+    "</Schema>\n";
+
+  const uint8_t DATA = 1;
+
+  /**
+   * Rows written to the commit log.  The first two fall in the range
+   * [""..m], the rest in [m..END_ROW_MARKER], which is halfway through
+   * being split at "t".
+   */
+  const char *lower_rows[] = { "a", "c", 0 };
+  const char *upper_rows[] = { "n", "t", "u", 0 };
+
+  /** Stands in for the METADATA table: the ranges have no cell stores */
+  class EmptyMetadata : public Metadata {
+  public:
+    virtual void reset_files_scan() { return; }
+    virtual bool get_next_files(std::string &ag_name, std::string &files) {
+      return false;
+    }
+    virtual void write_files(std::string &ag_name, std::string &files) {
+      return;
+    }
+  };
+
+  /**
+   * Moves each replayed range into the live map, as
+   * RangeServer::range_replayed does.
+   */
+  class LiveMapCallback : public LogReplayer::RangeReplayedCallback {
+  public:
+    LiveMapCallback(TableInfoMapPtr &live_map) : m_live_map(live_map) { }
+    virtual void range_replayed(TableInfoPtr &table_info, RangePtr &range) {
+      m_live_map->merge_range(table_info, range);
+    }
+  private:
+    TableInfoMapPtr m_live_map;
+  };
+
+  void write_log(Filesystem *fs, const char *log_dir, TableIdentifier *table) {
+    CommitLog log(fs, log_dir);
+    DynamicBuffer dbuf(table->encoded_length());
+    int64_t timestamp = 1;
+    int error;
+
+    table->encode(&dbuf.ptr);
+    for (const char **rowp = lower_rows; *rowp; rowp++) {
+      create_key_and_append(dbuf, FLAG_INSERT, *rowp, DATA, "", timestamp++);
+      append_as_byte_string(dbuf, *rowp, strlen(*rowp));
+    }
+    for (const char **rowp = upper_rows; *rowp; rowp++) {
+      create_key_and_append(dbuf, FLAG_INSERT, *rowp, DATA, "", timestamp++);
+      append_as_byte_string(dbuf, *rowp, strlen(*rowp));
+    }
+
+    if ((error = log.write(dbuf, timestamp)) != Error::OK)
+      HT_THROW(error, "Problem writing commit log");
+    if ((error = log.close()) != Error::OK)
+      HT_THROW(error, "Problem closing commit log");
+  }
+
+  /**
+   * Checks that the range holds exactly the given rows, in order.
+   */
+  bool check_range(SchemaPtr &schema_ptr, RangePtr &range_ptr,
+                   const char **rows) {
+    ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME, schema_ptr);
+    CellListScanner *scanner = range_ptr->create_scanner(scan_ctx);
+    ByteString bskey, value;
+    Key key;
+    bool ok = true;
+
+    for (; scanner->get(bskey, value); scanner->forward(), rows++) {
+      key.load(bskey);
+      if (*rows == 0 || strcmp(key.row, *rows)) {
+        HT_ERRORF("Range %s holds row '%s', expected '%s'",
+                  range_ptr->get_name().c_str(), key.row,
+                  *rows ? *rows : "nothing");
+        ok = false;
+        break;
+      }
+    }
+
+    if (ok && *rows) {
+      HT_ERRORF("Range %s is missing row '%s'",
+                range_ptr->get_name().c_str(), *rows);
+      ok = false;
+    }
+
+    delete scanner;
+    return ok;
+  }
+
+  /**
+   * Replays a commit log into two ranges whose split was interrupted and
+   * checks that replay leaves them for recovery to split, since the range
+   * transaction log and the commit logs the split writes to do not exist
+   * yet.
+   */
+  bool test_split_in_progress(Filesystem *fs, SchemaPtr &schema_ptr) {
+    MasterClientPtr master_client;
+    TableIdentifier table("LogReplayerTest");
+    EmptyMetadata metadata;
+    RangeSpec lower_spec("", "m");
+    RangeSpec upper_spec("m", Key::END_ROW_MARKER);
+    RangeState lower_state, upper_state;
+    TableInfoMapPtr replay_map = new TableInfoMap();
+    TableInfoMapPtr live_map = new TableInfoMap();
+    LiveMapCallback cb(live_map);
+    std::vector<RangePtr> split_ranges;
+
+    table.id = 5;
+    table.generation = 1;
+
+    lower_state.state = RangeState::SPLIT_SHRUNK;
+    upper_state.state = RangeState::SPLIT_LOG_INSTALLED;
+    upper_state.transfer_log = "/xfer";
+    upper_state.split_point = "t";
+
+    RangePtr lower = new Range(master_client, &table, schema_ptr, &lower_spec,
+                               &lower_state, &metadata);
+    RangePtr upper = new Range(master_client, &table, schema_ptr, &upper_spec,
+                               &upper_state, &metadata);
+
+    TableInfoPtr table_info = new TableInfo(master_client, &table, schema_ptr);
+    table_info->add_range(lower);
+    table_info->add_range(upper);
+    replay_map->set(table.id, table_info);
+
+    write_log(fs, "/log", &table);
+
+    {
+      LogReplayer replayer(replay_map, 2, 8, &cb);
+      CommitLogReader log_reader(fs, "/log");
+      replayer.replay(&log_reader);
+    }
+    live_map->merge(replay_map);
+
+    if (!check_range(schema_ptr, lower, lower_rows) ||
+        !check_range(schema_ptr, upper, upper_rows))
+      return false;
+
+    live_map->get_split_ranges(split_ranges);
+    if (split_ranges.size() != 2) {
+      HT_ERRORF("Expected 2 ranges to split, found %d",
+                (int)split_ranges.size());
+      return false;
+    }
+
+    // nothing may have claimed the ranges for maintenance during replay
+    if (lower->test_and_set_maintenance() ||
+        upper->test_and_set_maintenance()) {
+      HT_ERROR("Range split was scheduled during replay");
+      return false;
+    }
+
+    return true;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  char root[64];
+  bool ok = false;
+
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  SchemaPtr schema_ptr = Schema::new_instance(schema_str, strlen(schema_str));
+  if (!schema_ptr->is_valid()) {
+    HT_ERRORF("Schema parse error - %s", schema_ptr->get_error_string());
+    return 1;
+  }
+  schema_ptr->assign_ids();
+
+  sprintf(root, "/tmp/LogReplayer_test-%d", (int)getpid());
+
+  PropertiesPtr props_ptr = new Properties();
+  props_ptr->set("DfsBroker.Local.Root", root);
+  DfsBroker::LocalClient *fs = new DfsBroker::LocalClient(props_ptr);
+
+  Global::dfs = Global::log_dfs = fs;
+  Global::block_cache = new FileBlockCache(20000000LL);
+
+  fs->mkdirs("/log");
+  fs->mkdirs("/xfer");
+
+  try {
+    ok = test_split_in_progress(fs, schema_ptr);
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+  }
+
+  fs->rmdir("/log");
+  fs->rmdir("/xfer");
+  ::rmdir(root);
+
+  return ok ? 0 : 1;
+}
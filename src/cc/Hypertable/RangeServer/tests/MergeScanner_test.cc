@@ -0,0 +1,220 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdio>
+#include <cstring>
+
+#include "Common/ByteString.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Logger.h"
+#include "Common/System.h"
+#include "Common/Time.h"
+
+#include "Hypertable/Lib/Key.h"
+#include "Hypertable/Lib/Schema.h"
+
+#include "Hypertable/RangeServer/CellCache.h"
+#include "Hypertable/RangeServer/MergeScanner.h"
+#include "Hypertable/RangeServer/ScanContext.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+    "<Schema>\n"
+    "  <AccessGroup name=\"default\">\n"
+    "    <ColumnFamily>\n"
+    "      <Name>single</Name>\n"
+    "      <MaxVersions>1</MaxVersions>\n"
+    "    </ColumnFamily>\n"
+    "    <ColumnFamily>\n"
+    "      <Name>triple</Name>\n"
+    "      <MaxVersions>3</MaxVersions>\n"
+    "    </ColumnFamily>\n"
+    "    <ColumnFamily>\n"
+    "      <Name>expiring</Name>\n"
+    "      <ttl>3600</ttl>\n"
+    "    </ColumnFamily>\n"
+    "  </AccessGroup>\n"
+    "</Schema>\n";
+
+  const int64_t SECOND = 1000000000LL;
+
+  /**
+   * A cell to load, with its timestamp given in seconds after the start
+   * of the test, which is two hours ago.
+   */
+  struct TestCell {
+    const char *row;
+    uint8_t family;
+    uint8_t flag;
+    int64_t seconds;
+    const char *value;
+  };
+
+  /**
+   * Cells that were compacted earlier, standing in for an older CellStore.
+   */
+  TestCell older_cells[] = {
+    { "row1", 1, FLAG_INSERT, 1, "old" },
+    { "row3", 2, FLAG_INSERT, 1, "v1" },
+    { "row3", 2, FLAG_INSERT, 2, "v2" },
+    { 0, 0, 0, 0, 0 }
+  };
+
+  /**
+   * Cells still in the cell cache.
+   */
+  TestCell newer_cells[] = {
+    { "row0", 1, FLAG_INSERT, 1, "first" },
+    // delete followed by a re-insert in a max_versions=1 family
+    { "row1", 1, FLAG_DELETE_CELL, 2, "" },
+    { "row1", 1, FLAG_INSERT, 3, "new" },
+    // delete covering only the older of two versions
+    { "row2", 2, FLAG_DELETE_CELL, 5, "" },
+    { "row2", 2, FLAG_INSERT, 4, "masked" },
+    { "row2", 2, FLAG_INSERT, 6, "kept" },
+    // five versions in a max_versions=3 family
+    { "row3", 2, FLAG_INSERT, 3, "v3" },
+    { "row3", 2, FLAG_INSERT, 4, "v4" },
+    { "row3", 2, FLAG_INSERT, 5, "v5" },
+    // one cell past the one hour TTL and one well within it
+    { "row4", 3, FLAG_INSERT, 1, "expired" },
+    { "row4", 3, FLAG_INSERT, 7140, "fresh" },
+    { 0, 0, 0, 0, 0 }
+  };
+
+  /**
+   * Minor compactions write deletes out without applying them, so masked
+   * cells survive until a major compaction; delete records must not count
+   * as versions.
+   */
+  const char *minor_expected[] = {
+    "row0:1 first",
+    "row1:1 delete",
+    "row1:1 new",
+    "row2:2 delete",
+    "row2:2 kept",
+    "row2:2 masked",
+    "row3:2 v5",
+    "row3:2 v4",
+    "row3:2 v3",
+    "row4:3 fresh",
+    0
+  };
+
+  const char *major_expected[] = {
+    "row0:1 first",
+    "row1:1 new",
+    "row2:2 kept",
+    "row3:2 v5",
+    "row3:2 v4",
+    "row3:2 v3",
+    "row4:3 fresh",
+    0
+  };
+
+  void load_cache(CellCachePtr &cache, TestCell *cells, int64_t base) {
+    DynamicBuffer buf(0);
+
+    cache->lock();
+    for (; cells->row; cells++) {
+      buf.clear();
+      create_key_and_append(buf, cells->flag, cells->row, cells->family, "",
+                            base + cells->seconds * SECOND);
+      size_t value_offset = buf.fill();
+      append_as_byte_string(buf, cells->value, strlen(cells->value));
+      cache->add(ByteString(buf.base), ByteString(buf.base + value_offset), 0);
+    }
+    cache->unlock();
+  }
+
+  /**
+   * Merges the two caches the way AccessGroup::run_compaction does and
+   * compares the surviving cells, in order, against expected.
+   */
+  bool check_merge(SchemaPtr &schema_ptr, CellCachePtr &older,
+                   CellCachePtr &newer, bool major, const char **expected) {
+    const char *kind = major ? "major" : "minor";
+    ScanContextPtr scan_ctx = new ScanContext(END_OF_TIME, schema_ptr);
+    MergeScanner *mscanner = new MergeScanner(scan_ctx, !major);
+    ByteString bskey, value;
+    Key key;
+    const uint8_t *ptr;
+    char cell[128];
+    bool ok = true;
+
+    mscanner->add_scanner(newer->create_scanner(scan_ctx));
+    mscanner->add_scanner(older->create_scanner(scan_ctx));
+
+    for (; mscanner->get(bskey, value); mscanner->forward(), expected++) {
+      key.load(bskey);
+      size_t len = value.decode_length(&ptr);
+      if (key.flag == FLAG_INSERT)
+        sprintf(cell, "%s:%d %.*s", key.row, (int)key.column_family_code,
+                (int)len, (const char *)ptr);
+      else
+        sprintf(cell, "%s:%d delete", key.row, (int)key.column_family_code);
+      if (*expected == 0 || strcmp(cell, *expected)) {
+        HT_ERRORF("%s compaction produced '%s', expected '%s'", kind, cell,
+                  *expected ? *expected : "nothing");
+        ok = false;
+        break;
+      }
+    }
+
+    if (ok && *expected) {
+      HT_ERRORF("%s compaction dropped '%s'", kind, *expected);
+      ok = false;
+    }
+
+    delete mscanner;
+    return ok;
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  System::initialize(System::locate_install_dir(argv[0]));
+
+  SchemaPtr schema_ptr = Schema::new_instance(schema_str, strlen(schema_str));
+  if (!schema_ptr->is_valid()) {
+    HT_ERRORF("Schema parse error - %s", schema_ptr->get_error_string());
+    return 1;
+  }
+  schema_ptr->assign_ids();
+
+  int64_t base = (int64_t)get_ts64() - 7200 * SECOND;
+  CellCachePtr older = new CellCache();
+  CellCachePtr newer = new CellCache();
+
+  load_cache(older, older_cells, base);
+  load_cache(newer, newer_cells, base);
+
+  bool ok = check_merge(schema_ptr, older, newer, false, minor_expected) &&
+      check_merge(schema_ptr, older, newer, true, major_expected);
+
+  return ok ? 0 : 1;
+}
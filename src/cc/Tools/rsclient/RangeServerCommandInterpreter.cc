@@ -348,6 +348,11 @@ void RangeServerCommandInterpreter::execute_line(const String &line) {
     else if (state.command == COMMAND_SHUTDOWN) {
       m_range_server_ptr->shutdown(m_addr);
     }
+    else if (state.command == COMMAND_SHOW_STATISTICS) {
+      String stats;
+      m_range_server_ptr->get_statistics(m_addr, stats);
+      cout << stats << flush;
+    }
     else
       HT_THROW(Error::HQL_PARSE_ERROR, "unsupported command");
   }
@@ -0,0 +1,162 @@
+/** -*- c++ -*-
+ * Copyright (C) 2008 Doug Judd (Zvents, Inc.)
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "Common/String.h"
+#include "Common/Usage.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const char *usage[] = {
+    "usage: trace_report [options] <trace-log> [<trace-log> ...]",
+    "",
+    "  options:",
+    "    --min-duration=<us>  Only display traces whose longest span took at",
+    "                         least <us> microseconds",
+    "    --trace=<id>         Only display the trace with the given (hex) ID",
+    "    --help               Display this help text and exit",
+    "",
+    "  This program merges the trace logs written by clients, RangeServers",
+    "  and DFS brokers (see Hypertable.Trace.Log) and displays the spans of",
+    "  each trace in start order, with start times relative to the first",
+    "  span of the trace.",
+    "",
+    (const char *)0
+  };
+
+  struct SpanRec {
+    int64_t start;
+    int64_t duration;
+    String  process;
+    String  name;
+  };
+
+  struct LtSpanRec {
+    bool operator()(const SpanRec &s1, const SpanRec &s2) const {
+      if (s1.start != s2.start)
+        return s1.start < s2.start;
+      return s1.duration > s2.duration;
+    }
+  };
+
+  typedef std::map<uint64_t, std::vector<SpanRec> > TraceMap;
+
+  void load_trace_log(const char *fname, TraceMap &traces) {
+    ifstream in(fname);
+    String line;
+    int lineno = 0;
+
+    if (!in) {
+      cerr << "Unable to open trace log '" << fname << "'" << endl;
+      exit(1);
+    }
+
+    while (getline(in, line)) {
+      SpanRec span;
+      Llu trace_id;
+      long long start, duration;
+      char process[256];
+      int consumed = 0;
+
+      lineno++;
+      if (sscanf(line.c_str(), "%llx %lld %lld %255s %n", &trace_id, &start,
+                 &duration, process, &consumed) < 4 || consumed == 0) {
+        cerr << fname << ":" << lineno << ": malformed span, skipping" << endl;
+        continue;
+      }
+      span.start = start;
+      span.duration = duration;
+      span.process = process;
+      span.name = line.substr(consumed);
+      traces[trace_id].push_back(span);
+    }
+  }
+
+  void display_trace(uint64_t trace_id, std::vector<SpanRec> &spans) {
+    LtSpanRec ascending;
+    sort(spans.begin(), spans.end(), ascending);
+
+    int64_t base = spans[0].start;
+    int64_t end = base;
+    for (size_t i=0; i<spans.size(); i++)
+      end = std::max(end, spans[i].start + spans[i].duration);
+
+    printf("trace %016llx  spans=%d  elapsed=%lldus\n", (Llu)trace_id,
+           (int)spans.size(), (long long)(end - base));
+
+    for (size_t i=0; i<spans.size(); i++)
+      printf("  +%-10lld %10lldus  %-24s %s\n",
+             (long long)(spans[i].start - base), (long long)spans[i].duration,
+             spans[i].process.c_str(), spans[i].name.c_str());
+    printf("\n");
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  TraceMap traces;
+  std::vector<const char *> files;
+  int64_t min_duration = 0;
+  uint64_t only_trace = 0;
+
+  for (int i=1; i<argc; i++) {
+    if (!strncmp(argv[i], "--min-duration=", 15))
+      min_duration = strtoll(&argv[i][15], 0, 10);
+    else if (!strncmp(argv[i], "--trace=", 8))
+      only_trace = strtoull(&argv[i][8], 0, 16);
+    else if (argv[i][0] == '-')
+      Usage::dump_and_exit(usage);
+    else
+      files.push_back(argv[i]);
+  }
+
+  if (files.empty())
+    Usage::dump_and_exit(usage);
+
+  for (size_t i=0; i<files.size(); i++)
+    load_trace_log(files[i], traces);
+
+  for (TraceMap::iterator iter = traces.begin(); iter != traces.end(); ++iter) {
+    if (only_trace && (*iter).first != only_trace)
+      continue;
+    int64_t longest = 0;
+    for (size_t i=0; i<(*iter).second.size(); i++)
+      longest = std::max(longest, (*iter).second[i].duration);
+    if (longest < min_duration)
+      continue;
+    display_trace((*iter).first, (*iter).second);
+  }
+
+  return 0;
+}